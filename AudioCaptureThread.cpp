@@ -0,0 +1,453 @@
+#include "AudioCaptureThread.h"
+#include <QAudioSource>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QtMath>
+#include <cstring>
+
+// Picovoice C API
+extern "C" {
+#include "pv_porcupine.h"
+#include "pv_rhino.h"
+#include "pv_koala.h"
+}
+
+AudioCaptureThread::AudioCaptureThread(const QAudioDevice &device, const QAudioFormat &format,
+                                       const Engines &engines, quint32 generation, QObject *parent)
+    : QThread(parent)
+    , m_device(device)
+    , m_format(format)
+    , m_engines(engines)
+    , m_ring(engines.frameLength * 16)     // ~0.5 s at 512-sample frames
+    , m_state(PicovoiceManager::Listening)
+    , m_generation(generation)
+    , m_requestedState(PicovoiceManager::Listening)
+{
+    // Everything the frame loop touches is allocated here, once. Speech
+    // covers the ready prompt, a Rhino command up to its timeout, then a
+    // full STT utterance.
+    m_rawFrame.resize(m_engines.frameLength);
+    m_cleanFrame.resize(m_engines.frameLength);
+    m_speech.resize(samplesFor(PREBUFFER_MS + 2 * MAX_SPEECH_DURATION_MS));
+}
+
+AudioCaptureThread::~AudioCaptureThread()
+{
+    stop();
+}
+
+void AudioCaptureThread::stop()
+{
+    if (!isRunning()) return;
+    requestInterruption();
+    quit();   // Also ends an event loop that hasn't started yet
+    wait();
+}
+
+void AudioCaptureThread::setState(State state, quint32 generation)
+{
+    QMutexLocker lock(&m_requestMutex);
+    m_hasStateRequest = true;
+    m_requestedState = state;
+    m_requestedGeneration = generation;
+    m_finalizeRequested = false;   // Whatever it was for is over
+    m_requestPending.store(true, std::memory_order_release);
+}
+
+void AudioCaptureThread::finalize()
+{
+    QMutexLocker lock(&m_requestMutex);
+    m_finalizeRequested = true;
+    m_requestPending.store(true, std::memory_order_release);
+}
+
+void AudioCaptureThread::setPaused(bool paused, int deafMs)
+{
+    QMutexLocker lock(&m_requestMutex);
+    m_hasPauseRequest = true;
+    m_pausedRequest = paused;
+    m_requestedDeafMs = deafMs;
+    m_requestPending.store(true, std::memory_order_release);
+}
+
+void AudioCaptureThread::run()
+{
+    // Created here so its notifications are delivered to this thread
+    QAudioSource source(m_device, m_format);
+    source.setBufferSize(4096);  // 128ms at 16kHz mono 16-bit — low latency for voice
+    // Note: media.role=voice_assistant is set via PULSE_PROP in headunit.env for PipeWire/WirePlumber policy
+    m_source = &source;
+    m_io = source.start();
+    if (!m_io) {
+        m_source = nullptr;
+        emit captureFailed("Failed to start audio input");
+        return;
+    }
+    connect(m_io, &QIODevice::readyRead, &source, [this]() { readAvailable(); });
+
+    // Monitor audio source for errors and auto-recover (with retry limit)
+    connect(&source, &QAudioSource::stateChanged, &source, [this](QAudio::State state) {
+        if (state != QAudio::StoppedState || m_source->error() == QAudio::NoError) return;
+        if (++m_recoveryAttempts > MAX_AUDIO_RECOVERY_ATTEMPTS) {
+            qCritical() << "AudioCaptureThread: Audio recovery failed after"
+                        << MAX_AUDIO_RECOVERY_ATTEMPTS << "attempts, stopping";
+            emit captureFailed("Microphone disconnected — restart to retry");
+            return;
+        }
+        qWarning() << "AudioCaptureThread: Audio source error:" << m_source->error()
+                   << "— restart attempt" << m_recoveryAttempts;
+        QTimer::singleShot(500, m_source, [this]() { restartCapture(); });
+    });
+
+    qDebug() << "AudioCaptureThread: Capturing" << m_engines.frameLength << "sample frames at"
+             << m_engines.sampleRate << "Hz" << (m_engines.koala ? "with Koala" : "");
+    exec();
+
+    source.stop();
+    m_io = nullptr;
+    m_source = nullptr;
+    qDebug() << "AudioCaptureThread: Stopped after" << framesProcessed() << "frames, peak"
+             << peakFrameUs() << "us per frame";
+}
+
+void AudioCaptureThread::restartCapture()
+{
+    if (!m_source || isInterruptionRequested()) return;
+
+    QIODevice *oldIo = m_io;
+    m_io = m_source->start();
+    if (!m_io) {
+        qCritical() << "AudioCaptureThread: Failed to restart audio capture";
+        return;
+    }
+
+    // Qt may reuse the same QIODevice on restart; never connect twice
+    if (oldIo) oldIo->disconnect(m_source);
+    connect(m_io, &QIODevice::readyRead, m_source, [this]() { readAvailable(); });
+    m_recoveryAttempts = 0;
+    qDebug() << "AudioCaptureThread: Audio capture restarted successfully";
+}
+
+void AudioCaptureThread::applyRequests()
+{
+    if (!m_requestPending.load(std::memory_order_acquire)) return;
+
+    bool hasState, finalize, hasPause, paused;
+    State state;
+    quint32 generation;
+    int deafMs;
+    {
+        QMutexLocker lock(&m_requestMutex);
+        hasState = m_hasStateRequest;
+        state = m_requestedState;
+        generation = m_requestedGeneration;
+        finalize = m_finalizeRequested;
+        hasPause = m_hasPauseRequest;
+        paused = m_pausedRequest;
+        deafMs = m_requestedDeafMs;
+        m_hasStateRequest = m_finalizeRequested = m_hasPauseRequest = false;
+        m_requestPending.store(false, std::memory_order_relaxed);
+    }
+
+    if (hasPause) {
+        m_paused = paused;
+        m_ring.clear();
+        m_deafSamples = paused ? 0 : samplesFor(deafMs);
+    }
+    if (hasState) {
+        m_generation = generation;
+        enterState(state);
+    }
+    if (finalize && (m_state == PicovoiceManager::WaitingForCommand
+                     || m_state == PicovoiceManager::ProcessingSpeech))
+        endUtterance(Requested);
+}
+
+void AudioCaptureThread::readAvailable()
+{
+    applyRequests();
+
+    // Read straight into the ring, then consume it a frame at a time. The
+    // ring is drained after every read, so there is always room for the next.
+    // Int16 mono arrives in whole samples.
+    const int frameLength = m_engines.frameLength;
+    while (m_io) {
+        int space = 0;
+        int16_t *span = m_ring.writeSpan(&space);
+        if (space == 0) break;
+        const qint64 bytes = m_io->read(reinterpret_cast<char *>(span), qint64(space) * qint64(sizeof(int16_t)));
+        if (bytes <= 0) break;
+        m_ring.commitWrite(int(bytes / qint64(sizeof(int16_t))));
+
+        // Always read, even paused: stale audio (including TTS echo) must
+        // not pile up in the driver and flood the pipeline on resume
+        if (m_paused) {
+            m_ring.clear();
+            continue;
+        }
+
+        while (m_ring.read(m_rawFrame.data(), frameLength)) {
+            // Post-resume deaf period, for TTS echo and reverberation
+            if (m_deafSamples > 0) {
+                m_deafSamples -= frameLength;
+                continue;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+
+            const int16_t *frame = m_rawFrame.constData();
+            if (m_engines.koala) {
+                pv_status_t status = pv_koala_process(m_engines.koala, frame, m_cleanFrame.data());
+                if (status == PV_STATUS_SUCCESS) frame = m_cleanFrame.constData();
+            }
+            processFrame(frame);
+
+            const int us = int(timer.nsecsElapsed() / 1000);
+            if (us > m_peakFrameUs.load(std::memory_order_relaxed))
+                m_peakFrameUs.store(us, std::memory_order_relaxed);
+            m_framesProcessed.fetch_add(1, std::memory_order_relaxed);
+
+            // Pick up GUI requests between frames, not just between reads
+            applyRequests();
+            if (m_paused) break;
+        }
+    }
+}
+
+void AudioCaptureThread::processFrame(const int16_t *frame)
+{
+    const int32_t length = m_engines.frameLength;
+
+    switch (m_state) {
+        case PicovoiceManager::Listening: {
+            // Track ambient noise floor while idle (for adaptive speech detection)
+            const int16_t energy = frameEnergy(frame, length);
+            m_noiseFloor = m_noiseFloor * (1.0f - NOISE_FLOOR_ALPHA) + energy * NOISE_FLOOR_ALPHA;
+            // Cap so highway wind noise can't make speech detection impossible
+            if (m_noiseFloor > NOISE_FLOOR_MAX) m_noiseFloor = NOISE_FLOOR_MAX;
+            processWakeWord(frame);
+            break;
+        }
+
+        case PicovoiceManager::WaitingForReadyPrompt:
+            // Pre-buffer audio so we capture the user's command even if they start
+            // talking before the ready prompt finishes
+            appendSpeech(frame);
+            break;
+
+        case PicovoiceManager::WaitingForCommand:
+            processRhinoIntent(frame);
+            break;
+
+        case PicovoiceManager::WaitingForSpeechStart:
+        case PicovoiceManager::WaitingForFollowUp:
+            // No wake word needed: wait for the user to start speaking
+            if (isVoice(frame)) {
+                beginSpeech();
+                appendSpeech(frame);
+                m_state = PicovoiceManager::ProcessingSpeech;
+                emit speechStarted(m_generation);
+            }
+            break;
+
+        case PicovoiceManager::ProcessingSpeech: {
+            const bool streaming = m_streaming.load(std::memory_order_relaxed);
+            appendSpeech(frame);
+            if (streaming) streamSpeech(samplesFor(STREAM_CHUNK_MS));
+            m_speechSamples += length;
+            m_silentSamples = isVoice(frame) ? 0 : m_silentSamples + length;
+
+            // Silence-based finalization after the minimum speech duration,
+            // max duration as the fallback
+            const int silenceMs = streaming ? STREAMING_SILENCE_THRESHOLD_MS : SILENCE_THRESHOLD_MS;
+            if (m_speechSamples > samplesFor(MIN_SPEECH_DURATION_MS)
+                && m_silentSamples > samplesFor(silenceMs)) {
+                endUtterance(Silence);
+            } else if (m_speechSamples > samplesFor(MAX_SPEECH_DURATION_MS)) {
+                endUtterance(MaxDuration);
+            }
+            break;
+        }
+
+        case PicovoiceManager::WaitingForTranscription:
+            // Audio sent to STT — discard frames until the GUI moves on
+            break;
+    }
+}
+
+void AudioCaptureThread::processWakeWord(const int16_t *frame)
+{
+    if (!m_engines.porcupine) return;
+
+    int32_t keywordIndex = -1;
+    pv_status_t status = pv_porcupine_process(m_engines.porcupine, frame, &keywordIndex);
+    if (status != PV_STATUS_SUCCESS) {
+        qWarning() << "AudioCaptureThread: Porcupine process error:" << pv_status_to_string(status);
+        return;
+    }
+    if (keywordIndex < 0) return;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (m_lastDetectionMs != 0 && now - m_lastDetectionMs < DETECTION_DEBOUNCE_MS) {
+        qDebug() << "AudioCaptureThread: Ignoring duplicate detection (" << now - m_lastDetectionMs << "ms since last)";
+        return;
+    }
+
+    enterState(PicovoiceManager::WaitingForReadyPrompt);
+    emit wakeWordDetected(m_generation);
+}
+
+void AudioCaptureThread::processRhinoIntent(const int16_t *frame)
+{
+    if (!m_engines.rhino) {
+        // No Rhino: treat it as a query for STT
+        m_state = PicovoiceManager::ProcessingSpeech;
+        m_speechSamples = 0;
+        m_silentSamples = 0;
+        emit intentNotUnderstood(m_generation);
+        return;
+    }
+
+    bool isFinalized = false;
+    pv_status_t status = pv_rhino_process(m_engines.rhino, frame, &isFinalized);
+    if (status != PV_STATUS_SUCCESS) {
+        qWarning() << "AudioCaptureThread: Rhino process error:" << pv_status_to_string(status);
+        return;
+    }
+
+    // Also accumulate audio for a possible STT fallback
+    appendSpeech(frame);
+    if (!isFinalized) return;
+
+    bool isUnderstood = false;
+    pv_rhino_is_understood(m_engines.rhino, &isUnderstood);
+    if (!isUnderstood) {
+        // Keep recording; silence or the max duration ends it
+        m_state = PicovoiceManager::ProcessingSpeech;
+        m_speechSamples = 0;
+        m_silentSamples = 0;
+        emit intentNotUnderstood(m_generation);
+        return;
+    }
+
+    const char *intent = nullptr;
+    int32_t numSlots = 0;
+    const char **slotNames = nullptr;
+    const char **values = nullptr;
+    status = pv_rhino_get_intent(m_engines.rhino, &intent, &numSlots, &slotNames, &values);
+
+    QString intentName;
+    QVariantMap slotMap;
+    if (status == PV_STATUS_SUCCESS && intent) {
+        intentName = QString(intent);
+        for (int32_t i = 0; i < numSlots; i++)
+            slotMap[QString(slotNames[i])] = QString(values[i]);
+        pv_rhino_free_slots_and_values(m_engines.rhino, slotNames, values);
+    }
+
+    enterState(PicovoiceManager::Listening);
+    if (!intentName.isEmpty()) emit intentDetected(m_generation, intentName, slotMap);
+}
+
+void AudioCaptureThread::enterState(State state)
+{
+    m_state = state;
+    switch (state) {
+        case PicovoiceManager::Listening:
+            m_speechLength = 0;
+            m_streamedLength = 0;
+            if (m_engines.rhino) pv_rhino_reset(m_engines.rhino);
+            break;
+        case PicovoiceManager::WaitingForReadyPrompt:
+            // Also debounces a wake word straight after a button activation
+            m_lastDetectionMs = QDateTime::currentMSecsSinceEpoch();
+            beginSpeech();
+            break;
+        case PicovoiceManager::WaitingForSpeechStart:
+        case PicovoiceManager::WaitingForFollowUp:
+            beginSpeech();
+            break;
+        default:
+            // WaitingForCommand keeps what was said during the ready prompt
+            break;
+    }
+}
+
+void AudioCaptureThread::beginSpeech()
+{
+    m_speechLength = 0;
+    m_streamedLength = 0;
+    m_speechSamples = 0;
+    m_silentSamples = 0;
+    m_speechOverflowLogged = false;
+}
+
+void AudioCaptureThread::appendSpeech(const int16_t *frame)
+{
+    const int count = qMin(m_engines.frameLength, m_speech.size() - m_speechLength);
+    if (count < m_engines.frameLength && !m_speechOverflowLogged) {
+        qWarning() << "AudioCaptureThread: Speech buffer full, dropping audio";
+        m_speechOverflowLogged = true;
+    }
+    if (count <= 0) return;
+    std::memcpy(m_speech.data() + m_speechLength, frame, size_t(count) * sizeof(int16_t));
+    m_speechLength += count;
+}
+
+void AudioCaptureThread::streamSpeech(int minSamples)
+{
+    const int count = m_speechLength - m_streamedLength;
+    if (count <= 0 || count < minSamples) return;
+
+    emit speechAudio(m_generation, QVector<int16_t>(m_speech.constBegin() + m_streamedLength,
+                                                    m_speech.constBegin() + m_speechLength));
+    m_streamedLength = m_speechLength;
+}
+
+void AudioCaptureThread::endUtterance(EndReason reason)
+{
+    if (m_engines.rhino && m_state == PicovoiceManager::WaitingForCommand)
+        pv_rhino_reset(m_engines.rhino);
+
+    // The stream gets its tail before the end is signalled
+    if (m_state == PicovoiceManager::ProcessingSpeech && m_streaming.load(std::memory_order_relaxed))
+        streamSpeech(1);
+
+    // The one copy per utterance, handed to the GUI thread
+    const QVector<int16_t> audio(m_speech.constBegin(), m_speech.constBegin() + m_speechLength);
+    m_speechLength = 0;
+    m_streamedLength = 0;
+    m_state = PicovoiceManager::WaitingForTranscription;
+    emit utteranceEnded(m_generation, audio, reason);
+}
+
+bool AudioCaptureThread::isVoice(const int16_t *frame) const
+{
+    // Adaptive threshold: speech must be SPEECH_THRESHOLD_RATIO times the
+    // ambient noise level, and never below the fixed floor
+    const int16_t adaptive = static_cast<int16_t>(m_noiseFloor * SPEECH_THRESHOLD_RATIO);
+    const int16_t threshold = adaptive > SILENCE_ENERGY_THRESHOLD ? adaptive : SILENCE_ENERGY_THRESHOLD;
+    return frameEnergy(frame, m_engines.frameLength) > threshold;
+}
+
+int16_t AudioCaptureThread::frameEnergy(const int16_t *frame, int32_t length)
+{
+    // Calculate RMS (Root Mean Square) energy of the audio frame
+    if (!frame || length <= 0) {
+        return 0;
+    }
+
+    int64_t sumSquares = 0;
+    for (int32_t i = 0; i < length; ++i) {
+        int64_t sample = static_cast<int64_t>(frame[i]);
+        sumSquares += sample * sample;
+    }
+
+    // Return RMS as int16_t (approximation using integer math)
+    return static_cast<int16_t>(qSqrt(static_cast<double>(sumSquares) / length));
+}
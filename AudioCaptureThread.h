@@ -0,0 +1,169 @@
+#ifndef AUDIOCAPTURETHREAD_H
+#define AUDIOCAPTURETHREAD_H
+
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVariantMap>
+#include <QVector>
+#include <atomic>
+
+#include "PicovoiceManager.h"
+#include "SpscRingBuffer.h"
+
+class QAudioSource;
+class QIODevice;
+
+// Dedicated microphone thread for PicovoiceManager.
+//
+// Owns the QAudioSource and its event loop, so capture keeps up however
+// busy the GUI thread is. Each readyRead is read straight into a
+// preallocated ring, then consumed in fixed Porcupine-sized frames:
+// Koala noise suppression, the adaptive noise floor, Porcupine, Rhino and
+// the energy VAD all run here, and speech accumulates in a buffer sized
+// for the longest utterance up front. Nothing is allocated per frame.
+//
+// With streaming on, speech is also copied out in STREAM_CHUNK_MS pieces
+// as it accumulates (everything recorded so far in the first one), and
+// silence only ends an utterance after STREAMING_SILENCE_THRESHOLD_MS: the
+// streaming recognizer is expected to endpoint it first, through finalize().
+//
+// The thread runs the audio half of PicovoiceManager's state machine.
+// Transitions it makes itself (wake word, speech start and end, intents)
+// are signalled to the GUI thread; transitions the GUI makes (prompts,
+// timeouts, cancels) are requested with setState() and picked up before
+// the next frame. Every request carries a generation, and the signals
+// carry the generation they were made under, so the GUI can drop events
+// that raced with a newer request.
+class AudioCaptureThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    using State = PicovoiceManager::State;
+
+    enum EndReason {
+        Silence,        // SILENCE_THRESHOLD_MS without voice
+        MaxDuration,    // MAX_SPEECH_DURATION_MS reached
+        Requested       // finalize()
+    };
+    Q_ENUM(EndReason)
+
+    // Picovoice handles, owned by PicovoiceManager and used only by this
+    // thread while it runs
+    struct Engines {
+        pv_porcupine_t *porcupine = nullptr;
+        pv_rhino_t *rhino = nullptr;
+        pv_koala_t *koala = nullptr;    // Only if its frame length matches
+        int32_t frameLength = 512;
+        int32_t sampleRate = 16000;
+    };
+
+    AudioCaptureThread(const QAudioDevice &device, const QAudioFormat &format,
+                       const Engines &engines, quint32 generation, QObject *parent = nullptr);
+    ~AudioCaptureThread() override;
+
+    void stop();
+
+    // Any thread. Applied before the next frame; a newer request replaces
+    // a pending one.
+    void setState(State state, quint32 generation);
+    // Ends the utterance now (utteranceEnded with Requested, possibly empty)
+    void finalize();
+    // Audio is read and dropped while paused. Resuming with deafMs keeps
+    // dropping that much more, for the tail of TTS echo.
+    void setPaused(bool paused, int deafMs = 0);
+    // Any thread. Takes effect from the next frame.
+    void setStreaming(bool streaming) { m_streaming.store(streaming, std::memory_order_relaxed); }
+
+    // Counters — safe to read from any thread
+    quint64 framesProcessed() const { return m_framesProcessed.load(std::memory_order_relaxed); }
+    int peakFrameUs() const { return m_peakFrameUs.load(std::memory_order_relaxed); }
+
+    static constexpr int MAX_SPEECH_DURATION_MS = 10000;  // 10 seconds max
+    static constexpr int PREBUFFER_MS = 5000;             // Speech before the ready prompt ends
+    static constexpr int SILENCE_THRESHOLD_MS = 1500;     // 1.5 seconds of silence triggers finalization
+    static constexpr int STREAMING_SILENCE_THRESHOLD_MS = 3000;  // Fallback when the recognizer endpoints
+    static constexpr int STREAM_CHUNK_MS = 100;           // Streamed speech granularity
+    static constexpr int MIN_SPEECH_DURATION_MS = 500;    // Minimum speech before allowing silence detection
+    static constexpr int16_t SILENCE_ENERGY_THRESHOLD = 150;  // Minimum RMS floor (USB mic with PulseAudio boost)
+    static constexpr float NOISE_FLOOR_ALPHA = 0.02f;     // Slow adaptation rate
+    static constexpr float NOISE_FLOOR_MAX = 2000.0f;     // Speech threshold never above ~6000 RMS
+    static constexpr float SPEECH_THRESHOLD_RATIO = 3.0f; // Speech must be 3x noise floor
+    static constexpr int DETECTION_DEBOUNCE_MS = 1000;
+    static constexpr int MAX_AUDIO_RECOVERY_ATTEMPTS = 5;
+
+signals:
+    // Emitted from the capture thread; connect queued
+    void wakeWordDetected(quint32 generation);            // -> WaitingForReadyPrompt
+    void speechStarted(quint32 generation);               // -> ProcessingSpeech
+    void intentDetected(quint32 generation, const QString &intent, const QVariantMap &slots);  // -> Listening
+    void intentNotUnderstood(quint32 generation);         // -> ProcessingSpeech
+    void speechAudio(quint32 generation, const QVector<int16_t> &samples);  // Streaming, in ProcessingSpeech
+    void utteranceEnded(quint32 generation, const QVector<int16_t> &audio,
+                        AudioCaptureThread::EndReason reason);  // -> WaitingForTranscription
+    void captureFailed(const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    void readAvailable();
+    void restartCapture();
+    void applyRequests();
+    void processFrame(const int16_t *frame);
+    void processWakeWord(const int16_t *frame);
+    void processRhinoIntent(const int16_t *frame);
+    void enterState(State state);
+    void beginSpeech();
+    void appendSpeech(const int16_t *frame);
+    void streamSpeech(int minSamples);
+    void endUtterance(EndReason reason);
+    bool isVoice(const int16_t *frame) const;
+    int samplesFor(int ms) const { return int(qint64(ms) * m_engines.sampleRate / 1000); }
+    static int16_t frameEnergy(const int16_t *frame, int32_t length);
+
+    const QAudioDevice m_device;
+    const QAudioFormat m_format;
+    const Engines m_engines;
+
+    // Capture thread only
+    QAudioSource *m_source = nullptr;
+    QIODevice *m_io = nullptr;
+    int m_recoveryAttempts = 0;
+    SpscRingBuffer<int16_t> m_ring;
+    QVector<int16_t> m_rawFrame;
+    QVector<int16_t> m_cleanFrame;
+    QVector<int16_t> m_speech;      // Preallocated; m_speechLength used
+    int m_speechLength = 0;
+    int m_streamedLength = 0;       // Of m_speech, already sent with speechAudio
+    bool m_speechOverflowLogged = false;
+    State m_state;
+    quint32 m_generation;
+    float m_noiseFloor = 500.0f;    // Adaptive, updated while Listening
+    qint64 m_lastDetectionMs = 0;
+    int m_speechSamples = 0;        // Since speech start
+    int m_silentSamples = 0;        // Since the last voiced frame
+    int m_deafSamples = 0;
+    bool m_paused = false;
+
+    // Requests from other threads, guarded by m_requestMutex; the flag lets
+    // the frame loop skip the lock when there is nothing new
+    QMutex m_requestMutex;
+    std::atomic<bool> m_requestPending { false };
+    bool m_hasStateRequest = false;
+    State m_requestedState;
+    quint32 m_requestedGeneration = 0;
+    bool m_finalizeRequested = false;
+    bool m_pausedRequest = false;
+    bool m_hasPauseRequest = false;
+    int m_requestedDeafMs = 0;
+    std::atomic<bool> m_streaming { false };
+
+    std::atomic<quint64> m_framesProcessed { 0 };
+    std::atomic<int> m_peakFrameUs { 0 };
+};
+
+#endif // AUDIOCAPTURETHREAD_H
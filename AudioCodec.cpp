@@ -0,0 +1,340 @@
+#include "AudioCodec.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if HAS_OPUS
+#include <opus.h>
+#endif
+
+namespace {
+
+constexpr quint8 kOggBos = 0x02;
+constexpr quint8 kOggEos = 0x04;
+constexpr int kOggHeaderSize = 27;
+constexpr int kMaxPageSegments = 255;
+constexpr int kPacketsPerPage = 50;       // One second of 20 ms frames
+constexpr int kMaxPacketBytes = 1500;
+constexpr int kOpusRate = 48000;          // Granule positions are always at 48 kHz
+
+quint32 oggCrc(const char *data, int size)
+{
+    // CRC-32, polynomial 0x04C11DB7, unreflected, zero init (RFC 3533)
+    static const auto table = [] {
+        std::array<quint32, 256> t {};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 r = i << 24;
+            for (int bit = 0; bit < 8; ++bit)
+                r = (r & 0x80000000u) ? (r << 1) ^ 0x04C11DB7u : r << 1;
+            t[i] = r;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0;
+    for (int i = 0; i < size; ++i)
+        crc = (crc << 8) ^ table[((crc >> 24) ^ quint8(data[i])) & 0xFF];
+    return crc;
+}
+
+} // namespace
+
+// ============================================================================
+// Ogg framing
+// ============================================================================
+
+QByteArray AudioCodec::oggPage(const QList<QByteArray> &packets, qint64 granule, quint32 serial,
+                               quint32 sequence, quint8 flags)
+{
+    // Packets are never split across pages, so each one is a run of 255s
+    // ending in its remainder (0 if it is an exact multiple)
+    QByteArray lacing;
+    int bodySize = 0;
+    for (const QByteArray &packet : packets) {
+        lacing.append(QByteArray(packet.size() / 255, char(255)));
+        lacing.append(char(packet.size() % 255));
+        bodySize += packet.size();
+    }
+    if (lacing.size() > kMaxPageSegments) {
+        qWarning() << "AudioCodec: Too many segments for one Ogg page:" << lacing.size();
+        return QByteArray();
+    }
+
+    QByteArray page(kOggHeaderSize, '\0');
+    char *h = page.data();
+    std::memcpy(h, "OggS", 4);
+    h[4] = 0;                                   // Stream structure version
+    h[5] = char(flags);
+    qToLittleEndian<qint64>(granule, h + 6);
+    qToLittleEndian<quint32>(serial, h + 14);
+    qToLittleEndian<quint32>(sequence, h + 18);
+    // h[22..25]: CRC, filled in below over the whole page
+    h[26] = char(lacing.size());
+
+    page.reserve(kOggHeaderSize + lacing.size() + bodySize);
+    page.append(lacing);
+    for (const QByteArray &packet : packets)
+        page.append(packet);
+
+    qToLittleEndian<quint32>(oggCrc(page.constData(), page.size()), page.data() + 22);
+    return page;
+}
+
+QList<QByteArray> AudioCodec::oggPackets(const QByteArray &ogg, qint64 *lastGranule)
+{
+    QList<QByteArray> packets;
+    QByteArray packet;
+    qint64 granule = -1;
+
+    int pos = 0;
+    while (pos + kOggHeaderSize <= ogg.size()) {
+        const char *h = ogg.constData() + pos;
+        if (std::memcmp(h, "OggS", 4) != 0) {
+            qWarning() << "AudioCodec: Lost Ogg sync at byte" << pos;
+            break;
+        }
+        const int segments = quint8(h[26]);
+        const int tableEnd = pos + kOggHeaderSize + segments;
+        if (tableEnd > ogg.size()) break;
+
+        int bodyPos = tableEnd;
+        for (int i = 0; i < segments; ++i) {
+            const int length = quint8(ogg[pos + kOggHeaderSize + i]);
+            if (bodyPos + length > ogg.size()) {
+                qWarning() << "AudioCodec: Truncated Ogg page";
+                if (lastGranule) *lastGranule = granule;
+                return packets;
+            }
+            packet.append(ogg.constData() + bodyPos, length);
+            bodyPos += length;
+            // A lacing value under 255 ends the packet; 255 continues it,
+            // possibly onto the next page
+            if (length < 255) {
+                packets.append(packet);
+                packet.clear();
+            }
+        }
+
+        const qint64 pageGranule = qFromLittleEndian<qint64>(h + 6);
+        if (pageGranule != -1) granule = pageGranule;
+        pos = bodyPos;
+    }
+
+    if (lastGranule) *lastGranule = granule;
+    return packets;
+}
+
+// ============================================================================
+// Opus
+// ============================================================================
+
+QByteArray AudioCodec::encodeOggOpus(const QByteArray &pcm, int sampleRate, int bitrate)
+{
+#if HAS_OPUS
+    const qint64 samples = pcm.size() / qint64(sizeof(opus_int16));
+    if (samples == 0 || kOpusRate % sampleRate != 0) return QByteArray();
+
+    int err = OPUS_OK;
+    OpusEncoder *encoder = opus_encoder_create(sampleRate, 1, OPUS_APPLICATION_VOIP, &err);
+    if (err != OPUS_OK) {
+        qWarning() << "AudioCodec: opus_encoder_create failed:" << opus_strerror(err);
+        return QByteArray();
+    }
+    opus_encoder_ctl(encoder, OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(encoder, OPUS_GET_LOOKAHEAD(&lookahead));
+
+    const int scale = kOpusRate / sampleRate;
+    const int preSkip = lookahead * scale;
+    const int frameSamples = sampleRate * kFrameMs / 1000;
+    const quint32 serial = QRandomGenerator::global()->generate();
+
+    // Identification and comment headers (RFC 7845 section 5)
+    QByteArray head("OpusHead");
+    head.append(char(1));                      // Version
+    head.append(char(1));                      // Channels
+    char word[4];
+    qToLittleEndian<quint16>(quint16(preSkip), word);
+    head.append(word, 2);
+    qToLittleEndian<quint32>(quint32(sampleRate), word);
+    head.append(word, 4);
+    head.append(2, '\0');                      // Output gain
+    head.append(char(0));                      // Mapping family: mono/stereo
+
+    const QByteArray vendor = "HeadUnit";
+    QByteArray tags("OpusTags");
+    qToLittleEndian<quint32>(quint32(vendor.size()), word);
+    tags.append(word, 4);
+    tags.append(vendor);
+    tags.append(4, '\0');                      // No user comments
+
+    QByteArray out = oggPage({ head }, 0, serial, 0, kOggBos);
+    out.append(oggPage({ tags }, 0, serial, 1, 0));
+    quint32 sequence = 2;
+
+    // The decoder's output lags by the lookahead, so encode that much
+    // silence past the end; the final granule position trims it off again
+    const qint64 encodeSamples = samples + lookahead;
+    QVector<opus_int16> frame(frameSamples);
+    unsigned char packet[kMaxPacketBytes];
+    QList<QByteArray> pagePackets;
+    int pageSegments = 0;
+
+    for (qint64 pos = 0; pos < encodeSamples; pos += frameSamples) {
+        const qint64 available = qBound<qint64>(0, samples - pos, frameSamples);
+        std::fill(frame.begin(), frame.end(), 0);
+        if (available > 0)
+            std::memcpy(frame.data(), pcm.constData() + pos * sizeof(opus_int16),
+                        size_t(available) * sizeof(opus_int16));
+
+        const int length = opus_encode(encoder, frame.constData(), frameSamples, packet, kMaxPacketBytes);
+        if (length < 0) {
+            qWarning() << "AudioCodec: opus_encode failed:" << opus_strerror(length);
+            opus_encoder_destroy(encoder);
+            return QByteArray();
+        }
+        pagePackets.append(QByteArray(reinterpret_cast<const char *>(packet), length));
+        pageSegments += length / 255 + 1;
+
+        const bool last = pos + frameSamples >= encodeSamples;
+        if (last || pagePackets.size() >= kPacketsPerPage || pageSegments > kMaxPageSegments - 8) {
+            // Granule: 48 kHz samples decoded by the end of the page, pre-skip
+            // included; on the last page, where the real audio ends
+            const qint64 granule = last ? preSkip + samples * scale : (pos + frameSamples) * scale;
+            out.append(oggPage(pagePackets, granule, serial, sequence++, last ? kOggEos : 0));
+            pagePackets.clear();
+            pageSegments = 0;
+        }
+    }
+
+    opus_encoder_destroy(encoder);
+    return out;
+#else
+    Q_UNUSED(pcm);
+    Q_UNUSED(sampleRate);
+    Q_UNUSED(bitrate);
+    return QByteArray();
+#endif
+}
+
+QByteArray AudioCodec::decodeOggOpus(const QByteArray &ogg, int sampleRate)
+{
+#if HAS_OPUS
+    if (kOpusRate % sampleRate != 0) return QByteArray();
+
+    qint64 lastGranule = -1;
+    const QList<QByteArray> packets = oggPackets(ogg, &lastGranule);
+    if (packets.size() < 2 || !packets[0].startsWith("OpusHead") || packets[0].size() < 19) {
+        qWarning() << "AudioCodec: Not an Ogg Opus stream";
+        return QByteArray();
+    }
+
+    const QByteArray &head = packets[0];
+    const int channels = quint8(head[9]);
+    const int preSkip = qFromLittleEndian<quint16>(head.constData() + 10);
+    if (channels < 1 || channels > 2) {
+        qWarning() << "AudioCodec: Unsupported channel count" << channels;
+        return QByteArray();
+    }
+
+    int err = OPUS_OK;
+    OpusDecoder *decoder = opus_decoder_create(sampleRate, channels, &err);
+    if (err != OPUS_OK) {
+        qWarning() << "AudioCodec: opus_decoder_create failed:" << opus_strerror(err);
+        return QByteArray();
+    }
+
+    const int scale = kOpusRate / sampleRate;
+    const int maxFrame = sampleRate * 120 / 1000;   // Longest Opus packet
+    QVector<opus_int16> decoded(maxFrame * channels);
+    QByteArray pcm;
+
+    // packets[1] is OpusTags
+    for (int i = 2; i < packets.size(); ++i) {
+        const QByteArray &packet = packets[i];
+        const int frames = opus_decode(decoder, reinterpret_cast<const unsigned char *>(packet.constData()),
+                                       packet.size(), decoded.data(), maxFrame, 0);
+        if (frames < 0) {
+            qWarning() << "AudioCodec: opus_decode failed:" << opus_strerror(frames);
+            opus_decoder_destroy(decoder);
+            return QByteArray();
+        }
+        if (channels == 2) {
+            for (int f = 0; f < frames; ++f)
+                decoded[f] = opus_int16((int(decoded[2 * f]) + int(decoded[2 * f + 1])) / 2);
+        }
+        pcm.append(reinterpret_cast<const char *>(decoded.constData()), frames * int(sizeof(opus_int16)));
+    }
+    opus_decoder_destroy(decoder);
+
+    // Drop the encoder's lookahead from the start and the padding from the end
+    const qint64 skipBytes = qint64(preSkip / scale) * qint64(sizeof(opus_int16));
+    qint64 lengthBytes = pcm.size() - skipBytes;
+    if (lastGranule >= preSkip)
+        lengthBytes = qMin(lengthBytes, (lastGranule - preSkip) / scale * qint64(sizeof(opus_int16)));
+    if (lengthBytes <= 0) return QByteArray();
+    return pcm.mid(skipBytes, lengthBytes);
+#else
+    Q_UNUSED(ogg);
+    Q_UNUSED(sampleRate);
+    return QByteArray();
+#endif
+}
+
+// ============================================================================
+// AudioCodecThread
+// ============================================================================
+
+AudioCodecThread::AudioCodecThread(QObject *parent)
+    : QThread(parent)
+{
+}
+
+AudioCodecThread::~AudioCodecThread()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    wait();
+}
+
+quint64 AudioCodecThread::submit(Job job, const QByteArray &data, int sampleRate)
+{
+    const quint64 id = m_nextId++;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_tasks.append(Task { id, job, data, sampleRate });
+        m_wake.wakeOne();
+    }
+    if (!isRunning()) start();
+    return id;
+}
+
+void AudioCodecThread::run()
+{
+    forever {
+        Task task;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (m_tasks.isEmpty() && !m_stopping)
+                m_wake.wait(&m_mutex);
+            if (m_stopping) return;
+            task = m_tasks.takeFirst();
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const QByteArray result = task.job == Job::EncodeOpus
+            ? AudioCodec::encodeOggOpus(task.data, task.sampleRate)
+            : AudioCodec::decodeOggOpus(task.data, task.sampleRate);
+        emit done(task.id, result, timer.nsecsElapsed() / 1000);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef AUDIOCODEC_H
+#define AUDIOCODEC_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+
+// libopus is optional - without it the speech APIs stay on LINEAR16
+#if __has_include(<opus.h>)
+#define HAS_OPUS 1
+#else
+#define HAS_OPUS 0
+#endif
+
+// Ogg Opus (RFC 7845) encode and decode of 16-bit mono PCM, for the speech
+// APIs: GoogleSTT uploads OGG_OPUS instead of LINEAR16, and GoogleTTS asks
+// for OGG_OPUS and decodes it for QAudioSink. At the 24 kbit/s used here
+// speech is about a tenth of the size, which is what matters on a weak
+// rural LTE uplink; recognition accuracy is unaffected at this rate.
+//
+// Opus comes from libopus; the Ogg framing is done here, it is only a few
+// page headers.
+namespace AudioCodec {
+
+constexpr int kOpusBitrate = 24000;
+constexpr int kFrameMs = 20;
+
+inline bool isAvailable() { return HAS_OPUS; }
+
+// pcm: little-endian int16 mono at sampleRate (8, 12, 16, 24 or 48 kHz).
+// Empty on failure.
+QByteArray encodeOggOpus(const QByteArray &pcm, int sampleRate, int bitrate = kOpusBitrate);
+
+// Decodes an Ogg Opus stream to int16 mono at sampleRate (any of the rates
+// above), trimmed to the original length. Empty on failure.
+QByteArray decodeOggOpus(const QByteArray &ogg, int sampleRate);
+
+// Ogg framing, exposed for the benchmark
+QByteArray oggPage(const QList<QByteArray> &packets, qint64 granule, quint32 serial,
+                   quint32 sequence, quint8 flags);
+QList<QByteArray> oggPackets(const QByteArray &ogg, qint64 *lastGranule = nullptr);
+
+} // namespace AudioCodec
+
+// Runs encodes and decodes off the GUI thread. submit() queues a job and
+// returns its id; done() is emitted from the worker with the result (empty
+// on failure), so receivers get it queued on their own thread. Jobs run in
+// order; nothing is cancelled - a caller that lost interest ignores the id.
+class AudioCodecThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum class Job { EncodeOpus, DecodeOpus };
+
+    explicit AudioCodecThread(QObject *parent = nullptr);
+    ~AudioCodecThread();
+
+    quint64 submit(Job job, const QByteArray &data, int sampleRate);
+
+signals:
+    void done(quint64 id, const QByteArray &result, qint64 elapsedUs);
+
+protected:
+    void run() override;
+
+private:
+    struct Task {
+        quint64 id = 0;
+        Job job = Job::EncodeOpus;
+        QByteArray data;
+        int sampleRate = 0;
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QList<Task> m_tasks;
+    bool m_stopping = false;
+    std::atomic<quint64> m_nextId { 1 };
+};
+
+#endif // AUDIOCODEC_H
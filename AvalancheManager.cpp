@@ -1,6 +1,9 @@
 #include "AvalancheManager.h"
 #include "ContextAggregator.h"
+#include "RefreshScheduler.h"
+#include "Route.h"
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrlQuery>
@@ -9,49 +12,49 @@
 
 AvalancheManager::AvalancheManager(QObject *parent)
     : QObject(parent)
-    , m_network(new QNetworkAccessManager(this))
-    , m_refreshTimer(new QTimer(this))
 {
-    connect(m_network, &QNetworkAccessManager::finished,
-            this, &AvalancheManager::onForecastReply);
-
-    // Refresh avalanche forecasts every 30 minutes
-    m_refreshTimer->setInterval(30 * 60 * 1000);
-    connect(m_refreshTimer, &QTimer::timeout, this, &AvalancheManager::refreshForecasts);
-
     qDebug() << "AvalancheManager: Initialized";
 }
 
 void AvalancheManager::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+void AvalancheManager::setFeedFetcher(FeedFetcher *fetcher) { m_fetcher = fetcher; }
+
+void AvalancheManager::setRefreshScheduler(RefreshScheduler *scheduler)
+{
+    m_scheduler = scheduler;
+    // Refresh avalanche forecasts every 30 minutes
+    m_refreshTask = scheduler->add("avalanche", 30 * 60 * 1000, this, [this]() { refreshForecasts(); });
+}
 
-void AvalancheManager::setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent)
+void AvalancheManager::setRoute(const std::shared_ptr<const Route> &route, bool silent)
 {
-    if (coordinates.size() < 2) {
+    if (!route) {
         clearRoute();
         return;
     }
 
     m_suppressNextAlert = silent;
-    ++m_generation;
-    sampleMountainPoints(coordinates, durationSec);
+    ++m_routeGeneration;
+    sampleMountainPoints(*route);
 
     m_active = true;
     emit activeChanged();
 
-    fetchForecasts();
+    // The points are new, so every forecast has to be parsed again
+    fetchForecasts(FeedFetcher::NeedBody);
 
-    m_refreshTimer->start();
+    if (m_scheduler) m_scheduler->start(m_refreshTask);
     qDebug() << "AvalancheManager: Tracking" << m_points.size() << "points along route";
 }
 
 void AvalancheManager::clearRoute()
 {
-    ++m_generation;
+    ++m_routeGeneration;
     m_active = false;
     m_points.clear();
     m_summary.clear();
     m_highestDanger.clear();
-    m_refreshTimer->stop();
+    if (m_scheduler) m_scheduler->stop(m_refreshTask);
     emit activeChanged();
     emit summaryChanged();
 
@@ -64,38 +67,37 @@ void AvalancheManager::clearRoute()
     qDebug() << "AvalancheManager: Route cleared";
 }
 
-void AvalancheManager::sampleMountainPoints(const QJsonArray &coordinates, double durationSec)
+void AvalancheManager::sampleMountainPoints(const Route &route)
 {
     m_points.clear();
 
-    int numCoords = coordinates.size();
-    // Sample 8 evenly-spaced points along the route (including start and end)
-    int numSamples = qMin(8, numCoords);
-    if (numSamples < 2) numSamples = 2;
-
-    for (int i = 0; i < numSamples; ++i) {
-        double fraction = (numSamples == 1) ? 0.0 : static_cast<double>(i) / (numSamples - 1);
-        int idx = qMin(static_cast<int>(fraction * (numCoords - 1)), numCoords - 1);
+    // Every stop on the trip (a ski hill, a trailhead) plus fill so no two
+    // points are further apart than on kRoutePoints evenly spaced ones
+    const RouteSampler &sampler = route.sampler();
+    const QVector<RouteSampler::Sample> samples =
+        sampler.anchored(sampler.waypointKms(), route.totalKm() / (kRoutePoints - 1));
 
-        QJsonArray coord = coordinates[idx].toArray();
-        if (coord.size() < 2) continue;
+    for (int i = 0; i < samples.size(); ++i) {
+        const RouteSampler::Sample &s = samples[i];
 
         ForecastPoint pt;
-        pt.lon = coord[0].toDouble();
-        pt.lat = coord[1].toDouble();
-
-        double etaHours = (durationSec * fraction) / 3600.0;
+        pt.lat = s.lat;
+        pt.lon = s.lon;
+        pt.alongKm = s.alongKm;
 
         if (i == 0) pt.locationLabel = "Start";
-        else if (i == numSamples - 1) pt.locationLabel = "Destination";
-        else pt.locationLabel = QString("%1h ahead").arg(etaHours, 0, 'f', 1);
+        else if (i == samples.size() - 1) pt.locationLabel = "Destination";
+        else if (s.anchor >= 0) pt.locationLabel = QString("Stop %1").arg(s.anchor + 1);
+        else pt.locationLabel = QString("%1h ahead").arg(s.etaSec / 3600.0, 0, 'f', 1);
 
         m_points.append(pt);
     }
 }
 
-void AvalancheManager::fetchForecasts()
+void AvalancheManager::fetchForecasts(FeedFetcher::Mode mode)
 {
+    if (!m_fetcher) return;
+
     ++m_generation;
     m_pendingRequests = m_points.size();
 
@@ -108,48 +110,49 @@ void AvalancheManager::fetchForecasts()
 
         QUrl requestUrl(url);
         QNetworkRequest req(requestUrl);
-        req.setAttribute(QNetworkRequest::User, i);
-        req.setAttribute(QNetworkRequest::UserMax, m_generation);
-        m_network->get(req);
+        m_fetcher->get("avalanche/forecast", req, this,
+                       [this, i, route = m_routeGeneration, gen = m_generation](const FeedFetcher::Result &result) {
+            // Replies for a previous route's points are discarded; the new
+            // route fetches with NeedBody, so their saved validators can't
+            // hide a forecast. An overlapping refresh of the same points
+            // still lands, since the fetcher has already saved its validators.
+            if (route == m_routeGeneration) onForecastReply(i, result, gen == m_generation);
+        }, mode);
     }
 }
 
-void AvalancheManager::onForecastReply(QNetworkReply *reply)
+void AvalancheManager::onForecastReply(int idx, const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    // Discard stale replies from a previous route
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
-        return;
-    }
-
-    int idx = reply->request().attribute(QNetworkRequest::User).toInt();
     if (idx < 0 || idx >= m_points.size()) return;
 
     auto &pt = m_points[idx];
 
-    if (reply->error() != QNetworkReply::NoError) {
+    if (!result.ok()) {
         // 404 means no forecast zone for this point (non-mountain area) — expected
-        if (reply->error() == QNetworkReply::ContentNotFoundError) {
+        if (result.error == QNetworkReply::ContentNotFoundError) {
             qDebug() << "AvalancheManager: No forecast zone for point" << idx
                      << "(lat:" << pt.lat << "lon:" << pt.lon << ")";
         } else {
-            qWarning() << "AvalancheManager: Forecast fetch failed for point" << idx << reply->errorString();
+            qWarning() << "AvalancheManager: Forecast fetch failed for point" << idx << result.errorString;
         }
         pt.hasForecast = false;
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) buildSummary();
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    if (result.unchanged) {
+        // Same forecast as last time — keep what this point already holds
+        replyDone(current);
+        return;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonObject root = doc.object();
     QJsonObject report = root["report"].toObject();
 
     if (report.isEmpty()) {
         pt.hasForecast = false;
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) buildSummary();
+        replyDone(current);
         return;
     }
 
@@ -183,10 +186,14 @@ void AvalancheManager::onForecastReply(QNetworkReply *reply)
         pt.highlights = highlights.remove(htmlTags).simplified();
     }
 
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) {
-        buildSummary();
-    }
+    replyDone(current);
+}
+
+void AvalancheManager::replyDone(bool current)
+{
+    // Only the latest fetch counts toward completion
+    if (current) m_pendingRequests--;
+    if (m_pendingRequests <= 0) buildSummary();
 }
 
 void AvalancheManager::buildSummary()
@@ -204,6 +211,7 @@ void AvalancheManager::buildSummary()
         if (m_context) {
             m_context->setAvalancheSummary(QString());
         }
+        if (m_scheduler) m_scheduler->clearUpcoming(m_refreshTask);
         qDebug() << "AvalancheManager: No avalanche forecast zones along route";
         return;
     }
@@ -220,6 +228,16 @@ void AvalancheManager::buildSummary()
     }
     m_highestDanger = dangerLevelName(highest);
 
+    // Considerable or worse ahead: refresh more often on the approach
+    if (m_scheduler) {
+        QVector<double> dangerKms;
+        for (const auto *pt : active) {
+            if (qMax(pt->dangerAlpine, qMax(pt->dangerTreeline, pt->dangerBelowTree)) >= 3)
+                dangerKms.append(pt->alongKm);
+        }
+        m_scheduler->setUpcoming(m_refreshTask, dangerKms, "avalanche danger");
+    }
+
     // Build summary text
     QString summary;
     for (const auto *pt : active) {
@@ -268,7 +286,7 @@ void AvalancheManager::refreshForecasts()
 {
     if (!m_active || m_points.isEmpty()) return;
     qDebug() << "AvalancheManager: Refreshing forecasts";
-    fetchForecasts();
+    fetchForecasts(FeedFetcher::AllowUnchanged);
 }
 
 QString AvalancheManager::dangerLevelName(int level) const
@@ -3,12 +3,13 @@
 
 #include <QObject>
 #include <QString>
-#include <QJsonArray>
-#include <QTimer>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <memory>
+
+#include "FeedFetcher.h"
 
 class ContextAggregator;
+class RefreshScheduler;
+class Route;
 
 class AvalancheManager : public QObject
 {
@@ -21,13 +22,17 @@ public:
     explicit AvalancheManager(QObject *parent = nullptr);
 
     void setContextAggregator(ContextAggregator *ctx);
+    void setFeedFetcher(FeedFetcher *fetcher);
+    void setRefreshScheduler(RefreshScheduler *scheduler);
 
     bool active() const { return m_active; }
     QString summary() const { return m_summary; }
     QString highestDanger() const { return m_highestDanger; }
 
+    // From RouteLoader::routeChanged. silent suppresses the first alert.
+    void setRoute(const std::shared_ptr<const Route> &route, bool silent = false);
+
 public slots:
-    void setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent = false);
     void clearRoute();
 
 signals:
@@ -36,13 +41,13 @@ signals:
     void alertDetected(const QString &message);
 
 private slots:
-    void onForecastReply(QNetworkReply *reply);
     void refreshForecasts();
 
 private:
     struct ForecastPoint {
         double lat = 0.0;
         double lon = 0.0;
+        double alongKm = 0.0;
         QString locationLabel;
         int dangerAlpine = 0;    // 1-5
         int dangerTreeline = 0;
@@ -51,13 +56,16 @@ private:
         bool hasForecast = false;
     };
 
-    void sampleMountainPoints(const QJsonArray &coordinates, double durationSec);
-    void fetchForecasts();
+    void sampleMountainPoints(const Route &route);
+    void fetchForecasts(FeedFetcher::Mode mode);
+    void onForecastReply(int idx, const FeedFetcher::Result &result, bool current);
+    void replyDone(bool current);
     void buildSummary();
     QString dangerLevelName(int level) const;
 
-    QNetworkAccessManager *m_network;
-    QTimer *m_refreshTimer;
+    FeedFetcher *m_fetcher = nullptr;
+    RefreshScheduler *m_scheduler = nullptr;
+    int m_refreshTask = -1;
     ContextAggregator *m_context = nullptr;
 
     bool m_active = false;
@@ -66,11 +74,14 @@ private:
 
     QList<ForecastPoint> m_points;
     int m_pendingRequests = 0;
-    int m_generation = 0;
+    int m_generation = 0;       // Bumped per fetch
+    int m_routeGeneration = 0;  // Bumped when the points change
 
     // Change detection — only emit alertDetected when danger level changes
     int m_lastHighestDanger = 0;
     bool m_suppressNextAlert = false;
+
+    static constexpr int kRoutePoints = 8;   // Start and end included, before stops
 };
 
 #endif // AVALANCHEMANAGER_H
@@ -1,32 +1,71 @@
 #include "BorderWaitManager.h"
 #include "ContextAggregator.h"
-#include "GeoUtils.h"
+#include "RefreshScheduler.h"
+#include "Route.h"
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QRegularExpression>
 #include <QUrlQuery>
 #include <QtMath>
 
+namespace {
+
+const QString kLayer = QStringLiteral("borderWaits");
+
+// Wait times go stale fast; don't report one the agencies haven't
+// refreshed recently
+constexpr qint64 kMaxWaitAgeMs = 30 * 60 * 1000;
+
+} // namespace
+
 BorderWaitManager::BorderWaitManager(QObject *parent)
     : QObject(parent)
-    , m_cbpNetwork(new QNetworkAccessManager(this))
-    , m_cbsaNetwork(new QNetworkAccessManager(this))
-    , m_refreshTimer(new QTimer(this))
 {
-    connect(m_cbpNetwork, &QNetworkAccessManager::finished,
-            this, &BorderWaitManager::onCbpReply);
-    connect(m_cbsaNetwork, &QNetworkAccessManager::finished,
-            this, &BorderWaitManager::onCbsaReply);
+    qDebug() << "BorderWaitManager: Initialized";
+}
 
+void BorderWaitManager::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+void BorderWaitManager::setSpatialTileCache(SpatialTileCache *cache) { m_cache = cache; }
+void BorderWaitManager::setFeedFetcher(FeedFetcher *fetcher) { m_fetcher = fetcher; }
+
+void BorderWaitManager::setRefreshScheduler(RefreshScheduler *scheduler)
+{
+    m_scheduler = scheduler;
     // Refresh every 10 minutes
-    m_refreshTimer->setInterval(10 * 60 * 1000);
-    connect(m_refreshTimer, &QTimer::timeout, this, &BorderWaitManager::fetchWaitTimes);
+    m_refreshTask = scheduler->add("borderWaits", 10 * 60 * 1000, this, [this]() { fetchWaitTimes(); });
+}
 
-    qDebug() << "BorderWaitManager: Initialized";
+SpatialTileCache::Feature BorderWaitManager::toFeature(const QString &id, const WaitTimeData &data)
+{
+    SpatialTileCache::Feature f;
+    f.id = id;
+    f.lat = data.lat;
+    f.lon = data.lon;
+    f.data = {
+        { "crossingName", data.crossingName },
+        { "commercialMinutes", data.commercialMinutes },
+        { "passengerMinutes", data.passengerMinutes },
+        { "lanesOpen", data.lanesOpen },
+        { "lastUpdated", data.lastUpdated },
+    };
+    return f;
 }
 
-void BorderWaitManager::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+BorderWaitManager::WaitTimeData BorderWaitManager::fromFeature(const SpatialTileCache::Feature &f)
+{
+    WaitTimeData data;
+    data.lat = f.lat;
+    data.lon = f.lon;
+    data.source = f.source;
+    data.crossingName = f.data.value("crossingName").toString();
+    data.commercialMinutes = f.data.value("commercialMinutes", -1).toInt();
+    data.passengerMinutes = f.data.value("passengerMinutes", -1).toInt();
+    data.lanesOpen = f.data.value("lanesOpen").toInt();
+    data.lastUpdated = f.data.value("lastUpdated").toString();
+    return data;
+}
 
 QList<BorderWaitManager::KnownCrossing> BorderWaitManager::knownCrossings()
 {
@@ -50,18 +89,16 @@ QList<BorderWaitManager::KnownCrossing> BorderWaitManager::knownCrossings()
     return crossings;
 }
 
-void BorderWaitManager::setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent)
+void BorderWaitManager::setRoute(const std::shared_ptr<const Route> &route, bool silent)
 {
-    Q_UNUSED(durationSec)
-
-    if (coordinates.size() < 2) {
+    if (!route) {
         clearRoute();
         return;
     }
 
     m_suppressNextAlert = silent;
     ++m_generation;
-    sampleRoutePoints(coordinates);
+    m_route = route;
 
     if (!isNearBorder()) {
         if (m_active) {
@@ -75,22 +112,25 @@ void BorderWaitManager::setRouteCoordinates(const QJsonArray &coordinates, doubl
     m_active = true;
     emit activeChanged();
 
+    // Answer from the cache straight away; the fetch refreshes it
+    if (m_cache && m_cache->size(kLayer) > 0) processResults();
+
     fetchWaitTimes();
-    m_refreshTimer->start();
+    if (m_scheduler) m_scheduler->start(m_refreshTask);
 
-    qDebug() << "BorderWaitManager: Tracking route with" << m_routePoints.size() << "sample points near border";
+    qDebug() << "BorderWaitManager: Tracking" << m_route->totalKm() << "km route near border";
 }
 
 void BorderWaitManager::clearRoute()
 {
     ++m_generation;
     m_active = false;
-    m_routePoints.clear();
+    m_route.reset();
     m_waitData.clear();
     m_summary.clear();
     m_nearestCrossing.clear();
     m_waitMinutes = -1;
-    m_refreshTimer->stop();
+    if (m_scheduler) m_scheduler->stop(m_refreshTask);
     emit activeChanged();
     emit summaryChanged();
 
@@ -103,33 +143,14 @@ void BorderWaitManager::clearRoute()
     qDebug() << "BorderWaitManager: Route cleared";
 }
 
-void BorderWaitManager::sampleRoutePoints(const QJsonArray &coordinates)
-{
-    m_routePoints.clear();
-    int numCoords = coordinates.size();
-    // Sample ~20 points along the route for proximity checks
-    int numSamples = qMin(20, numCoords);
-    if (numSamples < 2) numSamples = 2;
-
-    for (int i = 0; i < numSamples; ++i) {
-        double fraction = static_cast<double>(i) / (numSamples - 1);
-        int idx = qMin(static_cast<int>(fraction * (numCoords - 1)), numCoords - 1);
-
-        QJsonArray coord = coordinates[idx].toArray();
-        if (coord.size() >= 2) {
-            m_routePoints.append({ coord[1].toDouble(), coord[0].toDouble() }); // lat, lon
-        }
-    }
-}
-
 bool BorderWaitManager::isNearBorder() const
 {
+    if (!m_route) return false;
+
     const auto crossings = knownCrossings();
-    for (const auto &pt : m_routePoints) {
-        for (const auto &cx : crossings) {
-            if (GeoUtils::haversineKm(pt.lat, pt.lon, cx.lat, cx.lon) < 50.0) {
-                return true;
-            }
+    for (const auto &cx : crossings) {
+        if (m_route->index()->isWithin(cx.lat, cx.lon, 50.0)) {
+            return true;
         }
     }
     return false;
@@ -137,8 +158,8 @@ bool BorderWaitManager::isNearBorder() const
 
 void BorderWaitManager::fetchWaitTimes()
 {
+    if (!m_fetcher) return;
     ++m_generation;
-    m_waitData.clear();
     m_pendingRequests = 0;
 
     // US CBP — JSON wait times
@@ -146,39 +167,40 @@ void BorderWaitManager::fetchWaitTimes()
     QUrl cbpUrl("https://bwt.cbp.gov/api/waittimes");
     QNetworkRequest cbpReq(cbpUrl);
     cbpReq.setRawHeader("Accept", "application/json");
-    cbpReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_cbpNetwork->get(cbpReq);
+    m_fetcher->get("borderWaits/CBP", cbpReq, this, [this, gen = m_generation](const FeedFetcher::Result &r) {
+        onCbpReply(r, gen == m_generation);
+    });
 
     // CBSA — CSV wait times
     m_pendingRequests++;
     QUrl cbsaUrl("https://www.cbsa-asfc.gc.ca/bwt-taf/bwt-eng.csv");
     QNetworkRequest cbsaReq(cbsaUrl);
-    cbsaReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_cbsaNetwork->get(cbsaReq);
+    m_fetcher->get("borderWaits/CBSA", cbsaReq, this, [this, gen = m_generation](const FeedFetcher::Result &r) {
+        onCbsaReply(r, gen == m_generation);
+    });
 
     qDebug() << "BorderWaitManager: Fetching wait times from CBP and CBSA";
 }
 
-void BorderWaitManager::onCbpReply(QNetworkReply *reply)
+void BorderWaitManager::onCbpReply(const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    // Discard stale replies from a previous route
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "BorderWaitManager: CBP fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "BorderWaitManager: CBP fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processResults();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "CBP");
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonArray entries = doc.array();
 
     const auto crossings = knownCrossings();
+    QList<SpatialTileCache::Feature> snapshot;
 
     for (const QJsonValue &v : entries) {
         QJsonObject obj = v.toObject();
@@ -214,36 +236,35 @@ void BorderWaitManager::onCbpReply(QNetworkReply *reply)
 
         data.lanesOpen = commLanes + passLanes;
 
-        m_waitData.append(data);
+        snapshot.append(toFeature(QString("cbp-%1").arg(portNumber), data));
     }
 
     qDebug() << "BorderWaitManager: CBP returned" << entries.size() << "entries,"
-             << "matched" << m_waitData.size() << "known crossings";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processResults();
+             << "matched" << snapshot.size() << "known crossings";
+    // An unparseable body isn't an empty feed; keep what the cache has
+    if (m_cache && doc.isArray()) m_cache->syncSource(kLayer, "CBP", snapshot);
+    replyDone(current);
 }
 
-void BorderWaitManager::onCbsaReply(QNetworkReply *reply)
+void BorderWaitManager::onCbsaReply(const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    // Discard stale replies from a previous route
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "BorderWaitManager: CBSA fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "BorderWaitManager: CBSA fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processResults();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "CBSA");
+        replyDone(current);
         return;
     }
 
-    QString csv = QString::fromUtf8(reply->readAll());
+    QString csv = QString::fromUtf8(result.body);
     QStringList lines = csv.split('\n', Qt::SkipEmptyParts);
 
     const auto crossings = knownCrossings();
-    int matchCount = 0;
+    QList<SpatialTileCache::Feature> snapshot;
 
     // Skip header row
     for (int i = 1; i < lines.size(); ++i) {
@@ -266,16 +287,6 @@ void BorderWaitManager::onCbsaReply(QNetworkReply *reply)
         }
         if (!matched) continue;
 
-        // Check if we already have CBP data for this crossing — skip duplicate
-        bool alreadyHave = false;
-        for (const auto &existing : m_waitData) {
-            if (existing.crossingName == matched->name) {
-                alreadyHave = true;
-                break;
-            }
-        }
-        if (alreadyHave) continue;
-
         WaitTimeData data;
         data.crossingName = matched->name;
         data.lat = matched->lat;
@@ -297,48 +308,74 @@ void BorderWaitManager::onCbsaReply(QNetworkReply *reply)
         data.commercialMinutes = parseMinutes(commercialFlow);
         data.passengerMinutes = parseMinutes(travellerFlow);
 
-        m_waitData.append(data);
-        matchCount++;
+        snapshot.append(toFeature("cbsa-" + matched->name, data));
     }
 
     qDebug() << "BorderWaitManager: CBSA returned" << lines.size() - 1 << "rows,"
-             << "matched" << matchCount << "known crossings";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processResults();
+             << "matched" << snapshot.size() << "known crossings";
+    // A body without even the header row isn't an empty feed
+    if (m_cache && !lines.isEmpty()) m_cache->syncSource(kLayer, "CBSA", snapshot);
+    replyDone(current);
+}
+
+void BorderWaitManager::replyDone(bool current)
+{
+    // Superseded replies still land in the cache, since their validators are
+    // already saved; only the current fetch counts toward completion.
+    if (current) m_pendingRequests--;
+    if (m_pendingRequests <= 0 && m_active) processResults();
 }
 
 void BorderWaitManager::processResults()
 {
-    // Filter wait data to crossings near the route (within 50km of any route point)
+    // Wait data for crossings near the route (within 50km of the route line),
+    // in route order, and the nearest one
     QList<WaitTimeData> nearRoute;
-    for (const auto &wd : m_waitData) {
-        for (const auto &pt : m_routePoints) {
-            if (GeoUtils::haversineKm(wd.lat, wd.lon, pt.lat, pt.lon) < 50.0) {
-                nearRoute.append(wd);
+    QList<double> distances;
+    m_nearestCrossing.clear();
+    m_waitMinutes = -1;
+
+    QList<SpatialTileCache::Hit> hits;
+    if (m_cache && m_route)
+        hits = m_cache->nearRoute(kLayer, m_route->index(), 50.0, kMaxWaitAgeMs);
+
+    QVector<double> crossingKms;
+    for (const auto &hit : hits) {
+        const WaitTimeData wd = fromFeature(hit.feature);
+
+        // Both agencies report some crossings — CBP's numbers win
+        int existing = -1;
+        for (int i = 0; i < nearRoute.size(); ++i) {
+            if (nearRoute[i].crossingName == wd.crossingName) {
+                existing = i;
                 break;
             }
         }
+        if (existing < 0) {
+            nearRoute.append(wd);
+            distances.append(hit.match.distanceKm);
+            crossingKms.append(hit.match.alongKm);
+        } else if (wd.source == "CBP") {
+            nearRoute[existing] = wd;
+        }
     }
 
-    // Find the nearest crossing to any route point
     double minDist = 999999.0;
-    m_nearestCrossing.clear();
-    m_waitMinutes = -1;
-
-    for (const auto &wd : nearRoute) {
-        for (const auto &pt : m_routePoints) {
-            double dist = GeoUtils::haversineKm(wd.lat, wd.lon, pt.lat, pt.lon);
-            if (dist < minDist) {
-                minDist = dist;
-                m_nearestCrossing = wd.crossingName;
-                // Use passenger wait time as the primary metric, fall back to commercial
-                m_waitMinutes = (wd.passengerMinutes >= 0) ? wd.passengerMinutes : wd.commercialMinutes;
-            }
+    for (int i = 0; i < nearRoute.size(); ++i) {
+        if (distances[i] < minDist) {
+            minDist = distances[i];
+            m_nearestCrossing = nearRoute[i].crossingName;
+            // Use passenger wait time as the primary metric, fall back to commercial
+            m_waitMinutes = (nearRoute[i].passengerMinutes >= 0) ? nearRoute[i].passengerMinutes
+                                                                 : nearRoute[i].commercialMinutes;
         }
     }
 
     m_waitData = nearRoute;
 
+    // Wait times matter most on the approach to a crossing
+    if (m_scheduler) m_scheduler->setUpcoming(m_refreshTask, crossingKms, "border crossing");
+
     qDebug() << "BorderWaitManager:" << nearRoute.size() << "crossings near route,"
              << "nearest:" << m_nearestCrossing << "wait:" << m_waitMinutes << "min";
 
@@ -3,12 +3,14 @@
 
 #include <QObject>
 #include <QString>
-#include <QJsonArray>
-#include <QTimer>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <memory>
+
+#include "FeedFetcher.h"
+#include "SpatialTileCache.h"
 
 class ContextAggregator;
+class RefreshScheduler;
+class Route;
 
 class BorderWaitManager : public QObject
 {
@@ -22,14 +24,19 @@ public:
     explicit BorderWaitManager(QObject *parent = nullptr);
 
     void setContextAggregator(ContextAggregator *ctx);
+    void setSpatialTileCache(SpatialTileCache *cache);
+    void setFeedFetcher(FeedFetcher *fetcher);
+    void setRefreshScheduler(RefreshScheduler *scheduler);
 
     bool active() const { return m_active; }
     QString summary() const { return m_summary; }
     QString nearestCrossing() const { return m_nearestCrossing; }
     int waitMinutes() const { return m_waitMinutes; }
 
+    // From RouteLoader::routeChanged. silent suppresses the first alert.
+    void setRoute(const std::shared_ptr<const Route> &route, bool silent = false);
+
 public slots:
-    void setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent = false);
     void clearRoute();
 
 signals:
@@ -39,8 +46,6 @@ signals:
 
 private slots:
     void fetchWaitTimes();
-    void onCbpReply(QNetworkReply *reply);
-    void onCbsaReply(QNetworkReply *reply);
 
 private:
     struct KnownCrossing {
@@ -61,27 +66,31 @@ private:
         QString source;
     };
 
-    struct RoutePoint { double lat = 0.0; double lon = 0.0; };
+    void onCbpReply(const FeedFetcher::Result &result, bool current);
+    void onCbsaReply(const FeedFetcher::Result &result, bool current);
+    void replyDone(bool current);
+    static SpatialTileCache::Feature toFeature(const QString &id, const WaitTimeData &data);
+    static WaitTimeData fromFeature(const SpatialTileCache::Feature &f);
 
     void processResults();
     void buildSummary();
-    void sampleRoutePoints(const QJsonArray &coordinates);
     bool isNearBorder() const;
 
     static QList<KnownCrossing> knownCrossings();
 
-    QNetworkAccessManager *m_cbpNetwork;
-    QNetworkAccessManager *m_cbsaNetwork;
-    QTimer *m_refreshTimer;
     ContextAggregator *m_context = nullptr;
+    SpatialTileCache *m_cache = nullptr;
+    FeedFetcher *m_fetcher = nullptr;
+    RefreshScheduler *m_scheduler = nullptr;
+    int m_refreshTask = -1;
 
     bool m_active = false;
     QString m_summary;
     QString m_nearestCrossing;
     int m_waitMinutes = -1;
 
-    QList<WaitTimeData> m_waitData;
-    QList<RoutePoint> m_routePoints;
+    QList<WaitTimeData> m_waitData;   // Crossings near the route
+    std::shared_ptr<const Route> m_route;
     int m_pendingRequests = 0;
     int m_generation = 0;
 
@@ -0,0 +1,205 @@
+#include "CanBusReader.h"
+#include "CanFrameLog.h"
+#include "TelemetryHistory.h"
+#include "TelemetryLog.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <time.h>
+
+CanBusReader::CanBusReader(int socket, DecodeFn decode, TelemetryHistory *history, QObject *parent)
+    : QThread(parent)
+    , m_socket(socket)
+    , m_decode(decode)
+    , m_history(history)
+{
+    // Ask the kernel to report receive-queue overflows as ancillary data,
+    // so we can count frames dropped before we had a chance to read them.
+    int enable = 1;
+    if (setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) < 0) {
+        qWarning() << "CanBusReader: SO_RXQ_OVFL not supported, drop counter disabled";
+    }
+
+    // Kernel receive timestamps for capture logs
+    if (setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMP, &enable, sizeof(enable)) < 0) {
+        qWarning() << "CanBusReader: SO_TIMESTAMP not supported, capture uses read time";
+    }
+}
+
+CanBusReader::~CanBusReader()
+{
+    stop();
+}
+
+void CanBusReader::stop()
+{
+    if (!isRunning()) return;
+    requestInterruption();
+    wait();
+}
+
+void CanBusReader::setRecorder(CanLogWriter *recorder)
+{
+    QMutexLocker lock(&m_recorderMutex);
+    m_recorder = recorder;
+}
+
+void CanBusReader::setDataLogger(TelemetryLogWriter *logger)
+{
+    QMutexLocker lock(&m_mutex);
+    m_logger = logger;
+}
+
+void CanBusReader::takeSnapshot(VehicleState &out)
+{
+    QMutexLocker lock(&m_mutex);
+    QVector<VehicleTuneAck> acks = std::move(m_shared.tuneAcks);
+    m_shared.tuneAcks.clear();
+    out = m_shared;
+    out.tuneAcks = std::move(acks);
+    m_shared.dirty = 0;
+    m_notifyPending.store(false, std::memory_order_release);
+}
+
+void CanBusReader::run()
+{
+    // Preallocated batch buffers — nothing is allocated per frame
+    struct canfd_frame frames[kBatchSize];
+    struct iovec iov[kBatchSize];
+    struct mmsghdr msgs[kBatchSize];
+    quint64 frameUs[kBatchSize];
+    bool valid[kBatchSize];
+    alignas(struct cmsghdr) char control[kBatchSize][CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(struct timeval))];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < kBatchSize; ++i) {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i];
+    }
+
+    struct pollfd pfd;
+    pfd.fd = m_socket;
+    pfd.events = POLLIN;
+
+    qDebug() << "CanBusReader: Started (batch size" << kBatchSize << ")";
+
+    while (!isInterruptionRequested()) {
+        // Short timeout so stop() is honoured promptly
+        int ready = poll(&pfd, 1, 100);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            qWarning() << "CanBusReader: poll failed:" << strerror(errno);
+            m_readErrors.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        if (ready == 0) continue;
+
+        bool decoded = false;
+
+        // Drain everything queued before handing control back to poll()
+        for (;;) {
+            for (int i = 0; i < kBatchSize; ++i)
+                msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+
+            int n = recvmmsg(m_socket, msgs, kBatchSize, MSG_DONTWAIT, nullptr);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    qWarning() << "CanBusReader: Read error:" << strerror(errno);
+                    m_readErrors.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+            if (n == 0) break;
+
+            quint64 accepted = 0;
+            uint32_t kernelDrops = m_lastKernelDrops;
+
+            // Fallback capture timestamp when the kernel doesn't supply one
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            const quint64 batchUs = quint64(ts.tv_sec) * 1000000ULL + quint64(ts.tv_nsec) / 1000ULL;
+
+            // Ancillary data and frame filtering, no lock needed
+            for (int i = 0; i < n; ++i) {
+                const struct msghdr &hdr = msgs[i].msg_hdr;
+                frameUs[i] = batchUs;
+                for (struct cmsghdr *c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(const_cast<struct msghdr *>(&hdr), c)) {
+                    if (c->cmsg_level != SOL_SOCKET) continue;
+                    if (c->cmsg_type == SO_RXQ_OVFL) {
+                        memcpy(&kernelDrops, CMSG_DATA(c), sizeof(kernelDrops));
+                    } else if (c->cmsg_type == SCM_TIMESTAMP) {
+                        struct timeval tv;
+                        memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+                        frameUs[i] = quint64(tv.tv_sec) * 1000000ULL + quint64(tv.tv_usec);
+                    }
+                }
+                valid[i] = (msgs[i].msg_len == CAN_MTU || msgs[i].msg_len == CANFD_MTU)
+                        && !(frames[i].can_id & (CAN_ERR_FLAG | CAN_RTR_FLAG));
+            }
+
+            // Capture first, outside the state lock: the recorder flushes to
+            // disk every 64 KB
+            {
+                QMutexLocker lock(&m_recorderMutex);
+                if (m_recorder) {
+                    for (int i = 0; i < n; ++i) {
+                        if (!valid[i]) continue;
+                        const struct canfd_frame &frame = frames[i];
+                        uint8_t flags = 0;
+                        if (msgs[i].msg_len == CANFD_MTU) {
+                            flags |= CanLogFrame::FlagFd;
+                            if (frame.flags & CANFD_BRS) flags |= CanLogFrame::FlagBrs;
+                            if (frame.flags & CANFD_ESI) flags |= CanLogFrame::FlagEsi;
+                        }
+                        m_recorder->append(frameUs[i], frame.can_id, flags, frame.data, frame.len);
+                    }
+                }
+            }
+
+            {
+                QMutexLocker lock(&m_mutex);
+
+                const uint32_t historyMs = m_history ? m_history->nowMs() : 0;
+                const uint32_t loggerMs = m_logger ? m_logger->nowMs() : 0;
+
+                for (int i = 0; i < n; ++i) {
+                    if (!valid[i]) continue;
+                    const struct canfd_frame &frame = frames[i];
+
+                    uint32_t groups = m_decode(m_shared, frame.can_id & CAN_EFF_MASK, frame.data, frame.len);
+                    if (groups && m_history) m_history->record(m_shared, groups, historyMs);
+                    if (groups && m_logger) m_logger->record(m_shared, groups, loggerMs);
+                    ++accepted;
+                }
+            }
+
+            m_framesReceived.fetch_add(accepted, std::memory_order_relaxed);
+            m_batches.fetch_add(1, std::memory_order_relaxed);
+            if (kernelDrops != m_lastKernelDrops) {
+                m_framesDropped.fetch_add(kernelDrops - m_lastKernelDrops, std::memory_order_relaxed);
+                m_lastKernelDrops = kernelDrops;
+            }
+            decoded = decoded || accepted > 0;
+
+            if (n < kBatchSize) break;
+        }
+
+        // One wakeup for the GUI thread per pending snapshot, however many
+        // batches land before it gets around to taking it
+        if (decoded && !m_notifyPending.exchange(true, std::memory_order_acq_rel))
+            emit snapshotReady();
+    }
+
+    qDebug() << "CanBusReader: Stopped after" << framesReceived() << "frames";
+}
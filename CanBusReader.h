@@ -0,0 +1,81 @@
+#ifndef CANBUSREADER_H
+#define CANBUSREADER_H
+
+#include <QThread>
+#include <QMutex>
+#include <atomic>
+
+#include "VehicleState.h"
+
+class CanLogWriter;
+class TelemetryHistory;
+class TelemetryLogWriter;
+
+// Dedicated SocketCAN reader thread.
+//
+// Drains the socket in batches with recvmmsg(), decodes each frame into a
+// shared VehicleState under one lock per batch, and signals the GUI thread
+// at most once per pending snapshot. The GUI side calls takeSnapshot() to
+// collect everything accumulated since the previous call.
+class CanBusReader : public QThread
+{
+    Q_OBJECT
+
+public:
+    // Returns the VehicleGroup bits the frame touched
+    using DecodeFn = uint32_t (*)(VehicleState &state, uint32_t canId, const uint8_t *data, uint8_t len);
+
+    static constexpr int kBatchSize = 32;
+
+    // history (optional) receives every decoded sample on the reader thread
+    CanBusReader(int socket, DecodeFn decode, TelemetryHistory *history, QObject *parent = nullptr);
+    ~CanBusReader() override;
+
+    void stop();
+
+    // Optional capture sink — every accepted frame is appended on the reader
+    // thread. Pass nullptr to detach; returns once no append is in flight.
+    void setRecorder(CanLogWriter *recorder);
+
+    // Optional session datalogger, same contract as setRecorder()
+    void setDataLogger(TelemetryLogWriter *logger);
+
+    // Copies the accumulated state into out (including queued tune ACKs and
+    // dirty group bits), then clears the dirty set. GUI thread only.
+    void takeSnapshot(VehicleState &out);
+
+    // Counters — safe to read from any thread
+    quint64 framesReceived() const { return m_framesReceived.load(std::memory_order_relaxed); }
+    quint64 framesDropped() const { return m_framesDropped.load(std::memory_order_relaxed); }
+    quint64 readErrors() const { return m_readErrors.load(std::memory_order_relaxed); }
+    quint64 batches() const { return m_batches.load(std::memory_order_relaxed); }
+
+signals:
+    void snapshotReady();  // Emitted from the reader thread; connect queued
+
+protected:
+    void run() override;
+
+private:
+    int m_socket;
+    DecodeFn m_decode;
+    TelemetryHistory *m_history;
+
+    QMutex m_mutex;
+    VehicleState m_shared;  // Guarded by m_mutex
+    // Its own lock: the recorder writes to disk, and takeSnapshot() must
+    // never wait on storage
+    QMutex m_recorderMutex;
+    CanLogWriter *m_recorder = nullptr;  // Guarded by m_recorderMutex
+    TelemetryLogWriter *m_logger = nullptr;  // Guarded by m_mutex
+    std::atomic<bool> m_notifyPending{false};
+
+    uint32_t m_lastKernelDrops = 0;  // SO_RXQ_OVFL is cumulative per socket
+
+    std::atomic<quint64> m_framesReceived{0};
+    std::atomic<quint64> m_framesDropped{0};
+    std::atomic<quint64> m_readErrors{0};
+    std::atomic<quint64> m_batches{0};
+};
+
+#endif // CANBUSREADER_H
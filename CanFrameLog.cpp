@@ -0,0 +1,339 @@
+#include "CanFrameLog.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QtEndian>
+#include <cstring>
+
+#include <linux/can.h>
+
+namespace {
+
+const char kMagic[8] = { 'H', 'U', 'C', 'A', 'N', 'L', 'O', 'G' };
+constexpr quint32 kVersion = 1;
+constexpr int kHeaderSize = 12;
+constexpr int kRecordHeaderSize = 14;
+
+void appendRecord(QByteArray &out, quint64 timestampUs, uint32_t canId, uint8_t flags,
+                  const uint8_t *data, uint8_t len)
+{
+    char hdr[kRecordHeaderSize];
+    qToLittleEndian<quint64>(timestampUs, hdr);
+    qToLittleEndian<quint32>(canId, hdr + 8);
+    hdr[12] = static_cast<char>(flags);
+    hdr[13] = static_cast<char>(len);
+    out.append(hdr, kRecordHeaderSize);
+    out.append(reinterpret_cast<const char *>(data), len);
+}
+
+int hexNibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+// ============================================================================
+// CanLogWriter
+// ============================================================================
+
+CanLogWriter::~CanLogWriter()
+{
+    close();
+}
+
+bool CanLogWriter::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "CanLogWriter: Cannot open" << path << ":" << m_file.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize];
+    memcpy(header, kMagic, sizeof(kMagic));
+    qToLittleEndian<quint32>(kVersion, header + 8);
+    m_file.write(header, kHeaderSize);
+
+    m_buffer.clear();
+    m_buffer.reserve(kFlushThreshold + kRecordHeaderSize + 64);
+    m_framesWritten = 0;
+    return true;
+}
+
+void CanLogWriter::close()
+{
+    if (!m_file.isOpen()) return;
+    flush();
+    m_file.close();
+}
+
+void CanLogWriter::append(quint64 timestampUs, uint32_t canId, uint8_t flags, const uint8_t *data, uint8_t len)
+{
+    if (!m_file.isOpen()) return;
+    if (len > 64) len = 64;
+    appendRecord(m_buffer, timestampUs, canId, flags, data, len);
+    ++m_framesWritten;
+    if (m_buffer.size() >= kFlushThreshold) flush();
+}
+
+void CanLogWriter::append(const CanLogFrame &frame)
+{
+    append(frame.timestampUs, frame.canId, frame.flags, frame.data, frame.len);
+}
+
+void CanLogWriter::flush()
+{
+    if (m_buffer.isEmpty() || !m_file.isOpen()) return;
+    if (m_file.write(m_buffer) != m_buffer.size()) {
+        qWarning() << "CanLogWriter: Write failed:" << m_file.errorString();
+    }
+    m_buffer.clear();
+}
+
+// ============================================================================
+// CanLogReader
+// ============================================================================
+
+bool CanLogReader::open(const QString &path)
+{
+    close();
+
+    if (CanFrameLog::isCandumpPath(path)) {
+        QFile text(path);
+        if (!text.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qWarning() << "CanLogReader: Cannot open" << path << ":" << text.errorString();
+            return false;
+        }
+        CanLogFrame frame;
+        while (!text.atEnd()) {
+            QByteArray line = text.readLine();
+            if (CanFrameLog::parseCandumpLine(line, frame))
+                appendRecord(m_converted, frame.timestampUs, frame.canId, frame.flags, frame.data, frame.len);
+        }
+        m_data = reinterpret_cast<const uchar *>(m_converted.constData());
+        m_size = m_converted.size();
+        m_offset = 0;
+        return true;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "CanLogReader: Cannot open" << path << ":" << m_file.errorString();
+        return false;
+    }
+    if (m_file.size() < kHeaderSize) {
+        qWarning() << "CanLogReader:" << path << "is too short to be a CAN log";
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_file.size());
+    if (!m_data || memcmp(m_data, kMagic, sizeof(kMagic)) != 0) {
+        qWarning() << "CanLogReader:" << path << "is not a HUCANLOG file";
+        close();
+        return false;
+    }
+    quint32 version = qFromLittleEndian<quint32>(m_data + 8);
+    if (version != kVersion) {
+        qWarning() << "CanLogReader: Unsupported log version" << version;
+        close();
+        return false;
+    }
+
+    // Skip past the header so both formats start at the first record
+    m_data += kHeaderSize;
+    m_size = m_file.size() - kHeaderSize;
+    m_offset = 0;
+    return true;
+}
+
+void CanLogReader::close()
+{
+    if (m_file.isOpen()) m_file.close();  // Also unmaps
+    m_converted.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_offset = 0;
+}
+
+bool CanLogReader::next(CanLogFrame &frame)
+{
+    if (!m_data || m_offset + kRecordHeaderSize > m_size) return false;
+
+    const uchar *p = m_data + m_offset;
+    uint8_t len = p[13];
+    if (len > 64 || m_offset + kRecordHeaderSize + len > m_size) {
+        qWarning() << "CanLogReader: Truncated record at offset" << m_offset;
+        m_offset = m_size;
+        return false;
+    }
+
+    frame.timestampUs = qFromLittleEndian<quint64>(p);
+    frame.canId = qFromLittleEndian<quint32>(p + 8);
+    frame.flags = p[12];
+    frame.len = len;
+    memcpy(frame.data, p + kRecordHeaderSize, len);
+    m_offset += kRecordHeaderSize + len;
+    return true;
+}
+
+void CanLogReader::rewind()
+{
+    m_offset = 0;
+}
+
+double CanLogReader::progress() const
+{
+    return m_size > 0 ? static_cast<double>(m_offset) / m_size : 0.0;
+}
+
+// ============================================================================
+// candump text format
+// ============================================================================
+
+namespace CanFrameLog {
+
+bool isCandumpPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "log" || suffix == "txt" || suffix == "candump";
+}
+
+bool parseCandumpLine(const QByteArray &line, CanLogFrame &frame)
+{
+    // (seconds.micros) iface id#data
+    QByteArray trimmed = line.trimmed();
+    if (!trimmed.startsWith('(')) return false;
+
+    int closeParen = trimmed.indexOf(')');
+    if (closeParen < 0) return false;
+    QByteArray stamp = trimmed.mid(1, closeParen - 1);
+    int dot = stamp.indexOf('.');
+    bool ok = false;
+    quint64 secs = stamp.left(dot < 0 ? stamp.size() : dot).toULongLong(&ok);
+    if (!ok) return false;
+    quint64 micros = 0;
+    if (dot >= 0) {
+        QByteArray frac = stamp.mid(dot + 1).left(6);
+        while (frac.size() < 6) frac.append('0');
+        micros = frac.toULongLong(&ok);
+        if (!ok) return false;
+    }
+
+    // Skip the interface name — the frame token is the last field
+    int space = trimmed.lastIndexOf(' ');
+    if (space < 0) return false;
+    QByteArray token = trimmed.mid(space + 1);
+
+    int hash = token.indexOf('#');
+    if (hash <= 0) return false;
+
+    QByteArray idText = token.left(hash);
+    uint32_t canId = idText.toUInt(&ok, 16);
+    if (!ok) return false;
+    if (idText.size() > 3) canId |= CAN_EFF_FLAG;
+
+    const char *p = token.constData() + hash + 1;
+    const char *end = token.constData() + token.size();
+    uint8_t flags = 0;
+
+    if (p < end && *p == 'R') return false;  // Remote frames carry no data
+    if (p < end && *p == '#') {
+        // CAN FD: "##<flags nibble><data>"
+        ++p;
+        if (p >= end) return false;
+        int fdFlags = hexNibble(*p++);
+        if (fdFlags < 0) return false;
+        flags |= CanLogFrame::FlagFd;
+        if (fdFlags & CANFD_BRS) flags |= CanLogFrame::FlagBrs;
+        if (fdFlags & CANFD_ESI) flags |= CanLogFrame::FlagEsi;
+    }
+
+    uint8_t len = 0;
+    while (p + 1 < end && len < 64) {
+        if (*p == '.') { ++p; continue; }  // candump allows '.' separators
+        int hi = hexNibble(p[0]);
+        int lo = hexNibble(p[1]);
+        if (hi < 0 || lo < 0) return false;
+        frame.data[len++] = static_cast<uint8_t>((hi << 4) | lo);
+        p += 2;
+    }
+
+    frame.timestampUs = secs * 1000000ULL + micros;
+    frame.canId = canId;
+    frame.flags = flags;
+    frame.len = len;
+    return true;
+}
+
+QByteArray formatCandumpLine(const CanLogFrame &frame, const QString &iface)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    QByteArray line;
+    line.reserve(48 + frame.len * 2);
+    line += '(';
+    line += QByteArray::number(frame.timestampUs / 1000000ULL);
+    line += '.';
+    line += QByteArray::number(frame.timestampUs % 1000000ULL).rightJustified(6, '0');
+    line += ") ";
+    line += iface.toLatin1();
+    line += ' ';
+
+    if (frame.canId & CAN_EFF_FLAG)
+        line += QByteArray::number(frame.canId & CAN_EFF_MASK, 16).toUpper().rightJustified(8, '0');
+    else
+        line += QByteArray::number(frame.canId & CAN_SFF_MASK, 16).toUpper().rightJustified(3, '0');
+
+    line += '#';
+    if (frame.flags & CanLogFrame::FlagFd) {
+        int fdFlags = 0;
+        if (frame.flags & CanLogFrame::FlagBrs) fdFlags |= CANFD_BRS;
+        if (frame.flags & CanLogFrame::FlagEsi) fdFlags |= CANFD_ESI;
+        line += '#';
+        line += hex[fdFlags & 0xF];
+    }
+    for (int i = 0; i < frame.len; ++i) {
+        line += hex[frame.data[i] >> 4];
+        line += hex[frame.data[i] & 0xF];
+    }
+    line += '\n';
+    return line;
+}
+
+qint64 convert(const QString &inPath, const QString &outPath, const QString &iface)
+{
+    CanLogReader reader;
+    if (!reader.open(inPath)) return -1;
+
+    qint64 count = 0;
+    CanLogFrame frame;
+
+    if (isCandumpPath(outPath)) {
+        QFile out(outPath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            qWarning() << "CanFrameLog: Cannot open" << outPath << ":" << out.errorString();
+            return -1;
+        }
+        while (reader.next(frame)) {
+            out.write(formatCandumpLine(frame, iface));
+            ++count;
+        }
+    } else {
+        CanLogWriter writer;
+        if (!writer.open(outPath)) return -1;
+        while (reader.next(frame)) {
+            writer.append(frame);
+            ++count;
+        }
+    }
+
+    qDebug() << "CanFrameLog: Converted" << count << "frames" << inPath << "->" << outPath;
+    return count;
+}
+
+} // namespace CanFrameLog
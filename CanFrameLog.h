@@ -0,0 +1,99 @@
+#ifndef CANFRAMELOG_H
+#define CANFRAMELOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <cstdint>
+
+// CAN capture log — compact binary format plus candump text import/export.
+//
+// Binary layout (little-endian):
+//   header:  "HUCANLOG" (8 bytes), uint32 version
+//   record:  uint64 timestamp_us, uint32 can_id, uint8 flags, uint8 len, data[len]
+//
+// can_id keeps the Linux flag bits (CAN_EFF_FLAG etc). Records are variable
+// length, so a classic 8-byte frame costs 22 bytes on disk.
+
+struct CanLogFrame {
+    enum Flags : uint8_t {
+        FlagFd  = 1u << 0,  // CAN FD frame
+        FlagBrs = 1u << 1,  // Bit rate switch
+        FlagEsi = 1u << 2,  // Error state indicator
+    };
+
+    quint64 timestampUs = 0;
+    uint32_t canId = 0;
+    uint8_t flags = 0;
+    uint8_t len = 0;
+    uint8_t data[64] = {};
+};
+
+// Buffered append-only writer. Not thread-safe — the caller serializes
+// append() (CanBusReader calls it under m_recorderMutex).
+class CanLogWriter
+{
+public:
+    CanLogWriter() = default;
+    ~CanLogWriter();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    void append(quint64 timestampUs, uint32_t canId, uint8_t flags, const uint8_t *data, uint8_t len);
+    void append(const CanLogFrame &frame);
+    void flush();
+
+    quint64 framesWritten() const { return m_framesWritten; }
+
+private:
+    static constexpr int kFlushThreshold = 64 * 1024;
+
+    QFile m_file;
+    QByteArray m_buffer;
+    quint64 m_framesWritten = 0;
+};
+
+// Sequential reader over a binary log (memory-mapped) or a candump text log
+// (converted to the binary record form in memory on open).
+class CanLogReader
+{
+public:
+    CanLogReader() = default;
+
+    bool open(const QString &path);
+    void close();
+
+    bool next(CanLogFrame &frame);
+    void rewind();
+
+    // 0.0 – 1.0 through the record stream
+    double progress() const;
+
+private:
+    QFile m_file;
+    QByteArray m_converted;          // candump logs only
+    const uchar *m_data = nullptr;   // mapped file or m_converted
+    qint64 m_size = 0;
+    qint64 m_offset = 0;
+};
+
+namespace CanFrameLog {
+
+// Format is chosen by extension: .log/.txt/.candump are candump text,
+// anything else is the binary format.
+bool isCandumpPath(const QString &path);
+
+// Parses one candump line: "(1700000000.123456) can0 123#DEADBEEF"
+// or CAN FD "(…) can0 123##1DEADBEEF".
+bool parseCandumpLine(const QByteArray &line, CanLogFrame &frame);
+QByteArray formatCandumpLine(const CanLogFrame &frame, const QString &iface);
+
+// Converts between formats (by extension). Returns the number of frames
+// converted, or -1 on error.
+qint64 convert(const QString &inPath, const QString &outPath, const QString &iface = "can0");
+
+} // namespace CanFrameLog
+
+#endif // CANFRAMELOG_H
@@ -0,0 +1,178 @@
+#include "CanTxScheduler.h"
+#include <QDebug>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/socket.h>
+
+CanTxScheduler::CanTxScheduler(int socket, QObject *parent)
+    : QObject(parent)
+    , m_socket(socket)
+    , m_retryTimer(new QTimer(this))
+{
+    for (int i = 0; i < kPoolSize; ++i)
+        m_freeList[i] = static_cast<uint8_t>(kPoolSize - 1 - i);
+    m_freeCount = kPoolSize;
+
+    m_retryTimer->setSingleShot(true);
+    m_retryTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_retryTimer, &QTimer::timeout, this, &CanTxScheduler::flush);
+}
+
+bool CanTxScheduler::send(Priority priority, uint32_t canId, const void *data, uint8_t len)
+{
+    if (len > CANFD_MAX_DLEN) {
+        qWarning() << "CanTxScheduler: Frame 0x" << Qt::hex << canId << "too long:" << Qt::dec << len;
+        ++m_dropped;
+        return false;
+    }
+
+    // Latest-wins for periodic traffic: overwrite a still-queued frame with
+    // the same ID rather than sending stale data first
+    int slot = -1;
+    if (priority != Safety) {
+        Queue &queue = m_queues[priority];
+        for (int i = 0; i < queue.count; ++i) {
+            if (m_pool[queue.at(i)].frame.can_id == canId) {
+                slot = queue.at(i);
+                break;
+            }
+        }
+    }
+
+    const bool replacing = slot >= 0;
+    if (!replacing) {
+        slot = allocSlot(priority);
+        if (slot < 0) {
+            qWarning() << "CanTxScheduler: TX pool full, dropping 0x" << Qt::hex << canId;
+            ++m_dropped;
+            return false;
+        }
+    }
+
+    Slot &s = m_pool[slot];
+    s.frame.can_id = canId;
+    s.frame.len = len;
+    s.frame.flags = len > CAN_MAX_DLEN ? CANFD_BRS : 0;  // Bit rate switch for FD data phase
+    s.frame.__res0 = 0;
+    s.frame.__res1 = 0;
+    memcpy(s.frame.data, data, len);
+    s.mtu = len > CAN_MAX_DLEN ? CANFD_MTU : CAN_MTU;
+    s.attempts = 0;
+
+    if (!replacing) {
+        m_queues[priority].push(static_cast<uint8_t>(slot));
+        ++m_queued;
+    }
+
+    // While backing off the kernel queue is known to be full; the retry
+    // timer will pick this frame up in priority order
+    if (!m_retryTimer->isActive()) flush();
+    return true;
+}
+
+int CanTxScheduler::pending() const
+{
+    int total = 0;
+    for (const Queue &queue : m_queues) total += queue.count;
+    return total;
+}
+
+int CanTxScheduler::allocSlot(Priority priority)
+{
+    if (m_freeCount == 0) {
+        // Evict the oldest frame of the lowest class below this one
+        for (int p = PriorityCount - 1; p > priority; --p) {
+            if (m_queues[p].count > 0) {
+                dropFront(p);
+                break;
+            }
+        }
+    }
+    if (m_freeCount == 0) return -1;
+    return m_freeList[--m_freeCount];
+}
+
+void CanTxScheduler::releaseSlot(uint8_t slot)
+{
+    m_freeList[m_freeCount++] = slot;
+}
+
+void CanTxScheduler::dropFront(int priority)
+{
+    uint8_t slot = m_queues[priority].pop();
+    qWarning() << "CanTxScheduler: Dropped 0x" << Qt::hex << m_pool[slot].frame.can_id
+               << Qt::dec << "after" << m_pool[slot].attempts << "attempts";
+    releaseSlot(slot);
+    ++m_dropped;
+}
+
+void CanTxScheduler::scheduleRetry()
+{
+    m_retryTimer->start(m_backoffMs);
+    m_backoffMs = qMin(m_backoffMs * 2, 32);
+}
+
+void CanTxScheduler::flush()
+{
+    struct mmsghdr msgs[kBatchSize];
+    struct iovec iov[kBatchSize];
+    int gathered[PriorityCount];
+
+    while (pending() > 0) {
+        // Gather up to kBatchSize frames, highest priority first
+        int count = 0;
+        for (int p = 0; p < PriorityCount; ++p) {
+            Queue &queue = m_queues[p];
+            gathered[p] = 0;
+            for (int i = 0; i < queue.count && count < kBatchSize; ++i) {
+                Slot &s = m_pool[queue.at(i)];
+                iov[count].iov_base = &s.frame;
+                iov[count].iov_len = s.mtu;
+                memset(&msgs[count], 0, sizeof(msgs[count]));
+                msgs[count].msg_hdr.msg_iov = &iov[count];
+                msgs[count].msg_hdr.msg_iovlen = 1;
+                ++count;
+                ++gathered[p];
+            }
+        }
+
+        int sent = sendmmsg(m_socket, msgs, count, MSG_DONTWAIT);
+        int sendErrno = errno;
+
+        // Sent frames leave the queues in the order they were gathered
+        int remaining = qMax(sent, 0);
+        m_sent += remaining;
+        for (int p = 0; p < PriorityCount && remaining > 0; ++p) {
+            int n = qMin(gathered[p], remaining);
+            for (int i = 0; i < n; ++i) releaseSlot(m_queues[p].pop());
+            remaining -= n;
+        }
+
+        if (sent == count) {
+            m_backoffMs = 1;
+            continue;
+        }
+        if (sent > 0) continue;  // Partial batch — the next call reports the error
+
+        // Nothing sent: the first queued frame (highest priority) failed
+        int failPrio = 0;
+        while (m_queues[failPrio].count == 0) ++failPrio;
+        Slot &failed = m_pool[m_queues[failPrio].at(0)];
+
+        if (sendErrno == EAGAIN || sendErrno == EWOULDBLOCK || sendErrno == ENOBUFS) {
+            if (++failed.attempts >= kMaxAttempts) {
+                dropFront(failPrio);
+            } else {
+                ++m_retried;
+            }
+            if (pending() > 0) scheduleRetry();
+            return;
+        }
+        if (sendErrno == EINTR) continue;
+
+        qWarning() << "CanTxScheduler: Send failed for 0x" << Qt::hex << failed.frame.can_id
+                   << ":" << strerror(sendErrno);
+        dropFront(failPrio);
+    }
+}
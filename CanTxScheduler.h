@@ -0,0 +1,91 @@
+#ifndef CANTXSCHEDULER_H
+#define CANTXSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <cstdint>
+
+#include <linux/can.h>
+
+// Prioritized, non-blocking CAN transmit queue.
+//
+// Frames are copied into a fixed pool at enqueue time — nothing is allocated
+// per send. Each flush drains the queues in priority order with one
+// sendmmsg(MSG_DONTWAIT). When the kernel TX queue is full (EAGAIN/ENOBUFS)
+// the remaining frames stay queued and a backoff timer retries them; a
+// frame is dropped only after kMaxAttempts, or when the pool is full and
+// a higher-priority frame needs its slot.
+//
+// Lower-priority classes are latest-wins per CAN ID: a new GPS fix replaces
+// a queued stale one instead of queueing behind it.
+class CanTxScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Safety = 0,     // Drive mode, launch, traction, tune deltas, rollback
+        Heartbeat = 1,
+        Gps = 2,
+        PriorityCount
+    };
+
+    static constexpr int kPoolSize = 64;
+    static constexpr int kBatchSize = 16;
+    static constexpr int kMaxAttempts = 8;
+
+    explicit CanTxScheduler(int socket, QObject *parent = nullptr);
+
+    // Queues a frame and attempts to send immediately. Returns false if
+    // the frame was dropped.
+    bool send(Priority priority, uint32_t canId, const void *data, uint8_t len);
+
+    int pending() const;
+
+    quint64 framesQueued() const { return m_queued; }
+    quint64 framesSent() const { return m_sent; }
+    quint64 framesRetried() const { return m_retried; }
+    quint64 framesDropped() const { return m_dropped; }
+
+private slots:
+    void flush();
+
+private:
+    struct Slot {
+        struct canfd_frame frame;
+        uint8_t mtu;        // CAN_MTU or CANFD_MTU
+        uint8_t attempts;
+    };
+
+    // Fixed-capacity FIFO of pool indices
+    struct Queue {
+        uint8_t items[kPoolSize];
+        int head = 0;
+        int count = 0;
+
+        uint8_t &at(int i) { return items[(head + i) % kPoolSize]; }
+        void push(uint8_t slot) { items[(head + count) % kPoolSize] = slot; ++count; }
+        uint8_t pop() { uint8_t s = items[head]; head = (head + 1) % kPoolSize; --count; return s; }
+    };
+
+    int allocSlot(Priority priority);
+    void releaseSlot(uint8_t slot);
+    void dropFront(int priority);
+    void scheduleRetry();
+
+    int m_socket;
+    Slot m_pool[kPoolSize];
+    uint8_t m_freeList[kPoolSize];
+    int m_freeCount = 0;
+    Queue m_queues[PriorityCount];
+
+    QTimer *m_retryTimer;
+    int m_backoffMs = 1;
+
+    quint64 m_queued = 0;
+    quint64 m_sent = 0;
+    quint64 m_retried = 0;
+    quint64 m_dropped = 0;
+};
+
+#endif // CANTXSCHEDULER_H
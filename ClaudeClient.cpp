@@ -302,6 +302,7 @@ void ClaudeClient::fireApiRequest()
     qDebug() << "ClaudeClient: Sending request:" << requestData.left(300) << "...";
 
     m_streamBuffer.clear();
+    m_streamParser.reset();
     m_currentReply = m_networkManager->post(networkRequest, requestData);
 
     connect(m_currentReply, &QNetworkReply::readyRead,
@@ -319,6 +320,9 @@ void ClaudeClient::onNetworkReply(QNetworkReply *reply)
 
     m_safetyTimer->stop();
 
+    // Anything that arrived after the last readyRead
+    if (reply->bytesAvailable() > 0) onReadyRead();
+
     int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     QByteArray responseData = m_streamBuffer;
     m_streamBuffer.clear();
@@ -356,29 +360,52 @@ void ClaudeClient::onNetworkReply(QNetworkReply *reply)
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(responseData);
-    if (doc.isNull() || !doc.isObject()) {
-        m_isProcessing = false;
-        emit processingChanged();
-        emit error("Invalid JSON response");
+    // The rest of the last sentence goes out before the response is handled
+    m_streamParser.flush();
+    emitSentences();
 
-        sanitizeHistory();
+    QJsonObject json;
+    if (m_streamParser.isComplete()) {
+        json = m_streamParser.message();
+    } else {
+        // Not an event stream (a proxy that doesn't stream, say): a plain JSON reply
+        QJsonDocument doc = QJsonDocument::fromJson(responseData);
+        if (doc.isNull() || !doc.isObject()) {
+            m_isProcessing = false;
+            emit processingChanged();
+            emit error(responseData.contains("event:") ? "Incomplete response" : "Invalid JSON response");
 
-        reply->deleteLater();
-        m_currentReply = nullptr;
-        return;
+            sanitizeHistory();
+
+            reply->deleteLater();
+            m_currentReply = nullptr;
+            return;
+        }
+        json = doc.object();
     }
 
     reply->deleteLater();
     m_currentReply = nullptr;
 
-    parseResponse(doc.object());
+    parseResponse(json);
 }
 
 void ClaudeClient::onReadyRead()
 {
     if (!m_currentReply) return;
-    m_streamBuffer.append(m_currentReply->readAll());
+    const QByteArray data = m_currentReply->readAll();
+    m_streamBuffer.append(data);
+    m_streamParser.feed(data);
+    emitSentences();
+}
+
+void ClaudeClient::emitSentences()
+{
+    const QStringList sentences = m_streamParser.takeSentences();
+    for (const QString &sentence : sentences) {
+        qDebug() << "ClaudeClient: Sentence:" << sentence.left(100);
+        emit sentenceReady(sentence);
+    }
 }
 
 // ========================================================================
@@ -393,6 +420,7 @@ QJsonObject ClaudeClient::buildRequest(const QString &systemPrompt)
     request["temperature"] = m_temperature;
     request["system"] = systemPrompt;
     request["messages"] = m_conversationHistory;
+    request["stream"] = true;
 
     if (!m_availableTools.isEmpty()) {
         request["tools"] = m_availableTools;
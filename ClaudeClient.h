@@ -12,6 +12,8 @@
 #include <QTimer>
 #include <QMap>
 
+#include "ClaudeStreamParser.h"
+
 class ToolExecutor;
 
 /**
@@ -20,6 +22,10 @@ class ToolExecutor;
  * Handles communication with Anthropic's Claude API including native tool use.
  * When Claude returns tool_use blocks, ClaudeClient executes them via ToolExecutor,
  * submits tool_result messages back, and loops until Claude gives a final text response.
+ *
+ * Responses are streamed: each sentence is emitted (sentenceReady) as soon as it is
+ * complete, in every turn of the tool loop, so speech can start long before the
+ * final response is in.
  */
 class ClaudeClient : public QObject
 {
@@ -74,6 +80,13 @@ signals:
      */
     void responseReceived(const QString &response, const QJsonArray &toolCalls);
 
+    /**
+     * Emitted for each complete sentence while the response streams in, including
+     * text Claude says before calling tools. All of a response's sentences arrive
+     * before its responseReceived.
+     */
+    void sentenceReady(const QString &sentence);
+
     void error(const QString &message);
 
 private slots:
@@ -87,6 +100,9 @@ private:
     // Build system prompt
     QString buildSystemPrompt() const;
 
+    // Emit sentences the stream parser has completed
+    void emitSentences();
+
     // Parse API response — may trigger tool loop or emit final response
     void parseResponse(const QJsonObject &json);
 
@@ -128,7 +144,8 @@ private:
     QStringList m_contactNames;
 
     // Streaming
-    QByteArray m_streamBuffer;
+    QByteArray m_streamBuffer;      // Raw body, for error reporting
+    ClaudeStreamParser m_streamParser;
     QString m_currentResponse;
 
     // Pending user message (added to history only on successful response)
@@ -0,0 +1,235 @@
+#include "ClaudeStreamParser.h"
+#include <QDebug>
+#include <QJsonDocument>
+
+namespace {
+
+// Words that end in a period without ending the sentence
+bool isAbbreviationWord(const QString &word)
+{
+    static const QStringList words = {
+        "mr", "mrs", "ms", "dr", "st", "ave", "blvd", "rd", "hwy", "mt",
+        "jr", "sr", "vs", "etc", "approx", "no", "min", "hr", "hrs"
+    };
+    return words.contains(word.toLower());
+}
+
+bool isClosingMark(QChar c)
+{
+    return c == '"' || c == '\'' || c == ')' || c == QChar(0x201D) || c == QChar(0x2019);
+}
+
+} // namespace
+
+void ClaudeStreamParser::reset()
+{
+    m_lineBuffer.clear();
+    m_eventName.clear();
+    m_eventData.clear();
+    m_message = QJsonObject();
+    m_blocks.clear();
+    m_blockText.clear();
+    m_toolInputJson.clear();
+    m_stopReason.clear();
+    m_error = QJsonObject();
+    m_complete = false;
+    m_pendingText.clear();
+    m_scanFrom = 0;
+    m_sentences.clear();
+}
+
+// ========================================================================
+// SSE FRAMING
+// ========================================================================
+
+void ClaudeStreamParser::feed(const QByteArray &bytes)
+{
+    m_lineBuffer.append(bytes);
+
+    // Lines end in \n (or \r\n); a blank line dispatches the event. Bytes
+    // after the last newline wait for the next feed.
+    int start = 0;
+    for (int nl = m_lineBuffer.indexOf('\n'); nl >= 0; nl = m_lineBuffer.indexOf('\n', start)) {
+        QByteArray line = m_lineBuffer.mid(start, nl - start);
+        start = nl + 1;
+        if (line.endsWith('\r')) line.chop(1);
+
+        if (line.isEmpty()) {
+            if (!m_eventData.isEmpty()) handleEvent(m_eventName, m_eventData);
+            m_eventName.clear();
+            m_eventData.clear();
+            continue;
+        }
+        if (line.startsWith(':')) continue;   // Comment / keep-alive
+
+        const int colon = line.indexOf(':');
+        const QByteArray field = colon < 0 ? line : line.left(colon);
+        QByteArray value = colon < 0 ? QByteArray() : line.mid(colon + 1);
+        if (value.startsWith(' ')) value.remove(0, 1);
+
+        if (field == "event") {
+            m_eventName = value;
+        } else if (field == "data") {
+            if (!m_eventData.isEmpty()) m_eventData.append('\n');
+            m_eventData.append(value);
+        }
+    }
+    m_lineBuffer.remove(0, start);
+}
+
+// ========================================================================
+// MESSAGE REASSEMBLY
+// ========================================================================
+
+void ClaudeStreamParser::handleEvent(const QByteArray &event, const QByteArray &data)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(data);
+    if (!doc.isObject()) {
+        qWarning() << "ClaudeStreamParser: Ignoring unparseable" << event << "event:" << data.left(200);
+        return;
+    }
+    const QJsonObject json = doc.object();
+    const QString type = json["type"].toString(QString::fromUtf8(event));
+    const int index = json["index"].toInt();
+
+    if (type == "message_start") {
+        m_message = json["message"].toObject();
+    } else if (type == "content_block_start") {
+        const QJsonObject block = json["content_block"].toObject();
+        m_blocks[index] = block;
+        if (block["type"].toString() == "text") m_blockText[index] = block["text"].toString();
+        if (block["type"].toString() == "tool_use") m_toolInputJson[index] = QString();
+    } else if (type == "content_block_delta") {
+        const QJsonObject delta = json["delta"].toObject();
+        const QString deltaType = delta["type"].toString();
+        if (deltaType == "text_delta") {
+            const QString text = delta["text"].toString();
+            m_blockText[index] += text;
+            appendText(text);
+        } else if (deltaType == "input_json_delta") {
+            m_toolInputJson[index] += delta["partial_json"].toString();
+        }
+    } else if (type == "content_block_stop") {
+        // Text before a tool call is spoken while the tool runs
+        if (m_blocks.value(index)["type"].toString() == "text") flush();
+    } else if (type == "message_delta") {
+        const QString stopReason = json["delta"].toObject()["stop_reason"].toString();
+        if (!stopReason.isEmpty()) m_stopReason = stopReason;
+    } else if (type == "message_stop") {
+        m_complete = true;
+        flush();
+    } else if (type == "error") {
+        m_error = json["error"].toObject();
+        m_complete = true;
+    }
+    // ping and anything newer: nothing to do
+}
+
+QJsonObject ClaudeStreamParser::message() const
+{
+    if (!m_error.isEmpty()) {
+        QJsonObject result;
+        result["error"] = m_error;
+        return result;
+    }
+
+    QJsonArray content;
+    for (auto it = m_blocks.constBegin(); it != m_blocks.constEnd(); ++it) {
+        QJsonObject block = it.value();
+        const QString type = block["type"].toString();
+        if (type == "text") {
+            block["text"] = m_blockText.value(it.key());
+        } else if (type == "tool_use") {
+            // An empty input streams as no fragments at all
+            const QString inputJson = m_toolInputJson.value(it.key());
+            if (!inputJson.isEmpty()) {
+                const QJsonDocument input = QJsonDocument::fromJson(inputJson.toUtf8());
+                if (input.isObject()) {
+                    block["input"] = input.object();
+                } else {
+                    qWarning() << "ClaudeStreamParser: Bad tool input for" << block["name"].toString();
+                }
+            }
+        }
+        content.append(block);
+    }
+
+    QJsonObject result = m_message;
+    result["content"] = content;
+    if (!m_stopReason.isEmpty()) result["stop_reason"] = m_stopReason;
+    return result;
+}
+
+// ========================================================================
+// SENTENCES
+// ========================================================================
+
+QStringList ClaudeStreamParser::takeSentences()
+{
+    QStringList sentences;
+    sentences.swap(m_sentences);
+    return sentences;
+}
+
+void ClaudeStreamParser::flush()
+{
+    const QString rest = m_pendingText.trimmed();
+    if (!rest.isEmpty()) m_sentences.append(rest);
+    m_pendingText.clear();
+    m_scanFrom = 0;
+}
+
+void ClaudeStreamParser::appendText(const QString &text)
+{
+    m_pendingText += text;
+    splitSentences();
+}
+
+void ClaudeStreamParser::splitSentences()
+{
+    // A sentence ends at . ! or ? (plus any closing quote or bracket)
+    // followed by whitespace, or at a newline. Whether punctuation ends a
+    // sentence isn't known until the character after it has arrived.
+    int i = m_scanFrom;
+    while (i < m_pendingText.size()) {
+        const QChar c = m_pendingText[i];
+        int end = -1;
+
+        if (c == '\n') {
+            end = i;
+        } else if (c == '.' || c == '!' || c == '?') {
+            int next = i + 1;
+            while (next < m_pendingText.size() && isClosingMark(m_pendingText[next])) ++next;
+            if (next >= m_pendingText.size()) break;   // Decide when more arrives
+            if (m_pendingText[next].isSpace() && !(c == '.' && isAbbreviation(i))) end = next;
+        }
+
+        if (end < 0) {
+            ++i;
+            continue;
+        }
+
+        const QString sentence = m_pendingText.left(end).trimmed();
+        if (sentence.size() < MIN_SENTENCE_CHARS) {
+            ++i;   // Too short to say on its own; runs on into the next
+            continue;
+        }
+        m_sentences.append(sentence);
+        m_pendingText.remove(0, end);
+        i = 0;
+    }
+    m_scanFrom = i;
+}
+
+bool ClaudeStreamParser::isAbbreviation(int dotIndex) const
+{
+    int start = dotIndex;
+    while (start > 0 && m_pendingText[start - 1].isLetter()) --start;
+    const QString word = m_pendingText.mid(start, dotIndex - start);
+    if (word.isEmpty()) return false;
+
+    // Initials and dotted abbreviations (J. R., e.g., U.S.)
+    if (word.size() == 1) return true;
+    if (start > 0 && m_pendingText[start - 1] == '.') return true;
+    return isAbbreviationWord(word);
+}
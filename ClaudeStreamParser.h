@@ -0,0 +1,79 @@
+#ifndef CLAUDESTREAMPARSER_H
+#define CLAUDESTREAMPARSER_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * ClaudeStreamParser - incremental parser for a streamed Messages API reply
+ *
+ * Fed the raw server-sent-event bytes as they arrive (any split, including
+ * mid-line and mid-UTF-8 character), it rebuilds the same message object a
+ * non-streamed request returns, so ClaudeClient's response handling and
+ * tool loop stay as they are. Along the way, text is cut into sentences as
+ * soon as each one is complete, for TTS to start on while the rest is
+ * still being generated.
+ *
+ * Usage:
+ *   parser.feed(reply->readAll());
+ *   for (const QString &s : parser.takeSentences()) speak(s);
+ *   ...
+ *   parser.flush();                 // the unterminated tail, at the end
+ *   if (parser.isComplete()) handle(parser.message());
+ */
+class ClaudeStreamParser
+{
+public:
+    void reset();
+
+    // Parses every complete event in bytes plus what was left over
+    void feed(const QByteArray &bytes);
+
+    // message_stop (or an error event) has been seen
+    bool isComplete() const { return m_complete; }
+
+    // {"content": [...], "stop_reason": ...} as far as it has arrived, or
+    // {"error": {...}} if the stream reported one
+    QJsonObject message() const;
+
+    // Sentences completed since the last call, in order
+    QStringList takeSentences();
+
+    // Ends the current sentence wherever it is (end of a text block or of
+    // the response); it is returned by the next takeSentences()
+    void flush();
+
+    // Shorter sentences are held back and spoken with the next one
+    static constexpr int MIN_SENTENCE_CHARS = 12;
+
+private:
+    void handleEvent(const QByteArray &event, const QByteArray &data);
+    void appendText(const QString &text);
+    void splitSentences();
+    bool isAbbreviation(int dotIndex) const;
+
+    // SSE framing
+    QByteArray m_lineBuffer;
+    QByteArray m_eventName;
+    QByteArray m_eventData;
+
+    // Message reassembly
+    QJsonObject m_message;
+    QMap<int, QJsonObject> m_blocks;        // By content block index
+    QMap<int, QString> m_blockText;         // text_delta accumulated per block
+    QMap<int, QString> m_toolInputJson;     // input_json_delta fragments
+    QString m_stopReason;
+    QJsonObject m_error;
+    bool m_complete = false;
+
+    // Sentence splitting
+    QString m_pendingText;
+    int m_scanFrom = 0;                     // m_pendingText before this has no boundary
+    QStringList m_sentences;
+};
+
+#endif // CLAUDESTREAMPARSER_H
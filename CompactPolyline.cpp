@@ -0,0 +1,140 @@
+#include "CompactPolyline.h"
+#include "GeoUtils.h"
+
+namespace {
+
+constexpr double kE6 = 1e6;
+constexpr double kInvE6 = 1e-6;
+
+inline void writeVarint(QByteArray &out, qint32 v)
+{
+    quint32 u = (static_cast<quint32>(v) << 1) ^ static_cast<quint32>(v >> 31);
+    while (u >= 0x80) {
+        out.append(static_cast<char>(u | 0x80));
+        u >>= 7;
+    }
+    out.append(static_cast<char>(u));
+}
+
+// No bounds check — the stream is only ever written by fromCoordinates
+inline qint32 readVarint(const uchar *&p)
+{
+    quint32 u = *p++;
+    if (u >= 0x80) {
+        u &= 0x7f;
+        int shift = 7;
+        quint32 b;
+        do {
+            b = *p++;
+            u |= (b & 0x7f) << shift;
+            shift += 7;
+        } while (b >= 0x80);
+    }
+    return static_cast<qint32>(u >> 1) ^ -static_cast<qint32>(u & 1);
+}
+
+} // namespace
+
+CompactPolyline CompactPolyline::fromCoordinates(const double *lats, const double *lons, int n)
+{
+    CompactPolyline line;
+    line.m_size = qMax(n, 0);
+    line.m_anchors.reserve((line.m_size + kAnchorInterval - 1) / kAnchorInterval);
+    line.m_deltas.reserve(line.m_size * 4);
+
+    qint32 prevLat = 0, prevLon = 0;
+    for (int i = 0; i < line.m_size; ++i) {
+        const qint32 lat = static_cast<qint32>(qRound64(lats[i] * kE6));
+        const qint32 lon = static_cast<qint32>(qRound64(lons[i] * kE6));
+        if (i % kAnchorInterval == 0) {
+            line.m_anchors.append({ lat, lon, static_cast<qint32>(line.m_deltas.size()) });
+        } else {
+            writeVarint(line.m_deltas, lat - prevLat);
+            writeVarint(line.m_deltas, lon - prevLon);
+        }
+        prevLat = lat;
+        prevLon = lon;
+    }
+    line.m_deltas.squeeze();
+    return line;
+}
+
+CompactPolyline CompactPolyline::fromPolyline(const QByteArray &encoded, int precision, bool *ok)
+{
+    QVector<double> lats, lons;
+    const bool valid = GeoUtils::decodePolyline(encoded, precision, lats, lons);
+    if (ok) *ok = valid;
+    if (!valid) return CompactPolyline();
+    return fromCoordinates(lats.constData(), lons.constData(), lats.size());
+}
+
+std::pair<double, double> CompactPolyline::at(int i) const
+{
+    const Anchor &a = m_anchors[i / kAnchorInterval];
+    qint32 lat = a.lat, lon = a.lon;
+    const uchar *p = reinterpret_cast<const uchar *>(m_deltas.constData()) + a.offset;
+    for (int k = i % kAnchorInterval; k > 0; --k) {
+        lat += readVarint(p);
+        lon += readVarint(p);
+    }
+    return { lat * kInvE6, lon * kInvE6 };
+}
+
+CompactPolyline::Segment CompactPolyline::segment(int i) const
+{
+    const Anchor &a = m_anchors[i / kAnchorInterval];
+    qint32 lat = a.lat, lon = a.lon;
+    const uchar *p = reinterpret_cast<const uchar *>(m_deltas.constData()) + a.offset;
+    for (int k = i % kAnchorInterval; k > 0; --k) {
+        lat += readVarint(p);
+        lon += readVarint(p);
+    }
+
+    Segment s;
+    s.lat0 = lat * kInvE6;
+    s.lon0 = lon * kInvE6;
+    if ((i + 1) % kAnchorInterval == 0) {
+        // The next point starts a new block and is stored absolute
+        const Anchor &next = m_anchors[(i + 1) / kAnchorInterval];
+        lat = next.lat;
+        lon = next.lon;
+    } else {
+        lat += readVarint(p);
+        lon += readVarint(p);
+    }
+    s.lat1 = lat * kInvE6;
+    s.lon1 = lon * kInvE6;
+    return s;
+}
+
+void CompactPolyline::decode(QVector<double> &lats, QVector<double> &lons) const
+{
+    lats.resize(m_size);
+    lons.resize(m_size);
+    double *outLat = lats.data();
+    double *outLon = lons.data();
+
+    // Anchors are written in order and the deltas between them are
+    // contiguous, so one pointer walks the whole stream
+    const uchar *p = reinterpret_cast<const uchar *>(m_deltas.constData());
+    qint32 lat = 0, lon = 0;
+    for (int i = 0; i < m_size; ++i) {
+        if (i % kAnchorInterval == 0) {
+            const Anchor &a = m_anchors[i / kAnchorInterval];
+            lat = a.lat;
+            lon = a.lon;
+        } else {
+            lat += readVarint(p);
+            lon += readVarint(p);
+        }
+        outLat[i] = lat * kInvE6;
+        outLon[i] = lon * kInvE6;
+    }
+}
+
+QByteArray CompactPolyline::toPolyline(int precision) const
+{
+    QVector<double> lats, lons;
+    decode(lats, lons);
+    return GeoUtils::encodePolyline(lats.constData(), lons.constData(), lats.size(), precision);
+}
@@ -0,0 +1,65 @@
+#ifndef COMPACTPOLYLINE_H
+#define COMPACTPOLYLINE_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+#include <utility>
+
+// Compact, immutable polyline store: int32 microdegree coordinates,
+// delta-encoded as zigzag LEB128 varints (7 bits per byte).
+//
+// Consecutive route vertices are a few metres to a few hundred metres
+// apart, so most deltas fit in one or two bytes per axis: a typical route
+// costs 3-5 bytes a point, against 16 for packed doubles and well over 100
+// for a QJsonArray of [lon, lat] arrays. Every kAnchorInterval-th point is
+// stored absolute in a side table, so at(i) decodes at most
+// kAnchorInterval - 1 deltas; decode() streams the whole line.
+class CompactPolyline
+{
+public:
+    static constexpr int kAnchorInterval = 32;
+
+    struct Segment {
+        double lat0, lon0;    // Point i
+        double lat1, lon1;    // Point i + 1
+    };
+
+    CompactPolyline() = default;
+
+    static CompactPolyline fromCoordinates(const double *lats, const double *lons, int n);
+
+    // From an encoded polyline string (precision 5 or 6). Returns an empty
+    // polyline and sets ok = false if the string is malformed.
+    static CompactPolyline fromPolyline(const QByteArray &encoded, int precision, bool *ok = nullptr);
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    // (lat, lon) of point i
+    std::pair<double, double> at(int i) const;
+
+    // Both ends of segment i in one walk; i + 1 must be a valid point
+    Segment segment(int i) const;
+
+    // Replaces lats/lons with every point
+    void decode(QVector<double> &lats, QVector<double> &lons) const;
+
+    QByteArray toPolyline(int precision = 5) const;
+
+    // Heap bytes held
+    int byteSize() const { return m_deltas.size() + m_anchors.size() * int(sizeof(Anchor)); }
+
+private:
+    struct Anchor {
+        qint32 lat;       // Microdegrees
+        qint32 lon;
+        qint32 offset;    // Into m_deltas, of the point after this one
+    };
+
+    QByteArray m_deltas;
+    QVector<Anchor> m_anchors;
+    int m_size = 0;
+};
+
+#endif // COMPACTPOLYLINE_H
@@ -5,9 +5,9 @@
 #include "SpotifyClient.h"
 #include "MediaController.h"
 #include "BluetoothManager.h"
+#include "RouteProgressTracker.h"
 #include <QDateTime>
 #include <QDebug>
-#include <QJsonArray>
 
 ContextAggregator::ContextAggregator(QObject *parent)
     : QObject(parent)
@@ -21,6 +21,7 @@ void ContextAggregator::setTidalClient(TidalClient *client) { m_tidal = client;
 void ContextAggregator::setSpotifyClient(SpotifyClient *client) { m_spotify = client; }
 void ContextAggregator::setMediaController(MediaController *mgr) { m_media = mgr; }
 void ContextAggregator::setBluetoothManager(BluetoothManager *mgr) { m_bluetooth = mgr; }
+void ContextAggregator::setRouteProgressTracker(RouteProgressTracker *tracker) { m_progress = tracker; }
 
 void ContextAggregator::setGpsLatitude(double lat)
 {
@@ -103,32 +104,35 @@ void ContextAggregator::setBorderWaitSummary(const QString &summary)
     m_borderWaitSummary = summary;
 }
 
-void ContextAggregator::setRouteCoordinates(const QJsonArray &coordinates, double /*durationSec*/)
+void ContextAggregator::setRoute(const std::shared_ptr<const Route> &route)
 {
-    m_routeCoords = coordinates;
-    qDebug() << "ContextAggregator: Stored" << coordinates.size() << "route coordinates for along-route search";
-}
-
-void ContextAggregator::clearRouteCoordinates()
-{
-    m_routeCoords = QJsonArray();
+    if (m_route == route) return;
+    m_route = route;
+    if (m_route)
+        qDebug() << "ContextAggregator: Route set," << m_route->size() << "points," << m_route->totalKm() << "km";
+    emit routeGeometryChanged();
 }
 
 QList<QPair<double,double>> ContextAggregator::routeSamplePoints(int count) const
 {
     QList<QPair<double,double>> points;
-    if (m_routeCoords.isEmpty() || count <= 0) return points;
+    if (!m_route || count <= 0) return points;
+
+    // count points spread over what is left of the route, so callers get
+    // the same coverage however far along the car is
+    const RouteSampler &sampler = m_route->sampler();
+    const double passedKm = m_progress && m_progress->tracking() && m_progress->routeIndex() == m_route->index()
+        ? m_progress->travelledKm() : 0.0;
+    if (passedKm <= 0.0) {
+        for (const RouteSampler::Sample &s : sampler.evenly(count))   // Cached per route
+            points.append({ s.lat, s.lon });
+        return points;
+    }
 
-    int total = m_routeCoords.size();
-    // Sample evenly spaced points along the route (skip start, include midpoints)
+    const double remainingKm = qMax(0.0, sampler.totalKm() - passedKm);
     for (int i = 1; i <= count; ++i) {
-        int idx = (total * i) / (count + 1);
-        if (idx >= total) idx = total - 1;
-        QJsonArray coord = m_routeCoords[idx].toArray();
-        if (coord.size() >= 2) {
-            // GeoJSON is [lon, lat]
-            points.append({coord[1].toDouble(), coord[0].toDouble()});
-        }
+        const RouteSampler::Sample s = sampler.sampleAt(passedKm + remainingKm * i / (count + 1));
+        points.append({ s.lat, s.lon });
     }
     return points;
 }
@@ -233,6 +237,12 @@ QString ContextAggregator::buildContext() const
     if (m_routeActive) {
         ctx += QString("Active route: destination %1, distance %2, ETA %3\n")
             .arg(m_routeDest, m_routeDist, m_routeDur);
+        if (m_progress && m_progress->valid()) {
+            ctx += QString("Route progress: %1 km driven, %2 km to go%3\n")
+                .arg(m_progress->travelledKm(), 0, 'f', 1)
+                .arg(m_progress->remainingKm(), 0, 'f', 1)
+                .arg(m_progress->offRoute() ? ", currently OFF the planned route" : "");
+        }
     }
 
     // Route weather (from RouteWeatherManager)
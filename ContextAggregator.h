@@ -3,9 +3,11 @@
 
 #include <QObject>
 #include <QString>
-#include <QJsonArray>
 #include <QPair>
 #include <QList>
+#include <memory>
+
+#include "Route.h"
 
 class WeatherManager;
 class VehicleBusManager;
@@ -13,6 +15,7 @@ class TidalClient;
 class SpotifyClient;
 class MediaController;
 class BluetoothManager;
+class RouteProgressTracker;
 
 class ContextAggregator : public QObject
 {
@@ -35,6 +38,7 @@ public:
     void setSpotifyClient(SpotifyClient *client);
     void setMediaController(MediaController *mgr);
     void setBluetoothManager(BluetoothManager *mgr);
+    void setRouteProgressTracker(RouteProgressTracker *tracker);
 
     double gpsLatitude() const { return m_gpsLat; }
     double gpsLongitude() const { return m_gpsLon; }
@@ -78,15 +82,20 @@ public:
     // Border wait times (set by BorderWaitManager)
     void setBorderWaitSummary(const QString &summary);
 
-    // Route sample points for along-route searches (lat/lon pairs evenly spaced)
-    Q_INVOKABLE void setRouteCoordinates(const QJsonArray &coordinates, double durationSec);
-    Q_INVOKABLE void clearRouteCoordinates();
+    // Active route (set by RouteLoader), null when there is none. Immutable —
+    // hold the pointer for as long as needed, from any thread.
+    void setRoute(const std::shared_ptr<const Route> &route);
+    std::shared_ptr<const Route> route() const { return m_route; }
+    std::shared_ptr<const RouteIndex> routeIndex() const { return m_route ? m_route->index() : nullptr; }
+
+    // count evenly spaced (by distance) points along the part of the route
+    // still ahead of the car, ends excluded
     QList<QPair<double,double>> routeSamplePoints(int count = 3) const;
-    const QJsonArray &routeCoordinates() const { return m_routeCoords; }
 
 signals:
     void gpsChanged();
     void routeChanged();
+    void routeGeometryChanged();   // route() replaced or cleared
 
 private:
     WeatherManager *m_weather = nullptr;
@@ -95,6 +104,7 @@ private:
     SpotifyClient *m_spotify = nullptr;
     MediaController *m_media = nullptr;
     BluetoothManager *m_bluetooth = nullptr;
+    RouteProgressTracker *m_progress = nullptr;
 
     double m_gpsLat = 0.0;
     double m_gpsLon = 0.0;
@@ -111,7 +121,7 @@ private:
     QString m_roadSurfaceSummary;
     QString m_avalancheSummary;
     QString m_borderWaitSummary;
-    QJsonArray m_routeCoords;
+    std::shared_ptr<const Route> m_route;
 };
 
 #endif // CONTEXTAGGREGATOR_H
@@ -0,0 +1,225 @@
+#include "DerivedChannels.h"
+#include <QLatin1String>
+#include <QtGlobal>
+#include <cmath>
+
+// Gives channel formulas access to the operator state they own
+struct DerivedContext {
+    const VehicleState &s;
+    DerivedChannels &engine;
+    uint32_t timeMs;
+
+    const DerivedConfig &config() const { return engine.m_config; }
+    double value(DerivedChannel c) const { return engine.m_values[static_cast<int>(c)]; }
+
+    double rpmAvg()
+    {
+        return engine.m_rpmMean.add(timeMs, s.rpm);
+    }
+
+    double knockRetardP95()
+    {
+        return engine.m_knockP95.add(timeMs, s.knockRetard, 0.95);
+    }
+
+    double injectorDutyP95()
+    {
+        return engine.m_dutyP95.add(timeMs, s.injectorDuty, 0.95);
+    }
+
+    // Trapezoidal integral of fuel flow. Gaps longer than kMaxGapMs (bus
+    // silence, replay seek) are not bridged.
+    double tripFuel()
+    {
+        constexpr uint32_t kMaxGapMs = 2000;
+        const double flow = value(DerivedChannel::FuelFlowLph);
+        if (engine.m_hasFlowSample && timeMs > engine.m_lastFlowMs) {
+            const uint32_t dtMs = timeMs - engine.m_lastFlowMs;
+            if (dtMs <= kMaxGapMs)
+                engine.m_tripLiters += (flow + engine.m_lastFlowLph) * 0.5 * dtMs / 3600000.0;
+        }
+        engine.m_lastFlowLph = flow;
+        engine.m_lastFlowMs = timeMs;
+        engine.m_hasFlowSample = true;
+        return engine.m_tripLiters;
+    }
+};
+
+namespace {
+
+constexpr uint32_t dep(DerivedChannel c) { return 1u << static_cast<int>(c); }
+
+struct DerivedInfo {
+    const char *name;
+    uint32_t groups;    // VehicleGroup inputs
+    uint32_t deps;      // Earlier derived channels this one reads
+    double (*compute)(DerivedContext &c);
+};
+
+const DerivedInfo kDerivedInfo[] = {
+    { "afrB1", VehGroupFuel, 0,
+      [](DerivedContext &c) { return c.s.lambdaB1 * c.config().stoichAfr; } },
+    { "afrB2", VehGroupFuel, 0,
+      [](DerivedContext &c) { return c.s.lambdaB2 * c.config().stoichAfr; } },
+    { "afrTarget", VehGroupFuel, 0,
+      [](DerivedContext &c) { return c.s.lambdaTarget * c.config().stoichAfr; } },
+    { "boostKpa", VehGroupTelemetry, 0,
+      [](DerivedContext &c) { return c.s.mapKpa - c.config().baroKpa; } },
+    { "fuelFlowLph", VehGroupFuel, 0,
+      [](DerivedContext &c) {
+          // duty x rated flow x cylinders, cc/min -> L/h
+          return c.s.injectorDuty / 100.0 * c.config().injectorCcMin * c.config().cylinders * 0.06;
+      } },
+    { "tripFuelL", VehGroupFuel, dep(DerivedChannel::FuelFlowLph),  // Integrates on every sample
+      [](DerivedContext &c) { return c.tripFuel(); } },
+    { "rpmAvg", VehGroupTelemetry, 0,
+      [](DerivedContext &c) { return c.rpmAvg(); } },
+    { "knockRetardP95", VehGroupIgnition, 0,
+      [](DerivedContext &c) { return c.knockRetardP95(); } },
+    { "injectorDutyP95", VehGroupFuel, 0,
+      [](DerivedContext &c) { return c.injectorDutyP95(); } },
+};
+
+static_assert(sizeof(kDerivedInfo) / sizeof(kDerivedInfo[0]) == static_cast<size_t>(DerivedChannel::Count),
+              "kDerivedInfo must list every DerivedChannel");
+
+} // namespace
+
+// ============================================================================
+// DerivedChannels
+// ============================================================================
+
+DerivedChannels::DerivedChannels()
+    : m_rpmMean(5000)
+    , m_knockP95(10000, 0.0, 32.0)
+    , m_dutyP95(30000, 0.0, 100.0)
+{
+}
+
+bool DerivedChannels::update(const VehicleState &state, uint32_t groups, uint32_t timeMs)
+{
+    if (!groups && m_primed) return false;
+
+    DerivedContext ctx{ state, *this, timeMs };
+    uint32_t changed = 0;
+
+    for (int i = 0; i < channelCount(); ++i) {
+        const DerivedInfo &info = kDerivedInfo[i];
+        if (m_primed && !(info.groups & groups) && !(info.deps & changed)) continue;
+
+        const double v = info.compute(ctx);
+        if (v != m_values[i]) {
+            m_values[i] = v;
+            changed |= 1u << i;
+        }
+    }
+
+    m_primed = true;
+    return changed != 0;
+}
+
+void DerivedChannels::setConfig(const DerivedConfig &config)
+{
+    m_config = config;
+    m_primed = false;  // Recompute everything on the next update
+}
+
+void DerivedChannels::reset()
+{
+    m_rpmMean.clear();
+    m_knockP95.clear();
+    m_dutyP95.clear();
+    m_values.fill(0.0);
+    m_primed = false;
+    resetTrip();
+}
+
+void DerivedChannels::resetTrip()
+{
+    m_tripLiters = 0.0;
+    m_hasFlowSample = false;
+    m_values[static_cast<int>(DerivedChannel::TripFuelL)] = 0.0;
+}
+
+QString DerivedChannels::channelName(DerivedChannel channel)
+{
+    const int index = static_cast<int>(channel);
+    if (index < 0 || index >= channelCount()) return QString();
+    return QLatin1String(kDerivedInfo[index].name);
+}
+
+int DerivedChannels::channelFromName(const QString &name)
+{
+    for (int i = 0; i < channelCount(); ++i) {
+        if (name == QLatin1String(kDerivedInfo[i].name)) return i;
+    }
+    return -1;
+}
+
+// ============================================================================
+// RollingMean
+// ============================================================================
+
+double DerivedChannels::RollingMean::add(uint32_t timeMs, double value)
+{
+    // Evict samples that left the window, or the oldest one if full
+    const int capacity = static_cast<int>(m_samples.size());
+    while (m_count > 0) {
+        const Sample &oldest = m_samples[(m_head - m_count + capacity) % capacity];
+        if (m_count < capacity && timeMs - oldest.timeMs <= m_windowMs) break;
+        m_sum -= oldest.value;
+        --m_count;
+    }
+
+    m_samples[m_head] = { timeMs, value };
+    m_head = (m_head + 1) % capacity;
+    ++m_count;
+    m_sum += value;
+
+    // Float drift from add/subtract pairs is reset whenever the window empties
+    if (m_count == 1) m_sum = value;
+    return m_sum / m_count;
+}
+
+// ============================================================================
+// RollingPercentile
+// ============================================================================
+
+int DerivedChannels::RollingPercentile::binOf(double value) const
+{
+    const double t = (value - m_lo) / (m_hi - m_lo);
+    return qBound(0, static_cast<int>(t * kBins), kBins - 1);
+}
+
+void DerivedChannels::RollingPercentile::clear()
+{
+    m_counts.fill(0);
+    m_head = m_count = 0;
+}
+
+double DerivedChannels::RollingPercentile::add(uint32_t timeMs, double value, double percentile)
+{
+    const int capacity = static_cast<int>(m_samples.size());
+    while (m_count > 0) {
+        const Sample &oldest = m_samples[(m_head - m_count + capacity) % capacity];
+        if (m_count < capacity && timeMs - oldest.timeMs <= m_windowMs) break;
+        --m_counts[oldest.bin];
+        --m_count;
+    }
+
+    const int bin = binOf(value);
+    m_samples[m_head] = { timeMs, static_cast<uint8_t>(bin) };
+    m_head = (m_head + 1) % capacity;
+    ++m_count;
+    ++m_counts[bin];
+
+    // Walk to the bin holding the requested rank; report its lower edge so
+    // a window of zeros reads exactly zero
+    const uint32_t rank = static_cast<uint32_t>(std::ceil(percentile * m_count));
+    uint32_t seen = 0;
+    for (int i = 0; i < kBins; ++i) {
+        seen += m_counts[i];
+        if (seen >= rank) return m_lo + (m_hi - m_lo) * i / kBins;
+    }
+    return m_hi;
+}
@@ -0,0 +1,135 @@
+#ifndef DERIVEDCHANNELS_H
+#define DERIVEDCHANNELS_H
+
+#include <QString>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "VehicleState.h"
+
+// Computed channels. Order matches kDerivedInfo in the .cpp — a channel may
+// only depend on channels declared before it.
+enum class DerivedChannel : int {
+    AfrB1,
+    AfrB2,
+    AfrTarget,
+    BoostKpa,
+    FuelFlowLph,
+    TripFuelL,
+    RpmAvg,
+    KnockRetardP95,
+    InjectorDutyP95,
+    Count
+};
+
+// Engine constants the derived channels need but the bus doesn't carry
+struct DerivedConfig {
+    double stoichAfr = 14.7;        // Gasoline
+    double baroKpa = 101.3;
+    double injectorCcMin = 440.0;   // Per injector at rated pressure
+    int cylinders = 8;
+};
+
+// Incremental dataflow over VehicleState.
+//
+// Each channel declares the VehicleGroup bits and earlier derived channels
+// it reads. update() recomputes only channels whose inputs changed, in
+// declaration order, so a chain like duty -> fuel flow -> trip fuel settles
+// in one pass. Windowed channels (rolling mean, percentiles) and the trip
+// integrator update in O(1) per sample; nothing rescans history.
+//
+// update() runs once per applied snapshot, not per frame, so a window sees
+// at most the fastest signal's broadcast rate (100 Hz). Rings are sized for
+// the full window at kMaxRateHz; anything faster shortens the window rather
+// than growing the ring.
+class DerivedChannels
+{
+public:
+    static constexpr uint32_t kMaxRateHz = 100;
+
+    // Ring slots for a window at kMaxRateHz
+    static constexpr int windowCapacity(uint32_t windowMs)
+    {
+        return static_cast<int>(windowMs * kMaxRateHz / 1000) + 1;
+    }
+
+    DerivedChannels();
+
+    // Feeds the groups touched since the last call. Returns true if any
+    // channel value changed.
+    bool update(const VehicleState &state, uint32_t groups, uint32_t timeMs);
+
+    double value(DerivedChannel channel) const { return m_values[static_cast<int>(channel)]; }
+
+    void setConfig(const DerivedConfig &config);
+    const DerivedConfig &config() const { return m_config; }
+
+    // Clears windows and the trip integrator
+    void reset();
+    void resetTrip();
+
+    static constexpr int channelCount() { return static_cast<int>(DerivedChannel::Count); }
+    static QString channelName(DerivedChannel channel);
+    static int channelFromName(const QString &name);
+
+    // Time-windowed rolling mean — running sum over a ring
+    class RollingMean
+    {
+    public:
+        explicit RollingMean(uint32_t windowMs = 0)
+            : m_samples(windowCapacity(windowMs)), m_windowMs(windowMs) {}
+        double add(uint32_t timeMs, double value);
+        void clear() { m_head = m_count = 0; m_sum = 0.0; }
+
+    private:
+        struct Sample { uint32_t timeMs; double value; };
+        std::vector<Sample> m_samples;   // Ring; full means the oldest is evicted early
+        uint32_t m_windowMs;
+        int m_head = 0;
+        int m_count = 0;
+        double m_sum = 0.0;
+    };
+
+    // Time-windowed percentile over a fixed-bin histogram. Insert and evict
+    // are O(1); a query walks the fixed bin count, independent of window size.
+    class RollingPercentile
+    {
+    public:
+        RollingPercentile() : RollingPercentile(0, 0.0, 1.0) {}
+        RollingPercentile(uint32_t windowMs, double lo, double hi)
+            : m_samples(windowCapacity(windowMs)), m_windowMs(windowMs), m_lo(lo), m_hi(hi) {}
+        double add(uint32_t timeMs, double value, double percentile);
+        void clear();
+
+    private:
+        static constexpr int kBins = 64;
+        struct Sample { uint32_t timeMs; uint8_t bin; };
+        int binOf(double value) const;
+        std::vector<Sample> m_samples;   // Ring, as in RollingMean
+        std::array<uint32_t, kBins> m_counts{};
+        uint32_t m_windowMs = 0;
+        double m_lo = 0.0;
+        double m_hi = 1.0;
+        int m_head = 0;
+        int m_count = 0;
+    };
+
+private:
+    friend struct DerivedContext;
+
+    DerivedConfig m_config;
+    std::array<double, static_cast<size_t>(DerivedChannel::Count)> m_values{};
+    bool m_primed = false;  // First update computes everything
+
+    // Per-operator state
+    RollingMean m_rpmMean;
+    RollingPercentile m_knockP95;
+    RollingPercentile m_dutyP95;
+    double m_tripLiters = 0.0;
+    double m_lastFlowLph = 0.0;
+    uint32_t m_lastFlowMs = 0;
+    bool m_hasFlowSample = false;
+};
+
+#endif // DERIVEDCHANNELS_H
@@ -0,0 +1,129 @@
+#include "FeedFetcher.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QRegularExpression>
+#include <QTimer>
+
+FeedFetcher::FeedFetcher(QObject *parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+{
+    qDebug() << "FeedFetcher: Initialized";
+}
+
+void FeedFetcher::get(const QString &source, QNetworkRequest request, QObject *receiver,
+                      Handler handler, Mode mode)
+{
+    const QString key = request.url().toString();
+    Stats &stats = m_stats[source];
+    const auto v = m_validators.constFind(key);
+
+    if (mode == AllowUnchanged && v != m_validators.constEnd()) {
+        // Still fresh by the server's own Cache-Control — don't wake the modem
+        if (v->freshUntilMs > QDateTime::currentMSecsSinceEpoch()) {
+            ++stats.fresh;
+            stats.bytesSaved += v->bodySize;
+            qDebug() << "FeedFetcher:" << source << "still fresh, saved" << v->bodySize << "bytes";
+            Result result;
+            result.source = source;
+            result.httpStatus = 200;
+            result.unchanged = true;
+            QTimer::singleShot(0, receiver, [handler, result]() { handler(result); });
+            return;
+        }
+        if (!v->etag.isEmpty()) request.setRawHeader("If-None-Match", v->etag);
+        if (!v->lastModified.isEmpty()) request.setRawHeader("If-Modified-Since", v->lastModified);
+    }
+
+    ++stats.requests;
+    QNetworkReply *reply = m_network->get(request);
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, source, mode, guard = QPointer<QObject>(receiver), handler]() {
+        onFinished(reply, source, mode, guard, handler);
+    });
+}
+
+void FeedFetcher::onFinished(QNetworkReply *reply, const QString &source, Mode mode,
+                             const QPointer<QObject> &receiver, const Handler &handler)
+{
+    reply->deleteLater();
+
+    const QString key = reply->request().url().toString();
+    Stats &stats = m_stats[source];
+
+    Result result;
+    result.source = source;
+    result.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    result.error = reply->error();
+    result.errorString = reply->errorString();
+
+    if (result.httpStatus == 304) {
+        // No body came back; the one we have is current. QNetworkReply may
+        // report this as an error without a cache attached, so clear it.
+        result.error = QNetworkReply::NoError;
+        result.errorString.clear();
+        result.unchanged = true;
+
+        Validator &v = m_validators[key];
+        v.freshUntilMs = freshUntil(reply);
+        ++stats.notModified;
+        stats.bytesSaved += v.bodySize;
+        qDebug() << "FeedFetcher:" << source << "not modified, saved" << v.bodySize << "bytes";
+    } else if (result.ok()) {
+        result.body = reply->readAll();
+        const qint64 size = result.body.size();
+        stats.bytesReceived += size;
+
+        Validator &v = m_validators[key];
+        const QByteArray hash = QCryptographicHash::hash(result.body, QCryptographicHash::Md5);
+        if (mode == AllowUnchanged && hash == v.bodyHash) {
+            // Same bytes as last time: the transfer happened, the parse needn't
+            result.unchanged = true;
+            result.body.clear();
+            ++stats.unchangedBodies;
+            qDebug() << "FeedFetcher:" << source << "body unchanged," << size << "bytes";
+        }
+        v.bodyHash = hash;
+        v.bodySize = size;
+        v.etag = reply->rawHeader("ETag");
+        v.lastModified = reply->rawHeader("Last-Modified");
+        v.freshUntilMs = freshUntil(reply);
+    }
+
+    if (receiver) handler(result);
+}
+
+qint64 FeedFetcher::freshUntil(const QNetworkReply *reply)
+{
+    // max-age (less any Age already spent in a proxy), unless the server
+    // asks for revalidation every time
+    const QByteArray cacheControl = reply->rawHeader("Cache-Control").toLower();
+    if (cacheControl.isEmpty() || cacheControl.contains("no-cache") || cacheControl.contains("no-store"))
+        return 0;
+
+    static const QRegularExpression maxAgeRe("max-age\\s*=\\s*(\\d+)");
+    const QRegularExpressionMatch match = maxAgeRe.match(QString::fromLatin1(cacheControl));
+    if (!match.hasMatch()) return 0;
+
+    const qint64 maxAge = match.captured(1).toLongLong() - reply->rawHeader("Age").toLongLong();
+    if (maxAge <= 0) return 0;
+    return QDateTime::currentMSecsSinceEpoch() + maxAge * 1000;
+}
+
+QVariantList FeedFetcher::sourceStats() const
+{
+    QVariantList list;
+    for (auto it = m_stats.cbegin(); it != m_stats.cend(); ++it) {
+        list.append(QVariantMap {
+            { "source", it.key() },
+            { "requests", it->requests },
+            { "fresh", it->fresh },
+            { "notModified", it->notModified },
+            { "unchangedBodies", it->unchangedBodies },
+            { "bytesReceived", it->bytesReceived },
+            { "bytesSaved", it->bytesSaved },
+        });
+    }
+    return list;
+}
@@ -0,0 +1,95 @@
+#ifndef FEEDFETCHER_H
+#define FEEDFETCHER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVariantList>
+#include <functional>
+
+// Shared HTTP GET layer for the polling managers.
+//
+// Remembers each URL's validators and answers repeat fetches as cheaply as
+// the server allows:
+//  - still fresh under its Cache-Control max-age: no request at all
+//  - ETag / Last-Modified known: a conditional GET, and a 304 carries no body
+//  - a full body identical to the last one (by hash): delivered as unchanged
+// In every one of those cases the handler gets Result::unchanged and an
+// empty body, and skips parsing. Requests made with NeedBody send no
+// validators and always deliver the body, for callers that have thrown
+// their parsed state away (a new route, say).
+//
+// Validators are saved before the handler runs, so a handler must consume
+// every body it is given: a body it drops won't be offered again until the
+// server's content changes.
+//
+// Bytes received and bytes saved are counted per source name for the
+// diagnostics page.
+class FeedFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result {
+        QString source;
+        QNetworkReply::NetworkError error = QNetworkReply::NoError;
+        QString errorString;
+        int httpStatus = 0;
+        bool unchanged = false;   // Nothing new since the last fetch of this URL
+        QByteArray body;          // Empty when unchanged
+
+        bool ok() const { return error == QNetworkReply::NoError; }
+    };
+
+    enum Mode {
+        AllowUnchanged,
+        NeedBody,
+    };
+
+    using Handler = std::function<void(const Result &)>;
+
+    explicit FeedFetcher(QObject *parent = nullptr);
+
+    // GETs the request and calls handler with the result, on this thread,
+    // unless receiver has been destroyed by then. source groups the
+    // statistics ("roadConditions/511AB").
+    void get(const QString &source, QNetworkRequest request, QObject *receiver,
+             Handler handler, Mode mode = AllowUnchanged);
+
+    // One map per source: requests, fresh (served without a request),
+    // notModified (304), unchangedBodies, bytesReceived, bytesSaved
+    Q_INVOKABLE QVariantList sourceStats() const;
+
+private:
+    struct Validator {
+        QByteArray etag;
+        QByteArray lastModified;
+        QByteArray bodyHash;
+        qint64 bodySize = 0;
+        qint64 freshUntilMs = 0;
+    };
+
+    struct Stats {
+        int requests = 0;
+        int fresh = 0;
+        int notModified = 0;
+        int unchangedBodies = 0;
+        qint64 bytesReceived = 0;
+        qint64 bytesSaved = 0;
+    };
+
+    void onFinished(QNetworkReply *reply, const QString &source, Mode mode,
+                    const QPointer<QObject> &receiver, const Handler &handler);
+    static qint64 freshUntil(const QNetworkReply *reply);
+
+    QNetworkAccessManager *m_network;
+    QHash<QString, Validator> m_validators;   // By URL
+    QHash<QString, Stats> m_stats;            // By source
+};
+
+#endif // FEEDFETCHER_H
@@ -0,0 +1,492 @@
+#include "GeoUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr double kEarthRadiusKm = 6371.0;
+constexpr double kDegToRad = M_PI / 180.0;
+
+// Lanes whose half latitude difference exceeds this skip the fast path —
+// the mean-latitude series below is only accurate for small offsets
+constexpr double kMaxHalfDeltaLat = 0.1;
+
+// sin(central angle / 2) limit for the asin series, about 1270 km. Longer
+// distances go to GeoUtils::haversineKm.
+constexpr double kMaxSeriesAsin = 0.1;
+
+// Results are produced in chunks of this many for the nearest* reductions
+constexpr int kChunk = 256;
+
+constexpr double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+// ============================================================================
+// Lane types
+//
+// Each provides a double vector V, a lane mask M and the handful of ops the
+// kernels need. Scalar is the one-lane fallback, and also handles the tail
+// of every batch so results don't depend on where the vector loop ends.
+// ============================================================================
+
+struct Scalar {
+    using V = double;
+    using M = bool;
+    static constexpr int kWidth = 1;
+    static constexpr const char *kName = "scalar";
+
+    static V load(const double *p) { return *p; }
+    static void store(double *p, V v) { *p = v; }
+    static V set(double x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V sqrt(V a) { return std::sqrt(a); }
+    static V abs(V a) { return std::fabs(a); }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static M gt(V a, V b) { return a > b; }
+    static M lt(V a, V b) { return a < b; }
+    static M orMask(M a, M b) { return a || b; }
+    static M andMask(M a, M b) { return a && b; }
+    static V select(M m, V a, V b) { return m ? a : b; }
+    static int bits(M m) { return m ? 1 : 0; }
+};
+
+#if defined(__AVX2__)
+
+struct Simd {
+    using V = __m256d;
+    using M = __m256d;
+    static constexpr int kWidth = 4;
+    static constexpr const char *kName = "avx2";
+
+    static V load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, V v) { _mm256_storeu_pd(p, v); }
+    static V set(double x) { return _mm256_set1_pd(x); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+    static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static M gt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static M lt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static M orMask(M a, M b) { return _mm256_or_pd(a, b); }
+    static M andMask(M a, M b) { return _mm256_and_pd(a, b); }
+    static V select(M m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+    static int bits(M m) { return _mm256_movemask_pd(m); }
+};
+
+#elif defined(__SSE2__)
+
+struct Simd {
+    using V = __m128d;
+    using M = __m128d;
+    static constexpr int kWidth = 2;
+    static constexpr const char *kName = "sse2";
+
+    static V load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, V v) { _mm_storeu_pd(p, v); }
+    static V set(double x) { return _mm_set1_pd(x); }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm_div_pd(a, b); }
+    static V sqrt(V a) { return _mm_sqrt_pd(a); }
+    static V abs(V a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static V min(V a, V b) { return _mm_min_pd(a, b); }
+    static V max(V a, V b) { return _mm_max_pd(a, b); }
+    static M gt(V a, V b) { return _mm_cmpgt_pd(a, b); }
+    static M lt(V a, V b) { return _mm_cmplt_pd(a, b); }
+    static M orMask(M a, M b) { return _mm_or_pd(a, b); }
+    static M andMask(M a, M b) { return _mm_and_pd(a, b); }
+    static V select(M m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    static int bits(M m) { return _mm_movemask_pd(m); }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+struct Simd {
+    using V = float64x2_t;
+    using M = uint64x2_t;
+    static constexpr int kWidth = 2;
+    static constexpr const char *kName = "neon";
+
+    static V load(const double *p) { return vld1q_f64(p); }
+    static void store(double *p, V v) { vst1q_f64(p, v); }
+    static V set(double x) { return vdupq_n_f64(x); }
+    static V add(V a, V b) { return vaddq_f64(a, b); }
+    static V sub(V a, V b) { return vsubq_f64(a, b); }
+    static V mul(V a, V b) { return vmulq_f64(a, b); }
+    static V div(V a, V b) { return vdivq_f64(a, b); }
+    static V sqrt(V a) { return vsqrtq_f64(a); }
+    static V abs(V a) { return vabsq_f64(a); }
+    static V min(V a, V b) { return vminq_f64(a, b); }
+    static V max(V a, V b) { return vmaxq_f64(a, b); }
+    static M gt(V a, V b) { return vcgtq_f64(a, b); }
+    static M lt(V a, V b) { return vcltq_f64(a, b); }
+    static M orMask(M a, M b) { return vorrq_u64(a, b); }
+    static M andMask(M a, M b) { return vandq_u64(a, b); }
+    static V select(M m, V a, V b) { return vbslq_f64(m, a, b); }
+    static int bits(M m)
+    {
+        return static_cast<int>((vgetq_lane_u64(m, 0) & 1) | ((vgetq_lane_u64(m, 1) & 1) << 1));
+    }
+};
+
+#else
+
+using Simd = Scalar;
+
+#endif
+
+// ============================================================================
+// Kernels
+// ============================================================================
+
+struct Query {
+    double lat;
+    double lon;
+    double cosLat;
+    double sinLat;
+    double toleranceKm;
+};
+
+Query makeQuery(double lat, double lon, double toleranceKm)
+{
+    const double phi = lat * kDegToRad;
+    return { lat, lon, std::cos(phi), std::sin(phi), toleranceKm };
+}
+
+// Query-relative longitude difference in degrees, wrapped to [-180, 180]
+template <class S>
+typename S::V deltaLon(const Query &q, typename S::V lon)
+{
+    using V = typename S::V;
+    V d = S::sub(lon, S::set(q.lon));
+    d = S::select(S::gt(d, S::set(180.0)), S::sub(d, S::set(360.0)), d);
+    return S::select(S::lt(d, S::set(-180.0)), S::add(d, S::set(360.0)), d);
+}
+
+// Taylor series for sin, accurate to ~1e-13 over [-pi/2, pi/2]
+template <class S>
+typename S::V sinSeries(typename S::V x)
+{
+    using V = typename S::V;
+    const V x2 = S::mul(x, x);
+    V p = S::set(1.0);
+    for (int k = 16; k >= 2; k -= 2)
+        p = S::sub(S::set(1.0), S::mul(S::mul(x2, S::set(1.0 / (k * (k + 1)))), p));
+    return S::mul(x, p);
+}
+
+// Taylor series for asin, accurate to rounding for |x| <= kMaxSeriesAsin
+template <class S>
+typename S::V asinSeries(typename S::V x)
+{
+    using V = typename S::V;
+    const V x2 = S::mul(x, x);
+    V p = S::set(231.0 / 13312.0);
+    p = S::add(S::set(63.0 / 2816.0), S::mul(x2, p));
+    p = S::add(S::set(35.0 / 1152.0), S::mul(x2, p));
+    p = S::add(S::set(5.0 / 112.0), S::mul(x2, p));
+    p = S::add(S::set(3.0 / 40.0), S::mul(x2, p));
+    p = S::add(S::set(1.0 / 6.0), S::mul(x2, p));
+    p = S::add(S::set(1.0), S::mul(x2, p));
+    return S::mul(x, p);
+}
+
+// Equirectangular distance at the mean latitude. cos/sin of the mean come
+// from a series around the query latitude, so the only libm calls per batch
+// are the two in makeQuery.
+//
+// The error against haversine stays below
+//     d * (dLon^2 * sin^2(meanLat) + dLat^2) / 8
+// (radians) everywhere off the poles; lanes where that exceeds the
+// tolerance are returned for the haversine pass.
+template <class S>
+typename S::M fastDistance(const Query &q, typename S::V lat, typename S::V lon, typename S::V &km)
+{
+    using V = typename S::V;
+    const V dLat = S::mul(S::sub(lat, S::set(q.lat)), S::set(kDegToRad));
+    const V dLon = S::mul(deltaLon<S>(q, lon), S::set(kDegToRad));
+
+    const V h = S::mul(dLat, S::set(0.5));
+    const V h2 = S::mul(h, h);
+    const V cosH = S::sub(S::set(1.0), S::mul(h2, S::sub(S::set(0.5), S::mul(h2, S::set(1.0 / 24.0)))));
+    const V sinH = S::mul(h, S::sub(S::set(1.0), S::mul(h2, S::sub(S::set(1.0 / 6.0), S::mul(h2, S::set(1.0 / 120.0))))));
+    const V cosMean = S::sub(S::mul(S::set(q.cosLat), cosH), S::mul(S::set(q.sinLat), sinH));
+    const V sinMean = S::add(S::mul(S::set(q.sinLat), cosH), S::mul(S::set(q.cosLat), sinH));
+
+    const V x = S::mul(dLon, cosMean);
+    const V dLat2 = S::mul(dLat, dLat);
+    km = S::mul(S::set(kEarthRadiusKm), S::sqrt(S::add(S::mul(x, x), dLat2)));
+
+    const V ew = S::mul(dLon, sinMean);
+    const V bound = S::add(S::mul(S::mul(km, S::add(S::mul(ew, ew), dLat2)), S::set(0.125)), S::set(1e-9));
+    return S::orMask(S::gt(bound, S::set(q.toleranceKm)),
+                     S::gt(S::abs(h), S::set(kMaxHalfDeltaLat)));
+}
+
+// Haversine with series in place of libm. The other latitude's cosine is
+// rebuilt from the query's with double-angle identities, so only sin of the
+// two half differences is needed. Lanes too far apart for the asin series
+// are returned for a scalar pass.
+template <class S>
+typename S::M seriesHaversine(const Query &q, typename S::V lat, typename S::V lon, typename S::V &km)
+{
+    using V = typename S::V;
+    const V h = S::mul(S::sub(lat, S::set(q.lat)), S::set(0.5 * kDegToRad));
+    const V sinH = sinSeries<S>(h);
+    const V sinL = sinSeries<S>(S::mul(deltaLon<S>(q, lon), S::set(0.5 * kDegToRad)));
+
+    const V sinH2 = S::mul(sinH, sinH);
+    const V cosH = S::sqrt(S::max(S::sub(S::set(1.0), sinH2), S::set(0.0)));
+    const V cos2H = S::sub(S::set(1.0), S::add(sinH2, sinH2));
+    const V sin2H = S::mul(S::set(2.0), S::mul(sinH, cosH));
+    const V cosLat = S::sub(S::mul(S::set(q.cosLat), cos2H), S::mul(S::set(q.sinLat), sin2H));
+
+    const V a = S::add(sinH2, S::mul(S::mul(S::set(q.cosLat), cosLat), S::mul(sinL, sinL)));
+    const V s = S::sqrt(S::max(a, S::set(0.0)));
+    km = S::mul(S::set(2.0 * kEarthRadiusKm), asinSeries<S>(s));
+    return S::gt(s, S::set(kMaxSeriesAsin));
+}
+
+// Fast path where it's good enough, series haversine elsewhere. Returns the
+// lanes still needing GeoUtils::haversineKm.
+template <class S>
+typename S::M distanceLanes(const Query &q, typename S::V lat, typename S::V lon, typename S::V &km)
+{
+    const typename S::M inexact = fastDistance<S>(q, lat, lon, km);
+    if (!S::bits(inexact)) return inexact;
+
+    typename S::V exactKm;
+    const typename S::M far = seriesHaversine<S>(q, lat, lon, exactKm);
+    km = S::select(inexact, exactKm, km);
+    return S::andMask(inexact, far);
+}
+
+template <class S>
+void distanceBlock(const Query &q, const double *lats, const double *lons, double *out)
+{
+    typename S::V km;
+    int scalar = S::bits(distanceLanes<S>(q, S::load(lats), S::load(lons), km));
+    S::store(out, km);
+    for (; scalar; scalar &= scalar - 1) {
+        const int lane = __builtin_ctz(scalar);
+        out[lane] = GeoUtils::haversineKm(q.lat, q.lon, lats[lane], lons[lane]);
+    }
+}
+
+// Segments lats[i] -> lats[i+1] for the block's lanes. The one segment
+// projection, shared by RouteIndex and RouteProgressTracker: project in a
+// flat frame centred on the query, interpolate the closest point, then
+// measure the true distance to it.
+template <class S>
+void segmentBlock(const Query &q, const double *lats, const double *lons, double *out, double *outT)
+{
+    using V = typename S::V;
+    const V aLat = S::load(lats), aLon = S::load(lons);
+    const V bLat = S::load(lats + 1), bLon = S::load(lons + 1);
+
+    const V kx = S::set(q.cosLat);
+    const V ax = S::mul(deltaLon<S>(q, aLon), kx), ay = S::sub(aLat, S::set(q.lat));
+    const V bx = S::mul(deltaLon<S>(q, bLon), kx), by = S::sub(bLat, S::set(q.lat));
+    const V dx = S::sub(bx, ax), dy = S::sub(by, ay);
+    const V lenSq = S::add(S::mul(dx, dx), S::mul(dy, dy));
+    const V dot = S::add(S::mul(ax, dx), S::mul(ay, dy));
+
+    // A zero-length segment has dot == 0 too, which lands on t = 0
+    V t = S::div(S::sub(S::set(0.0), dot), S::max(lenSq, S::set(std::numeric_limits<double>::min())));
+    t = S::max(S::set(0.0), S::min(t, S::set(1.0)));
+
+    const V cLat = S::add(aLat, S::mul(t, S::sub(bLat, aLat)));
+    const V cLon = S::add(aLon, S::mul(t, S::sub(bLon, aLon)));
+
+    V km;
+    int scalar = S::bits(distanceLanes<S>(q, cLat, cLon, km));
+    S::store(out, km);
+    if (outT) S::store(outT, t);
+
+    if (scalar) {
+        double lat[S::kWidth], lon[S::kWidth];
+        S::store(lat, cLat);
+        S::store(lon, cLon);
+        for (; scalar; scalar &= scalar - 1) {
+            const int lane = __builtin_ctz(scalar);
+            out[lane] = GeoUtils::haversineKm(q.lat, q.lon, lat[lane], lon[lane]);
+        }
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+namespace GeoUtils {
+
+void distancesKm(double lat, double lon, const double *lats, const double *lons, int n,
+                 double *outKm, double toleranceKm)
+{
+    const Query q = makeQuery(lat, lon, toleranceKm);
+    int i = 0;
+    for (; i + Simd::kWidth <= n; i += Simd::kWidth)
+        distanceBlock<Simd>(q, lats + i, lons + i, outKm + i);
+    for (; i < n; ++i)
+        distanceBlock<Scalar>(q, lats + i, lons + i, outKm + i);
+}
+
+void segmentDistancesKm(double lat, double lon, const double *lats, const double *lons, int n,
+                        double *outKm, double *outT, double toleranceKm)
+{
+    const Query q = makeQuery(lat, lon, toleranceKm);
+    const int segments = n - 1;
+    int i = 0;
+    for (; i + Simd::kWidth <= segments; i += Simd::kWidth)
+        segmentBlock<Simd>(q, lats + i, lons + i, outKm + i, outT ? outT + i : nullptr);
+    for (; i < segments; ++i)
+        segmentBlock<Scalar>(q, lats + i, lons + i, outKm + i, outT ? outT + i : nullptr);
+}
+
+int nearestPoint(double lat, double lon, const double *lats, const double *lons, int n,
+                 double *distanceKm, double toleranceKm)
+{
+    double km[kChunk];
+    int best = -1;
+    double bestKm = std::numeric_limits<double>::infinity();
+
+    for (int start = 0; start < n; start += kChunk) {
+        const int count = std::min(kChunk, n - start);
+        distancesKm(lat, lon, lats + start, lons + start, count, km, toleranceKm);
+        for (int i = 0; i < count; ++i) {
+            if (km[i] < bestKm) {
+                bestKm = km[i];
+                best = start + i;
+            }
+        }
+    }
+
+    if (distanceKm) *distanceKm = bestKm;
+    return best;
+}
+
+int nearestSegment(double lat, double lon, const double *lats, const double *lons, int n,
+                   double *distanceKm, double *t, double toleranceKm)
+{
+    double km[kChunk], ts[kChunk];
+    int best = -1;
+    double bestKm = std::numeric_limits<double>::infinity();
+    double bestT = 0.0;
+
+    // Chunks overlap by one point so no segment is lost at the seams
+    for (int start = 0; start + 1 < n; start += kChunk) {
+        const int points = std::min(kChunk + 1, n - start);
+        segmentDistancesKm(lat, lon, lats + start, lons + start, points, km, ts, toleranceKm);
+        for (int i = 0; i < points - 1; ++i) {
+            if (km[i] < bestKm) {
+                bestKm = km[i];
+                bestT = ts[i];
+                best = start + i;
+            }
+        }
+    }
+
+    if (distanceKm) *distanceKm = bestKm;
+    if (t) *t = bestT;
+    return best;
+}
+
+const char *batchIsa()
+{
+    return Simd::kName;
+}
+
+// ============================================================================
+// Encoded polyline
+// ============================================================================
+
+namespace {
+
+inline void writePolylineValue(QByteArray &out, qint64 v)
+{
+    // Zigzag, then 5-bit chunks low first with 0x20 as the continuation bit, offset by 63
+    quint64 u = (static_cast<quint64>(v) << 1) ^ static_cast<quint64>(v >> 63);
+    while (u >= 0x20) {
+        out.append(static_cast<char>((0x20 | (u & 0x1f)) + 63));
+        u >>= 5;
+    }
+    out.append(static_cast<char>(u + 63));
+}
+
+inline bool readPolylineValue(const char *&p, const char *end, qint64 &v)
+{
+    quint64 u = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 5) {
+        const int b = static_cast<unsigned char>(*p++) - 63;
+        if (b < 0 || b > 0x3f) return false;
+        u |= static_cast<quint64>(b & 0x1f) << shift;
+        if (b < 0x20) {
+            v = static_cast<qint64>(u >> 1) ^ -static_cast<qint64>(u & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+QByteArray encodePolyline(const double *lats, const double *lons, int n, int precision)
+{
+    const double factor = kPow10[qBound(0, precision, 9)];
+    QByteArray out;
+    out.reserve(n * 8);
+
+    qint64 prevLat = 0, prevLon = 0;
+    for (int i = 0; i < n; ++i) {
+        const qint64 lat = qRound64(lats[i] * factor);
+        const qint64 lon = qRound64(lons[i] * factor);
+        writePolylineValue(out, lat - prevLat);
+        writePolylineValue(out, lon - prevLon);
+        prevLat = lat;
+        prevLon = lon;
+    }
+    return out;
+}
+
+bool decodePolyline(const char *data, int size, int precision, QVector<double> &lats, QVector<double> &lons,
+                    int maxPoints)
+{
+    const double scale = 1.0 / kPow10[qBound(0, precision, 9)];
+
+    // Road geometry averages three to four bytes per value
+    const int expected = maxPoints >= 0 ? qMin(maxPoints, size / 2) : size / 6;
+    lats.reserve(lats.size() + expected);
+    lons.reserve(lons.size() + expected);
+
+    const char *p = data;
+    const char *end = data + size;
+    qint64 lat = 0, lon = 0;
+    for (int count = 0; p < end && count != maxPoints; ++count) {
+        qint64 dLat, dLon;
+        if (!readPolylineValue(p, end, dLat) || !readPolylineValue(p, end, dLon)) return false;
+        lat += dLat;
+        lon += dLon;
+        lats.append(lat * scale);
+        lons.append(lon * scale);
+    }
+    return true;
+}
+
+} // namespace GeoUtils
@@ -2,8 +2,8 @@
 #define GEOUTILS_H
 
 #include <QtMath>
-#include <QJsonArray>
-#include <QString>
+#include <QByteArray>
+#include <QVector>
 
 namespace GeoUtils {
 
@@ -44,111 +44,52 @@ inline double pointToSegmentDistanceKm(double pLat, double pLon,
     return haversineKm(pLat, pLon, closestLat, closestLon);
 }
 
-// Douglas-Peucker polyline simplification.
-// Input: QJsonArray of GeoJSON [lon, lat] pairs.
-// Returns simplified array with <= targetPoints points.
-inline QJsonArray simplifyRoute(const QJsonArray &coords, int targetPoints = 100)
+// Batch kernels: one query point against n points held as separate lat and
+// lon arrays (GeoUtils.cpp). Vectorized with AVX2 or SSE2 on x86 and NEON on
+// aarch64, whichever the compiler targets.
+//
+// Each lane takes an equirectangular distance at the pair's mean latitude
+// and falls back to haversine when that shortcut's error bound exceeds
+// toleranceKm, so every result is within toleranceKm of haversineKm.
+// A tolerance of 0 gives haversine everywhere. The vector haversine uses
+// polynomial sin/asin; pairs over ~1270 km apart go through haversineKm.
+constexpr double kBatchToleranceKm = 0.001;
+
+// outKm[i] = distance to (lats[i], lons[i])
+void distancesKm(double lat, double lon, const double *lats, const double *lons, int n,
+                 double *outKm, double toleranceKm = kBatchToleranceKm);
+
+// Distance to each segment i -> i+1 of an n-point polyline (n-1 results).
+// The closest point is found in a flat frame around the query point and
+// outT, if given, receives its position along the segment (0..1).
+void segmentDistancesKm(double lat, double lon, const double *lats, const double *lons, int n,
+                        double *outKm, double *outT = nullptr,
+                        double toleranceKm = kBatchToleranceKm);
+
+// Index of the closest point / segment, -1 if there is none
+int nearestPoint(double lat, double lon, const double *lats, const double *lons, int n,
+                 double *distanceKm = nullptr, double toleranceKm = kBatchToleranceKm);
+int nearestSegment(double lat, double lon, const double *lats, const double *lons, int n,
+                   double *distanceKm = nullptr, double *t = nullptr,
+                   double toleranceKm = kBatchToleranceKm);
+
+// Instruction set the batch kernels were built for ("avx2", "sse2", "neon", "scalar")
+const char *batchIsa();
+
+// Encoded Polyline Algorithm (Google; Mapbox "polyline" and "polyline6").
+// precision is decimal places: 5 for polyline, 6 for polyline6.
+QByteArray encodePolyline(const double *lats, const double *lons, int n, int precision = 5);
+
+// Appends the decoded points to lats/lons, stopping after maxPoints if it
+// is not negative. False, with whatever decoded before the error appended,
+// if the string is truncated or malformed.
+bool decodePolyline(const char *data, int size, int precision, QVector<double> &lats, QVector<double> &lons,
+                    int maxPoints = -1);
+
+inline bool decodePolyline(const QByteArray &encoded, int precision, QVector<double> &lats, QVector<double> &lons,
+                           int maxPoints = -1)
 {
-    if (coords.size() <= targetPoints) return coords;
-
-    // Recursive Douglas-Peucker implementation
-    struct DP {
-        static void run(const QJsonArray &pts, int first, int last,
-                        double epsilon, QVector<bool> &keep)
-        {
-            if (last <= first + 1) return;
-
-            double aLat = pts[first].toArray()[1].toDouble();
-            double aLon = pts[first].toArray()[0].toDouble();
-            double bLat = pts[last].toArray()[1].toDouble();
-            double bLon = pts[last].toArray()[0].toDouble();
-
-            double maxDist = 0.0;
-            int maxIdx = first;
-
-            for (int i = first + 1; i < last; ++i) {
-                double pLat = pts[i].toArray()[1].toDouble();
-                double pLon = pts[i].toArray()[0].toDouble();
-                double d = pointToSegmentDistanceKm(pLat, pLon, aLat, aLon, bLat, bLon);
-                if (d > maxDist) {
-                    maxDist = d;
-                    maxIdx = i;
-                }
-            }
-
-            if (maxDist > epsilon) {
-                keep[maxIdx] = true;
-                run(pts, first, maxIdx, epsilon, keep);
-                run(pts, maxIdx, last, epsilon, keep);
-            }
-        }
-    };
-
-    // Auto-tune epsilon: start at 0.05 km, double until we hit target
-    double epsilon = 0.05;
-    QJsonArray result;
-
-    for (int attempt = 0; attempt < 20; ++attempt) {
-        QVector<bool> keep(coords.size(), false);
-        keep[0] = true;
-        keep[coords.size() - 1] = true;
-
-        DP::run(coords, 0, coords.size() - 1, epsilon, keep);
-
-        int count = 0;
-        for (bool k : keep) { if (k) ++count; }
-
-        if (count <= targetPoints || attempt == 19) {
-            result = QJsonArray();
-            for (int i = 0; i < coords.size(); ++i) {
-                if (keep[i]) result.append(coords[i]);
-            }
-            break;
-        }
-
-        epsilon *= 2.0;
-    }
-
-    return result;
-}
-
-// Google Encoded Polyline encoder.
-// Input: QJsonArray of GeoJSON [lon, lat] pairs.
-// Output: encoded polyline QString per Google's algorithm.
-inline QString encodePolyline(const QJsonArray &coords)
-{
-    QString result;
-    int prevLat = 0, prevLon = 0;
-
-    for (int i = 0; i < coords.size(); ++i) {
-        QJsonArray pt = coords[i].toArray();
-        double lon = pt[0].toDouble();
-        double lat = pt[1].toDouble();
-
-        int iLat = qRound(lat * 1e5);
-        int iLon = qRound(lon * 1e5);
-
-        int dLat = iLat - prevLat;
-        int dLon = iLon - prevLon;
-        prevLat = iLat;
-        prevLon = iLon;
-
-        auto encodeValue = [&result](int v) {
-            // Zigzag encode: left-shift 1, XOR with arithmetic right-shift 31
-            v = (v < 0) ? ~(v << 1) : (v << 1);
-            // Break into 5-bit chunks with 0x20 continuation bit, add 63
-            while (v >= 0x20) {
-                result += QChar((0x20 | (v & 0x1F)) + 63);
-                v >>= 5;
-            }
-            result += QChar(v + 63);
-        };
-
-        encodeValue(dLat);
-        encodeValue(dLon);
-    }
-
-    return result;
+    return decodePolyline(encoded.constData(), encoded.size(), precision, lats, lons, maxPoints);
 }
 
 } // namespace GeoUtils
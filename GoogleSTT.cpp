@@ -1,4 +1,5 @@
 #include "GoogleSTT.h"
+#include "AudioCodec.h"
 #include <QDebug>
 #include <QNetworkRequest>
 #include <QJsonDocument>
@@ -10,6 +11,7 @@ GoogleSTT::GoogleSTT(QObject *parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
     , m_currentReply(nullptr)
+    , m_codec(new AudioCodecThread(this))
     , m_languageCode("en-US")
     , m_isProcessing(false)
     , m_statusMessage("Not configured")
@@ -34,6 +36,10 @@ GoogleSTT::GoogleSTT(QObject *parent)
     // Connect network manager signals
     connect(m_networkManager, &QNetworkAccessManager::finished,
             this, &GoogleSTT::onNetworkReply);
+    connect(m_codec, &AudioCodecThread::done, this, &GoogleSTT::onAudioEncoded);
+
+    if (!AudioCodec::isAvailable())
+        qDebug() << "GoogleSTT: libopus not available - uploading LINEAR16";
 
     qDebug() << "GoogleSTT: Initialization complete";
 }
@@ -113,9 +119,38 @@ void GoogleSTT::transcribeRaw(const QByteArray &audioData)
 
     m_isProcessing = true;
     emit processingChanged();
+
+    if (AudioCodec::isAvailable()) {
+        setStatusMessage("Encoding audio...");
+        m_pendingAudio = audioData;
+        m_encodeJob = m_codec->submit(AudioCodecThread::Job::EncodeOpus, audioData, SAMPLE_RATE);
+        return;
+    }
+
+    setStatusMessage("Sending to Google STT...");
+    sendToGoogle(audioData, "LINEAR16");
+}
+
+void GoogleSTT::onAudioEncoded(quint64 job, const QByteArray &encoded, qint64 elapsedUs)
+{
+    // Cancelled, or superseded
+    if (job != m_encodeJob) {
+        return;
+    }
+    m_encodeJob = 0;
+    const QByteArray audioData = m_pendingAudio;
+    m_pendingAudio.clear();
+
     setStatusMessage("Sending to Google STT...");
+    if (encoded.isEmpty()) {
+        qWarning() << "GoogleSTT: Opus encode failed, sending LINEAR16";
+        sendToGoogle(audioData, "LINEAR16");
+        return;
+    }
 
-    sendToGoogle(audioData);
+    qDebug() << "GoogleSTT: Encoded" << audioData.size() << "->" << encoded.size()
+             << "bytes in" << elapsedUs / 1000.0 << "ms";
+    sendToGoogle(encoded, "OGG_OPUS");
 }
 
 void GoogleSTT::cancel()
@@ -126,6 +161,8 @@ void GoogleSTT::cancel()
         m_currentReply->abort();
         m_currentReply = nullptr;
     }
+    m_encodeJob = 0;
+    m_pendingAudio.clear();
 
     m_isProcessing = false;
     emit processingChanged();
@@ -136,14 +173,14 @@ void GoogleSTT::cancel()
 // NETWORK HANDLING
 // ========================================================================
 
-void GoogleSTT::sendToGoogle(const QByteArray &audioData)
+void GoogleSTT::sendToGoogle(const QByteArray &audioData, const QString &encoding)
 {
     // Encode audio to base64
     QString audioContent = encodeAudioToBase64(audioData);
 
     // Build request JSON
     QJsonObject config;
-    config["encoding"] = "LINEAR16";
+    config["encoding"] = encoding;
     config["sampleRateHertz"] = SAMPLE_RATE;
     config["languageCode"] = m_languageCode;
     config["enableAutomaticPunctuation"] = true;
@@ -193,7 +230,8 @@ void GoogleSTT::sendToGoogle(const QByteArray &audioData)
 
     // Send request
     QByteArray requestData = QJsonDocument(request).toJson(QJsonDocument::Compact);
-    qDebug() << "GoogleSTT: Sending request, audio size:" << audioData.size() << "bytes";
+    qDebug() << "GoogleSTT: Sending request," << encoding << "audio size:" << audioData.size()
+             << "bytes, request:" << requestData.size() << "bytes";
 
     m_currentReply = m_networkManager->post(networkRequest, requestData);
 
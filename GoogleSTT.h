@@ -8,6 +8,8 @@
 #include <QNetworkReply>
 #include <QVector>
 
+class AudioCodecThread;
+
 /**
  * GoogleSTT - Google Cloud Speech-to-Text Integration
  *
@@ -20,6 +22,8 @@
  * - Support for speech context hints (contact names)
  * - Multiple language support
  * - Automatic punctuation
+ * - Audio is uploaded as Ogg Opus when libopus is available (about a tenth
+ *   of LINEAR16), encoded on a worker thread
  *
  * Usage:
  *   GoogleSTT *stt = new GoogleSTT(this);
@@ -98,9 +102,10 @@ signals:
 private slots:
     void onNetworkReply(QNetworkReply *reply);
     void onNetworkError(QNetworkReply::NetworkError error);
+    void onAudioEncoded(quint64 job, const QByteArray &encoded, qint64 elapsedUs);
 
 private:
-    void sendToGoogle(const QByteArray &audioData);
+    void sendToGoogle(const QByteArray &audioData, const QString &encoding);
     void setStatusMessage(const QString &msg);
     QString encodeAudioToBase64(const QByteArray &audioData);
 
@@ -108,6 +113,11 @@ private:
     QNetworkAccessManager *m_networkManager;
     QNetworkReply *m_currentReply;
 
+    // Upload encoding
+    AudioCodecThread *m_codec;
+    quint64 m_encodeJob = 0;        // Encode in progress, 0 if none
+    QByteArray m_pendingAudio;      // Its LINEAR16 input, the fallback
+
     // Configuration
     QString m_apiKey;
     QString m_languageCode;
@@ -1,6 +1,9 @@
 #include "GoogleTTS.h"
+#include "TtsAudioCache.h"
+#include "AudioCodec.h"
 #include <QDebug>
-#include <QPointer>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <QNetworkRequest>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -11,7 +14,6 @@
 GoogleTTS::GoogleTTS(QObject *parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
-    , m_currentReply(nullptr)
     , m_voiceName("en-US-Studio-O")  // Studio: highest quality female US English voice
     , m_languageCode("en-US")
     , m_speakingRate(1.0)
@@ -21,6 +23,9 @@ GoogleTTS::GoogleTTS(QObject *parent)
     , m_isSpeaking(false)
     , m_isProcessing(false)
     , m_statusMessage("Not configured")
+    , m_cache(new TtsAudioCache(this))
+    , m_codec(new AudioCodecThread(this))
+    , m_useOpus(AudioCodec::isAvailable())
 {
     qDebug() << "GoogleTTS: Initializing...";
 
@@ -42,6 +47,10 @@ GoogleTTS::GoogleTTS(QObject *parent)
     // Connect network manager signals
     connect(m_networkManager, &QNetworkAccessManager::finished,
             this, &GoogleTTS::onNetworkReply);
+    connect(m_codec, &AudioCodecThread::done, this, &GoogleTTS::onAudioDecoded);
+
+    if (!m_useOpus)
+        qDebug() << "GoogleTTS: libopus not available - requesting LINEAR16";
 
     qDebug() << "GoogleTTS: Initialization complete";
 }
@@ -53,11 +62,19 @@ GoogleTTS::~GoogleTTS()
     }
 
     // In the destructor, the event loop won't run again so we must
-    // delete the reply directly (deleteLater won't execute).
-    if (m_currentReply) {
-        m_currentReply->abort();
-        delete m_currentReply;
-        m_currentReply = nullptr;
+    // delete the replies directly (deleteLater won't execute).
+    disconnect(m_networkManager, nullptr, this, nullptr);
+    for (Segment &segment : m_segments) {
+        if (segment.reply) {
+            segment.reply->abort();
+            delete segment.reply;
+            segment.reply = nullptr;
+        }
+    }
+    if (m_prewarmReply) {
+        m_prewarmReply->abort();
+        delete m_prewarmReply;
+        m_prewarmReply = nullptr;
     }
 
     delete m_audioSink;
@@ -126,45 +143,62 @@ void GoogleTTS::speak(const QString &text)
     }
 
     // Stop any current audio playback safely
-    if (m_isSpeaking || m_audioSink || m_audioBuffer || m_currentReply) {
+    if (m_isSpeaking || m_audioSink || m_audioBuffer || !m_segments.isEmpty()) {
         qDebug() << "GoogleTTS: Stopping current speech before starting new one";
         stop();
     }
 
     qDebug() << "GoogleTTS: Speaking:" << text;
 
-    // Check cache for short phrases (ready prompts, acknowledgments)
-    if (text.length() <= MAX_CACHE_TEXT_LENGTH && m_audioCache.contains(text)) {
-        qDebug() << "GoogleTTS: Cache hit for:" << text;
-        m_isSpeaking = true;
-        m_isProcessing = false;
-        emit speakingChanged();
-        emit speechStarted();
-        setStatusMessage("Speaking...");
-        playAudio(m_audioCache[text]);
+    // A one-sentence utterance
+    m_segments.append(Segment{ text });
+    m_queueOpen = false;
+    synthesizeAhead();
+    playNextSegment();
+}
+
+void GoogleTTS::enqueue(const QString &text)
+{
+    if (m_apiKey.isEmpty()) {
+        emit error("API key not configured");
+        setStatusMessage("Error: No API key");
         return;
     }
 
-    // Store text for caching after synthesis
-    m_pendingSpeakText = text;
+    if (text.trimmed().isEmpty()) {
+        return;
+    }
+
+    // A new utterance replaces a finished one still playing, as speak() does
+    if (!m_queueOpen && (m_isSpeaking || m_audioSink || m_audioBuffer || !m_segments.isEmpty())) {
+        qDebug() << "GoogleTTS: Stopping current speech before starting new one";
+        stop();
+    }
 
-    // Send to Google for synthesis
-    sendToGoogle(text);
+    qDebug() << "GoogleTTS: Queued:" << text << "(" << m_segments.size() << "ahead )";
+
+    m_segments.append(Segment{ text });
+    m_queueOpen = true;
+    synthesizeAhead();
+    playNextSegment();
+}
+
+void GoogleTTS::finishQueue()
+{
+    if (!m_queueOpen) {
+        return;
+    }
+
+    m_queueOpen = false;
+    playNextSegment();
 }
 
 void GoogleTTS::stop()
 {
     qDebug() << "GoogleTTS: Stopping speech...";
 
-    // Abort any pending network request first
-    // Don't deleteLater here — the QNetworkAccessManager::finished signal will
-    // still fire for the aborted reply, and onNetworkReply handles deletion.
-    if (m_currentReply) {
-        disconnect(m_currentReply, &QNetworkReply::errorOccurred,
-                   this, &GoogleTTS::onNetworkError);
-        m_currentReply->abort();
-        m_currentReply = nullptr;
-    }
+    // Abort any pending network requests first
+    clearQueue();
 
     // Stop audio sink first (disconnecting signal prevents re-entry)
     if (m_audioSink) {
@@ -183,9 +217,6 @@ void GoogleTTS::stop()
         m_audioBuffer = nullptr;
     }
 
-    // Now safe to clear audio data since buffer is gone
-    m_audioData.clear();
-
     // Update state
     m_isSpeaking = false;
     m_isProcessing = false;
@@ -195,15 +226,111 @@ void GoogleTTS::stop()
 }
 
 // ========================================================================
-// GOOGLE TTS API
+// SENTENCE QUEUE
 // ========================================================================
 
-void GoogleTTS::sendToGoogle(const QString &text)
+void GoogleTTS::synthesizeAhead()
 {
-    m_isProcessing = true;
-    emit processingChanged();
-    setStatusMessage("Synthesizing speech...");
+    int inFlight = 0;
+    for (const Segment &segment : m_segments) {
+        if (segment.reply) inFlight++;
+    }
+
+    for (Segment &segment : m_segments) {
+        if (inFlight >= MAX_SYNTHESIS_AHEAD) break;
+        if (segment.ready || segment.reply || segment.decodeJob) continue;
+
+        // Anything said before plays from the cache without a request
+        segment.cacheKey = cacheKey(segment.text);
+        if (segment.text.length() <= MAX_CACHE_TEXT_LENGTH) {
+            QElapsedTimer lookupTimer;
+            lookupTimer.start();
+            const QByteArray cached = m_cache->lookup(segment.cacheKey);
+            if (!cached.isEmpty()) {
+                qDebug() << "GoogleTTS: Cache hit for:" << segment.text
+                         << "(" << lookupTimer.nsecsElapsed() / 1000 << "us )";
+                segment.audio = cached;
+                segment.ready = true;
+                continue;
+            }
+        }
+
+        segment.reply = sendToGoogle(segment.text);
+        inFlight++;
+    }
 
+    updateProcessing();
+}
+
+void GoogleTTS::playNextSegment()
+{
+    if (m_playingSegment) {
+        return;
+    }
+
+    if (m_segments.isEmpty()) {
+        // Everything played; done unless more sentences are on the way
+        if (!m_queueOpen && m_isSpeaking) {
+            qDebug() << "GoogleTTS: Playback finished";
+            // Reset before emitting: a listener may speak() again right away
+            setStatusMessage("Ready");
+            reset();
+            emit speechFinished();
+        }
+        return;
+    }
+
+    if (!m_segments.first().ready) {
+        // Synthesis hasn't caught up; the reply handler calls back
+        return;
+    }
+
+    m_playingSegment = true;
+    playAudio(m_segments.first().audio);
+}
+
+void GoogleTTS::clearQueue()
+{
+    // Don't deleteLater here — the QNetworkAccessManager::finished signal will
+    // still fire for each aborted reply, and onNetworkReply handles deletion.
+    QList<QNetworkReply *> replies;
+    for (const Segment &segment : m_segments) {
+        if (segment.reply) replies.append(segment.reply);
+    }
+    m_segments.clear();
+    m_queueOpen = false;
+    m_playingSegment = false;
+
+    for (QNetworkReply *reply : replies) {
+        disconnect(reply, &QNetworkReply::errorOccurred,
+                   this, &GoogleTTS::onNetworkError);
+        reply->abort();
+    }
+}
+
+void GoogleTTS::updateProcessing()
+{
+    bool processing = false;
+    for (const Segment &segment : m_segments) {
+        if (segment.reply || segment.decodeJob) {
+            processing = true;
+            break;
+        }
+    }
+
+    if (m_isProcessing != processing) {
+        m_isProcessing = processing;
+        emit processingChanged();
+        if (processing && !m_isSpeaking) setStatusMessage("Synthesizing speech...");
+    }
+}
+
+// ========================================================================
+// GOOGLE TTS API
+// ========================================================================
+
+QNetworkReply *GoogleTTS::sendToGoogle(const QString &text)
+{
     qDebug() << "GoogleTTS: Sending text to Google TTS API";
 
     // Build JSON request
@@ -215,7 +342,8 @@ void GoogleTTS::sendToGoogle(const QString &text)
     voice["name"] = m_voiceName;
 
     QJsonObject audioConfig;
-    audioConfig["audioEncoding"] = "LINEAR16";
+    // Opus is decoded to LINEAR16 at the same rate before playback
+    audioConfig["audioEncoding"] = m_useOpus ? "OGG_OPUS" : "LINEAR16";
     audioConfig["sampleRateHertz"] = SAMPLE_RATE;
     audioConfig["speakingRate"] = m_speakingRate;
     audioConfig["pitch"] = m_pitch;
@@ -236,23 +364,37 @@ void GoogleTTS::sendToGoogle(const QString &text)
     QByteArray requestData = QJsonDocument(request).toJson(QJsonDocument::Compact);
     qDebug() << "GoogleTTS: Request size:" << requestData.size() << "bytes";
 
-    m_currentReply = m_networkManager->post(networkRequest, requestData);
+    QNetworkReply *reply = m_networkManager->post(networkRequest, requestData);
 
     // Connect reply signals
-    connect(m_currentReply, &QNetworkReply::errorOccurred,
+    connect(reply, &QNetworkReply::errorOccurred,
             this, &GoogleTTS::onNetworkError);
+    reply->setProperty("opus", m_useOpus);
+    return reply;
 }
 
 void GoogleTTS::onNetworkReply(QNetworkReply *reply)
 {
-    // Safety check - if this reply was already handled or aborted, skip it
-    if (reply != m_currentReply) {
+    if (reply == m_prewarmReply) {
+        m_prewarmReply = nullptr;
         reply->deleteLater();
+        onPrewarmReply(reply);
         return;
     }
 
-    m_isProcessing = false;
-    emit processingChanged();
+    // Safety check - if this reply was already handled or aborted, skip it
+    int index = -1;
+    for (int i = 0; i < m_segments.size(); ++i) {
+        if (m_segments[i].reply == reply) {
+            index = i;
+            break;
+        }
+    }
+    reply->deleteLater();
+    if (index < 0) {
+        return;
+    }
+    m_segments[index].reply = nullptr;
 
     int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     QByteArray responseData = reply->readAll();
@@ -260,16 +402,20 @@ void GoogleTTS::onNetworkReply(QNetworkReply *reply)
     qDebug() << "GoogleTTS: HTTP Status Code:" << statusCode;
     qDebug() << "GoogleTTS: Response size:" << responseData.size() << "bytes";
 
+    // Any failure ends the whole utterance, whichever sentence it was
+    auto fail = [this](const QString &message, const QString &status) {
+        emit error(message);
+        setStatusMessage(status);
+        clearQueue();
+        reset();
+        emit speechFinished();
+    };
+
     if (reply->error() != QNetworkReply::NoError) {
         QString errorMsg = reply->errorString();
         qWarning() << "GoogleTTS: Network error:" << errorMsg;
         qWarning() << "GoogleTTS: Response body:" << responseData;
-        emit error("TTS error: " + errorMsg);
-        setStatusMessage("Error: " + errorMsg);
-        reply->deleteLater();
-        m_currentReply = nullptr;
-        reset();
-        emit speechFinished();
+        fail("TTS error: " + errorMsg, "Error: " + errorMsg);
         return;
     }
 
@@ -277,12 +423,7 @@ void GoogleTTS::onNetworkReply(QNetworkReply *reply)
     QJsonDocument doc = QJsonDocument::fromJson(responseData);
     if (doc.isNull() || !doc.isObject()) {
         qWarning() << "GoogleTTS: Invalid JSON response";
-        emit error("Invalid response from Google");
-        setStatusMessage("Error: Invalid response");
-        reply->deleteLater();
-        m_currentReply = nullptr;
-        reset();
-        emit speechFinished();
+        fail("Invalid response from Google", "Error: Invalid response");
         return;
     }
 
@@ -293,70 +434,179 @@ void GoogleTTS::onNetworkReply(QNetworkReply *reply)
         QJsonObject errorObj = response["error"].toObject();
         QString errorMessage = errorObj["message"].toString();
         qWarning() << "GoogleTTS: API error:" << errorMessage;
-        emit error("Google TTS error: " + errorMessage);
-        setStatusMessage("Error: " + errorMessage);
-        reply->deleteLater();
-        m_currentReply = nullptr;
-        reset();
-        emit speechFinished();
+        fail("Google TTS error: " + errorMessage, "Error: " + errorMessage);
         return;
     }
 
     // Extract audio content
-    if (response.contains("audioContent")) {
-        QString audioContentBase64 = response["audioContent"].toString();
-        QByteArray audioData = QByteArray::fromBase64(audioContentBase64.toLatin1());
-
-        if (audioData.isEmpty()) {
-            qWarning() << "GoogleTTS: Base64 decode produced empty audio data";
-            emit error("Invalid audio data received");
-            setStatusMessage("Error: Invalid audio data");
-            m_pendingSpeakText.clear();
-            emit speechFinished();
-            reply->deleteLater();
-            m_currentReply = nullptr;
-            return;
-        }
+    QByteArray audioData = QByteArray::fromBase64(response["audioContent"].toString().toLatin1());
+    if (audioData.isEmpty()) {
+        qWarning() << "GoogleTTS: No audio data in response";
+        fail("No audio data received", "Error: No audio data");
+        return;
+    }
 
-        qDebug() << "GoogleTTS: Received audio data:" << audioData.size() << "bytes";
+    const bool opus = reply->property("opus").toBool();
+    qDebug() << "GoogleTTS: Received audio data:" << audioData.size() << "bytes"
+             << (opus ? "OGG_OPUS" : "LINEAR16");
 
-        // Cache short phrases for instant playback next time (cap at 20 entries)
-        if (m_pendingSpeakText.length() <= MAX_CACHE_TEXT_LENGTH && !m_pendingSpeakText.isEmpty()) {
-            if (m_audioCache.size() >= MAX_CACHE_ENTRIES && !m_audioCache.contains(m_pendingSpeakText)) {
-                // Evict oldest entry (arbitrary — QHash has no order, just remove one)
-                m_audioCache.erase(m_audioCache.begin());
-            }
-            m_audioCache[m_pendingSpeakText] = audioData;
-            qDebug() << "GoogleTTS: Cached audio for:" << m_pendingSpeakText
-                     << "(" << m_audioCache.size() << "entries)";
+    if (opus) {
+        m_segments[index].decodeJob = m_codec->submit(AudioCodecThread::Job::DecodeOpus, audioData, SAMPLE_RATE);
+        return;
+    }
+    segmentAudioReady(index, audioData);
+}
+
+void GoogleTTS::onAudioDecoded(quint64 job, const QByteArray &pcm, qint64 elapsedUs)
+{
+    if (job == m_prewarmDecodeJob) {
+        m_prewarmDecodeJob = 0;
+        if (!pcm.isEmpty()) m_cache->store(m_prewarmKey, m_prewarmText, pcm);
+        prewarmNext();
+        return;
+    }
+
+    // Not found: the utterance was stopped while decoding
+    int index = -1;
+    for (int i = 0; i < m_segments.size(); ++i) {
+        if (m_segments[i].decodeJob == job) {
+            index = i;
+            break;
         }
-        m_pendingSpeakText.clear();
+    }
+    if (index < 0) {
+        return;
+    }
+    m_segments[index].decodeJob = 0;
+
+    if (pcm.isEmpty()) {
+        // Don't lose the sentence: fetch it again uncompressed, and stay on
+        // LINEAR16 from now on
+        qWarning() << "GoogleTTS: Opus decode failed - switching to LINEAR16";
+        m_useOpus = false;
+        m_segments[index].reply = sendToGoogle(m_segments[index].text);
+        updateProcessing();
+        return;
+    }
 
-        // Play the audio
-        playAudio(audioData);
-    } else {
-        qWarning() << "GoogleTTS: No audioContent in response";
-        emit error("No audio data received");
-        setStatusMessage("Error: No audio data");
-        emit speechFinished();
+    qDebug() << "GoogleTTS: Decoded" << pcm.size() << "bytes in" << elapsedUs / 1000.0 << "ms";
+    segmentAudioReady(index, pcm);
+}
+
+void GoogleTTS::segmentAudioReady(int index, const QByteArray &pcm)
+{
+    // Cache for instant playback next time, this run or the next
+    Segment &segment = m_segments[index];
+    if (segment.text.length() <= MAX_CACHE_TEXT_LENGTH) {
+        m_cache->store(segment.cacheKey, segment.text, pcm);
     }
 
-    reply->deleteLater();
-    m_currentReply = nullptr;
+    segment.audio = pcm;
+    segment.ready = true;
+
+    // Keep the pipeline full, and play if this was the one being waited on
+    synthesizeAhead();
+    playNextSegment();
 }
 
 void GoogleTTS::onNetworkError(QNetworkReply::NetworkError error)
 {
     Q_UNUSED(error);
 
-    if (!m_currentReply) {
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply) {
         return;
     }
 
-    // Log the error here but do NOT delete/null m_currentReply.
+    // Log the error here but do NOT delete the reply.
     // The QNetworkAccessManager::finished signal always fires after errorOccurred,
     // and onNetworkReply handles cleanup. Deleting here causes double-deletion.
-    qWarning() << "GoogleTTS: Network error:" << m_currentReply->errorString();
+    qWarning() << "GoogleTTS: Network error:" << reply->errorString();
+}
+
+// ========================================================================
+// CACHE PRE-WARMING
+// ========================================================================
+
+QString GoogleTTS::cacheKey(const QString &text) const
+{
+    return TtsAudioCache::makeKey(text, m_languageCode + '/' + m_voiceName, m_speakingRate, m_pitch);
+}
+
+void GoogleTTS::prewarm(const QStringList &phrases)
+{
+    QStringList texts = phrases;
+    for (const QString &text : m_cache->mostUsed(PREWARM_MOST_USED)) {
+        if (!texts.contains(text)) texts.append(text);
+    }
+
+    const bool idle = m_prewarmQueue.isEmpty() && !m_prewarmReply && !m_prewarmDecodeJob;
+    for (const QString &text : texts) {
+        if (!m_prewarmQueue.contains(text)) m_prewarmQueue.append(text);
+    }
+    qDebug() << "GoogleTTS: Pre-warming" << m_prewarmQueue.size() << "phrases";
+
+    if (idle) {
+        QTimer::singleShot(PREWARM_START_DELAY_MS, this, &GoogleTTS::prewarmNext);
+    }
+}
+
+void GoogleTTS::prewarmNext()
+{
+    while (!m_prewarmQueue.isEmpty() && !m_prewarmReply && !m_prewarmDecodeJob) {
+        const QString text = m_prewarmQueue.first();
+        const QString key = cacheKey(text);
+
+        // Already on disk: just bring it into memory
+        if (m_cache->preload(key)) {
+            m_prewarmQueue.removeFirst();
+            continue;
+        }
+
+        if (m_apiKey.isEmpty()) {
+            qDebug() << "GoogleTTS: No API key - skipping pre-warm of" << m_prewarmQueue.size() << "phrases";
+            m_prewarmQueue.clear();
+            return;
+        }
+
+        // Speech being synthesized or played takes priority
+        if (m_isSpeaking || !m_segments.isEmpty()) {
+            QTimer::singleShot(PREWARM_RETRY_MS, this, &GoogleTTS::prewarmNext);
+            return;
+        }
+
+        m_prewarmQueue.removeFirst();
+        m_prewarmText = text;
+        m_prewarmKey = key;
+        m_prewarmReply = sendToGoogle(text);
+        return;
+    }
+
+    if (m_prewarmQueue.isEmpty() && !m_prewarmReply && !m_prewarmDecodeJob) {
+        qDebug() << "GoogleTTS: Pre-warm complete -" << m_cache->size() << "cached,"
+                 << m_cache->diskBytes() << "bytes on disk";
+    }
+}
+
+void GoogleTTS::onPrewarmReply(QNetworkReply *reply)
+{
+    const QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+    const QByteArray audioData = QByteArray::fromBase64(response["audioContent"].toString().toLatin1());
+
+    if (reply->error() != QNetworkReply::NoError || audioData.isEmpty()) {
+        // Most likely offline at boot; the next start tries again
+        qWarning() << "GoogleTTS: Pre-warm failed for" << m_prewarmText << "-" << reply->errorString()
+                   << "- dropping" << m_prewarmQueue.size() << "remaining";
+        m_prewarmQueue.clear();
+        return;
+    }
+
+    if (reply->property("opus").toBool()) {
+        m_prewarmDecodeJob = m_codec->submit(AudioCodecThread::Job::DecodeOpus, audioData, SAMPLE_RATE);
+        return;
+    }
+    m_cache->store(m_prewarmKey, m_prewarmText, audioData);
+    prewarmNext();
 }
 
 // ========================================================================
@@ -426,14 +676,18 @@ void GoogleTTS::playAudio(const QByteArray &audioData)
         return;
     }
 
-    // Store audio data in buffer - make a copy to ensure ownership
-    m_audioData = audioData;
-    m_audioBuffer = new QBuffer(&m_audioData, this);
+    // The buffer owns its copy, so a previous buffer still being torn down
+    // by reset() never shares data with this one
+    m_audioBuffer = new QBuffer(this);
+    m_audioBuffer->setData(audioData);
     m_audioBuffer->open(QIODevice::ReadOnly);
 
-    m_isSpeaking = true;
-    emit speakingChanged();
-    emit speechStarted();
+    // Once per utterance, not per sentence
+    if (!m_isSpeaking) {
+        m_isSpeaking = true;
+        emit speakingChanged();
+        emit speechStarted();
+    }
     setStatusMessage("Speaking...");
 
     // Start playback
@@ -448,12 +702,12 @@ void GoogleTTS::onAudioStateChanged(QAudio::State state)
 
     switch (state) {
     case QAudio::IdleState:
-        // Playback finished
-        if (m_isSpeaking) {
-            qDebug() << "GoogleTTS: Playback finished";
-            emit speechFinished();
-            setStatusMessage("Ready");
-            reset();
+        // Sentence finished; play the next one (or finish) once we're out
+        // of the sink's callback, since that replaces the sink
+        if (m_isSpeaking && m_playingSegment) {
+            m_playingSegment = false;
+            if (!m_segments.isEmpty()) m_segments.removeFirst();
+            QMetaObject::invokeMethod(this, &GoogleTTS::playNextSegment, Qt::QueuedConnection);
         }
         break;
 
@@ -465,6 +719,7 @@ void GoogleTTS::onAudioStateChanged(QAudio::State state)
                 emit error("Audio playback error");
                 setStatusMessage("Error: Playback failed");
             }
+            clearQueue();
             reset();
         }
         break;
@@ -494,28 +749,29 @@ void GoogleTTS::setStatusMessage(const QString &msg)
 
 void GoogleTTS::reset()
 {
-    // Schedule cleanup to happen after we exit the current callback
-    // This is important when reset() is called from onAudioStateChanged
-    // Use QPointer guard: if GoogleTTS is destroyed before the lambda
-    // runs, the QPointer goes null and we skip the cleanup safely.
-    QPointer<GoogleTTS> guard(this);
-    QMetaObject::invokeMethod(this, [guard]() {
-        if (!guard) return;
-        // Disconnect first to prevent any further callbacks
-        if (guard->m_audioSink) {
-            guard->disconnect(guard->m_audioSink, &QAudioSink::stateChanged,
-                       guard, &GoogleTTS::onAudioStateChanged);
-            delete guard->m_audioSink;
-            guard->m_audioSink = nullptr;
-        }
+    // Take the current sink and buffer now, so a speak() that starts before
+    // the deferred cleanup runs gets fresh ones that the cleanup never sees
+    QAudioSink *sink = m_audioSink;
+    QBuffer *buffer = m_audioBuffer;
+    m_audioSink = nullptr;
+    m_audioBuffer = nullptr;
 
-        if (guard->m_audioBuffer) {
-            guard->m_audioBuffer->close();
-            delete guard->m_audioBuffer;
-            guard->m_audioBuffer = nullptr;
-        }
+    // Disconnect first to prevent any further callbacks
+    if (sink) {
+        disconnect(sink, &QAudioSink::stateChanged, this, &GoogleTTS::onAudioStateChanged);
+    }
 
-        guard->m_audioData.clear();
+    // Delete after we exit the current callback - reset() is called from
+    // onAudioStateChanged, inside the sink's own signal
+    QMetaObject::invokeMethod(this, [sink, buffer]() {
+        if (sink) {
+            sink->stop();
+            delete sink;
+        }
+        if (buffer) {
+            buffer->close();
+            delete buffer;
+        }
     }, Qt::QueuedConnection);
 
     // Update state immediately
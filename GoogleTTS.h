@@ -10,7 +10,11 @@
 #include <QAudioFormat>
 #include <QBuffer>
 #include <QMediaDevices>
-#include <QHash>
+#include <QList>
+#include <QStringList>
+
+class TtsAudioCache;
+class AudioCodecThread;
 
 /**
  * GoogleTTS - Google Cloud Text-to-Speech Integration
@@ -24,12 +28,24 @@
  * - Adjustable speaking rate and pitch
  * - Simple REST API integration
  * - Automatic audio playback
+ * - Sentence queue: playback of the first sentence starts while later ones
+ *   are still being written and synthesized
+ * - Persistent audio cache (TtsAudioCache): sentences said before play
+ *   without a network request, across restarts, and a phrase list can be
+ *   synthesized ahead of time with prewarm()
+ * - Audio is downloaded as Ogg Opus when libopus is available and decoded
+ *   on a worker thread; LINEAR16 otherwise
  *
  * Usage:
  *   GoogleTTS *tts = new GoogleTTS(this);
  *   tts->setApiKey("AIza...");
  *   connect(tts, &GoogleTTS::speechFinished, ...);
  *   tts->speak("Hello, world!");
+ *
+ *   // Or sentence by sentence, as text streams in
+ *   tts->enqueue("First sentence.");
+ *   tts->enqueue("Second sentence.");
+ *   tts->finishQueue();   // speechFinished once both have played
  */
 class GoogleTTS : public QObject
 {
@@ -108,10 +124,33 @@ public slots:
     void speak(const QString &text);
 
     /**
-     * Stop current speech playback
+     * Add a sentence to the utterance being spoken, or start one. Up to
+     * MAX_SYNTHESIS_AHEAD sentences are synthesized while earlier ones play.
+     * The utterance stays open for more until finishQueue().
+     * @param text: The next sentence
+     */
+    void enqueue(const QString &text);
+
+    /**
+     * No more sentences for the current utterance; speechFinished follows
+     * once everything queued has played
+     */
+    void finishQueue();
+
+    /**
+     * Stop current speech playback and drop anything queued
      */
     void stop();
 
+    /**
+     * Make sure phrases play from the cache: the given ones plus the most
+     * used responses are loaded into memory, and any not cached for the
+     * current voice are synthesized one at a time while nothing is being
+     * spoken. Call after the voice is configured.
+     * @param phrases: Fixed prompts and acknowledgements
+     */
+    void prewarm(const QStringList &phrases);
+
 signals:
     // ========== SIGNALS ==========
 
@@ -151,13 +190,61 @@ private slots:
      */
     void onAudioStateChanged(QAudio::State state);
 
+    /**
+     * Handle Opus audio decoded on the codec thread
+     */
+    void onAudioDecoded(quint64 job, const QByteArray &pcm, qint64 elapsedUs);
+
 private:
     // ========== HELPER METHODS ==========
 
     /**
      * Send text to Google TTS API
      */
-    void sendToGoogle(const QString &text);
+    QNetworkReply *sendToGoogle(const QString &text);
+
+    /**
+     * Start synthesis for queued sentences, up to MAX_SYNTHESIS_AHEAD at once
+     */
+    void synthesizeAhead();
+
+    /**
+     * Decoded audio for a sentence has arrived: cache it, then play or
+     * keep synthesizing
+     */
+    void segmentAudioReady(int index, const QByteArray &pcm);
+
+    /**
+     * Play the next sentence if it is ready and nothing is playing; finish
+     * the utterance when the queue is closed and empty
+     */
+    void playNextSegment();
+
+    /**
+     * Abort all synthesis and drop the queue
+     */
+    void clearQueue();
+
+    /**
+     * Update isProcessing from the requests in flight
+     */
+    void updateProcessing();
+
+    /**
+     * Cache key for text in the current voice settings
+     */
+    QString cacheKey(const QString &text) const;
+
+    /**
+     * Warm the next pre-warm phrase: load it if cached, otherwise
+     * synthesize it once nothing else is using the API
+     */
+    void prewarmNext();
+
+    /**
+     * Store the audio of a finished pre-warm request and move on
+     */
+    void onPrewarmReply(QNetworkReply *reply);
 
     /**
      * Initialize audio output
@@ -183,7 +270,6 @@ private:
 
     // Network
     QNetworkAccessManager *m_networkManager;
-    QNetworkReply *m_currentReply;
 
     // Configuration
     QString m_apiKey;
@@ -196,18 +282,44 @@ private:
     QAudioSink *m_audioSink;
     QBuffer *m_audioBuffer;
     QAudioFormat m_audioFormat;
-    QByteArray m_audioData;
 
     // State
     bool m_isSpeaking;
     bool m_isProcessing;
     QString m_statusMessage;
 
-    // Audio cache for short phrases (ready prompts, acknowledgments)
-    QHash<QString, QByteArray> m_audioCache;
-    QString m_pendingSpeakText;  // Text being synthesized (for caching)
-    static constexpr int MAX_CACHE_TEXT_LENGTH = 50;  // Only cache short phrases
-    static constexpr int MAX_CACHE_ENTRIES = 20;       // Cap cache size
+    // Sentence queue for the current utterance; the first is playing or
+    // plays next
+    struct Segment {
+        QString text;
+        QString cacheKey;                // Voice settings when it was requested
+        QByteArray audio;
+        QNetworkReply *reply = nullptr;  // While synthesizing
+        quint64 decodeJob = 0;           // While decoding
+        bool ready = false;
+    };
+    QList<Segment> m_segments;
+    bool m_queueOpen = false;        // More sentences may be enqueued
+    bool m_playingSegment = false;   // m_segments.first() is in the sink
+    static constexpr int MAX_SYNTHESIS_AHEAD = 3;
+
+    // Audio cache, persistent across restarts
+    TtsAudioCache *m_cache;
+    static constexpr int MAX_CACHE_TEXT_LENGTH = 200;  // Longer answers are rarely said twice
+
+    // Opus transport
+    AudioCodecThread *m_codec;
+    bool m_useOpus;                  // Cleared if a decode ever fails
+
+    // Startup pre-warming
+    QStringList m_prewarmQueue;
+    QNetworkReply *m_prewarmReply = nullptr;
+    quint64 m_prewarmDecodeJob = 0;
+    QString m_prewarmText;
+    QString m_prewarmKey;
+    static constexpr int PREWARM_START_DELAY_MS = 3000;   // Let startup settle first
+    static constexpr int PREWARM_RETRY_MS = 2000;         // While speech is in progress
+    static constexpr int PREWARM_MOST_USED = 20;
 
     // Constants
     static constexpr const char* API_ENDPOINT = "https://texttospeech.googleapis.com/v1/text:synthesize";
@@ -1,88 +1,79 @@
 #include "HighwayCameraManager.h"
-#include "GeoUtils.h"
+#include "RefreshScheduler.h"
+#include "Route.h"
+#include "RouteProgressTracker.h"
+#include "SpatialTileCache.h"
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrlQuery>
 #include <QtMath>
 
+namespace {
+
+const QString kLayer = QStringLiteral("cameras");
+
+// Cameras rarely move; a week-old cache is still worth showing
+constexpr qint64 kMaxCameraAgeMs = 7LL * 24 * 60 * 60 * 1000;
+
+} // namespace
+
 HighwayCameraManager::HighwayCameraManager(QObject *parent)
     : QObject(parent)
-    , m_albertaNetwork(new QNetworkAccessManager(this))
-    , m_drivebcNetwork(new QNetworkAccessManager(this))
-    , m_refreshTimer(new QTimer(this))
 {
-    connect(m_albertaNetwork, &QNetworkAccessManager::finished,
-            this, &HighwayCameraManager::onAlbertaReply);
-    connect(m_drivebcNetwork, &QNetworkAccessManager::finished,
-            this, &HighwayCameraManager::onDriveBCReply);
-
-    // Refresh every 5 minutes
-    m_refreshTimer->setInterval(5 * 60 * 1000);
-    connect(m_refreshTimer, &QTimer::timeout, this, &HighwayCameraManager::fetchCameras);
-
     qDebug() << "HighwayCameraManager: Initialized";
 }
 
-void HighwayCameraManager::setRouteCoordinates(const QJsonArray &coordinates, double durationSec)
+void HighwayCameraManager::setSpatialTileCache(SpatialTileCache *cache) { m_cache = cache; }
+void HighwayCameraManager::setFeedFetcher(FeedFetcher *fetcher) { m_fetcher = fetcher; }
+void HighwayCameraManager::setRouteProgressTracker(RouteProgressTracker *tracker) { m_tracker = tracker; }
+
+void HighwayCameraManager::setRefreshScheduler(RefreshScheduler *scheduler)
 {
-    Q_UNUSED(durationSec)
+    m_scheduler = scheduler;
+    // Refresh every 5 minutes
+    m_refreshTask = scheduler->add("cameras", 5 * 60 * 1000, this, [this]() { fetchCameras(); });
+}
 
-    if (coordinates.size() < 2) {
+void HighwayCameraManager::setRoute(const std::shared_ptr<const Route> &route)
+{
+    if (!route) {
         clearRoute();
         return;
     }
 
     ++m_generation;
-    sampleRoutePoints(coordinates);
+    m_route = route;
 
     m_active = true;
     emit activeChanged();
 
+    // Answer from the cache straight away; the fetch refreshes it
+    if (m_cache && m_cache->size(kLayer) > 0) processResults();
+
     fetchCameras();
-    m_refreshTimer->start();
+    if (m_scheduler) m_scheduler->start(m_refreshTask);
 
-    qDebug() << "HighwayCameraManager: Tracking route with" << m_routePoints.size() << "sample points";
+    qDebug() << "HighwayCameraManager: Tracking" << m_route->totalKm() << "km route";
 }
 
 void HighwayCameraManager::clearRoute()
 {
     ++m_generation;
     m_active = false;
-    m_routePoints.clear();
-    m_allCameras.clear();
-    m_routeCameras.clear();
+    m_route.reset();
     m_camerasJson = QJsonArray();
-    m_refreshTimer->stop();
+    if (m_scheduler) m_scheduler->stop(m_refreshTask);
     emit activeChanged();
     emit camerasChanged();
 
     qDebug() << "HighwayCameraManager: Route cleared";
 }
 
-void HighwayCameraManager::sampleRoutePoints(const QJsonArray &coordinates)
-{
-    m_routePoints.clear();
-    int numCoords = coordinates.size();
-    // Sample ~20 points along the route for proximity checks
-    int numSamples = qMin(20, numCoords);
-    if (numSamples < 2) numSamples = 2;
-
-    for (int i = 0; i < numSamples; ++i) {
-        double fraction = static_cast<double>(i) / (numSamples - 1);
-        int idx = qMin(static_cast<int>(fraction * (numCoords - 1)), numCoords - 1);
-
-        QJsonArray coord = coordinates[idx].toArray();
-        if (coord.size() >= 2) {
-            m_routePoints.append({ coord[1].toDouble(), coord[0].toDouble() }); // lat, lon
-        }
-    }
-}
-
 void HighwayCameraManager::fetchCameras()
 {
+    if (!m_fetcher) return;
     ++m_generation;
-    m_allCameras.clear();
     m_pendingRequests = 0;
 
     // 511 Alberta cameras
@@ -90,37 +81,39 @@ void HighwayCameraManager::fetchCameras()
     QUrl abUrl("https://511.alberta.ca/api/v2/get/cameras");
     QNetworkRequest abReq(abUrl);
     abReq.setRawHeader("Accept", "application/json");
-    abReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_albertaNetwork->get(abReq);
+    m_fetcher->get("cameras/511AB", abReq, this, [this, gen = m_generation](const FeedFetcher::Result &r) {
+        onAlbertaReply(r, gen == m_generation);
+    });
 
     // DriveBC webcams
     m_pendingRequests++;
     QUrl bcUrl("https://www.drivebc.ca/api/webcams/");
     QNetworkRequest bcReq(bcUrl);
     bcReq.setRawHeader("Accept", "application/json");
-    bcReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_drivebcNetwork->get(bcReq);
+    m_fetcher->get("cameras/DriveBC", bcReq, this, [this, gen = m_generation](const FeedFetcher::Result &r) {
+        onDriveBCReply(r, gen == m_generation);
+    });
 
     qDebug() << "HighwayCameraManager: Fetching cameras from 511AB and DriveBC";
 }
 
-void HighwayCameraManager::onAlbertaReply(QNetworkReply *reply)
+void HighwayCameraManager::onAlbertaReply(const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "HighwayCameraManager: Alberta fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "HighwayCameraManager: Alberta fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processResults();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "511AB");
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonArray cameras = doc.array();
+    QList<SpatialTileCache::Feature> snapshot;
 
     for (const QJsonValue &v : cameras) {
         QJsonObject obj = v.toObject();
@@ -141,41 +134,42 @@ void HighwayCameraManager::onAlbertaReply(QNetworkReply *reply)
         }
         if (imageUrl.isEmpty()) continue;
 
-        Camera cam;
+        SpatialTileCache::Feature cam;
         cam.id = QString("ab-%1").arg(obj["Id"].toString());
-        cam.name = obj["Name"].toString();
-        cam.imageUrl = imageUrl;
         cam.lat = lat;
         cam.lon = lon;
-        cam.direction = obj["Direction"].toString();
-        cam.roadName = obj["Roadway"].toString();
-        cam.source = "511AB";
-
-        m_allCameras.append(cam);
+        cam.data = {
+            { "name", obj["Name"].toString() },
+            { "imageUrl", imageUrl },
+            { "direction", obj["Direction"].toString() },
+            { "roadName", obj["Roadway"].toString() },
+        };
+        snapshot.append(cam);
     }
 
     qDebug() << "HighwayCameraManager: Alberta returned" << cameras.size() << "cameras";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processResults();
+    // An unparseable body isn't an empty feed; keep what the cache has
+    if (m_cache && doc.isArray()) m_cache->syncSource(kLayer, "511AB", snapshot);
+    replyDone(current);
 }
 
-void HighwayCameraManager::onDriveBCReply(QNetworkReply *reply)
+void HighwayCameraManager::onDriveBCReply(const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "HighwayCameraManager: DriveBC fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "HighwayCameraManager: DriveBC fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processResults();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "DriveBC");
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonArray webcams = doc.array();
+    QList<SpatialTileCache::Feature> snapshot;
 
     for (const QJsonValue &v : webcams) {
         QJsonObject obj = v.toObject();
@@ -192,65 +186,62 @@ void HighwayCameraManager::onDriveBCReply(QNetworkReply *reply)
         QString imageUrl = links["imageDisplay"].toString();
         if (imageUrl.isEmpty()) continue;
 
-        Camera cam;
+        SpatialTileCache::Feature cam;
         cam.id = QString("bc-%1").arg(obj["id"].toInt());
-        cam.name = obj["camName"].toString();
-        cam.imageUrl = imageUrl;
         cam.lat = lat;
         cam.lon = lon;
-        cam.direction = obj["caption"].toString();
-        cam.roadName = obj["highway"].toString();
-        cam.source = "DriveBC";
-
-        m_allCameras.append(cam);
+        cam.data = {
+            { "name", obj["camName"].toString() },
+            { "imageUrl", imageUrl },
+            { "direction", obj["caption"].toString() },
+            { "roadName", obj["highway"].toString() },
+        };
+        snapshot.append(cam);
     }
 
     qDebug() << "HighwayCameraManager: DriveBC returned" << webcams.size() << "webcams";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processResults();
+    if (m_cache && doc.isArray()) m_cache->syncSource(kLayer, "DriveBC", snapshot);
+    replyDone(current);
 }
 
-void HighwayCameraManager::processResults()
+void HighwayCameraManager::replyDone(bool current)
 {
-    m_routeCameras.clear();
+    // Superseded replies still land in the cache, since their validators are
+    // already saved; only the current fetch counts toward completion.
+    if (current) m_pendingRequests--;
+    if (m_pendingRequests <= 0 && m_active) processResults();
+}
 
-    // Filter cameras near route (within 15km of any route sample point)
-    for (const auto &cam : m_allCameras) {
-        if (isNearRoute(cam.lat, cam.lon, 15.0)) {
-            m_routeCameras.append(cam);
-        }
-    }
+void HighwayCameraManager::processResults()
+{
+    // Cameras within 15km of the route line, in route order
+    QList<SpatialTileCache::Hit> hits;
+    if (m_cache && m_route)
+        hits = m_cache->nearRoute(kLayer, m_route->index(), 15.0, kMaxCameraAgeMs);
+
+    // Build QJsonArray for QML consumption. Each camera carries where it is
+    // on the route and when the car gets there, so the view can show the
+    // next ones rather than the closest. ETAs count from the car's position
+    // (negative once passed), from the route start until it is tracked.
+    double carEtaSec = 0.0;
+    if (m_route && m_tracker && m_tracker->tracking() && m_tracker->routeIndex() == m_route->index())
+        carEtaSec = m_route->sampler().etaSecAt(m_tracker->travelledKm());
 
-    // Build QJsonArray for QML consumption
     QJsonArray arr;
-    for (const auto &cam : m_routeCameras) {
-        QJsonObject obj;
-        obj["id"] = cam.id;
-        obj["name"] = cam.name;
-        obj["imageUrl"] = cam.imageUrl;
-        obj["lat"] = cam.lat;
-        obj["lon"] = cam.lon;
-        obj["direction"] = cam.direction;
-        obj["roadName"] = cam.roadName;
-        obj["source"] = cam.source;
+    for (const auto &hit : hits) {
+        QJsonObject obj = QJsonObject::fromVariantMap(hit.feature.data);
+        obj["id"] = hit.feature.id;
+        obj["lat"] = hit.feature.lat;
+        obj["lon"] = hit.feature.lon;
+        obj["source"] = hit.feature.source;
+        obj["alongKm"] = hit.match.alongKm;
+        obj["etaMinutes"] = qRound((m_route->sampler().etaSecAt(hit.match.alongKm) - carEtaSec) / 60.0);
         arr.append(obj);
     }
     m_camerasJson = arr;
 
     emit camerasChanged();
 
-    qDebug() << "HighwayCameraManager:" << m_allCameras.size() << "total cameras,"
-             << m_routeCameras.size() << "near route";
-}
-
-bool HighwayCameraManager::isNearRoute(double lat, double lon, double radiusKm) const
-{
-    // Check against sampled route points
-    for (const auto &pt : m_routePoints) {
-        if (GeoUtils::haversineKm(lat, lon, pt.lat, pt.lon) < radiusKm) {
-            return true;
-        }
-    }
-    return false;
+    qDebug() << "HighwayCameraManager:" << (m_cache ? m_cache->size(kLayer) : 0) << "cached cameras,"
+             << arr.size() << "near route";
 }
-
@@ -4,9 +4,14 @@
 #include <QObject>
 #include <QString>
 #include <QJsonArray>
-#include <QTimer>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <memory>
+
+#include "FeedFetcher.h"
+
+class RefreshScheduler;
+class Route;
+class RouteProgressTracker;
+class SpatialTileCache;
 
 class HighwayCameraManager : public QObject
 {
@@ -18,12 +23,19 @@ class HighwayCameraManager : public QObject
 public:
     explicit HighwayCameraManager(QObject *parent = nullptr);
 
+    void setSpatialTileCache(SpatialTileCache *cache);
+    void setFeedFetcher(FeedFetcher *fetcher);
+    void setRefreshScheduler(RefreshScheduler *scheduler);
+    void setRouteProgressTracker(RouteProgressTracker *tracker);
+
     bool active() const { return m_active; }
     QJsonArray cameras() const { return m_camerasJson; }
     int cameraCount() const { return m_camerasJson.size(); }
 
+    // From RouteLoader::routeChanged
+    void setRoute(const std::shared_ptr<const Route> &route);
+
 public slots:
-    void setRouteCoordinates(const QJsonArray &coordinates, double durationSec);
     void clearRoute();
 
 signals:
@@ -32,37 +44,23 @@ signals:
 
 private slots:
     void fetchCameras();
-    void onAlbertaReply(QNetworkReply *reply);
-    void onDriveBCReply(QNetworkReply *reply);
 
 private:
-    struct Camera {
-        QString id;
-        QString name;
-        QString imageUrl;
-        double lat = 0.0;
-        double lon = 0.0;
-        QString direction;
-        QString roadName;
-        QString source;
-    };
-
-    struct RoutePoint { double lat = 0.0; double lon = 0.0; };
-
+    void onAlbertaReply(const FeedFetcher::Result &result, bool current);
+    void onDriveBCReply(const FeedFetcher::Result &result, bool current);
+    void replyDone(bool current);
     void processResults();
-    void sampleRoutePoints(const QJsonArray &coordinates);
-    bool isNearRoute(double lat, double lon, double radiusKm) const;
 
-    QNetworkAccessManager *m_albertaNetwork;
-    QNetworkAccessManager *m_drivebcNetwork;
-    QTimer *m_refreshTimer;
+    SpatialTileCache *m_cache = nullptr;
+    FeedFetcher *m_fetcher = nullptr;
+    RefreshScheduler *m_scheduler = nullptr;
+    RouteProgressTracker *m_tracker = nullptr;
+    int m_refreshTask = -1;
 
     bool m_active = false;
     QJsonArray m_camerasJson;  // For QML consumption
 
-    QList<Camera> m_allCameras;
-    QList<Camera> m_routeCameras;
-    QList<RoutePoint> m_routePoints;
+    std::shared_ptr<const Route> m_route;
     int m_pendingRequests = 0;
     int m_generation = 0;
 };
@@ -1,13 +1,13 @@
 #include "PicovoiceManager.h"
+#include "AudioCaptureThread.h"
 #include "GoogleSTT.h"
+#include "StreamingSTT.h"
 #include <QDebug>
 #include <QAudioFormat>
 #include <QAudioDevice>
 #include <QMediaDevices>
 #include <QFile>
 #include <QDir>
-#include <QDateTime>
-#include <QtMath>
 #include <QCoreApplication>
 #include <QTimer>
 
@@ -27,10 +27,9 @@ PicovoiceManager::PicovoiceManager(QObject *parent)
     , m_leopard(nullptr)
     , m_koala(nullptr)
     , m_googleSTT(nullptr)
+    , m_streamingSTT(nullptr)
     , m_wakeWord("jarvis")
     , m_sensitivity(0.5f)
-    , m_audioSource(nullptr)
-    , m_audioDevice(nullptr)
     , m_frameLength(0)
     , m_sampleRate(0)
     , m_koalaFrameLength(0)
@@ -39,9 +38,6 @@ PicovoiceManager::PicovoiceManager(QObject *parent)
     , m_isPaused(false)
     , m_isInitialized(false)
     , m_wakeWordAvailable(false)
-    , m_speechStartTime(0)
-    , m_lastVoiceActivityTime(0)
-    , m_lastDetectionTime(0)
     , m_followUpTimer(nullptr)
     , m_readyPromptTimer(nullptr)
     , m_speechStartTimer(nullptr)
@@ -58,6 +54,19 @@ PicovoiceManager::PicovoiceManager(QObject *parent)
     connect(m_googleSTT, &GoogleSTT::error,
             this, &PicovoiceManager::onGoogleError);
 
+    // Streaming STT, used once an endpoint is configured
+    m_streamingSTT = new StreamingSTT(this);
+    connect(m_streamingSTT, &StreamingSTT::interimResult,
+            this, &PicovoiceManager::onStreamingInterim);
+    connect(m_streamingSTT, &StreamingSTT::endOfSpeech,
+            this, &PicovoiceManager::onStreamingEndOfSpeech);
+    connect(m_streamingSTT, &StreamingSTT::finalResult,
+            this, &PicovoiceManager::onStreamingFinal);
+    connect(m_streamingSTT, &StreamingSTT::finished,
+            this, &PicovoiceManager::onStreamingFinished);
+    connect(m_streamingSTT, &StreamingSTT::error,
+            this, &PicovoiceManager::onStreamingError);
+
     // Follow-up timer: returns to Listening after 12s silence in follow-up mode
     m_followUpTimer = new QTimer(this);
     m_followUpTimer->setSingleShot(true);
@@ -96,16 +105,10 @@ PicovoiceManager::PicovoiceManager(QObject *parent)
     m_commandTimer->setSingleShot(true);
     m_commandTimer->setInterval(10000);
     connect(m_commandTimer, &QTimer::timeout, this, [this]() {
-        if (m_state == WaitingForCommand) {
+        if (m_state == WaitingForCommand && m_capture) {
             qWarning() << "PicovoiceManager: Rhino command timeout (10s), falling back to STT";
-            if (m_rhino) pv_rhino_reset(m_rhino);
-            // Use accumulated speech buffer for STT
-            if (!m_speechBuffer.isEmpty()) {
-                finalizeLeopardTranscription();
-            } else {
-                resetToListening();
-                emit interactionReset();
-            }
+            // The capture thread hands over what it has recorded (onCaptureUtterance)
+            m_capture->finalize();
         }
     });
 
@@ -195,54 +198,32 @@ void PicovoiceManager::start()
         qWarning() << "PicovoiceManager: Default format not supported, trying to use nearest";
     }
 
-    m_audioSource = new QAudioSource(deviceInfo, format, this);
-    m_audioSource->setBufferSize(4096);  // 128ms at 16kHz mono 16-bit — low latency for voice
-    // Note: media.role=voice_assistant is set via PULSE_PROP in headunit.env for PipeWire/WirePlumber policy
-    m_audioDevice = m_audioSource->start();
-
-    if (!m_audioDevice) {
-        emit error("Failed to start audio input");
-        setStatusMessage("Error: Could not start microphone");
-        delete m_audioSource;
-        m_audioSource = nullptr;
-        return;
-    }
-
-    // Connect to audio ready signal
-    connect(m_audioDevice, &QIODevice::readyRead, this, &PicovoiceManager::onAudioReady);
-
-    // Monitor audio source for errors and auto-recover (with retry limit)
-    connect(m_audioSource, &QAudioSource::stateChanged, this, [this](QAudio::State state) {
-        if (state == QAudio::StoppedState && m_audioSource->error() != QAudio::NoError) {
-            m_audioRecoveryAttempts++;
-            if (m_audioRecoveryAttempts > MAX_AUDIO_RECOVERY_ATTEMPTS) {
-                qCritical() << "PicovoiceManager: Audio recovery failed after"
-                            << MAX_AUDIO_RECOVERY_ATTEMPTS << "attempts, stopping";
-                emit error("Microphone disconnected — restart to retry");
-                return;
-            }
-            qWarning() << "PicovoiceManager: Audio source error:" << m_audioSource->error()
-                       << "— restart attempt" << m_audioRecoveryAttempts;
-            QTimer::singleShot(500, this, [this]() {
-                if (m_audioSource && m_isRunning) {
-                    auto *oldDevice = m_audioDevice;
-                    m_audioDevice = m_audioSource->start();
-                    if (m_audioDevice) {
-                        // Always disconnect old device to prevent duplicate connections
-                        // (Qt may reuse the same QIODevice pointer on restart)
-                        if (oldDevice) {
-                            disconnect(oldDevice, &QIODevice::readyRead, this, &PicovoiceManager::onAudioReady);
-                        }
-                        connect(m_audioDevice, &QIODevice::readyRead, this, &PicovoiceManager::onAudioReady);
-                        m_audioRecoveryAttempts = 0;  // Reset on success
-                        qDebug() << "PicovoiceManager: Audio capture restarted successfully";
-                    } else {
-                        qCritical() << "PicovoiceManager: Failed to restart audio capture";
-                    }
-                }
-            });
-        }
-    });
+    // Capture and wake word / VAD processing run on their own thread, so
+    // a busy GUI thread can't drop audio. The handles stay ours; the thread
+    // only uses them until stop().
+    AudioCaptureThread::Engines engines;
+    engines.porcupine = m_porcupine;
+    engines.rhino = m_rhino;
+    engines.koala = (m_koala && m_koalaFrameLength == m_frameLength) ? m_koala : nullptr;
+    engines.frameLength = m_frameLength;
+    engines.sampleRate = m_sampleRate;
+
+    m_capture = new AudioCaptureThread(deviceInfo, format, engines, ++m_captureGeneration, this);
+    connect(m_capture, &AudioCaptureThread::wakeWordDetected,
+            this, &PicovoiceManager::onCaptureWakeWord, Qt::QueuedConnection);
+    connect(m_capture, &AudioCaptureThread::speechStarted,
+            this, &PicovoiceManager::onCaptureSpeechStarted, Qt::QueuedConnection);
+    connect(m_capture, &AudioCaptureThread::intentDetected,
+            this, &PicovoiceManager::onCaptureIntent, Qt::QueuedConnection);
+    connect(m_capture, &AudioCaptureThread::intentNotUnderstood,
+            this, &PicovoiceManager::onCaptureIntentNotUnderstood, Qt::QueuedConnection);
+    connect(m_capture, &AudioCaptureThread::utteranceEnded,
+            this, &PicovoiceManager::onCaptureUtterance, Qt::QueuedConnection);
+    connect(m_capture, &AudioCaptureThread::speechAudio,
+            this, &PicovoiceManager::onCaptureSpeechAudio, Qt::QueuedConnection);
+    connect(m_capture, &AudioCaptureThread::captureFailed,
+            this, &PicovoiceManager::onCaptureFailed, Qt::QueuedConnection);
+    m_capture->start(QThread::TimeCriticalPriority);
 
     m_isRunning = true;
     m_isPaused = false;
@@ -270,13 +251,13 @@ void PicovoiceManager::stop()
     m_speechStartTimer->stop();
     m_transcriptionTimer->stop();
     m_commandTimer->stop();
+    endStreamingUtterance();
 
-    // Stop audio input
-    if (m_audioSource) {
-        m_audioSource->stop();
-        delete m_audioSource;
-        m_audioSource = nullptr;
-        m_audioDevice = nullptr;  // Deleted by QAudioSource
+    // Stop audio input; the Picovoice handles are ours again after this
+    if (m_capture) {
+        m_capture->stop();
+        delete m_capture;
+        m_capture = nullptr;
     }
 
     m_isRunning = false;
@@ -295,6 +276,7 @@ void PicovoiceManager::pause()
     }
 
     m_isPaused = true;
+    m_capture->setPaused(true);
 
     // Stop ALL active state timers — they'll resume when resume() is called if still relevant.
     // Without this, timers fire during TTS playback and silently reset state.
@@ -315,11 +297,10 @@ void PicovoiceManager::resume()
     }
 
     m_isPaused = false;
-    m_resumeTime = QDateTime::currentMSecsSinceEpoch();
 
-    // Discard any microphone audio captured during the pause (contains TTS echo)
-    if (m_audioDevice) m_audioDevice->readAll();  // Flush OS/driver buffer
-    m_audioBuffer.clear();
+    // Audio captured during the pause was discarded (it contains TTS echo);
+    // skip a little more for the echo's tail
+    m_capture->setPaused(false, POST_RESUME_DEAF_MS);
 
     // Restart the appropriate state timer that was stopped during pause()
     if (m_state == WaitingForReadyPrompt) {
@@ -451,221 +432,121 @@ void PicovoiceManager::setSpeechContextHints(const QStringList &hints)
     if (m_googleSTT) {
         m_googleSTT->setSpeechContextHints(enhancedHints);
     }
+    if (m_streamingSTT) {
+        m_streamingSTT->setSpeechContextHints(enhancedHints);
+    }
     qDebug() << "PicovoiceManager: Speech context hints set:" << enhancedHints.size()
              << "phrases (from" << hints.size() << "names)";
 }
 
-// ========== AUDIO PROCESSING ==========
-
-void PicovoiceManager::onAudioReady()
+void PicovoiceManager::setStreamingSttUrl(const QString &url)
 {
-    if (!m_audioDevice) return;
-
-    // ALWAYS read from device to prevent OS/driver buffer buildup.
-    // Without this, stale audio (including TTS echo) accumulates during pause
-    // and floods the pipeline when we resume.
-    QByteArray data = m_audioDevice->readAll();
-
-    if (m_isPaused) return;  // Discard audio while paused
-
-    // Post-resume deaf period — discard audio for a short window after resume
-    // to avoid TTS echo/reverberation in ALL states (not just WaitingForFollowUp)
-    if (m_resumeTime > 0) {
-        qint64 elapsed = QDateTime::currentMSecsSinceEpoch() - m_resumeTime;
-        if (elapsed < POST_RESUME_DEAF_MS) return;
-        m_resumeTime = 0;  // Clear so we don't check every frame
+    m_streamingSTT->setEndpoint(QUrl(url));
+    if (m_streamingSTT->isConfigured()) {
+        qDebug() << "PicovoiceManager: Streaming STT enabled";
+    } else if (!url.isEmpty()) {
+        qWarning() << "PicovoiceManager: Streaming STT unavailable, using batch STT";
     }
+}
 
-    m_audioBuffer.append(data);
-
-    // Process Porcupine frames (512 samples per frame)
-    // Koala is optional and only applied if initialized
-    const int bytesPerFrame = m_frameLength * sizeof(int16_t);
-
-    while (m_audioBuffer.size() >= bytesPerFrame) {
-        const int16_t *inputFrame = reinterpret_cast<const int16_t*>(m_audioBuffer.constData());
-
-        // Apply Koala noise suppression if available
-        if (m_processedFrame.size() != m_frameLength) {
-            m_processedFrame.resize(m_frameLength);
-        }
-        if (m_koala && m_koalaFrameLength == m_frameLength) {
-            // Koala initialized and frame sizes match - apply noise suppression
-            pv_status_t status = pv_koala_process(m_koala, inputFrame, m_processedFrame.data());
-            if (status != PV_STATUS_SUCCESS) {
-                qWarning() << "PicovoiceManager: Koala process error:" << pv_status_to_string(status);
-                // Continue without noise suppression
-                memcpy(m_processedFrame.data(), inputFrame, bytesPerFrame);
-            }
-        } else {
-            // No Koala or frame size mismatch - use original audio
-            memcpy(m_processedFrame.data(), inputFrame, bytesPerFrame);
-        }
-
-        // Process frame based on current state
-        processAudioFrame(m_processedFrame.data(), m_frameLength);
+// ========== AUDIO PROCESSING ==========
 
-        // Remove processed frame from buffer
-        m_audioBuffer.remove(0, bytesPerFrame);
-    }
+void PicovoiceManager::setCaptureState(State state)
+{
+    m_state = state;
+    if (m_capture) m_capture->setState(state, ++m_captureGeneration);
 }
 
-void PicovoiceManager::processAudioFrame(const int16_t *frame, int32_t length)
+void PicovoiceManager::onCaptureWakeWord(quint32 generation)
 {
-    switch (m_state) {
-        case Listening: {
-            // Track ambient noise floor while idle (for adaptive speech detection)
-            int16_t energy = calculateFrameEnergy(frame, length);
-            m_noiseFloor = m_noiseFloor * (1.0f - NOISE_FLOOR_ALPHA) + energy * NOISE_FLOOR_ALPHA;
-            // Cap noise floor so speech threshold never exceeds ~6000 RMS
-            // (prevents highway wind noise from making speech detection impossible)
-            if (m_noiseFloor > 2000.0f) m_noiseFloor = 2000.0f;
-            processWakeWord(frame);
-            break;
-        }
+    if (generation != m_captureGeneration) return;
 
-        case WaitingForReadyPrompt:
-            // Pre-buffer audio so we capture the user's command even if they start
-            // talking before the ready prompt finishes
-            for (int32_t i = 0; i < length; ++i) {
-                m_speechBuffer.append(frame[i]);
-            }
-            break;
-
-        case WaitingForCommand:
-            processRhinoIntent(frame);
-            break;
-
-        case WaitingForSpeechStart: {
-            // No Rhino: wait for user to start speaking (energy-based detection)
-            // Uses adaptive noise floor — speech must be 3x ambient noise level
-            int16_t energy = calculateFrameEnergy(frame, length);
-            int16_t adaptiveThreshold = (int16_t)(m_noiseFloor * SPEECH_THRESHOLD_RATIO);
-            int16_t threshold = adaptiveThreshold > SILENCE_ENERGY_THRESHOLD ? adaptiveThreshold : SILENCE_ENERGY_THRESHOLD;
-
-            if (energy > threshold) {
-                // Speech detected — transition to ProcessingSpeech
-                m_speechStartTimer->stop();
-                qDebug() << "PicovoiceManager: Speech start detected, recording...";
-                m_state = ProcessingSpeech;
-                m_speechStartTime = QDateTime::currentMSecsSinceEpoch();
-                m_lastVoiceActivityTime = m_speechStartTime;
-                m_speechBuffer.clear();
-                m_speechBuffer.reserve(16000 * 10);
-
-                // Accumulate this frame
-                for (int32_t i = 0; i < length; ++i) {
-                    m_speechBuffer.append(frame[i]);
-                }
-            }
-            break;
-        }
+    qDebug() << "PicovoiceManager: Wake word detected!" << m_wakeWord;
+    emit wakeWordDetected(m_wakeWord);
 
-        case ProcessingSpeech: {
-            // Accumulate audio for Leopard
-            for (int32_t i = 0; i < length; ++i) {
-                m_speechBuffer.append(frame[i]);
-            }
+    // The capture thread is already in WaitingForReadyPrompt, pre-buffering
+    // audio so we capture the user's command even if they start talking early
+    m_state = WaitingForReadyPrompt;
+    m_speechBuffer.clear();
+    m_readyPromptTimer->start();
+    setStatusMessage("Playing ready prompt...");
+    qDebug() << "PicovoiceManager: Waiting for ready prompt to finish...";
+}
 
-            qint64 now = QDateTime::currentMSecsSinceEpoch();
-            qint64 speechDuration = now - m_speechStartTime;
+void PicovoiceManager::onCaptureSpeechStarted(quint32 generation)
+{
+    if (generation != m_captureGeneration) return;
 
-            // Calculate frame energy for VAD (adaptive threshold)
-            int16_t energy = calculateFrameEnergy(frame, length);
-            int16_t adaptiveThreshold = (int16_t)(m_noiseFloor * SPEECH_THRESHOLD_RATIO);
-            int16_t threshold = adaptiveThreshold > SILENCE_ENERGY_THRESHOLD ? adaptiveThreshold : SILENCE_ENERGY_THRESHOLD;
+    // From WaitingForSpeechStart or WaitingForFollowUp
+    m_speechStartTimer->stop();
+    m_followUpTimer->stop();
+    m_state = ProcessingSpeech;
+    qDebug() << "PicovoiceManager: Speech start detected, recording...";
+    beginStreamingUtterance();
+}
 
-            // Track voice activity
-            if (energy > threshold) {
-                m_lastVoiceActivityTime = now;
-            }
+void PicovoiceManager::onCaptureIntent(quint32 generation, const QString &intent, const QVariantMap &slots)
+{
+    if (generation != m_captureGeneration) return;
 
-            // Check for silence-based finalization (after minimum speech duration)
-            if (speechDuration > MIN_SPEECH_DURATION_MS) {
-                qint64 silenceDuration = now - m_lastVoiceActivityTime;
-                if (silenceDuration > SILENCE_THRESHOLD_MS) {
-                    qDebug() << "PicovoiceManager: Silence detected (" << silenceDuration << "ms), finalizing...";
-                    finalizeLeopardTranscription();
-                    break;
-                }
-            }
+    m_commandTimer->stop();
+    qDebug() << "PicovoiceManager: Intent detected:" << intent << slots;
+    emit intentDetected(intent, slots);
+    resetToListening();
+}
 
-            // Check if we've reached max speech duration (fallback)
-            if (speechDuration > MAX_SPEECH_DURATION_MS) {
-                qDebug() << "PicovoiceManager: Max speech duration reached, finalizing...";
-                finalizeLeopardTranscription();
-            }
-            break;
-        }
+void PicovoiceManager::onCaptureIntentNotUnderstood(quint32 generation)
+{
+    if (generation != m_captureGeneration) return;
 
-        case WaitingForTranscription:
-            // Audio sent to STT — nothing to do, just discard frames until result arrives
-            break;
-
-        case WaitingForFollowUp: {
-            // In follow-up mode: no wake word needed, detect speech directly
-            // (Post-resume deaf period is handled globally in onAudioReady)
-            int16_t energy = calculateFrameEnergy(frame, length);
-            int16_t adaptiveThreshold = (int16_t)(m_noiseFloor * SPEECH_THRESHOLD_RATIO);
-            int16_t threshold = adaptiveThreshold > SILENCE_ENERGY_THRESHOLD ? adaptiveThreshold : SILENCE_ENERGY_THRESHOLD;
-
-            if (energy > threshold) {
-                // Speech detected — stop the timeout and start accumulating
-                m_followUpTimer->stop();
-                qDebug() << "PicovoiceManager: Follow-up speech detected, recording...";
-                m_state = ProcessingSpeech;
-                m_speechStartTime = QDateTime::currentMSecsSinceEpoch();
-                m_lastVoiceActivityTime = m_speechStartTime;
-                m_speechBuffer.clear();
-                m_speechBuffer.reserve(16000 * 10);
-
-                // Accumulate this frame
-                for (int32_t i = 0; i < length; ++i) {
-                    m_speechBuffer.append(frame[i]);
-                }
-            }
-            break;
-        }
-    }
+    // Rhino didn't understand; the capture thread keeps recording for STT
+    // and finalizes on silence or the max duration
+    qDebug() << "PicovoiceManager: Rhino didn't understand, using STT...";
+    m_commandTimer->stop();
+    m_state = ProcessingSpeech;
+    setStatusMessage("Processing complex query...");
+    beginStreamingUtterance();
 }
 
-void PicovoiceManager::processWakeWord(const int16_t *frame)
+void PicovoiceManager::onCaptureUtterance(quint32 generation, const QVector<int16_t> &audio, int reason)
 {
-    if (!m_porcupine) {
-        return;
-    }
+    if (generation != m_captureGeneration) return;
 
-    int32_t keywordIndex = -1;
-    pv_status_t status = pv_porcupine_process(m_porcupine, frame, &keywordIndex);
+    m_commandTimer->stop();
+    m_state = WaitingForTranscription;
+    m_speechBuffer = audio;
 
-    if (status != PV_STATUS_SUCCESS) {
-        qWarning() << "PicovoiceManager: Porcupine process error:" << pv_status_to_string(status);
+    if (audio.isEmpty()) {
+        // Only a command timeout ends an utterance before anything was said
+        resetToListening();
+        emit interactionReset();
         return;
     }
 
-    if (keywordIndex >= 0) {
-        // Wake word detected! Check debouncing
-        qint64 now = QDateTime::currentMSecsSinceEpoch();
-        qint64 timeSinceLastDetection = now - m_lastDetectionTime;
+    if (reason == AudioCaptureThread::Silence)
+        qDebug() << "PicovoiceManager: Silence detected, finalizing...";
+    else if (reason == AudioCaptureThread::MaxDuration)
+        qDebug() << "PicovoiceManager: Max speech duration reached, finalizing...";
 
-        if (timeSinceLastDetection >= DETECTION_DEBOUNCE_MS || m_lastDetectionTime == 0) {
-            qDebug() << "PicovoiceManager: Wake word detected!" << m_wakeWord;
-            m_lastDetectionTime = now;
+    if (m_streamingUtterance) {
+        finishStreamingTranscription();
+        return;
+    }
+    finalizeLeopardTranscription();
+}
 
-            emit wakeWordDetected(m_wakeWord);
+void PicovoiceManager::onCaptureSpeechAudio(quint32 generation, const QVector<int16_t> &samples)
+{
+    if (generation != m_captureGeneration || !m_streamingUtterance) return;
+    m_streamingSTT->sendAudio(samples);
+}
 
-            // Transition to WaitingForReadyPrompt state - wait for TTS prompt to finish
-            // Pre-buffer audio so we capture user's command even if they start talking early
-            m_state = WaitingForReadyPrompt;
-            m_speechBuffer.clear();
-            m_speechBuffer.reserve(16000 * 10);
-            m_readyPromptTimer->start();
-            setStatusMessage("Playing ready prompt...");
-            qDebug() << "PicovoiceManager: Waiting for ready prompt to finish...";
-        } else {
-            qDebug() << "PicovoiceManager: Ignoring duplicate detection (" << timeSinceLastDetection << "ms since last)";
-        }
-    }
+void PicovoiceManager::onCaptureFailed(const QString &message)
+{
+    qCritical() << "PicovoiceManager: Audio capture failed:" << message;
+    stop();
+    emit error(message);
+    setStatusMessage("Error: Could not start microphone");
 }
 
 void PicovoiceManager::onReadyPromptFinished()
@@ -678,102 +559,25 @@ void PicovoiceManager::onReadyPromptFinished()
     }
 
     qDebug() << "PicovoiceManager: Ready prompt finished, now listening for command...";
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
 
     // Now transition to actual command listening
     if (m_rhino) {
-        m_state = WaitingForCommand;
+        // Rhino starts with what was said during the prompt
+        setCaptureState(WaitingForCommand);
         m_commandTimer->start();
         setStatusMessage("Listening for command...");
     } else {
-        // No Rhino, go straight to speech accumulation.
-        // Use WaitingForFollowUp-like approach: wait for the user to actually start
-        // speaking before starting ProcessingSpeech with its silence detection.
-        // Otherwise silence detection fires after ~1.5s even if the user hasn't spoken yet.
-        m_state = WaitingForSpeechStart;
-        m_speechBuffer.clear();
-        m_speechBuffer.reserve(16000 * 10);
+        // No Rhino: wait for the user to actually start speaking before
+        // ProcessingSpeech and its silence detection begin. Otherwise
+        // silence detection fires after ~1.5s even if the user hasn't
+        // spoken yet.
+        setCaptureState(WaitingForSpeechStart);
         m_speechStartTimer->start();
         qDebug() << "PicovoiceManager: Waiting for user to start speaking (no Rhino)...";
         setStatusMessage("Listening...");
     }
 }
 
-void PicovoiceManager::processRhinoIntent(const int16_t *frame)
-{
-    if (!m_rhino) {
-        // No Rhino, fall back to Leopard immediately
-        m_state = ProcessingSpeech;
-        qint64 now = QDateTime::currentMSecsSinceEpoch();
-        m_speechStartTime = now;
-        m_lastVoiceActivityTime = now;
-        m_speechBuffer.clear();
-        m_speechBuffer.reserve(16000 * 10);
-        return;
-    }
-
-    bool isFinalized = false;
-    pv_status_t status = pv_rhino_process(m_rhino, frame, &isFinalized);
-
-    if (status != PV_STATUS_SUCCESS) {
-        qWarning() << "PicovoiceManager: Rhino process error:" << pv_status_to_string(status);
-        return;
-    }
-
-    // Also accumulate audio for potential Leopard fallback
-    for (int32_t i = 0; i < m_frameLength; ++i) {
-        m_speechBuffer.append(frame[i]);
-    }
-
-    if (isFinalized) {
-        m_commandTimer->stop();
-        bool isUnderstood = false;
-        pv_rhino_is_understood(m_rhino, &isUnderstood);
-
-        if (isUnderstood) {
-            // Rhino understood the intent
-            const char *intent = nullptr;
-            int32_t numSlots = 0;
-            const char **slotNames = nullptr;
-            const char **values = nullptr;
-
-            status = pv_rhino_get_intent(m_rhino, &intent, &numSlots, &slotNames, &values);
-
-            if (status == PV_STATUS_SUCCESS && intent) {
-                qDebug() << "PicovoiceManager: Intent detected:" << intent;
-
-                // Convert slots to QVariantMap
-                QVariantMap slotMap;
-                for (int32_t i = 0; i < numSlots; i++) {
-                    slotMap[QString(slotNames[i])] = QString(values[i]);
-                    qDebug() << "  Slot:" << slotNames[i] << "=" << values[i];
-                }
-
-                emit intentDetected(QString(intent), slotMap);
-
-                // Free Rhino resources
-                pv_rhino_free_slots_and_values(m_rhino, slotNames, values);
-            }
-
-            // Reset and return to listening
-            pv_rhino_reset(m_rhino);
-            resetToListening();
-        } else {
-            // Rhino didn't understand, use Leopard for full transcription
-            qDebug() << "PicovoiceManager: Rhino didn't understand, using Leopard...";
-            m_commandTimer->stop();
-            m_state = ProcessingSpeech;
-            qint64 now = QDateTime::currentMSecsSinceEpoch();
-            m_speechStartTime = now;
-            m_lastVoiceActivityTime = now;  // Initialize VAD timestamp
-            setStatusMessage("Processing complex query...");
-
-            // Continue accumulating audio for a bit longer, then finalize
-            // We'll finalize on timeout or silence detection
-        }
-    }
-}
-
 void PicovoiceManager::finalizeLeopardTranscription()
 {
     if (m_speechBuffer.isEmpty()) {
@@ -781,9 +585,9 @@ void PicovoiceManager::finalizeLeopardTranscription()
         return;
     }
 
-    // Prevent re-entry while STT is already processing
+    // A new utterance supersedes anything still in flight
     if (m_googleSTT && m_googleSTT->isProcessing()) {
-        return;
+        m_googleSTT->cancel();
     }
 
     // Try Google STT first (better accuracy for names)
@@ -791,8 +595,7 @@ void PicovoiceManager::finalizeLeopardTranscription()
         qDebug() << "PicovoiceManager: Transcribing with Google STT..." << m_speechBuffer.size() << "samples";
         setStatusMessage("Sending to Google STT...");
 
-        // Transition to WaitingForTranscription — stops silence detection from re-firing
-        m_state = WaitingForTranscription;
+        // Already WaitingForTranscription, which the capture thread idles in
         m_transcriptionTimer->start();
 
         // Send audio to Google STT - callback will handle result
@@ -869,7 +672,6 @@ void PicovoiceManager::onGoogleTranscriptionReady(const QString &text, float con
     if (text.trimmed().isEmpty()) {
         qDebug() << "PicovoiceManager: Empty Google STT result, returning to listening";
         m_speechBuffer.clear();
-        m_speechBuffer.reserve(16000 * 10);
         resetToListening();
         return;
     }
@@ -878,7 +680,6 @@ void PicovoiceManager::onGoogleTranscriptionReady(const QString &text, float con
 
     // Reset state and speech buffer
     m_speechBuffer.clear();
-    m_speechBuffer.reserve(16000 * 10);
     resetToListening();
 }
 
@@ -909,10 +710,119 @@ void PicovoiceManager::onGoogleError(const QString &message)
 
     // Reset state
     m_speechBuffer.clear();
-    m_speechBuffer.reserve(16000 * 10);
     resetToListening();
 }
 
+// ========== STREAMING STT ==========
+
+void PicovoiceManager::beginStreamingUtterance()
+{
+    if (!m_capture || !m_streamingSTT->isConfigured()) return;
+
+    // The capture thread sends everything recorded so far with its first
+    // chunk, so starting here loses nothing
+    m_streamingUtterance = true;
+    m_streamFinal = false;
+    m_streamDone = false;
+    m_streamTranscript.clear();
+    m_streamConfidence = 0.0f;
+    m_streamingSTT->begin(m_sampleRate);
+    m_capture->setStreaming(true);
+}
+
+void PicovoiceManager::finishStreamingTranscription()
+{
+    // Usually the recognizer's endpoint ended the utterance and the
+    // transcript is already here
+    if (m_streamFinal || m_streamDone) {
+        deliverStreamingTranscript();
+        return;
+    }
+
+    qDebug() << "PicovoiceManager: Waiting for streaming STT result...";
+    setStatusMessage("Finishing transcription...");
+    m_transcriptionTimer->start();
+    m_streamingSTT->finish();
+}
+
+void PicovoiceManager::deliverStreamingTranscript()
+{
+    const QString text = m_streamTranscript;
+    const float confidence = m_streamConfidence;
+    endStreamingUtterance();
+
+    // Same handling as a batch result
+    onGoogleTranscriptionReady(text, confidence);
+}
+
+void PicovoiceManager::endStreamingUtterance()
+{
+    if (!m_streamingUtterance) return;
+    m_streamingUtterance = false;
+    m_streamingSTT->cancel();
+    if (m_capture) m_capture->setStreaming(false);
+}
+
+void PicovoiceManager::onStreamingInterim(const QString &text, float stability)
+{
+    if (!m_streamingUtterance) return;
+    qDebug() << "PicovoiceManager: Streaming STT interim:" << text << "stability:" << stability;
+    emit partialTranscription(text);
+}
+
+void PicovoiceManager::onStreamingEndOfSpeech()
+{
+    if (!m_streamingUtterance || m_state != ProcessingSpeech || !m_capture) return;
+
+    // The recognizer endpointed: stop recording now rather than waiting
+    // out the silence timer. The final result follows.
+    qDebug() << "PicovoiceManager: Streaming STT heard end of speech, finalizing...";
+    m_capture->finalize();
+}
+
+void PicovoiceManager::onStreamingFinal(const QString &text, float confidence)
+{
+    if (!m_streamingUtterance) return;
+
+    m_streamTranscript = m_streamTranscript.isEmpty() ? text : m_streamTranscript + ' ' + text;
+    m_streamConfidence = confidence;
+    m_streamFinal = true;
+
+    if (m_state == ProcessingSpeech && m_capture) {
+        // Delivered when the capture thread hands over the utterance
+        m_capture->finalize();
+    } else if (m_state == WaitingForTranscription) {
+        deliverStreamingTranscript();
+    }
+}
+
+void PicovoiceManager::onStreamingFinished()
+{
+    if (!m_streamingUtterance) return;
+
+    m_streamDone = true;
+    if (m_state == ProcessingSpeech && m_capture) {
+        m_capture->finalize();
+    } else if (m_state == WaitingForTranscription) {
+        deliverStreamingTranscript();
+    }
+}
+
+void PicovoiceManager::onStreamingError(const QString &message)
+{
+    if (!m_streamingUtterance) return;
+
+    qWarning() << "PicovoiceManager: Streaming STT error:" << message << "- using batch STT";
+    endStreamingUtterance();
+
+    // Still recording: the utterance ends on silence as usual and goes to
+    // batch STT. Already over: send what was recorded now.
+    if (m_state == WaitingForTranscription) {
+        m_transcriptionTimer->stop();
+        finalizeLeopardTranscription();
+    }
+}
+
 void PicovoiceManager::manualActivate()
 {
     if (!m_isRunning) {
@@ -927,21 +837,19 @@ void PicovoiceManager::manualActivate()
     if (m_googleSTT && m_googleSTT->isProcessing()) {
         m_googleSTT->cancel();
     }
+    endStreamingUtterance();
     m_followUpTimer->stop();
     m_speechStartTimer->stop();
     m_transcriptionTimer->stop();
     m_commandTimer->stop();
     m_isPaused = false;
+    m_capture->setPaused(false);
 
     // Simulate wake word detection - go to WaitingForReadyPrompt
-    m_lastDetectionTime = QDateTime::currentMSecsSinceEpoch();
     m_speechBuffer.clear();
-    m_speechBuffer.reserve(16000 * 10);
-    if (m_audioDevice) m_audioDevice->readAll();
-    m_audioBuffer.clear();
     emit wakeWordDetected(m_wakeWord);
 
-    m_state = WaitingForReadyPrompt;
+    setCaptureState(WaitingForReadyPrompt);
     m_readyPromptTimer->start();
     setStatusMessage("Playing ready prompt...");
 }
@@ -954,9 +862,8 @@ void PicovoiceManager::enterFollowUpMode()
     }
 
     qDebug() << "PicovoiceManager: Entering follow-up mode (12s timeout)";
-    m_state = WaitingForFollowUp;
+    setCaptureState(WaitingForFollowUp);
     m_speechBuffer.clear();
-    m_speechBuffer.reserve(16000 * 10);
     // Only start the timeout if not paused (TTS might still be playing).
     // If paused, the timer will start when resume() is called.
     if (!m_isPaused) {
@@ -969,6 +876,7 @@ void PicovoiceManager::cancelAndReset()
 {
     qDebug() << "PicovoiceManager: Cancel and reset — returning to wake word listening";
     m_isPaused = false;
+    if (m_capture) m_capture->setPaused(false);
     // Cancel any in-flight Google STT request so stale results don't arrive later
     if (m_googleSTT && m_googleSTT->isProcessing()) {
         m_googleSTT->cancel();
@@ -979,22 +887,16 @@ void PicovoiceManager::cancelAndReset()
 
 void PicovoiceManager::resetToListening()
 {
-    // Discard any stale audio that accumulated during STT processing
-    if (m_audioDevice) m_audioDevice->readAll();
-    m_audioBuffer.clear();
+    endStreamingUtterance();
     m_speechBuffer.clear();
-    m_speechBuffer.reserve(16000 * 10);
     m_readyPromptTimer->stop();
     m_followUpTimer->stop();
     m_speechStartTimer->stop();
     m_transcriptionTimer->stop();
     m_commandTimer->stop();
-    m_state = Listening;
 
-    // Reset Rhino if it was used
-    if (m_rhino) {
-        pv_rhino_reset(m_rhino);
-    }
+    // The capture thread drops its speech buffer and resets Rhino
+    setCaptureState(Listening);
 
     if (m_wakeWordAvailable) {
         setStatusMessage(QString("Listening for '%1'...").arg(m_wakeWord));
@@ -1324,20 +1226,3 @@ void PicovoiceManager::setStatusMessage(const QString &msg)
     m_statusMessage = msg;
     emit statusMessageChanged();
 }
-
-int16_t PicovoiceManager::calculateFrameEnergy(const int16_t *frame, int32_t length) const
-{
-    // Calculate RMS (Root Mean Square) energy of the audio frame
-    if (!frame || length <= 0) {
-        return 0;
-    }
-
-    int64_t sumSquares = 0;
-    for (int32_t i = 0; i < length; ++i) {
-        int64_t sample = static_cast<int64_t>(frame[i]);
-        sumSquares += sample * sample;
-    }
-
-    // Return RMS as int16_t (approximation using integer math)
-    return static_cast<int16_t>(qSqrt(static_cast<double>(sumSquares) / length));
-}
@@ -2,16 +2,15 @@
 #define PICOVOICEMANAGER_H
 
 #include <QObject>
-#include <QAudioSource>
-#include <QIODevice>
-#include <QByteArray>
 #include <QVector>
 #include <QVariantMap>
 #include <QString>
 #include <QTimer>
 
+class AudioCaptureThread;
 // Forward declaration for Google STT
 class GoogleSTT;
+class StreamingSTT;
 
 // Forward declarations for Picovoice C structures
 typedef struct pv_porcupine pv_porcupine_t;
@@ -30,6 +29,17 @@ class PicovoiceManager : public QObject
     Q_PROPERTY(QString wakeWord READ wakeWord WRITE setWakeWord NOTIFY wakeWordChanged)
 
 public:
+    // Voice state machine. AudioCaptureThread runs the audio half of it.
+    enum State {
+        Listening,            // Listening for wake word
+        WaitingForReadyPrompt,// Wake word detected, waiting for TTS ready prompt to finish
+        WaitingForCommand,    // Ready prompt finished, processing with Rhino
+        WaitingForSpeechStart,// No Rhino: waiting for user to start speaking (energy-based)
+        ProcessingSpeech,     // Accumulating audio for Leopard/Google STT
+        WaitingForTranscription, // Audio sent to STT, waiting for result (no further processing)
+        WaitingForFollowUp    // After response, listening without wake word (12s timeout)
+    };
+
     explicit PicovoiceManager(QObject *parent = nullptr);
     ~PicovoiceManager();
 
@@ -50,6 +60,7 @@ public:
     void setRhinoContextPath(const QString &path);
     void setGoogleApiKey(const QString &key);
     void setSpeechContextHints(const QStringList &hints);
+    void setStreamingSttUrl(const QString &url);  // Empty: batch Google STT only
 
     // Getters
     bool isRunning() const { return m_isRunning; }
@@ -63,6 +74,7 @@ signals:
     void wakeWordDetected(const QString &keyword);
     void intentDetected(const QString &intent, const QVariantMap &slots);
     void transcriptionReady(const QString &text);
+    void partialTranscription(const QString &text);  // Streaming STT's guess so far
     void error(const QString &message);
     void interactionReset();  // Emitted when PicovoiceManager silently returns to Listening (timeouts)
     void statusMessageChanged();
@@ -73,21 +85,23 @@ signals:
     void wakeWordChanged();
 
 private slots:
-    void onAudioReady();
+    // From AudioCaptureThread; each ignores events older than m_captureGeneration
+    void onCaptureWakeWord(quint32 generation);
+    void onCaptureSpeechStarted(quint32 generation);
+    void onCaptureIntent(quint32 generation, const QString &intent, const QVariantMap &slots);
+    void onCaptureIntentNotUnderstood(quint32 generation);
+    void onCaptureUtterance(quint32 generation, const QVector<int16_t> &audio, int reason);
+    void onCaptureSpeechAudio(quint32 generation, const QVector<int16_t> &samples);
+    void onCaptureFailed(const QString &message);
     void onGoogleTranscriptionReady(const QString &text, float confidence);
     void onGoogleError(const QString &message);
+    void onStreamingInterim(const QString &text, float stability);
+    void onStreamingEndOfSpeech();
+    void onStreamingFinal(const QString &text, float confidence);
+    void onStreamingFinished();
+    void onStreamingError(const QString &message);
 
 private:
-    // State machine
-    enum State {
-        Listening,            // Listening for wake word
-        WaitingForReadyPrompt,// Wake word detected, waiting for TTS ready prompt to finish
-        WaitingForCommand,    // Ready prompt finished, processing with Rhino
-        WaitingForSpeechStart,// No Rhino: waiting for user to start speaking (energy-based)
-        ProcessingSpeech,     // Accumulating audio for Leopard/Google STT
-        WaitingForTranscription, // Audio sent to STT, waiting for result (no further processing)
-        WaitingForFollowUp    // After response, listening without wake word (12s timeout)
-    };
     State m_state;
 
     // Picovoice components
@@ -101,16 +115,24 @@ private:
     QString m_googleApiKey;
     QStringList m_speechContextHints;
 
+    // Streaming STT: recognizes while the user talks and endpoints the
+    // utterance; the batch path above is the fallback
+    StreamingSTT *m_streamingSTT;
+    bool m_streamingUtterance = false;  // The current utterance is being streamed
+    bool m_streamFinal = false;         // Final result received
+    bool m_streamDone = false;          // Stream closed cleanly
+    QString m_streamTranscript;
+    float m_streamConfidence = 0.0f;
+
     // Configuration
     QString m_accessKey;
     QString m_wakeWord;
     QString m_rhinoContextPath;
     float m_sensitivity;
 
-    // Audio pipeline
-    QAudioSource *m_audioSource;
-    QIODevice *m_audioDevice;
-    QByteArray m_audioBuffer;
+    // Audio pipeline: capture and frame processing on their own thread
+    AudioCaptureThread *m_capture = nullptr;
+    quint32 m_captureGeneration = 0;
 
     // Audio parameters
     int32_t m_frameLength;          // Frame length for Porcupine/Rhino/Koala
@@ -125,37 +147,14 @@ private:
     bool m_wakeWordAvailable;
     QString m_statusMessage;
 
-    // Audio recovery
-    int m_audioRecoveryAttempts = 0;
-    static const int MAX_AUDIO_RECOVERY_ATTEMPTS = 5;
-
-    // Reusable frame buffer (avoids per-frame allocation)
-    QVector<int16_t> m_processedFrame;
-
-    // Speech buffer for Leopard (when Rhino doesn't understand)
+    // The utterance handed over by AudioCaptureThread, for STT
     QVector<int16_t> m_speechBuffer;
-    qint64 m_speechStartTime;
-    static const int MAX_SPEECH_DURATION_MS = 10000;  // 10 seconds max
-
-    // Voice Activity Detection (VAD) for faster response
-    qint64 m_lastVoiceActivityTime;
-    static const int SILENCE_THRESHOLD_MS = 1500;     // 1.5 seconds of silence triggers finalization
-    static const int16_t SILENCE_ENERGY_THRESHOLD = 150;  // Minimum RMS floor (USB mic with PulseAudio boost)
-    float m_noiseFloor = 500.0f;                          // Adaptive noise floor (updated in Listening state)
-    static constexpr float NOISE_FLOOR_ALPHA = 0.02f;     // Slow adaptation rate
-    static constexpr float SPEECH_THRESHOLD_RATIO = 3.0f; // Speech must be 3x noise floor
-    static const int MIN_SPEECH_DURATION_MS = 500;    // Minimum speech before allowing silence detection
-
-    // Debouncing
-    qint64 m_lastDetectionTime;
-    static const int DETECTION_DEBOUNCE_MS = 1000;
 
     // Follow-up mode
     QTimer *m_followUpTimer;
     static const int FOLLOW_UP_TIMEOUT_MS = 12000;  // 12 seconds
 
     // Post-resume deaf period to avoid TTS echo pickup
-    qint64 m_resumeTime = 0;
     static const int POST_RESUME_DEAF_MS = 400;  // Ignore audio for 400ms after resume
 
     // Ready prompt safety timeout
@@ -181,12 +180,13 @@ private:
     void cleanupLeopard();
     void cleanupKoala();
 
-    // Audio processing methods
-    void processAudioFrame(const int16_t *frame, int32_t length);
-    void processWakeWord(const int16_t *frame);
-    void processRhinoIntent(const int16_t *frame);
+    // Transcription
     void finalizeLeopardTranscription();
     QString transcribeWithLeopard(const QVector<int16_t> &audioBuffer);
+    void beginStreamingUtterance();
+    void finishStreamingTranscription();
+    void deliverStreamingTranscript();
+    void endStreamingUtterance();
 
     // Helper methods
     static QString basePath();
@@ -194,7 +194,7 @@ private:
     QString getKeywordPath() const;
     void setStatusMessage(const QString &msg);
     void resetToListening();
-    int16_t calculateFrameEnergy(const int16_t *frame, int32_t length) const;
+    void setCaptureState(State state);
 };
 
 #endif // PICOVOICEMANAGER_H
@@ -1,6 +1,7 @@
 #include "PlacesSearchManager.h"
 #include "ContextAggregator.h"
 #include "GeoUtils.h"
+#include "Route.h"
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -87,7 +88,7 @@ void PlacesSearchManager::searchPlaces(const QString &query, const QString &cate
     }
 
     // Path B — along-route with full polyline (new API)
-    if (alongRoute && m_context && !m_context->routeCoordinates().isEmpty()) {
+    if (alongRoute && m_context && m_context->route()) {
         searchAlongRouteNew(query, category, lat, lon);
         return;
     }
@@ -333,7 +334,7 @@ void PlacesSearchManager::executeDeferredSearch(double lat, double lon)
     qDebug() << "PlacesSearchManager: Executing deferred search at" << lat << lon
              << "query:" << m_deferredQuery << "alongRoute:" << m_deferredAlongRoute;
 
-    if (m_deferredAlongRoute && m_context && !m_context->routeCoordinates().isEmpty()) {
+    if (m_deferredAlongRoute && m_context && m_context->route()) {
         searchAlongRouteNew(m_deferredQuery, m_deferredCategory, lat, lon);
     } else {
         searchAtPoint(lat, lon, m_deferredQuery, m_deferredCategory, 15000);
@@ -343,9 +344,18 @@ void PlacesSearchManager::executeDeferredSearch(double lat, double lon)
 void PlacesSearchManager::searchAlongRouteNew(const QString &query, const QString &category,
                                                double originLat, double originLon)
 {
-    QJsonArray coords = m_context->routeCoordinates();
-    QJsonArray simplified = GeoUtils::simplifyRoute(coords, 100);
-    QString encoded = GeoUtils::encodePolyline(simplified);
+    const std::shared_ptr<const Route> route = m_context->route();
+    QVector<double> routeLats, routeLons;
+    route->geometry().decode(routeLats, routeLons);
+    QVector<int> kept(100);
+    kept.resize(m_simplifier.simplify(routeLats.constData(), routeLons.constData(),
+                                      routeLats.size(), kept.size(), kept.data()));
+    QVector<double> lats(kept.size()), lons(kept.size());
+    for (int k = 0; k < kept.size(); ++k) {
+        lats[k] = routeLats[kept[k]];
+        lons[k] = routeLons[kept[k]];
+    }
+    QString encoded = QString::fromLatin1(GeoUtils::encodePolyline(lats.constData(), lons.constData(), kept.size()));
 
     if (encoded.isEmpty()) {
         qWarning() << "PlacesSearchManager: Polyline encoding failed, falling back to old method";
@@ -354,7 +364,7 @@ void PlacesSearchManager::searchAlongRouteNew(const QString &query, const QStrin
     }
 
     qDebug() << "PlacesSearchManager: Along-route Text Search for" << query
-             << "polyline:" << simplified.size() << "pts (from" << coords.size() << ")";
+             << "polyline:" << kept.size() << "pts (from" << route->size() << ")";
 
     // Build the text query — append category if provided
     QString textQuery = query;
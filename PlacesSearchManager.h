@@ -7,6 +7,8 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 
+#include "PolylineSimplifier.h"
+
 class ContextAggregator;
 
 class PlacesSearchManager : public QObject
@@ -63,6 +65,7 @@ private:
     QString m_googleApiKey;
     QString m_lastGeocodeQuery;
     ContextAggregator *m_context = nullptr;
+    PolylineSimplifier m_simplifier;   // Route polyline for along-route search
 
     void searchAtPoint(double lat, double lon, const QString &query, const QString &category, int radiusM);
     void collectAlongRouteResults();
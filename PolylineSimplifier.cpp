@@ -0,0 +1,156 @@
+#include "PolylineSimplifier.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kKmPerDegLat = 110.574;
+constexpr double kKmPerDegLonEquator = 111.320;
+
+} // namespace
+
+int PolylineSimplifier::simplify(const double *lats, const double *lons, int n, int targetPoints,
+                                 int *out, Method method)
+{
+    if (n <= 0) return 0;
+    targetPoints = qMax(targetPoints, 2);
+
+    if (n <= targetPoints) {
+        for (int i = 0; i < n; ++i)
+            out[i] = i;
+        return n;
+    }
+
+    project(lats, lons, n);
+    m_keep.fill(0, n);
+
+    if (method == Visvalingam)
+        visvalingam(n, targetPoints);
+    else
+        douglasPeucker(n, targetPoints);
+
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        if (m_keep[i]) out[count++] = i;
+    }
+    return count;
+}
+
+void PolylineSimplifier::project(const double *lats, const double *lons, int n)
+{
+    // One scale for the whole line, taken at its middle — simplification
+    // compares distances against each other, not against a threshold
+    const double kx = kKmPerDegLonEquator * qCos(qDegreesToRadians(lats[n / 2]));
+    m_x.resize(n);
+    m_y.resize(n);
+    for (int i = 0; i < n; ++i) {
+        m_x[i] = lons[i] * kx;
+        m_y[i] = lats[i] * kKmPerDegLat;
+    }
+}
+
+// ============================================================================
+// Douglas-Peucker
+// ============================================================================
+
+PolylineSimplifier::Range PolylineSimplifier::farthest(int first, int last) const
+{
+    Range r{ first, last, -1, -1.0 };
+    const double ax = m_x[first], ay = m_y[first];
+    const double dx = m_x[last] - ax, dy = m_y[last] - ay;
+    const double lenSq = dx * dx + dy * dy;
+
+    for (int i = first + 1; i < last; ++i) {
+        const double px = m_x[i] - ax, py = m_y[i] - ay;
+        const double t = lenSq > 0.0 ? qBound(0.0, (px * dx + py * dy) / lenSq, 1.0) : 0.0;
+        const double ex = px - t * dx, ey = py - t * dy;
+        const double d = ex * ex + ey * ey;
+        if (d > r.distSq) {
+            r.distSq = d;
+            r.farthest = i;
+        }
+    }
+    return r;
+}
+
+void PolylineSimplifier::douglasPeucker(int n, int targetPoints)
+{
+    m_keep[0] = m_keep[n - 1] = 1;
+    int kept = 2;
+
+    // At most one open range per kept gap
+    m_ranges.clear();
+    m_ranges.reserve(targetPoints);
+    m_ranges.append(farthest(0, n - 1));
+
+    while (kept < targetPoints && !m_ranges.isEmpty()) {
+        std::pop_heap(m_ranges.begin(), m_ranges.end());
+        const Range r = m_ranges.takeLast();
+        if (r.farthest < 0) continue;
+
+        m_keep[r.farthest] = 1;
+        ++kept;
+
+        for (const Range &half : { farthest(r.first, r.farthest), farthest(r.farthest, r.last) }) {
+            if (half.farthest < 0) continue;
+            m_ranges.append(half);
+            std::push_heap(m_ranges.begin(), m_ranges.end());
+        }
+    }
+}
+
+// ============================================================================
+// Visvalingam-Whyatt
+// ============================================================================
+
+double PolylineSimplifier::triangleArea(int a, int b, int c) const
+{
+    return 0.5 * std::fabs((m_x[b] - m_x[a]) * (m_y[c] - m_y[a]) - (m_x[c] - m_x[a]) * (m_y[b] - m_y[a]));
+}
+
+void PolylineSimplifier::visvalingam(int n, int targetPoints)
+{
+    m_prev.resize(n);
+    m_next.resize(n);
+    m_area.resize(n);
+    m_areas.clear();
+    m_areas.reserve(3 * n);   // n seeds plus two updates per removal
+
+    for (int i = 0; i < n; ++i) {
+        m_keep[i] = 1;
+        m_prev[i] = i - 1;
+        m_next[i] = i + 1;
+    }
+    for (int i = 1; i < n - 1; ++i) {
+        m_area[i] = triangleArea(i - 1, i, i + 1);
+        m_areas.append({ m_area[i], i });
+    }
+    std::make_heap(m_areas.begin(), m_areas.end());
+
+    int remaining = n;
+    double floorArea = 0.0;
+    while (remaining > targetPoints && !m_areas.isEmpty()) {
+        std::pop_heap(m_areas.begin(), m_areas.end());
+        const AreaEntry e = m_areas.takeLast();
+
+        // Superseded by a later update, or already gone
+        if (!m_keep[e.index] || e.area != m_area[e.index]) continue;
+
+        const int p = m_prev[e.index], nx = m_next[e.index];
+        m_keep[e.index] = 0;
+        m_next[p] = nx;
+        m_prev[nx] = p;
+        --remaining;
+
+        // A neighbour never ranks below the point just removed, so removal
+        // order stays monotonic
+        floorArea = qMax(floorArea, e.area);
+        for (const int i : { p, nx }) {
+            if (m_prev[i] < 0 || m_next[i] >= n) continue;
+            m_area[i] = qMax(triangleArea(m_prev[i], i, m_next[i]), floorArea);
+            m_areas.append({ m_area[i], i });
+            std::push_heap(m_areas.begin(), m_areas.end());
+        }
+    }
+}
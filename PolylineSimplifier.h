@@ -0,0 +1,65 @@
+#ifndef POLYLINESIMPLIFIER_H
+#define POLYLINESIMPLIFIER_H
+
+#include <QVector>
+
+// Polyline simplification to an exact point budget over packed lat/lon
+// arrays.
+//
+// Douglas-Peucker runs as a priority refinement: an explicit heap holds the
+// open ranges keyed by their farthest point, and the most significant one is
+// split until the budget is met. That is the same order epsilon-driven DP
+// would add points in, so one pass yields exactly the requested count.
+// Visvalingam-Whyatt drops the point with the smallest effective triangle
+// area until the budget is left, which keeps shape better on curvy roads
+// and worse on long straights with a single detour.
+//
+// Points are projected once into a local flat km frame. Scratch space lives
+// in the simplifier and is reused, so keeping one instance around makes
+// repeated calls allocation-free.
+class PolylineSimplifier
+{
+public:
+    enum Method {
+        DouglasPeucker,
+        Visvalingam
+    };
+
+    // Writes the indices of min(n, targetPoints) kept points to out in
+    // ascending order and returns that count. Both endpoints are always kept,
+    // so targetPoints below 2 is treated as 2.
+    int simplify(const double *lats, const double *lons, int n, int targetPoints, int *out,
+                 Method method = DouglasPeucker);
+
+private:
+    struct Range {
+        int first;
+        int last;
+        int farthest;       // -1 when the range has no interior points
+        double distSq;
+        bool operator<(const Range &o) const { return distSq < o.distSq; }
+    };
+
+    struct AreaEntry {
+        double area;
+        int index;
+        bool operator<(const AreaEntry &o) const { return area > o.area; }  // Min-heap
+    };
+
+    void project(const double *lats, const double *lons, int n);
+    Range farthest(int first, int last) const;
+    double triangleArea(int a, int b, int c) const;
+    void douglasPeucker(int n, int targetPoints);
+    void visvalingam(int n, int targetPoints);
+
+    QVector<double> m_x;
+    QVector<double> m_y;
+    QVector<char> m_keep;
+    QVector<Range> m_ranges;
+    QVector<AreaEntry> m_areas;
+    QVector<double> m_area;
+    QVector<int> m_prev;
+    QVector<int> m_next;
+};
+
+#endif // POLYLINESIMPLIFIER_H
@@ -0,0 +1,216 @@
+#include "RefreshScheduler.h"
+#include "RouteProgressTracker.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QNetworkInformation>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVariantMap>
+#include <algorithm>
+#include <limits>
+
+RefreshScheduler::RefreshScheduler(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_movingMs(QDateTime::currentMSecsSinceEpoch())
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &RefreshScheduler::onTimeout);
+
+    // Without a backend the network is assumed up
+    if (QNetworkInformation::load(QNetworkInformation::Feature::Reachability)) {
+        connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged,
+                this, [this](QNetworkInformation::Reachability reachability) {
+            qDebug() << "RefreshScheduler: Network reachability" << int(reachability);
+            rearm();
+        });
+    } else {
+        qDebug() << "RefreshScheduler: No network information backend, assuming online";
+    }
+
+    qDebug() << "RefreshScheduler: Initialized";
+}
+
+void RefreshScheduler::setRouteProgressTracker(RouteProgressTracker *tracker) { m_tracker = tracker; }
+
+int RefreshScheduler::add(const QString &name, int intervalMs, QObject *receiver, std::function<void()> task)
+{
+    Task t;
+    t.name = name;
+    t.intervalMs = intervalMs;
+    t.plannedMs = intervalMs;
+    t.receiver = receiver;
+    t.run = std::move(task);
+    m_tasks.append(t);
+    return m_tasks.size() - 1;
+}
+
+void RefreshScheduler::start(int id)
+{
+    if (id < 0 || id >= m_tasks.size()) return;
+    Task &t = m_tasks[id];
+    t.running = true;
+    t.lastRunMs = QDateTime::currentMSecsSinceEpoch();
+    t.jitter = drawJitter();
+    rearm();
+}
+
+void RefreshScheduler::stop(int id)
+{
+    if (id < 0 || id >= m_tasks.size()) return;
+    Task &t = m_tasks[id];
+    t.running = false;
+    t.upcomingKms.clear();
+    rearm();
+}
+
+void RefreshScheduler::setUpcoming(int id, QVector<double> alongKms, const QString &what)
+{
+    if (id < 0 || id >= m_tasks.size()) return;
+    std::sort(alongKms.begin(), alongKms.end());
+    Task &t = m_tasks[id];
+    if (t.upcomingKms == alongKms && t.upcomingWhat == what) return;
+    t.upcomingKms = std::move(alongKms);
+    t.upcomingWhat = what;
+    rearm();
+}
+
+void RefreshScheduler::clearUpcoming(int id)
+{
+    if (id < 0 || id >= m_tasks.size() || m_tasks[id].upcomingKms.isEmpty()) return;
+    m_tasks[id].upcomingKms.clear();
+    rearm();
+}
+
+double RefreshScheduler::drawJitter()
+{
+    return 0.9 + 0.2 * QRandomGenerator::global()->generateDouble();
+}
+
+bool RefreshScheduler::online() const
+{
+    const QNetworkInformation *info = QNetworkInformation::instance();
+    if (!info) return true;
+    const auto reachability = info->reachability();
+    return reachability == QNetworkInformation::Reachability::Online
+        || reachability == QNetworkInformation::Reachability::Unknown;
+}
+
+void RefreshScheduler::replan(Task &t, double speedKmh, bool parked) const
+{
+    double interval = t.intervalMs;
+    QString reason = "base";
+
+    if (parked) {
+        interval *= kParkedFactor;
+        reason = "parked";
+    } else if (speedKmh > kTownKmh) {
+        // Faster driving reaches the data sooner
+        interval *= qMax(0.5, kTownKmh / speedKmh);
+        reason = QString("%1 km/h").arg(qRound(speedKmh));
+    }
+
+    if (!t.upcomingKms.isEmpty() && !parked && speedKmh > kParkedKmh && m_tracker && m_tracker->tracking()) {
+        const double travelledKm = m_tracker->travelledKm();
+        const auto next = std::lower_bound(t.upcomingKms.cbegin(), t.upcomingKms.cend(), travelledKm);
+        const double aheadKm = next != t.upcomingKms.cend() ? *next - travelledKm : -1.0;
+        const double etaMin = aheadKm / speedKmh * 60.0;
+        if (aheadKm >= 0.0 && etaMin <= kLookaheadMin) {
+            const double beforeFeature = etaMin * 60.0 * 1000.0 / kRefreshesBeforeFeature;
+            if (beforeFeature < interval) {
+                interval = beforeFeature;
+                reason = QString("%1 in %2 min").arg(t.upcomingWhat).arg(qRound(etaMin));
+            }
+        }
+    }
+
+    const double lo = qMax<double>(kMinIntervalMs, t.intervalMs / 4.0);
+    const double hi = qMax(lo, t.intervalMs * 3.0);
+    t.plannedMs = qint64(qBound(lo, interval, hi));
+    t.dueMs = t.lastRunMs + qint64(t.plannedMs * t.jitter);
+    t.reason = reason;
+}
+
+void RefreshScheduler::onTimeout()
+{
+    if (!online()) {
+        qDebug() << "RefreshScheduler: Offline, deferring refreshes";
+        rearm();
+        return;
+    }
+
+    // Everything due within the window rides along with whatever woke us.
+    // The window never exceeds a quarter of a task's interval, so a short
+    // interval isn't halved by being pulled forward.
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList ran;
+    for (int id = 0; id < m_tasks.size(); ++id) {
+        Task &t = m_tasks[id];
+        if (!t.running) continue;
+        if (!t.receiver) {
+            t.running = false;
+            continue;
+        }
+        const qint64 window = qMin<qint64>(kCoalesceMs, t.plannedMs / 4);
+        if (t.dueMs > now + window) continue;
+
+        t.lastRunMs = now;
+        t.jitter = drawJitter();
+        ran.append(QString("%1 (%2)").arg(t.name, t.reason));
+        const std::function<void()> run = t.run;   // May start/stop tasks
+        run();
+    }
+
+    if (!ran.isEmpty())
+        qDebug() << "RefreshScheduler: Ran" << ran.join(", ");
+    rearm();
+}
+
+void RefreshScheduler::rearm()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // Unknown speed (no recent fix) counts as moving, so a missing GPS
+    // never backs the feeds off
+    const double speedKmh = m_tracker ? m_tracker->speedKmh() : -1.0;
+    if (speedKmh < 0.0 || speedKmh > kParkedKmh) m_movingMs = now;
+    const bool parked = speedKmh >= 0.0 && now - m_movingMs >= kParkedAfterMs;
+
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (Task &t : m_tasks) {
+        if (!t.running || !t.receiver) continue;
+        replan(t, speedKmh, parked);
+        next = qMin(next, t.dueMs);
+    }
+    emit planChanged();
+
+    if (next == std::numeric_limits<qint64>::max()) {
+        m_timer->stop();
+        return;
+    }
+
+    // Wake at least every kReplanMs so speed and position changes reach the
+    // plan. Offline, overdue tasks wait for reachabilityChanged instead of
+    // spinning the timer.
+    qint64 delay = qMax<qint64>(0, next - now);
+    if (!online()) delay = qMax<qint64>(delay, kReplanMs);
+    m_timer->start(int(qMin<qint64>(delay, kReplanMs)));
+}
+
+QVariantList RefreshScheduler::plan() const
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVariantList list;
+    for (const Task &t : m_tasks) {
+        const bool running = t.running && t.receiver;
+        list.append(QVariantMap {
+            { "name", t.name },
+            { "running", running },
+            { "baseMs", t.intervalMs },
+            { "intervalMs", t.plannedMs },
+            { "dueInMs", running ? qMax<qint64>(0, t.dueMs - now) : -1 },
+            { "reason", running ? (online() ? t.reason : QString("offline")) : QString("stopped") },
+        });
+    }
+    return list;
+}
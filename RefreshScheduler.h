@@ -0,0 +1,104 @@
+#ifndef REFRESHSCHEDULER_H
+#define REFRESHSCHEDULER_H
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+#include <QVariantList>
+#include <QVector>
+#include <functional>
+
+class RouteProgressTracker;
+
+// One timer for every periodic refresh, planned from what the car is doing.
+//
+// Managers register a task with a base interval instead of owning a QTimer.
+// The base interval is the feed's volatility: how often it is worth
+// refreshing in town with nothing notable ahead. Each task's actual
+// interval is replanned from the base at least once a minute:
+//  - parked (under kParkedKmh for kParkedAfterMs): kParkedFactor times longer
+//  - above kTownKmh: shorter in proportion to speed, down to half
+//  - the next feature flagged with setUpcoming() is reached within
+//    kLookaheadMin: short enough for about kRefreshesBeforeFeature more
+//    fetches on the way there
+//  - clamped to [base / 4, base * 3], never under kMinIntervalMs
+// Nothing runs while the network reports itself down; overdue tasks run
+// as soon as it is back.
+//
+// Each run is jittered by up to ±10% so fleets of head units don't hit the
+// feeds in lockstep, and whenever the timer fires every running task due
+// within the coalescing window runs with it — the modem wakes once for the
+// lot instead of once per manager.
+class RefreshScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantList plan READ plan NOTIFY planChanged)
+
+public:
+    explicit RefreshScheduler(QObject *parent = nullptr);
+
+    // Speed and route position for planning. Without it every task runs at
+    // its base interval.
+    void setRouteProgressTracker(RouteProgressTracker *tracker);
+
+    // Registers a stopped task and returns its id. task runs on this thread
+    // and is dropped once receiver is destroyed.
+    int add(const QString &name, int intervalMs, QObject *receiver, std::function<void()> task);
+
+    // First run one (jittered) interval from now
+    void start(int id);
+    void stop(int id);
+
+    // The route features this task's data matters for, as distances along
+    // the route (RouteIndex km). The plan follows the first one still ahead
+    // of the car. Cleared by clearUpcoming() and stop().
+    void setUpcoming(int id, QVector<double> alongKms, const QString &what);
+    void clearUpcoming(int id);
+
+    // One map per task: name, running, baseMs, intervalMs, dueInMs, reason
+    QVariantList plan() const;
+
+signals:
+    void planChanged();
+
+private:
+    struct Task {
+        QString name;
+        int intervalMs = 0;          // Base
+        QPointer<QObject> receiver;
+        std::function<void()> run;
+        bool running = false;
+        qint64 lastRunMs = 0;        // Or start time before the first run
+        double jitter = 1.0;         // Drawn per run
+        qint64 plannedMs = 0;        // Current interval
+        qint64 dueMs = 0;
+        QString reason;
+        QVector<double> upcomingKms; // Sorted
+        QString upcomingWhat;
+    };
+
+    static constexpr int kCoalesceMs = 90 * 1000;
+    static constexpr int kReplanMs = 60 * 1000;
+    static constexpr int kMinIntervalMs = 60 * 1000;
+    static constexpr double kParkedKmh = 3.0;
+    static constexpr qint64 kParkedAfterMs = 3 * 60 * 1000;
+    static constexpr double kParkedFactor = 3.0;
+    static constexpr double kTownKmh = 50.0;
+    static constexpr double kLookaheadMin = 60.0;
+    static constexpr int kRefreshesBeforeFeature = 3;
+
+    static double drawJitter();
+    void replan(Task &t, double speedKmh, bool parked) const;
+    bool online() const;
+    void onTimeout();
+    void rearm();
+
+    RouteProgressTracker *m_tracker = nullptr;
+    QList<Task> m_tasks;   // Index is the id
+    QTimer *m_timer;
+    qint64 m_movingMs = 0; // Last time the car was seen above kParkedKmh
+};
+
+#endif // REFRESHSCHEDULER_H
@@ -1,65 +1,103 @@
 #include "RoadConditionManager.h"
 #include "ContextAggregator.h"
-#include "GeoUtils.h"
+#include "RefreshScheduler.h"
+#include "Route.h"
+#include "RouteProgressTracker.h"
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrlQuery>
 #include <QtMath>
 
+namespace {
+
+const QString kLayer = QStringLiteral("roadEvents");
+
+// Events the feeds haven't confirmed in this long are treated as over
+constexpr qint64 kMaxEventAgeMs = 30 * 60 * 1000;
+
+} // namespace
+
 RoadConditionManager::RoadConditionManager(QObject *parent)
     : QObject(parent)
-    , m_albertaNetwork(new QNetworkAccessManager(this))
-    , m_drivebcNetwork(new QNetworkAccessManager(this))
-    , m_refreshTimer(new QTimer(this))
 {
-    connect(m_albertaNetwork, &QNetworkAccessManager::finished,
-            this, &RoadConditionManager::onAlbertaReply);
-    connect(m_drivebcNetwork, &QNetworkAccessManager::finished,
-            this, &RoadConditionManager::onDriveBCReply);
-
-    // Refresh every 5 minutes
-    m_refreshTimer->setInterval(5 * 60 * 1000);
-    connect(m_refreshTimer, &QTimer::timeout, this, &RoadConditionManager::fetchConditions);
-
     qDebug() << "RoadConditionManager: Initialized";
 }
 
 void RoadConditionManager::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+void RoadConditionManager::setRouteProgressTracker(RouteProgressTracker *tracker) { m_tracker = tracker; }
+void RoadConditionManager::setSpatialTileCache(SpatialTileCache *cache) { m_cache = cache; }
+void RoadConditionManager::setFeedFetcher(FeedFetcher *fetcher) { m_fetcher = fetcher; }
+
+void RoadConditionManager::setRefreshScheduler(RefreshScheduler *scheduler)
+{
+    m_scheduler = scheduler;
+    // Refresh every 5 minutes
+    m_refreshTask = scheduler->add("roadConditions", 5 * 60 * 1000, this, [this]() { fetchConditions(); });
+}
 
-void RoadConditionManager::setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent)
+SpatialTileCache::Feature RoadConditionManager::toFeature(const RoadEvent &ev)
 {
-    Q_UNUSED(durationSec)
+    SpatialTileCache::Feature f;
+    f.id = ev.id;
+    f.lat = ev.lat;
+    f.lon = ev.lon;
+    f.data = {
+        { "roadName", ev.roadName },
+        { "description", ev.description },
+        { "eventType", ev.eventType },
+        { "severity", ev.severity },
+        { "fullClosure", ev.fullClosure },
+    };
+    return f;
+}
 
-    if (coordinates.size() < 2) {
+RoadConditionManager::RoadEvent RoadConditionManager::fromFeature(const SpatialTileCache::Feature &f)
+{
+    RoadEvent ev;
+    ev.id = f.id;
+    ev.lat = f.lat;
+    ev.lon = f.lon;
+    ev.roadName = f.data.value("roadName").toString();
+    ev.description = f.data.value("description").toString();
+    ev.eventType = f.data.value("eventType").toString();
+    ev.severity = f.data.value("severity").toString();
+    ev.fullClosure = f.data.value("fullClosure").toBool();
+    return ev;
+}
+
+void RoadConditionManager::setRoute(const std::shared_ptr<const Route> &route, bool silent)
+{
+    if (!route) {
         clearRoute();
         return;
     }
 
     m_suppressNextAlert = silent;
     ++m_generation;
-    m_routeCoordinates = coordinates;
-    sampleRoutePoints(coordinates);
+    m_route = route;
 
     m_active = true;
     emit activeChanged();
 
+    // Answer from the cache straight away; the fetch refreshes it
+    if (m_cache && m_cache->size(kLayer) > 0) processEvents();
+
     fetchConditions();
-    m_refreshTimer->start();
+    if (m_scheduler) m_scheduler->start(m_refreshTask);
 
-    qDebug() << "RoadConditionManager: Tracking route with" << m_routePoints.size() << "sample points";
+    qDebug() << "RoadConditionManager: Tracking" << m_route->totalKm() << "km route";
 }
 
 void RoadConditionManager::clearRoute()
 {
     ++m_generation;
     m_active = false;
-    m_routeCoordinates = QJsonArray();
-    m_routePoints.clear();
-    m_allEvents.clear();
+    m_route.reset();
     m_routeEvents.clear();
     m_summary.clear();
-    m_refreshTimer->stop();
+    if (m_scheduler) m_scheduler->stop(m_refreshTask);
     emit activeChanged();
     emit summaryChanged();
 
@@ -72,41 +110,20 @@ void RoadConditionManager::clearRoute()
     qDebug() << "RoadConditionManager: Route cleared";
 }
 
-void RoadConditionManager::sampleRoutePoints(const QJsonArray &coordinates)
-{
-    m_routePoints.clear();
-    int numCoords = coordinates.size();
-    // Sample ~20 points along the route for proximity checks
-    int numSamples = qMin(20, numCoords);
-    if (numSamples < 2) numSamples = 2;
-
-    for (int i = 0; i < numSamples; ++i) {
-        double fraction = static_cast<double>(i) / (numSamples - 1);
-        int idx = qMin(static_cast<int>(fraction * (numCoords - 1)), numCoords - 1);
-
-        QJsonArray coord = coordinates[idx].toArray();
-        if (coord.size() >= 2) {
-            m_routePoints.append({ coord[1].toDouble(), coord[0].toDouble() }); // lat, lon
-        }
-    }
-}
-
 void RoadConditionManager::fetchConditions()
 {
+    if (!m_fetcher) return;
     ++m_generation;
-    m_allEvents.clear();
     m_pendingRequests = 0;
 
-    // Build bounding box from route points or current GPS
+    // Build bounding box from the route or current GPS
     double minLat = 90, maxLat = -90, minLon = 180, maxLon = -180;
 
-    if (!m_routePoints.isEmpty()) {
-        for (const auto &pt : m_routePoints) {
-            minLat = qMin(minLat, pt.lat);
-            maxLat = qMax(maxLat, pt.lat);
-            minLon = qMin(minLon, pt.lon);
-            maxLon = qMax(maxLon, pt.lon);
-        }
+    if (m_route) {
+        minLat = m_route->minLat();
+        maxLat = m_route->maxLat();
+        minLon = m_route->minLon();
+        maxLon = m_route->maxLon();
         // Add padding (roughly 15km)
         minLat -= 0.15; maxLat += 0.15;
         minLon -= 0.15; maxLon += 0.15;
@@ -125,42 +142,47 @@ void RoadConditionManager::fetchConditions()
     QUrl abUrl("https://prod-ab.ibi511.com/api/v2/get/event");
     QNetworkRequest abReq(abUrl);
     abReq.setRawHeader("Accept", "application/json");
-    abReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_albertaNetwork->get(abReq);
+    m_fetcher->get("roadConditions/511AB", abReq, this, [this, gen = m_generation](const FeedFetcher::Result &r) {
+        onAlbertaReply(r, gen == m_generation);
+    });
 
-    // DriveBC — fetch active events with bounding box
+    // DriveBC — fetch active events with bounding box. Only that box is
+    // replaced in the cache when the reply lands, even if a newer fetch has
+    // started since.
     m_pendingRequests++;
+    const SpatialTileCache::Bounds bcBounds = { minLat, maxLat, minLon, maxLon };
     QString bcUrlStr = QString("https://api.open511.gov.bc.ca/events?format=json&status=ACTIVE"
         "&area_id=drivebc.ca&bbox=%1,%2,%3,%4&limit=50")
         .arg(minLon, 0, 'f', 4).arg(minLat, 0, 'f', 4)
         .arg(maxLon, 0, 'f', 4).arg(maxLat, 0, 'f', 4);
     QUrl bcUrl(bcUrlStr);
     QNetworkRequest bcReq(bcUrl);
-    bcReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_drivebcNetwork->get(bcReq);
+    m_fetcher->get("roadConditions/DriveBC", bcReq, this,
+                   [this, gen = m_generation, bounds = bcBounds](const FeedFetcher::Result &r) {
+        onDriveBCReply(r, bounds, gen == m_generation);
+    });
 
     qDebug() << "RoadConditionManager: Fetching conditions, bbox:"
              << minLat << minLon << "to" << maxLat << maxLon;
 }
 
-void RoadConditionManager::onAlbertaReply(QNetworkReply *reply)
+void RoadConditionManager::onAlbertaReply(const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    // Discard stale replies from a previous route
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "RoadConditionManager: Alberta fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "RoadConditionManager: Alberta fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processEvents();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "511AB");
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonArray events = doc.array();
+    QList<SpatialTileCache::Feature> snapshot;
 
     for (const QJsonValue &v : events) {
         QJsonObject obj = v.toObject();
@@ -182,33 +204,34 @@ void RoadConditionManager::onAlbertaReply(QNetworkReply *reply)
         // Skip events with no valid location
         if (ev.lat == 0.0 && ev.lon == 0.0) continue;
 
-        m_allEvents.append(ev);
+        snapshot.append(toFeature(ev));
     }
 
     qDebug() << "RoadConditionManager: Alberta returned" << events.size() << "events";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processEvents();
+    // An unparseable body isn't an empty feed; keep what the cache has
+    if (m_cache && doc.isArray()) m_cache->syncSource(kLayer, "511AB", snapshot);
+    replyDone(current);
 }
 
-void RoadConditionManager::onDriveBCReply(QNetworkReply *reply)
+void RoadConditionManager::onDriveBCReply(const FeedFetcher::Result &result,
+                                          const SpatialTileCache::Bounds &bounds, bool current)
 {
-    reply->deleteLater();
-
-    // Discard stale replies from a previous route
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "RoadConditionManager: DriveBC fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "RoadConditionManager: DriveBC fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processEvents();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "DriveBC", bounds);
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonObject root = doc.object();
     QJsonArray events = root["events"].toArray();
+    QList<SpatialTileCache::Feature> snapshot;
 
     for (const QJsonValue &v : events) {
         QJsonObject obj = v.toObject();
@@ -238,26 +261,55 @@ void RoadConditionManager::onDriveBCReply(QNetworkReply *reply)
 
         if (ev.lat == 0.0 && ev.lon == 0.0) continue;
 
-        m_allEvents.append(ev);
+        snapshot.append(toFeature(ev));
     }
 
     qDebug() << "RoadConditionManager: DriveBC returned" << events.size() << "events";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processEvents();
+    if (m_cache && root.contains("events")) m_cache->syncSource(kLayer, "DriveBC", snapshot, bounds);
+    replyDone(current);
+}
+
+void RoadConditionManager::replyDone(bool current)
+{
+    // Superseded replies still land in the cache, since their validators are
+    // already saved; only the current fetch counts toward completion.
+    if (current) m_pendingRequests--;
+    if (m_pendingRequests <= 0 && m_active) processEvents();
 }
 
 void RoadConditionManager::processEvents()
 {
     m_routeEvents.clear();
 
-    // Filter events that are actually ON the route (within 200m of the route line)
-    for (const auto &ev : m_allEvents) {
-        if (isOnRoute(ev.lat, ev.lon)) {
-            m_routeEvents.append(ev);
-        }
+    // Events actually ON the route (within 200m of the route line) and not
+    // already behind the car. With no route, within 200m of the car.
+    const double ON_ROUTE_THRESHOLD_KM = 0.2; // 200 meters
+    const double PASSED_MARGIN_KM = 0.5;      // Keep events just behind us (GPS lag, long closures)
+
+    QList<SpatialTileCache::Hit> hits;
+    if (m_cache && m_route) {
+        hits = m_cache->nearRoute(kLayer, m_route->index(), ON_ROUTE_THRESHOLD_KM, kMaxEventAgeMs);
+    } else if (m_cache && m_context && m_context->gpsLatitude() != 0.0) {
+        hits = m_cache->nearPoint(kLayer, m_context->gpsLatitude(), m_context->gpsLongitude(),
+                                  ON_ROUTE_THRESHOLD_KM, kMaxEventAgeMs);
+    }
+
+    const bool tracking = m_route && m_tracker && m_tracker->tracking()
+                          && m_tracker->routeIndex() == m_route->index();
+    QVector<double> eventKms;
+    for (const auto &hit : hits) {
+        if (tracking && hit.match.alongKm < m_tracker->travelledKm() - PASSED_MARGIN_KM) continue;
+        m_routeEvents.append(fromFeature(hit.feature));
+        eventKms.append(hit.match.alongKm);
     }
 
-    qDebug() << "RoadConditionManager:" << m_allEvents.size() << "total events,"
+    // Refresh more often as the car closes on an event
+    if (m_scheduler) {
+        if (m_route) m_scheduler->setUpcoming(m_refreshTask, eventKms, "road event");
+        else m_scheduler->clearUpcoming(m_refreshTask);
+    }
+
+    qDebug() << "RoadConditionManager:" << (m_cache ? m_cache->size(kLayer) : 0) << "cached events,"
              << m_routeEvents.size() << "near route";
 
     buildSummary();
@@ -329,43 +381,6 @@ void RoadConditionManager::buildSummary()
     qDebug() << "RoadConditionManager: Summary updated," << m_routeEvents.size() << "route events";
 }
 
-bool RoadConditionManager::isOnRoute(double lat, double lon) const
-{
-    // Check perpendicular distance from the event to each segment of the actual route polyline.
-    // Only events within 200m of the route line itself are considered "on route".
-    const double ON_ROUTE_THRESHOLD_KM = 0.2; // 200 meters
-
-    int numCoords = m_routeCoordinates.size();
-    if (numCoords >= 2) {
-        // Walk every segment of the full route polyline
-        // For performance, step through every 5th coordinate (routes can have thousands of points)
-        int step = qMax(1, numCoords / 500);
-        for (int i = 0; i < numCoords - step; i += step) {
-            QJsonArray a = m_routeCoordinates[i].toArray();
-            int j = qMin(i + step, numCoords - 1);
-            QJsonArray b = m_routeCoordinates[j].toArray();
-            if (a.size() >= 2 && b.size() >= 2) {
-                double dist = GeoUtils::pointToSegmentDistanceKm(
-                    lat, lon,
-                    a[1].toDouble(), a[0].toDouble(),  // lat, lon (GeoJSON is lon,lat)
-                    b[1].toDouble(), b[0].toDouble());
-                if (dist < ON_ROUTE_THRESHOLD_KM) {
-                    return true;
-                }
-            }
-        }
-        return false;
-    }
-
-    // No route — check GPS position with 200m radius
-    if (m_context && m_context->gpsLatitude() != 0.0) {
-        return GeoUtils::haversineKm(lat, lon, m_context->gpsLatitude(), m_context->gpsLongitude()) < ON_ROUTE_THRESHOLD_KM;
-    }
-
-    return false;
-}
-
-
 QString RoadConditionManager::shortenDescription(const QString &desc) const
 {
     // Strip "Activities:" boilerplate and truncate for TTS
@@ -4,12 +4,15 @@
 #include <QObject>
 #include <QString>
 #include <QSet>
-#include <QJsonArray>
-#include <QTimer>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <memory>
+
+#include "FeedFetcher.h"
+#include "SpatialTileCache.h"
 
 class ContextAggregator;
+class RefreshScheduler;
+class Route;
+class RouteProgressTracker;
 
 class RoadConditionManager : public QObject
 {
@@ -21,12 +24,18 @@ public:
     explicit RoadConditionManager(QObject *parent = nullptr);
 
     void setContextAggregator(ContextAggregator *ctx);
+    void setRouteProgressTracker(RouteProgressTracker *tracker);
+    void setSpatialTileCache(SpatialTileCache *cache);
+    void setFeedFetcher(FeedFetcher *fetcher);
+    void setRefreshScheduler(RefreshScheduler *scheduler);
 
     bool active() const { return m_active; }
     QString summary() const { return m_summary; }
 
+    // From RouteLoader::routeChanged. silent suppresses the first alert.
+    void setRoute(const std::shared_ptr<const Route> &route, bool silent = false);
+
 public slots:
-    void setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent = false);
     void clearRoute();
 
 signals:
@@ -36,8 +45,6 @@ signals:
 
 private slots:
     void fetchConditions();
-    void onAlbertaReply(QNetworkReply *reply);
-    void onDriveBCReply(QNetworkReply *reply);
 
 private:
     struct RoadEvent {
@@ -51,29 +58,33 @@ private:
         bool fullClosure = false;
     };
 
+    static SpatialTileCache::Feature toFeature(const RoadEvent &ev);
+    static RoadEvent fromFeature(const SpatialTileCache::Feature &f);
+
+    void onAlbertaReply(const FeedFetcher::Result &result, bool current);
+    void onDriveBCReply(const FeedFetcher::Result &result, const SpatialTileCache::Bounds &bounds,
+                        bool current);
+    void replyDone(bool current);
     void processEvents();
     void buildSummary();
-    bool isOnRoute(double lat, double lon) const;
     QString shortenDescription(const QString &desc) const;
 
-    QNetworkAccessManager *m_albertaNetwork;
-    QNetworkAccessManager *m_drivebcNetwork;
-    QTimer *m_refreshTimer;
+    FeedFetcher *m_fetcher = nullptr;
+    RefreshScheduler *m_scheduler = nullptr;
+    int m_refreshTask = -1;
     ContextAggregator *m_context = nullptr;
+    RouteProgressTracker *m_tracker = nullptr;
+    SpatialTileCache *m_cache = nullptr;
 
     bool m_active = false;
     QString m_summary;
 
-    QList<RoadEvent> m_allEvents;
     QList<RoadEvent> m_routeEvents;  // filtered to route proximity
-    QJsonArray m_routeCoordinates;
     int m_pendingRequests = 0;
     int m_generation = 0;
 
     // Sample points along route for proximity checks
-    struct RoutePoint { double lat; double lon; };
-    QList<RoutePoint> m_routePoints;
-    void sampleRoutePoints(const QJsonArray &coordinates);
+    std::shared_ptr<const Route> m_route;
 
     // Change detection — only emit alertDetected when event set differs
     QSet<QString> m_lastEventIds;
@@ -1,63 +1,103 @@
 #include "RoadSurfaceManager.h"
 #include "ContextAggregator.h"
 #include "GeoUtils.h"
+#include "RefreshScheduler.h"
+#include "Route.h"
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QtMath>
 #include <cmath>
 
+namespace {
+
+const QString kLayer = QStringLiteral("roadSurface");
+
+// Surface reports older than this say little about the road now
+constexpr qint64 kMaxReportAgeMs = 60 * 60 * 1000;
+
+} // namespace
+
 RoadSurfaceManager::RoadSurfaceManager(QObject *parent)
     : QObject(parent)
-    , m_albertaNetwork(new QNetworkAccessManager(this))
-    , m_drivebcNetwork(new QNetworkAccessManager(this))
-    , m_refreshTimer(new QTimer(this))
 {
-    connect(m_albertaNetwork, &QNetworkAccessManager::finished,
-            this, &RoadSurfaceManager::onAlbertaReply);
-    connect(m_drivebcNetwork, &QNetworkAccessManager::finished,
-            this, &RoadSurfaceManager::onDriveBCReply);
-
-    // Refresh every 10 minutes
-    m_refreshTimer->setInterval(10 * 60 * 1000);
-    connect(m_refreshTimer, &QTimer::timeout, this, &RoadSurfaceManager::fetchConditions);
-
     qDebug() << "RoadSurfaceManager: Initialized";
 }
 
 void RoadSurfaceManager::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+void RoadSurfaceManager::setSpatialTileCache(SpatialTileCache *cache) { m_cache = cache; }
+void RoadSurfaceManager::setFeedFetcher(FeedFetcher *fetcher) { m_fetcher = fetcher; }
+
+void RoadSurfaceManager::setRefreshScheduler(RefreshScheduler *scheduler)
+{
+    m_scheduler = scheduler;
+    // Refresh every 10 minutes
+    m_refreshTask = scheduler->add("roadSurface", 10 * 60 * 1000, this, [this]() { fetchConditions(); });
+}
 
-void RoadSurfaceManager::setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent)
+SpatialTileCache::Feature RoadSurfaceManager::toFeature(const SurfaceReport &rpt)
 {
-    Q_UNUSED(durationSec)
+    SpatialTileCache::Feature f;
+    f.id = rpt.id;
+    f.lat = rpt.lat;
+    f.lon = rpt.lon;
+    f.data = {
+        { "roadName", rpt.roadName },
+        { "condition", rpt.condition },
+    };
+    // Left out when unknown: NaN never compares equal, so every sync would
+    // count the report as changed
+    if (!std::isnan(rpt.pavementTempC))
+        f.data.insert("pavementTempC", rpt.pavementTempC);
+    return f;
+}
+
+RoadSurfaceManager::SurfaceReport RoadSurfaceManager::fromFeature(const SpatialTileCache::Feature &f)
+{
+    SurfaceReport rpt;
+    rpt.id = f.id;
+    rpt.lat = f.lat;
+    rpt.lon = f.lon;
+    rpt.source = f.source;
+    rpt.roadName = f.data.value("roadName").toString();
+    rpt.condition = f.data.value("condition").toString();
+    rpt.pavementTempC = f.data.value("pavementTempC", std::numeric_limits<double>::quiet_NaN()).toDouble();
+    return rpt;
+}
 
-    if (coordinates.size() < 2) {
+void RoadSurfaceManager::setRoute(const std::shared_ptr<const Route> &route, bool silent)
+{
+    if (!route) {
         clearRoute();
         return;
     }
 
     m_suppressNextAlert = silent;
     ++m_generation;
-    m_routeCoordinates = coordinates;
+    m_route = route;
 
     m_active = true;
     emit activeChanged();
 
+    // Answer from the cache straight away; the fetch refreshes it
+    if (m_cache && m_cache->size(kLayer) > 0) processResults();
+
     fetchConditions();
-    m_refreshTimer->start();
+    if (m_scheduler) m_scheduler->start(m_refreshTask);
 
-    qDebug() << "RoadSurfaceManager: Tracking route with" << coordinates.size() << "coordinates";
+    qDebug() << "RoadSurfaceManager: Tracking route with" << m_route->size() << "points";
 }
 
 void RoadSurfaceManager::clearRoute()
 {
     ++m_generation;
     m_active = false;
-    m_routeCoordinates = QJsonArray();
-    m_allReports.clear();
+    m_route.reset();
     m_routeReports.clear();
     m_summary.clear();
-    m_refreshTimer->stop();
+    if (m_scheduler) m_scheduler->stop(m_refreshTask);
     emit activeChanged();
     emit summaryChanged();
 
@@ -72,8 +112,8 @@ void RoadSurfaceManager::clearRoute()
 
 void RoadSurfaceManager::fetchConditions()
 {
+    if (!m_fetcher) return;
     ++m_generation;
-    m_allReports.clear();
     m_pendingRequests = 0;
 
     // 511 Alberta Winter Roads — returns all roads, filter by proximity later
@@ -81,52 +121,58 @@ void RoadSurfaceManager::fetchConditions()
     QUrl abUrl("https://511.alberta.ca/api/v2/get/winterroads");
     QNetworkRequest abReq(abUrl);
     abReq.setRawHeader("Accept", "application/json");
-    abReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_albertaNetwork->get(abReq);
+    m_fetcher->get("roadSurface/511AB", abReq, this, [this, gen = m_generation](const FeedFetcher::Result &r) {
+        onAlbertaReply(r, gen == m_generation);
+    });
 
     // DriveBC Weather Stations — returns all stations, filter by proximity later
     m_pendingRequests++;
     QUrl bcUrl("https://www.drivebc.ca/api/weather/current/");
     QNetworkRequest bcReq(bcUrl);
     bcReq.setRawHeader("Accept", "application/json");
-    bcReq.setAttribute(QNetworkRequest::UserMax, m_generation);
-    m_drivebcNetwork->get(bcReq);
+    m_fetcher->get("roadSurface/DriveBC", bcReq, this, [this, gen = m_generation](const FeedFetcher::Result &r) {
+        onDriveBCReply(r, gen == m_generation);
+    });
 
     qDebug() << "RoadSurfaceManager: Fetching surface conditions from 511AB + DriveBC";
 }
 
-void RoadSurfaceManager::onAlbertaReply(QNetworkReply *reply)
+void RoadSurfaceManager::onAlbertaReply(const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    // Discard stale replies from a previous route
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "RoadSurfaceManager: Alberta fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "RoadSurfaceManager: Alberta fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processResults();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "511AB");
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonArray roads = doc.array();
+    QList<SpatialTileCache::Feature> snapshot;
 
     for (const QJsonValue &v : roads) {
         QJsonObject obj = v.toObject();
 
-        QString encodedPolyline = obj["EncodedPolyline"].toString();
+        const QByteArray encodedPolyline = obj["EncodedPolyline"].toString().toLatin1();
         if (encodedPolyline.isEmpty()) continue;
 
-        QPair<double, double> firstPt = decodePolylineFirstPoint(encodedPolyline);
-        if (firstPt.first == 0.0 && firstPt.second == 0.0) continue;
+        // The report is placed at the segment's first point
+        QVector<double> lats, lons;
+        GeoUtils::decodePolyline(encodedPolyline, 5, lats, lons, 1);
+        if (lats.isEmpty()) continue;
 
         SurfaceReport rpt;
+        // The feed has no stable id; the segment geometry identifies it
+        rpt.id = "ab-" + QString::fromLatin1(QCryptographicHash::hash(encodedPolyline,
+                                                                      QCryptographicHash::Sha1).toHex().left(16));
         rpt.roadName = obj["RoadwayName"].toString();
-        rpt.lat = firstPt.first;
-        rpt.lon = firstPt.second;
+        rpt.lat = lats[0];
+        rpt.lon = lons[0];
         rpt.source = "511AB";
         rpt.pavementTempC = std::numeric_limits<double>::quiet_NaN();
 
@@ -142,32 +188,32 @@ void RoadSurfaceManager::onAlbertaReply(QNetworkReply *reply)
 
         if (rpt.condition.isEmpty() || rpt.condition == "No Report") continue;
 
-        m_allReports.append(rpt);
+        snapshot.append(toFeature(rpt));
     }
 
     qDebug() << "RoadSurfaceManager: Alberta returned" << roads.size() << "winter road entries";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processResults();
+    // An unparseable body isn't an empty feed; keep what the cache has
+    if (m_cache && doc.isArray()) m_cache->syncSource(kLayer, "511AB", snapshot);
+    replyDone(current);
 }
 
-void RoadSurfaceManager::onDriveBCReply(QNetworkReply *reply)
+void RoadSurfaceManager::onDriveBCReply(const FeedFetcher::Result &result, bool current)
 {
-    reply->deleteLater();
-
-    // Discard stale replies from a previous route
-    if (reply->request().attribute(QNetworkRequest::UserMax).toInt() != m_generation) {
+    if (!result.ok()) {
+        qWarning() << "RoadSurfaceManager: DriveBC fetch failed:" << result.errorString;
+        replyDone(current);
         return;
     }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "RoadSurfaceManager: DriveBC fetch failed:" << reply->errorString();
-        m_pendingRequests--;
-        if (m_pendingRequests <= 0) processResults();
+    if (result.unchanged) {
+        if (m_cache) m_cache->touchSource(kLayer, "DriveBC");
+        replyDone(current);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonArray stations = doc.array();
+    QList<SpatialTileCache::Feature> snapshot;
 
     for (const QJsonValue &v : stations) {
         QJsonObject obj = v.toObject();
@@ -200,67 +246,63 @@ void RoadSurfaceManager::onDriveBCReply(QNetworkReply *reply)
             rpt.roadName = obj["name"].toString();
         }
 
+        const QString stationId = obj["id"].toVariant().toString();
+        rpt.id = "bc-" + (stationId.isEmpty() ? rpt.roadName : stationId);
+
         if (rpt.lat == 0.0 && rpt.lon == 0.0) continue;
 
-        m_allReports.append(rpt);
+        snapshot.append(toFeature(rpt));
     }
 
     qDebug() << "RoadSurfaceManager: DriveBC returned" << stations.size() << "weather stations";
-    m_pendingRequests--;
-    if (m_pendingRequests <= 0) processResults();
+    if (m_cache && doc.isArray()) m_cache->syncSource(kLayer, "DriveBC", snapshot);
+    replyDone(current);
 }
 
-QPair<double, double> RoadSurfaceManager::decodePolylineFirstPoint(const QString &encoded)
+bool RoadSurfaceManager::isIcy(const SurfaceReport &rpt)
 {
-    // Google Encoded Polyline Algorithm — decode only the first lat/lon pair
-    // Each value: read 5-bit chunks (char - 63), bottom 5 bits, continue if bit 0x20 set
-    // Then zigzag decode: (result >> 1) ^ -(result & 1), divide by 1e5
-
-    int index = 0;
-    int len = encoded.length();
-    double lat = 0.0;
-    double lon = 0.0;
-
-    // Decode latitude
-    if (index >= len) return qMakePair(0.0, 0.0);
-    int shift = 0;
-    int result = 0;
-    int b;
-    do {
-        if (index >= len) return qMakePair(0.0, 0.0);
-        b = encoded.at(index++).toLatin1() - 63;
-        result |= (b & 0x1F) << shift;
-        shift += 5;
-    } while (b >= 0x20);
-    lat = ((result & 1) ? ~(result >> 1) : (result >> 1)) / 1e5;
-
-    // Decode longitude
-    if (index >= len) return qMakePair(0.0, 0.0);
-    shift = 0;
-    result = 0;
-    do {
-        if (index >= len) return qMakePair(0.0, 0.0);
-        b = encoded.at(index++).toLatin1() - 63;
-        result |= (b & 0x1F) << shift;
-        shift += 5;
-    } while (b >= 0x20);
-    lon = ((result & 1) ? ~(result >> 1) : (result >> 1)) / 1e5;
-
-    return qMakePair(lat, lon);
+    return rpt.condition.contains("Ice", Qt::CaseInsensitive) ||
+           rpt.condition.contains("Covered Snow", Qt::CaseInsensitive) ||
+           rpt.condition.contains("Packed", Qt::CaseInsensitive);
+}
+
+void RoadSurfaceManager::replyDone(bool current)
+{
+    // Superseded replies still land in the cache, since their validators are
+    // already saved; only the current fetch counts toward completion.
+    if (current) m_pendingRequests--;
+    if (m_pendingRequests <= 0 && m_active) processResults();
 }
 
 void RoadSurfaceManager::processResults()
 {
     m_routeReports.clear();
 
-    // Filter reports near route (within 200m of route polyline)
-    for (const auto &rpt : m_allReports) {
-        if (isNearRoute(rpt.lat, rpt.lon)) {
-            m_routeReports.append(rpt);
-        }
+    // Reports within 200m of the route polyline, or of the car with no route
+    const double ON_ROUTE_THRESHOLD_KM = 0.2; // 200 meters
+
+    QList<SpatialTileCache::Hit> hits;
+    if (m_cache && m_route) {
+        hits = m_cache->nearRoute(kLayer, m_route->index(), ON_ROUTE_THRESHOLD_KM, kMaxReportAgeMs);
+    } else if (m_cache && m_context && m_context->gpsLatitude() != 0.0) {
+        hits = m_cache->nearPoint(kLayer, m_context->gpsLatitude(), m_context->gpsLongitude(),
+                                  ON_ROUTE_THRESHOLD_KM, kMaxReportAgeMs);
+    }
+    QVector<double> hazardKms;
+    for (const auto &hit : hits) {
+        const SurfaceReport rpt = fromFeature(hit.feature);
+        m_routeReports.append(rpt);
+        if (isIcy(rpt) || (!std::isnan(rpt.pavementTempC) && rpt.pavementTempC < -5.0))
+            hazardKms.append(hit.match.alongKm);
     }
 
-    qDebug() << "RoadSurfaceManager:" << m_allReports.size() << "total reports,"
+    // Refresh more often on the approach to ice
+    if (m_scheduler) {
+        if (m_route) m_scheduler->setUpcoming(m_refreshTask, hazardKms, "icy road");
+        else m_scheduler->clearUpcoming(m_refreshTask);
+    }
+
+    qDebug() << "RoadSurfaceManager:" << (m_cache ? m_cache->size(kLayer) : 0) << "cached reports,"
              << m_routeReports.size() << "near route";
 
     buildSummary();
@@ -270,12 +312,7 @@ void RoadSurfaceManager::processResults()
     for (const auto &rpt : m_routeReports) {
         QString road = rpt.roadName.isEmpty() ? "your route" : rpt.roadName;
 
-        bool dangerousCondition =
-            rpt.condition.contains("Ice", Qt::CaseInsensitive) ||
-            rpt.condition.contains("Covered Snow", Qt::CaseInsensitive) ||
-            rpt.condition.contains("Packed", Qt::CaseInsensitive);
-
-        if (dangerousCondition) {
+        if (isIcy(rpt)) {
             combinedAlert += QString("Icy road conditions reported on %1 ahead. ").arg(road);
         }
 
@@ -335,41 +372,3 @@ void RoadSurfaceManager::buildSummary()
 
     qDebug() << "RoadSurfaceManager: Summary updated," << m_routeReports.size() << "route reports";
 }
-
-bool RoadSurfaceManager::isNearRoute(double lat, double lon) const
-{
-    // Check perpendicular distance from the report to each segment of the actual route polyline.
-    // Only reports within 200m of the route line itself are considered "near route".
-    const double ON_ROUTE_THRESHOLD_KM = 0.2; // 200 meters
-
-    int numCoords = m_routeCoordinates.size();
-    if (numCoords >= 2) {
-        // Walk every segment of the full route polyline
-        // For performance, step through every 5th coordinate (routes can have thousands of points)
-        int step = qMax(1, numCoords / 500);
-        for (int i = 0; i < numCoords - step; i += step) {
-            QJsonArray a = m_routeCoordinates[i].toArray();
-            int j = qMin(i + step, numCoords - 1);
-            QJsonArray b = m_routeCoordinates[j].toArray();
-            if (a.size() >= 2 && b.size() >= 2) {
-                double dist = GeoUtils::pointToSegmentDistanceKm(
-                    lat, lon,
-                    a[1].toDouble(), a[0].toDouble(),  // lat, lon (GeoJSON is lon,lat)
-                    b[1].toDouble(), b[0].toDouble());
-                if (dist < ON_ROUTE_THRESHOLD_KM) {
-                    return true;
-                }
-            }
-        }
-        return false;
-    }
-
-    // No route — check GPS position with 200m radius
-    if (m_context && m_context->gpsLatitude() != 0.0) {
-        return GeoUtils::haversineKm(lat, lon, m_context->gpsLatitude(), m_context->gpsLongitude()) < ON_ROUTE_THRESHOLD_KM;
-    }
-
-    return false;
-}
-
-
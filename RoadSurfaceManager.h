@@ -3,13 +3,14 @@
 
 #include <QObject>
 #include <QString>
-#include <QJsonArray>
-#include <QTimer>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QPair>
+#include <memory>
+
+#include "FeedFetcher.h"
+#include "SpatialTileCache.h"
 
 class ContextAggregator;
+class RefreshScheduler;
+class Route;
 
 class RoadSurfaceManager : public QObject
 {
@@ -21,12 +22,17 @@ public:
     explicit RoadSurfaceManager(QObject *parent = nullptr);
 
     void setContextAggregator(ContextAggregator *ctx);
+    void setSpatialTileCache(SpatialTileCache *cache);
+    void setFeedFetcher(FeedFetcher *fetcher);
+    void setRefreshScheduler(RefreshScheduler *scheduler);
 
     bool active() const { return m_active; }
     QString summary() const { return m_summary; }
 
+    // From RouteLoader::routeChanged. silent suppresses the first alert.
+    void setRoute(const std::shared_ptr<const Route> &route, bool silent = false);
+
 public slots:
-    void setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent = false);
     void clearRoute();
 
 signals:
@@ -36,11 +42,10 @@ signals:
 
 private slots:
     void fetchConditions();
-    void onAlbertaReply(QNetworkReply *reply);
-    void onDriveBCReply(QNetworkReply *reply);
 
 private:
     struct SurfaceReport {
+        QString id;
         QString roadName;
         QString condition;          // "Bare Dry", "Bare Wet", "Covered Snow", "Ice", etc.
         double pavementTempC = 0.0; // NaN if unavailable
@@ -49,23 +54,27 @@ private:
         QString source;             // "511AB" or "DriveBC"
     };
 
+    void onAlbertaReply(const FeedFetcher::Result &result, bool current);
+    void onDriveBCReply(const FeedFetcher::Result &result, bool current);
+    void replyDone(bool current);
+    static SpatialTileCache::Feature toFeature(const SurfaceReport &rpt);
+    static SurfaceReport fromFeature(const SpatialTileCache::Feature &f);
+    static bool isIcy(const SurfaceReport &rpt);
+
     void processResults();
     void buildSummary();
-    bool isNearRoute(double lat, double lon) const;
-    // Decode Google Encoded Polyline to get first coordinate
-    static QPair<double, double> decodePolylineFirstPoint(const QString &encoded);
 
-    QNetworkAccessManager *m_albertaNetwork;
-    QNetworkAccessManager *m_drivebcNetwork;
-    QTimer *m_refreshTimer;
     ContextAggregator *m_context = nullptr;
+    SpatialTileCache *m_cache = nullptr;
+    FeedFetcher *m_fetcher = nullptr;
+    RefreshScheduler *m_scheduler = nullptr;
+    int m_refreshTask = -1;
+    std::shared_ptr<const Route> m_route;
 
     bool m_active = false;
     QString m_summary;
 
-    QList<SurfaceReport> m_allReports;
     QList<SurfaceReport> m_routeReports;
-    QJsonArray m_routeCoordinates;
     int m_pendingRequests = 0;
     int m_generation = 0;
 
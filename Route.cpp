@@ -0,0 +1,129 @@
+#include "Route.h"
+#include "GeoUtils.h"
+#include <QDebug>
+#include <QJsonArray>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+qint16 parseMaxspeed(const QJsonObject &ann)
+{
+    if (ann["none"].toBool()) return Route::kSpeedNone;
+    if (ann["unknown"].toBool() || !ann.contains("speed")) return Route::kSpeedUnknown;
+
+    const int speed = ann["speed"].toInt();
+    if (ann["unit"].toString() == "mph") return static_cast<qint16>(qRound(speed * 1.60934));
+    return static_cast<qint16>(speed);   // km/h is the default
+}
+
+} // namespace
+
+std::shared_ptr<const Route> Route::fromDirections(const QJsonObject &route, QString *error)
+{
+    std::shared_ptr<Route> r(new Route);
+    r->m_distanceKm = route["distance"].toDouble() / 1000.0;
+    r->m_durationSec = route["duration"].toDouble();
+
+    // Steps and maxspeed from all legs. Legs share their boundary waypoint,
+    // so the concatenated annotations line up one per geometry segment.
+    const QJsonArray legs = route["legs"].toArray();
+    r->m_legCount = legs.size();
+    QVector<qint16> rawMaxspeed;
+    for (const QJsonValue &legValue : legs) {
+        const QJsonObject leg = legValue.toObject();
+
+        const QJsonArray maxspeed = leg["annotation"].toObject().value("maxspeed").toArray();
+        for (const QJsonValue &ann : maxspeed)
+            rawMaxspeed.append(parseMaxspeed(ann.toObject()));
+
+        for (const QJsonValue &stepValue : leg["steps"].toArray()) {
+            const QJsonObject step = stepValue.toObject();
+            const QJsonObject maneuver = step["maneuver"].toObject();
+            const QJsonArray location = maneuver["location"].toArray();
+
+            RouteStep s;
+            s.instruction = maneuver["instruction"].toString();
+            s.type = maneuver["type"].toString();
+            s.modifier = maneuver["modifier"].toString();
+            s.name = step["name"].toString();
+            s.distanceM = step["distance"].toDouble();
+            s.durationSec = step["duration"].toDouble();
+            if (location.size() >= 2) {
+                s.lon = location[0].toDouble();
+                s.lat = location[1].toDouble();
+            }
+            r->m_steps.append(s);
+        }
+    }
+    r->m_hasMaxspeed = !rawMaxspeed.isEmpty();
+
+    // Geometry arrives as a polyline6 string (what RouteLoader asks for);
+    // a GeoJSON LineString is accepted too
+    QVector<double> lats, lons;
+    const QJsonValue geometry = route["geometry"];
+    if (geometry.isString()) {
+        if (!GeoUtils::decodePolyline(geometry.toString().toLatin1(), kPolylinePrecision, lats, lons)) {
+            if (error) *error = QStringLiteral("Malformed route polyline");
+            return nullptr;
+        }
+    } else {
+        const QJsonArray coordinates = geometry.toObject().value("coordinates").toArray();
+        lats.reserve(coordinates.size());
+        lons.reserve(coordinates.size());
+        for (const QJsonValue &v : coordinates) {
+            // Malformed points are skipped below; NaN keeps the indices
+            // lined up with the maxspeed annotations until then
+            const QJsonArray pt = v.toArray();
+            const bool valid = pt.size() >= 2 && pt[0].isDouble() && pt[1].isDouble();
+            lons.append(valid ? pt[0].toDouble() : qQNaN());
+            lats.append(valid ? pt[1].toDouble() : qQNaN());
+        }
+    }
+
+    // Exact repeats are dropped here rather than in RouteIndex so the
+    // maxspeed of the zero-length segment goes with them and the rest stay
+    // aligned. A segment bridging a skipped malformed point takes the
+    // maxspeed of the annotation leading into the point after it.
+    int kept = 0;
+    int skipped = 0;
+    r->m_maxspeed.reserve(lats.size());
+    for (int i = 0; i < lats.size(); ++i) {
+        if (qIsNaN(lats[i])) {
+            ++skipped;
+            continue;
+        }
+        if (kept > 0 && lats[kept - 1] == lats[i] && lons[kept - 1] == lons[i]) continue;
+        if (kept > 0)
+            r->m_maxspeed.append(i - 1 < rawMaxspeed.size() ? rawMaxspeed[i - 1] : kSpeedUnknown);
+        lats[kept] = lats[i];
+        lons[kept] = lons[i];
+        ++kept;
+    }
+    lats.resize(kept);
+    lons.resize(kept);
+    if (skipped > 0)
+        qWarning() << "Route: Skipped" << skipped << "malformed coordinates";
+
+    if (!lats.isEmpty()) {
+        const auto [minLat, maxLat] = std::minmax_element(lats.cbegin(), lats.cend());
+        const auto [minLon, maxLon] = std::minmax_element(lons.cbegin(), lons.cend());
+        r->m_minLat = *minLat;
+        r->m_maxLat = *maxLat;
+        r->m_minLon = *minLon;
+        r->m_maxLon = *maxLon;
+    }
+
+    r->m_index = RouteIndex::build(std::move(lats), std::move(lons));
+    if (!r->m_index) {
+        if (error) *error = QStringLiteral("Route geometry has fewer than two points");
+        return nullptr;
+    }
+    r->m_sampler = std::make_unique<const RouteSampler>(r->m_index, r->m_steps, r->averageSpeedKmh());
+    return r;
+}
+
+double Route::averageSpeedKmh() const
+{
+    return m_durationSec > 0.0 ? totalKm() / (m_durationSec / 3600.0) : 80.0;
+}
@@ -0,0 +1,91 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+
+#include "CompactPolyline.h"
+#include "RouteIndex.h"
+#include "RouteSampler.h"
+
+// One turn-by-turn step, flattened across legs
+struct RouteStep {
+    QString instruction;
+    QString type;           // Mapbox maneuver type ("turn", "arrive", ...)
+    QString modifier;       // "left", "slight right", ...
+    QString name;           // Road name
+    double distanceM = 0.0;
+    double durationSec = 0.0;
+    double lat = 0.0;       // Maneuver location
+    double lon = 0.0;
+};
+
+// Immutable, parsed Mapbox directions route.
+//
+// Built once per directions response by RouteLoader (off the GUI thread)
+// and shared by pointer with every route-aware manager, so nobody walks the
+// response again. The geometry is held once, as the RouteIndex's
+// CompactPolyline (geometry()), with cumulative distance per point, and the
+// per-segment maxspeed annotations are aligned with its segments:
+// maxspeedKmh(i) covers point i to i + 1. sampler() picks points along it
+// by distance or driving time.
+class Route
+{
+public:
+    static constexpr qint16 kSpeedUnknown = 0;
+    static constexpr qint16 kSpeedNone = -1;   // Posted "no limit" (autobahn)
+    static constexpr int kPolylinePrecision = 6; // geometries=polyline6
+
+    // Builds from one element of a directions response's "routes" array.
+    // Returns nullptr (and sets error) if the geometry is unusable.
+    static std::shared_ptr<const Route> fromDirections(const QJsonObject &route, QString *error = nullptr);
+
+    const std::shared_ptr<const RouteIndex> &index() const { return m_index; }
+    const CompactPolyline &geometry() const { return m_index->points(); }
+    const RouteSampler &sampler() const { return *m_sampler; }
+
+    int size() const { return m_index->size(); }
+    double lat(int i) const { return m_index->lat(i); }
+    double lon(int i) const { return m_index->lon(i); }
+    double cumulativeKm(int i) const { return m_index->cumulativeKm(i); }
+    double totalKm() const { return m_index->totalKm(); }
+
+    // As reported by Mapbox
+    double distanceKm() const { return m_distanceKm; }
+    double durationSec() const { return m_durationSec; }
+
+    // Over the whole route, 80 km/h when Mapbox gave no duration
+    double averageSpeedKmh() const;
+
+    bool hasMaxspeed() const { return m_hasMaxspeed; }
+    qint16 maxspeedKmh(int segment) const { return m_maxspeed[segment]; }
+
+    const QVector<RouteStep> &steps() const { return m_steps; }
+    int legCount() const { return m_legCount; }
+
+    double minLat() const { return m_minLat; }
+    double maxLat() const { return m_maxLat; }
+    double minLon() const { return m_minLon; }
+    double maxLon() const { return m_maxLon; }
+
+private:
+    Route() = default;
+
+    std::shared_ptr<const RouteIndex> m_index;
+    std::unique_ptr<const RouteSampler> m_sampler;
+    QVector<qint16> m_maxspeed;   // km/h per segment, or kSpeedUnknown / kSpeedNone
+    bool m_hasMaxspeed = false;
+    QVector<RouteStep> m_steps;
+    int m_legCount = 0;
+    double m_distanceKm = 0.0;
+    double m_durationSec = 0.0;
+    double m_minLat = 0.0;
+    double m_maxLat = 0.0;
+    double m_minLon = 0.0;
+    double m_maxLon = 0.0;
+};
+
+#endif // ROUTE_H
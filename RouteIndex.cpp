@@ -0,0 +1,170 @@
+#include "RouteIndex.h"
+#include "GeoUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kKmPerDegLat = 110.574;
+constexpr double kKmPerDegLonEquator = 111.320;
+
+// Rings searched before an unbounded nearest() gives up on the grid and
+// scans every segment — only hit when the point is far off the route
+constexpr int kMaxRings = 32;
+
+} // namespace
+
+std::shared_ptr<const RouteIndex> RouteIndex::build(QVector<double> lats, QVector<double> lons)
+{
+    std::shared_ptr<RouteIndex> index(new RouteIndex);
+    const int n = qMin(lats.size(), lons.size());
+
+    // Compact in place, collapsing exact repeats — they add zero-length
+    // segments and nothing else
+    int kept = 0;
+    for (int i = 0; i < n; ++i) {
+        if (kept > 0 && lats[kept - 1] == lats[i] && lons[kept - 1] == lons[i]) continue;
+        lats[kept] = lats[i];
+        lons[kept] = lons[i];
+        ++kept;
+    }
+    if (kept < 2) return nullptr;
+
+    // Store the points, then read them back so distances and the grid are
+    // built from exactly the coordinates lookups will see
+    index->m_points = CompactPolyline::fromCoordinates(lats.constData(), lons.constData(), kept);
+    index->m_points.decode(lats, lons);
+
+    index->m_cumKm.reserve(kept);
+    index->m_cumKm.append(0.0);
+    double maxAbsLat = qAbs(lats[0]);
+    for (int i = 1; i < kept; ++i) {
+        index->m_cumKm.append(index->m_cumKm.last()
+                              + GeoUtils::haversineKm(lats[i - 1], lons[i - 1], lats[i], lons[i]));
+        maxAbsLat = qMax(maxAbsLat, qAbs(lats[i]));
+    }
+
+    index->m_lat0 = lats.first();
+    index->m_lon0 = lons.first();
+    index->m_kmPerDegLat = kKmPerDegLat;
+    index->m_kmPerDegLon = kKmPerDegLonEquator * qCos(qDegreesToRadians(qMin(maxAbsLat, 89.0)));
+
+    // Bucket each segment into every cell its bounding box touches
+    const int segments = kept - 1;
+    index->m_cells.reserve(segments * 2);
+    for (int s = 0; s < segments; ++s) {
+        const double ax = index->projX(lons[s]), ay = index->projY(lats[s]);
+        const double bx = index->projX(lons[s + 1]), by = index->projY(lats[s + 1]);
+        const int x0 = static_cast<int>(std::floor(qMin(ax, bx) / kCellKm));
+        const int x1 = static_cast<int>(std::floor(qMax(ax, bx) / kCellKm));
+        const int y0 = static_cast<int>(std::floor(qMin(ay, by) / kCellKm));
+        const int y1 = static_cast<int>(std::floor(qMax(ay, by) / kCellKm));
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (int cy = y0; cy <= y1; ++cy)
+                index->m_cells.append({ index->cellKey(cx, cy), s });
+        }
+    }
+    std::sort(index->m_cells.begin(), index->m_cells.end());
+
+    return index;
+}
+
+int64_t RouteIndex::cellKey(int cx, int cy) const
+{
+    return (static_cast<int64_t>(cx) << 32) | static_cast<uint32_t>(cy);
+}
+
+void RouteIndex::checkSegment(int seg, const CompactPolyline::Segment &s, double lat, double lon,
+                              Match &best) const
+{
+    // The batch kernel's projection, so every caller agrees on which point
+    // of a segment is closest
+    const double lats[2] = { s.lat0, s.lat1 };
+    const double lons[2] = { s.lon0, s.lon1 };
+    double d, t;
+    GeoUtils::segmentDistancesKm(lat, lon, lats, lons, 2, &d, &t);
+    if (d < best.distanceKm) {
+        best.distanceKm = d;
+        best.segment = seg;
+        best.t = t;
+        best.lat = s.lat0 + t * (s.lat1 - s.lat0);
+        best.lon = s.lon0 + t * (s.lon1 - s.lon0);
+    }
+}
+
+RouteIndex::Match RouteIndex::nearest(double lat, double lon, double maxKm) const
+{
+    Match best;
+    if (m_points.size() < 2) return best;
+
+    const int qx = static_cast<int>(std::floor(projX(lon) / kCellKm));
+    const int qy = static_cast<int>(std::floor(projY(lat) / kCellKm));
+
+    auto visitCell = [&](int cx, int cy) {
+        const int64_t key = cellKey(cx, cy);
+        auto it = std::lower_bound(m_cells.begin(), m_cells.end(), key,
+                                   [](const CellEntry &e, int64_t k) { return e.key < k; });
+        for (; it != m_cells.end() && it->key == key; ++it)
+            checkSegment(it->segment, m_points.segment(it->segment), lat, lon, best);
+    };
+
+    // Everything in rings 0..r is at least r cells' worth of projected
+    // distance closer than anything outside them, and projected distance
+    // never exceeds true distance
+    const bool bounded = std::isfinite(maxKm);
+    const int maxRing = bounded ? static_cast<int>(std::ceil(maxKm / kCellKm)) : kMaxRings;
+    bool settled = false;
+    for (int r = 0; r <= maxRing; ++r) {
+        if (r == 0) {
+            visitCell(qx, qy);
+        } else {
+            for (int i = -r; i <= r; ++i) {
+                visitCell(qx + i, qy - r);
+                visitCell(qx + i, qy + r);
+            }
+            for (int i = -r + 1; i <= r - 1; ++i) {
+                visitCell(qx - r, qy + i);
+                visitCell(qx + r, qy + i);
+            }
+        }
+        if (best.distanceKm <= r * kCellKm) {
+            settled = true;
+            break;
+        }
+    }
+
+    if (!settled && !bounded) {
+        // Far off the route — exhaustive batch scan, decoding the line once
+        // rather than seeking to every segment
+        QVector<double> lats, lons;
+        m_points.decode(lats, lons);
+        const int s = GeoUtils::nearestSegment(lat, lon, lats.constData(), lons.constData(), lats.size());
+        if (s >= 0)
+            checkSegment(s, { lats[s], lons[s], lats[s + 1], lons[s + 1] }, lat, lon, best);
+    }
+
+    if (best.segment < 0 || best.distanceKm > maxKm) return Match();
+
+    best.valid = true;
+    best.alongKm = m_cumKm[best.segment] + best.t * (m_cumKm[best.segment + 1] - m_cumKm[best.segment]);
+    return best;
+}
+
+int RouteIndex::segmentAt(double alongKm) const
+{
+    if (m_cumKm.size() < 2) return -1;
+    auto it = std::upper_bound(m_cumKm.begin(), m_cumKm.end(), alongKm);
+    const int seg = static_cast<int>(it - m_cumKm.begin()) - 1;
+    return qBound(0, seg, m_cumKm.size() - 2);
+}
+
+std::pair<double, double> RouteIndex::pointAt(double alongKm) const
+{
+    const int seg = segmentAt(alongKm);
+    if (seg < 0) return { 0.0, 0.0 };
+
+    const double segKm = m_cumKm[seg + 1] - m_cumKm[seg];
+    const double t = segKm > 0.0 ? qBound(0.0, (alongKm - m_cumKm[seg]) / segKm, 1.0) : 0.0;
+    const CompactPolyline::Segment s = m_points.segment(seg);
+    return { s.lat0 + t * (s.lat1 - s.lat0), s.lon0 + t * (s.lon1 - s.lon0) };
+}
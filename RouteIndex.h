@@ -0,0 +1,95 @@
+#ifndef ROUTEINDEX_H
+#define ROUTEINDEX_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "CompactPolyline.h"
+
+// Immutable spatial index over the active route polyline.
+//
+// Built once per route by Route (on RouteLoader's parse thread) and shared
+// (read-only, any thread) with every manager that needs point-to-route
+// questions answered.
+// The vertices are held in a CompactPolyline — the route's only copy of its
+// geometry — with a cumulative distance per vertex; segments are bucketed
+// in a uniform grid keyed by a sorted (cell, segment) array, so a lookup is
+// a binary search plus an exact distance check against the handful of
+// segments in nearby cells. Coordinates are microdegrees, which is what
+// polyline6 carries anyway.
+class RouteIndex
+{
+public:
+    struct Match {
+        bool valid = false;
+        double distanceKm = std::numeric_limits<double>::infinity();  // Point to route
+        double alongKm = 0.0;     // Distance from route start to the closest point
+        int segment = -1;         // Index of the segment's first vertex
+        double t = 0.0;           // Position within the segment, 0..1
+        double lat = 0.0;         // Closest point on the route
+        double lon = 0.0;
+    };
+
+    // Builds from lat/lon arrays of equal length, which are only needed for
+    // the build. Exact repeats are collapsed. Returns nullptr for fewer than
+    // two distinct points.
+    static std::shared_ptr<const RouteIndex> build(QVector<double> lats, QVector<double> lons);
+
+    int size() const { return m_points.size(); }
+    double lat(int i) const { return m_points.at(i).first; }
+    double lon(int i) const { return m_points.at(i).second; }
+    CompactPolyline::Segment segment(int s) const { return m_points.segment(s); }
+    double cumulativeKm(int i) const { return m_cumKm[i]; }
+    double totalKm() const { return m_cumKm.isEmpty() ? 0.0 : m_cumKm.last(); }
+
+    // Every vertex; decode() it for whole-route work
+    const CompactPolyline &points() const { return m_points; }
+
+    // Closest point on the route. With a finite maxKm only that radius is
+    // searched and an invalid Match means nothing is that close.
+    Match nearest(double lat, double lon,
+                  double maxKm = std::numeric_limits<double>::infinity()) const;
+
+    bool isWithin(double lat, double lon, double km) const { return nearest(lat, lon, km).valid; }
+
+    // Point at a distance along the route, clamped to its ends
+    std::pair<double, double> pointAt(double alongKm) const;
+
+    // Index of the segment containing alongKm (binary search on cumulative distance)
+    int segmentAt(double alongKm) const;
+
+private:
+    RouteIndex() = default;
+
+    static constexpr double kCellKm = 1.0;
+
+    int64_t cellKey(int cx, int cy) const;
+    double projX(double lon) const { return (lon - m_lon0) * m_kmPerDegLon; }
+    double projY(double lat) const { return (lat - m_lat0) * m_kmPerDegLat; }
+    void checkSegment(int seg, const CompactPolyline::Segment &s, double lat, double lon,
+                      Match &best) const;
+
+    CompactPolyline m_points;
+    QVector<double> m_cumKm;
+
+    // Grid projection. m_kmPerDegLon uses the route's highest |latitude| so
+    // projected distances never exceed true ones and radius searches
+    // can't miss a segment.
+    double m_lat0 = 0.0;
+    double m_lon0 = 0.0;
+    double m_kmPerDegLat = 110.574;
+    double m_kmPerDegLon = 111.320;
+
+    struct CellEntry {
+        int64_t key;
+        int segment;
+        bool operator<(const CellEntry &o) const { return key < o.key || (key == o.key && segment < o.segment); }
+    };
+    QVector<CellEntry> m_cells;   // Sorted by key
+};
+
+#endif // ROUTEINDEX_H
@@ -0,0 +1,215 @@
+#include "RouteLoader.h"
+#include "ContextAggregator.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QThread>
+#include <QUrl>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+struct ParsedDirections {
+    std::shared_ptr<const Route> route;
+    QVariantMap qmlRoute;
+    QString error;
+};
+
+// Runs on the worker thread
+ParsedDirections parseDirections(const QByteArray &body)
+{
+    ParsedDirections parsed;
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(body, &parseError);
+    if (doc.isNull()) {
+        parsed.error = "Invalid directions response: " + parseError.errorString();
+        return parsed;
+    }
+
+    const QJsonArray routes = doc.object()["routes"].toArray();
+    if (routes.isEmpty()) {
+        parsed.error = "No routes found";
+        return parsed;
+    }
+
+    const QJsonObject json = routes[0].toObject();
+    parsed.route = Route::fromDirections(json, &parsed.error);
+    if (!parsed.route) return parsed;
+
+    QVariantList steps;
+    steps.reserve(parsed.route->steps().size());
+    for (const RouteStep &s : parsed.route->steps()) {
+        steps.append(QVariantMap {
+            { "instruction", s.instruction },
+            { "type", s.type },
+            { "modifier", s.modifier },
+            { "distance", s.distanceM },
+            { "duration", s.durationSec },
+            { "name", s.name },
+            { "lat", s.lat },
+            { "lon", s.lon },
+        });
+    }
+
+    // The map layer takes GeoJSON text as well as a variant tree, so write
+    // the line straight from the Route's geometry into one byte array
+    // rather than handing QML a nested list per point
+    QVector<double> lats, lons;
+    parsed.route->geometry().decode(lats, lons);
+    QByteArray geoJson;
+    geoJson.reserve(64 + lats.size() * 24);
+    geoJson += R"({"type":"Feature","properties":{},"geometry":{"type":"LineString","coordinates":[)";
+    for (int i = 0; i < lats.size(); ++i) {
+        if (i > 0) geoJson += ',';
+        geoJson += '[' + QByteArray::number(lons[i], 'f', 6) + ',' + QByteArray::number(lats[i], 'f', 6) + ']';
+    }
+    geoJson += "]}}";
+
+    // Initial heading for nav mode before there is a GPS fix
+    const double startBearing = qRadiansToDegrees(qAtan2(lons[1] - lons[0], lats[1] - lats[0]));
+
+    parsed.qmlRoute = {
+        { "distance", json["distance"].toDouble() },
+        { "duration", json["duration"].toDouble() },
+        { "geoJson", geoJson },
+        { "startBearing", std::fmod(startBearing + 360.0, 360.0) },
+        { "steps", steps },
+    };
+    return parsed;
+}
+
+} // namespace
+
+RouteLoader::RouteLoader(QObject *parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+{
+    connect(m_network, &QNetworkAccessManager::finished,
+            this, &RouteLoader::onDirectionsReply);
+    qDebug() << "RouteLoader: Initialized";
+}
+
+RouteLoader::~RouteLoader()
+{
+    // A parse still running would post its result to a dead object
+    for (QThread *worker : m_workers)
+        worker->wait();
+}
+
+void RouteLoader::setMapboxToken(const QString &token) { m_mapboxToken = token; }
+void RouteLoader::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+
+void RouteLoader::requestRoute(const QVariantList &points, bool silent)
+{
+    ++m_generation;
+
+    if (points.size() < 2) {
+        // The bump above already dropped any request in flight
+        qWarning() << "RouteLoader: Need an origin and a destination, got" << points.size() << "point(s)";
+        setLoading(false);
+        emit routeFailed("Route needs an origin and a destination");
+        return;
+    }
+
+    QStringList coords;
+    for (const QVariant &v : points) {
+        const QVariantMap pt = v.toMap();
+        coords.append(QString("%1,%2").arg(pt["lon"].toDouble(), 0, 'f', 6)
+                                      .arg(pt["lat"].toDouble(), 0, 'f', 6));
+    }
+
+    QUrl url("https://api.mapbox.com/directions/v5/mapbox/driving/" + coords.join(';')
+             + "?geometries=polyline6&overview=full&steps=true&banner_instructions=true"
+               "&annotations=maxspeed&access_token=" + m_mapboxToken);
+    QNetworkRequest req(url);
+    req.setAttribute(QNetworkRequest::User, silent);
+    req.setAttribute(QNetworkRequest::UserMax, m_generation);
+    m_network->get(req);
+
+    setLoading(true);
+    qDebug() << "RouteLoader: Requesting route through" << points.size() << "points" << (silent ? "(silent)" : "");
+}
+
+void RouteLoader::clear()
+{
+    ++m_generation;
+    setLoading(false);
+    if (!m_route) return;
+
+    m_route.reset();
+    if (m_context) m_context->setRoute(nullptr);
+    emit routeChanged(nullptr, false);
+    qDebug() << "RouteLoader: Route cleared";
+}
+
+void RouteLoader::onDirectionsReply(QNetworkReply *reply)
+{
+    reply->deleteLater();
+
+    // Discard stale replies from an abandoned request
+    const int generation = reply->request().attribute(QNetworkRequest::UserMax).toInt();
+    if (generation != m_generation) return;
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() != QNetworkReply::NoError || statusCode != 200) {
+        qWarning() << "RouteLoader: Directions request failed — HTTP" << statusCode << reply->errorString();
+        setLoading(false);
+        emit routeFailed(reply->errorString());
+        return;
+    }
+
+    const bool silent = reply->request().attribute(QNetworkRequest::User).toBool();
+    const QByteArray body = reply->readAll();
+
+    QThread *worker = QThread::create([this, body, generation, silent]() {
+        QElapsedTimer timer;
+        timer.start();
+        const ParsedDirections parsed = parseDirections(body);
+        qDebug() << "RouteLoader: Parsed" << body.size() << "bytes in" << timer.elapsed() << "ms";
+
+        QMetaObject::invokeMethod(this, [this, generation, silent, parsed]() {
+            finishLoad(generation, silent, parsed.route, parsed.qmlRoute, parsed.error);
+        }, Qt::QueuedConnection);
+    });
+    m_workers.append(worker);
+    connect(worker, &QThread::finished, this, [this, worker]() {
+        m_workers.removeOne(worker);
+        worker->deleteLater();
+    });
+    worker->start(QThread::LowPriority);
+}
+
+void RouteLoader::finishLoad(int generation, bool silent, const std::shared_ptr<const Route> &route,
+                             const QVariantMap &qmlRoute, const QString &error)
+{
+    if (generation != m_generation) return;
+    setLoading(false);
+
+    if (!route) {
+        qWarning() << "RouteLoader:" << error;
+        emit routeFailed(error);
+        return;
+    }
+
+    m_route = route;
+    qDebug() << "RouteLoader: Route ready," << route->size() << "points," << route->totalKm() << "km,"
+             << route->steps().size() << "steps," << route->legCount() << "leg(s)";
+
+    // ContextAggregator first — it owns the route index the progress
+    // tracker and the managers filter against
+    if (m_context) m_context->setRoute(route);
+    emit routeChanged(route, silent);
+    emit routeLoaded(qmlRoute, silent);
+}
+
+void RouteLoader::setLoading(bool loading)
+{
+    if (m_loading == loading) return;
+    m_loading = loading;
+    emit loadingChanged();
+}
@@ -0,0 +1,83 @@
+#ifndef ROUTELOADER_H
+#define ROUTELOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <memory>
+
+#include "Route.h"
+
+class QThread;
+class ContextAggregator;
+
+// Fetches Mapbox driving directions and turns the response into one shared,
+// immutable Route.
+//
+// The reply body is parsed on a short-lived worker thread; the GUI thread
+// only sees the finished Route and a QML-ready summary (route line GeoJSON
+// and steps, also built on the worker). ContextAggregator gets the route
+// first, then routeChanged() fans it out to the route-aware managers, then
+// routeLoaded() hands Maps.qml what it draws.
+//
+// Each requestRoute() or clear() bumps a generation so a slow reply or
+// parse for an abandoned route is dropped.
+class RouteLoader : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+
+public:
+    explicit RouteLoader(QObject *parent = nullptr);
+    ~RouteLoader() override;
+
+    void setMapboxToken(const QString &token);
+    void setContextAggregator(ContextAggregator *ctx);
+
+    bool loading() const { return m_loading; }
+    std::shared_ptr<const Route> route() const { return m_route; }
+
+    // points: [{lat, lon}, ...], origin first, destination last.
+    // silent is passed through to the managers (suppresses repeat alerts
+    // when a route is only being recalculated).
+    Q_INVOKABLE void requestRoute(const QVariantList &points, bool silent = false);
+
+    // Drops any request in flight and the current route
+    Q_INVOKABLE void clear();
+
+signals:
+    void loadingChanged();
+
+    // For Maps.qml: distance (m), duration (s), geoJson (route line
+    // Feature as GeoJSON text, for the map source), startBearing (degrees,
+    // first segment) and steps (instruction, type, modifier, distance,
+    // duration, name, lat, lon)
+    void routeLoaded(const QVariantMap &route, bool silent);
+    void routeFailed(const QString &error);
+
+    // For C++ consumers. route is null when cleared.
+    void routeChanged(const std::shared_ptr<const Route> &route, bool silent);
+
+private slots:
+    void onDirectionsReply(QNetworkReply *reply);
+
+private:
+    void finishLoad(int generation, bool silent, const std::shared_ptr<const Route> &route,
+                    const QVariantMap &qmlRoute, const QString &error);
+    void setLoading(bool loading);
+
+    QNetworkAccessManager *m_network;
+    ContextAggregator *m_context = nullptr;
+    QString m_mapboxToken;
+
+    std::shared_ptr<const Route> m_route;
+    QList<QThread *> m_workers;
+    int m_generation = 0;
+    bool m_loading = false;
+};
+
+#endif // ROUTELOADER_H
@@ -0,0 +1,183 @@
+#include "RouteProgressTracker.h"
+#include "ContextAggregator.h"
+#include "GeoUtils.h"
+#include <QDebug>
+#include <QtMath>
+
+namespace {
+
+constexpr double kKmPerDegLat = 110.574;
+constexpr double kKmPerDegLonEquator = 111.320;
+
+} // namespace
+
+RouteProgressTracker::RouteProgressTracker(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void RouteProgressTracker::setContextAggregator(ContextAggregator *ctx)
+{
+    if (m_context == ctx) return;
+    if (m_context) {
+        disconnect(m_context, &ContextAggregator::routeGeometryChanged,
+                   this, &RouteProgressTracker::onRouteGeometryChanged);
+    }
+    m_context = ctx;
+    if (m_context) {
+        connect(m_context, &ContextAggregator::routeGeometryChanged,
+                this, &RouteProgressTracker::onRouteGeometryChanged);
+    }
+    onRouteGeometryChanged();
+}
+
+double RouteProgressTracker::fraction() const
+{
+    const double total = m_route ? m_route->totalKm() : 0.0;
+    return total > 0.0 ? qBound(0.0, m_progress.travelledKm / total, 1.0) : 0.0;
+}
+
+double RouteProgressTracker::speedKmh() const
+{
+    if (!m_sinceSpeed.isValid() || m_sinceSpeed.elapsed() > kSpeedStaleMs) return -1.0;
+    return m_speedKmh;
+}
+
+void RouteProgressTracker::onRouteGeometryChanged()
+{
+    m_route = m_context ? m_context->routeIndex() : nullptr;
+
+    const bool wasOffRoute = m_progress.offRoute;
+    m_progress = RouteProgress();
+    if (m_route) m_progress.remainingKm = m_route->totalKm();
+    m_farFixes = 0;
+    m_sinceFix.invalidate();
+
+    emit progressChanged();
+    if (wasOffRoute) emit offRouteChanged();
+
+    if (m_route)
+        qDebug() << "RouteProgressTracker: Tracking" << m_route->size() << "points," << m_route->totalKm() << "km";
+}
+
+// ============================================================================
+// Matching
+// ============================================================================
+
+RouteProgressTracker::Candidate RouteProgressTracker::scoreSegment(int seg, double lat, double lon,
+                                                                   double headingDeg) const
+{
+    // Same batch-kernel projection as RouteIndex::nearest, so the two agree
+    // on which point of a segment is closest
+    const CompactPolyline::Segment s = m_route->segment(seg);
+    const double lats[2] = { s.lat0, s.lat1 };
+    const double lons[2] = { s.lon0, s.lon1 };
+
+    Candidate c;
+    c.segment = seg;
+    GeoUtils::segmentDistancesKm(lat, lon, lats, lons, 2, &c.distanceKm, &c.t);
+    c.lat = s.lat0 + c.t * (s.lat1 - s.lat0);
+    c.lon = s.lon0 + c.t * (s.lon1 - s.lon0);
+    c.alongKm = m_route->cumulativeKm(seg) + c.t * (m_route->cumulativeKm(seg + 1) - m_route->cumulativeKm(seg));
+
+    // 0 when driving along the segment, kHeadingWeightKm when driving against it
+    c.score = c.distanceKm;
+    const double dx = (s.lon1 - s.lon0) * kKmPerDegLonEquator * qCos(qDegreesToRadians(lat));
+    const double dy = (s.lat1 - s.lat0) * kKmPerDegLat;
+    if (headingDeg >= 0.0 && (dx != 0.0 || dy != 0.0)) {
+        const double bearing = qRadiansToDegrees(qAtan2(dx, dy));
+        c.score += kHeadingWeightKm * 0.5 * (1.0 - qCos(qDegreesToRadians(headingDeg - bearing)));
+    }
+    return c;
+}
+
+bool RouteProgressTracker::searchWindow(double lat, double lon, double headingDeg, double aheadKm,
+                                        Candidate &best) const
+{
+    if (m_progress.segment < 0) return false;
+
+    // Step back from the last match rather than binary-searching — the
+    // window start moves by a segment or two per fix
+    const double fromKm = m_progress.travelledKm - kWindowBackKm;
+    const double toKm = m_progress.travelledKm + aheadKm;
+    int seg = qMin(m_progress.segment, m_route->size() - 2);
+    while (seg > 0 && m_route->cumulativeKm(seg) > fromKm)
+        --seg;
+
+    bool found = false;
+    for (; seg < m_route->size() - 1 && m_route->cumulativeKm(seg) <= toKm; ++seg) {
+        const Candidate c = scoreSegment(seg, lat, lon, headingDeg);
+        if (!found || c.score < best.score) {
+            best = c;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool RouteProgressTracker::reacquire(double lat, double lon, double headingDeg, Candidate &best) const
+{
+    const RouteIndex::Match match = m_route->nearest(lat, lon, kAcquireKm);
+    if (!match.valid) return false;
+    best = scoreSegment(match.segment, lat, lon, headingDeg);
+    return true;
+}
+
+void RouteProgressTracker::updatePosition(double lat, double lon, double speedKmh, double headingDeg)
+{
+    m_speedKmh = qMax(speedKmh, 0.0);
+    m_sinceSpeed.start();
+
+    if (!m_route) return;
+
+    // GPS heading is noise at walking pace
+    const double heading = usableHeading(headingDeg, speedKmh);
+
+    // As far as the car could have got since the last fix, doubled for slack
+    const double dtSec = m_sinceFix.isValid() ? qMin(m_sinceFix.elapsed() / 1000.0, 60.0) : 0.0;
+    m_sinceFix.start();
+    const double aheadKm = qMax(kMinWindowAheadKm, 2.0 * qMax(speedKmh, 0.0) * dtSec / 3600.0);
+
+    Candidate best;
+    bool found = m_progress.valid && searchWindow(lat, lon, heading, aheadKm, best);
+    if (!found || best.distanceKm > kOffRouteKm) {
+        Candidate nearest;
+        if (reacquire(lat, lon, heading, nearest) && (!found || nearest.score < best.score)) {
+            best = nearest;
+            found = true;
+        }
+    }
+
+    // Never matched and not near the route yet
+    if (!found) return;
+
+    m_progress.distanceFromRouteKm = best.distanceKm;
+    if (best.distanceKm > kOffRouteKm) {
+        if (++m_farFixes >= kOffRouteFixes) setOffRoute(true);
+    } else {
+        m_farFixes = 0;
+        if (best.distanceKm <= kOnRouteKm) setOffRoute(false);
+    }
+
+    // Progress only moves on fixes that are clearly on the route
+    if (!m_progress.offRoute && best.distanceKm <= kOffRouteKm) {
+        m_progress.valid = true;
+        m_progress.segment = best.segment;
+        m_progress.t = best.t;
+        m_progress.travelledKm = best.alongKm;
+        m_progress.remainingKm = qMax(0.0, m_route->totalKm() - best.alongKm);
+        m_progress.lat = best.lat;
+        m_progress.lon = best.lon;
+    }
+
+    emit progressChanged();
+}
+
+void RouteProgressTracker::setOffRoute(bool off)
+{
+    if (m_progress.offRoute == off) return;
+    m_progress.offRoute = off;
+    qDebug() << "RouteProgressTracker:" << (off ? "Off route" : "Back on route") << "at"
+             << m_progress.travelledKm << "km," << m_progress.distanceFromRouteKm * 1000.0 << "m from route";
+    emit offRouteChanged();
+}
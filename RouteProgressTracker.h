@@ -0,0 +1,127 @@
+#ifndef ROUTEPROGRESSTRACKER_H
+#define ROUTEPROGRESSTRACKER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <memory>
+
+#include "RouteIndex.h"
+
+class ContextAggregator;
+
+// Where the car is on the active route.
+struct RouteProgress {
+    bool valid = false;             // Matched to the current route at least once
+    bool offRoute = false;
+    int segment = -1;               // RouteIndex segment of the snapped point
+    double t = 0.0;                 // Position within the segment, 0..1
+    double travelledKm = 0.0;       // Route start to the snapped point
+    double remainingKm = 0.0;       // Snapped point to the destination
+    double distanceFromRouteKm = 0.0;
+    double lat = 0.0;               // Snapped point
+    double lon = 0.0;
+};
+
+// Map-matches GPS fixes onto the active route (ContextAggregator's
+// RouteIndex) and publishes the result for every manager that needs to
+// know how far along it the car is.
+//
+// Each fix only scores the segments in a window around the last match, a
+// short distance back and as far ahead as the car could have driven since
+// the previous fix, so the per-fix cost doesn't grow with route length.
+// Candidates are scored on distance plus a penalty for disagreeing with the
+// GPS heading, which keeps the match on the right carriageway where a road
+// doubles back on itself. When nothing in the window is close, the route
+// index is queried once to re-acquire (tunnels, skipped GPS fixes).
+//
+// Off-route is declared after kOffRouteFixes consecutive fixes further than
+// kOffRouteKm from the route and cleared on the first fix back within
+// kOnRouteKm; travelled distance is held while off route.
+class RouteProgressTracker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool valid READ valid NOTIFY progressChanged)
+    Q_PROPERTY(bool offRoute READ offRoute NOTIFY offRouteChanged)
+    Q_PROPERTY(double travelledKm READ travelledKm NOTIFY progressChanged)
+    Q_PROPERTY(double remainingKm READ remainingKm NOTIFY progressChanged)
+    Q_PROPERTY(double fraction READ fraction NOTIFY progressChanged)
+    Q_PROPERTY(double distanceFromRouteKm READ distanceFromRouteKm NOTIFY progressChanged)
+
+public:
+    explicit RouteProgressTracker(QObject *parent = nullptr);
+
+    void setContextAggregator(ContextAggregator *ctx);
+
+    const RouteProgress &progress() const { return m_progress; }
+
+    // The route the progress refers to — compare with Route::index()
+    std::shared_ptr<const RouteIndex> routeIndex() const { return m_route; }
+
+    // headingDeg, or -1 when the car is too slow for the GPS course to mean
+    // anything
+    static double usableHeading(double headingDeg, double speedKmh)
+    {
+        return (headingDeg >= 0.0 && speedKmh >= kMinHeadingSpeedKmh) ? headingDeg : -1.0;
+    }
+
+    // Valid and on route — the travelled/remaining figures describe the car
+    bool tracking() const { return m_progress.valid && !m_progress.offRoute; }
+
+    bool valid() const { return m_progress.valid; }
+    bool offRoute() const { return m_progress.offRoute; }
+    double travelledKm() const { return m_progress.travelledKm; }
+    double remainingKm() const { return m_progress.remainingKm; }
+    double fraction() const;
+    double distanceFromRouteKm() const { return m_progress.distanceFromRouteKm; }
+
+    // GPS speed of the latest fix, route or not; -1 when there hasn't been
+    // one for kSpeedStaleMs
+    double speedKmh() const;
+
+public slots:
+    // Called from Maps.qml onPositionChanged. headingDeg < 0 when unknown.
+    void updatePosition(double lat, double lon, double speedKmh, double headingDeg);
+
+signals:
+    void progressChanged();
+    void offRouteChanged();
+
+private slots:
+    void onRouteGeometryChanged();
+
+private:
+    struct Candidate {
+        int segment = -1;
+        double t = 0.0;
+        double distanceKm = 0.0;
+        double alongKm = 0.0;
+        double lat = 0.0;
+        double lon = 0.0;
+        double score = 0.0;
+    };
+
+    Candidate scoreSegment(int seg, double lat, double lon, double headingDeg) const;
+    bool searchWindow(double lat, double lon, double headingDeg, double aheadKm, Candidate &best) const;
+    bool reacquire(double lat, double lon, double headingDeg, Candidate &best) const;
+    void setOffRoute(bool off);
+
+    ContextAggregator *m_context = nullptr;
+    std::shared_ptr<const RouteIndex> m_route;
+    RouteProgress m_progress;
+    int m_farFixes = 0;
+    QElapsedTimer m_sinceFix;
+    double m_speedKmh = 0.0;
+    QElapsedTimer m_sinceSpeed;
+
+    static constexpr double kOffRouteKm = 0.06;
+    static constexpr double kOnRouteKm = 0.03;
+    static constexpr int kOffRouteFixes = 2;
+    static constexpr double kAcquireKm = 0.2;        // First match / re-acquire radius
+    static constexpr double kWindowBackKm = 0.05;    // GPS jitter behind the last match
+    static constexpr double kMinWindowAheadKm = 0.3;
+    static constexpr double kHeadingWeightKm = 0.05; // Score cost of driving against a segment
+    static constexpr double kMinHeadingSpeedKmh = 10.0;
+    static constexpr qint64 kSpeedStaleMs = 30 * 1000;
+};
+
+#endif // ROUTEPROGRESSTRACKER_H
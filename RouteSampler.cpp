@@ -0,0 +1,185 @@
+#include "RouteSampler.h"
+#include "Route.h"
+#include <QMutexLocker>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// Anchors closer than this are the same place
+constexpr double kSameKm = 1e-6;
+
+} // namespace
+
+RouteSampler::RouteSampler(std::shared_ptr<const RouteIndex> index, const QVector<RouteStep> &steps,
+                           double averageSpeedKmh)
+    : m_index(std::move(index))
+{
+    const double totalKm = m_index->totalKm();
+
+    // Step distances are Mapbox's; scale them onto the polyline
+    double stepsKm = 0.0;
+    for (const RouteStep &s : steps) stepsKm += s.distanceM / 1000.0;
+    const double scale = stepsKm > 0.0 ? totalKm / stepsKm : 0.0;
+
+    m_profileKm.append(0.0);
+    m_profileSec.append(0.0);
+    double km = 0.0;
+    double sec = 0.0;
+    for (const RouteStep &s : steps) {
+        // The maneuver is at the start of its step
+        if (s.type == QLatin1String("arrive")) m_waypointKms.append(qMin(km, totalKm));
+
+        km += s.distanceM / 1000.0 * scale;
+        sec += s.durationSec;
+        if (km > m_profileKm.last() + kSameKm) {
+            m_profileKm.append(km);
+            m_profileSec.append(sec);
+        } else {
+            m_profileSec.last() = sec;
+        }
+    }
+
+    if (m_profileKm.size() < 2 || sec <= 0.0) {
+        const double kmh = averageSpeedKmh > 0.0 ? averageSpeedKmh : 80.0;
+        m_profileKm = { 0.0, totalKm };
+        m_profileSec = { 0.0, totalKm / kmh * 3600.0 };
+    }
+    m_profileKm.last() = totalKm;
+
+    if (m_waypointKms.isEmpty() || m_waypointKms.last() < totalKm - kSameKm)
+        m_waypointKms.append(totalKm);
+    else
+        m_waypointKms.last() = totalKm;
+}
+
+double RouteSampler::etaSecAt(double alongKm) const
+{
+    alongKm = qBound(0.0, alongKm, totalKm());
+    auto it = std::upper_bound(m_profileKm.cbegin(), m_profileKm.cend(), alongKm);
+    const int i = qBound(0, int(it - m_profileKm.cbegin()) - 1, m_profileKm.size() - 2);
+
+    const double t = (alongKm - m_profileKm[i]) / (m_profileKm[i + 1] - m_profileKm[i]);
+    return m_profileSec[i] + t * (m_profileSec[i + 1] - m_profileSec[i]);
+}
+
+double RouteSampler::kmAtEtaSec(double etaSec) const
+{
+    etaSec = qBound(0.0, etaSec, totalSec());
+    auto it = std::lower_bound(m_profileSec.cbegin(), m_profileSec.cend(), etaSec);
+    const int i = qBound(1, int(it - m_profileSec.cbegin()), m_profileSec.size() - 1);
+
+    const double span = m_profileSec[i] - m_profileSec[i - 1];
+    if (span <= 0.0) return m_profileKm[i - 1];
+    const double t = (etaSec - m_profileSec[i - 1]) / span;
+    return m_profileKm[i - 1] + t * (m_profileKm[i] - m_profileKm[i - 1]);
+}
+
+RouteSampler::Sample RouteSampler::sampleAt(double alongKm) const
+{
+    Sample s;
+    s.alongKm = qBound(0.0, alongKm, totalKm());
+    s.etaSec = etaSecAt(s.alongKm);
+    const auto [lat, lon] = m_index->pointAt(s.alongKm);
+    s.lat = lat;
+    s.lon = lon;
+    return s;
+}
+
+QVector<RouteSampler::Sample> RouteSampler::cached(const QString &key,
+                                                   const std::function<QVector<Sample>()> &build) const
+{
+    QMutexLocker lock(&m_cacheMutex);
+    auto it = m_cache.constFind(key);
+    if (it != m_cache.constEnd()) return *it;
+    return *m_cache.insert(key, build());
+}
+
+QVector<RouteSampler::Sample> RouteSampler::evenly(int count, bool includeEnds) const
+{
+    count = qBound(0, count, kMaxSamples);
+    if (count == 0) return {};
+    if (includeEnds && count == 1) count = 2;
+
+    return cached(QStringLiteral("n:%1:%2").arg(count).arg(includeEnds), [&] {
+        QVector<Sample> samples;
+        samples.reserve(count);
+        const int pieces = includeEnds ? count - 1 : count + 1;
+        const int first = includeEnds ? 0 : 1;
+        for (int i = 0; i < count; ++i)
+            samples.append(sampleAt(totalKm() * (first + i) / pieces));
+        return samples;
+    });
+}
+
+QVector<RouteSampler::Sample> RouteSampler::byDistance(double intervalKm) const
+{
+    intervalKm = qMax(intervalKm, totalKm() / kMaxSamples);
+    if (intervalKm <= 0.0) return { sampleAt(0.0) };
+
+    return cached(QStringLiteral("d:%1").arg(intervalKm, 0, 'g', 12), [&] {
+        QVector<Sample> samples;
+        const int steps = qFloor(totalKm() / intervalKm);
+        for (int i = 0; i <= steps; ++i)
+            samples.append(sampleAt(i * intervalKm));
+        if (samples.last().alongKm < totalKm() - kSameKm)
+            samples.append(sampleAt(totalKm()));
+        return samples;
+    });
+}
+
+QVector<RouteSampler::Sample> RouteSampler::byTime(double intervalSec) const
+{
+    intervalSec = qMax(intervalSec, totalSec() / kMaxSamples);
+    if (intervalSec <= 0.0) return { sampleAt(0.0) };
+
+    return cached(QStringLiteral("t:%1").arg(intervalSec, 0, 'g', 12), [&] {
+        QVector<Sample> samples;
+        const int steps = qFloor(totalSec() / intervalSec);
+        for (int i = 0; i <= steps; ++i)
+            samples.append(sampleAt(kmAtEtaSec(i * intervalSec)));
+        if (samples.last().alongKm < totalKm() - kSameKm)
+            samples.append(sampleAt(totalKm()));
+        return samples;
+    });
+}
+
+QVector<RouteSampler::Sample> RouteSampler::anchored(QVector<double> anchorKms, double maxGapKm) const
+{
+    // Stations in route order: the ends, then the anchors, which take an
+    // end's place when they sit on it
+    struct Station { double km; int anchor; };
+    QVector<Station> stations;
+    stations.reserve(anchorKms.size() + 2);
+    stations.append({ 0.0, -1 });
+    for (int i = 0; i < anchorKms.size(); ++i)
+        stations.append({ qBound(0.0, anchorKms[i], totalKm()), i });
+    stations.append({ totalKm(), -1 });
+    std::stable_sort(stations.begin(), stations.end(),
+                     [](const Station &a, const Station &b) { return a.km < b.km; });
+
+    QVector<Station> unique;
+    for (const Station &s : stations) {
+        if (!unique.isEmpty() && s.km - unique.last().km < kSameKm) {
+            if (unique.last().anchor < 0) unique.last().anchor = s.anchor;
+            continue;
+        }
+        unique.append(s);
+    }
+
+    if (maxGapKm > 0.0) maxGapKm = qMax(maxGapKm, totalKm() / kMaxSamples);
+    QVector<Sample> samples;
+    for (int i = 0; i < unique.size(); ++i) {
+        if (i > 0 && maxGapKm > 0.0) {
+            const double from = unique[i - 1].km;
+            const double gap = unique[i].km - from;
+            const int fill = qCeil(gap / maxGapKm) - 1;
+            for (int f = 1; f <= fill; ++f)
+                samples.append(sampleAt(from + gap * f / (fill + 1)));
+        }
+        Sample s = sampleAt(unique[i].km);
+        s.anchor = unique[i].anchor;
+        samples.append(s);
+    }
+    return samples;
+}
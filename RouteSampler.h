@@ -0,0 +1,84 @@
+#ifndef ROUTESAMPLER_H
+#define ROUTESAMPLER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+#include "RouteIndex.h"
+
+struct RouteStep;
+
+// Sample points along a route by distance, by driving time, or anchored on
+// known features, all measured along the RouteIndex polyline.
+//
+// Owned by Route and built with it. The time profile is piecewise linear
+// between step maneuvers (Mapbox's per-step duration spread over the
+// step's distance), so an hour of city driving gets as many time samples
+// as an hour on the highway. Whole-route sample sets are cached on first
+// use; the sampler is read-only otherwise and safe to share across threads.
+class RouteSampler
+{
+public:
+    struct Sample {
+        double alongKm = 0.0;   // From the route start
+        double etaSec = 0.0;    // Driving time from the route start
+        double lat = 0.0;
+        double lon = 0.0;
+        int anchor = -1;        // Index into anchored()'s anchorKms, -1 for fill
+    };
+
+    // steps may be empty; averageSpeedKmh times the route then
+    RouteSampler(std::shared_ptr<const RouteIndex> index, const QVector<RouteStep> &steps,
+                 double averageSpeedKmh);
+
+    double totalKm() const { return m_index->totalKm(); }
+    double totalSec() const { return m_profileSec.last(); }
+
+    // Driving time from the start to alongKm, and the reverse
+    double etaSecAt(double alongKm) const;
+    double kmAtEtaSec(double etaSec) const;
+
+    Sample sampleAt(double alongKm) const;
+
+    // count points spaced equally by distance; with includeEnds the first
+    // and last are the route's start and end, otherwise the route is cut
+    // into count + 1 equal pieces
+    QVector<Sample> evenly(int count, bool includeEnds = false) const;
+
+    // Every intervalKm from the start, plus the end
+    QVector<Sample> byDistance(double intervalKm) const;
+
+    // Every intervalSec of driving from the start, plus the end
+    QVector<Sample> byTime(double intervalSec) const;
+
+    // A sample at each anchor (clamped to the route, in route order) and at
+    // both ends of the route, with equally spaced fill wherever two
+    // neighbours are more than maxGapKm apart (none for maxGapKm <= 0).
+    // Not cached.
+    QVector<Sample> anchored(QVector<double> anchorKms, double maxGapKm) const;
+
+    // Along-route positions of the trip's stops: each leg's arrival,
+    // the destination last
+    const QVector<double> &waypointKms() const { return m_waypointKms; }
+
+private:
+    static constexpr int kMaxSamples = 2000;
+
+    QVector<Sample> cached(const QString &key, const std::function<QVector<Sample>()> &build) const;
+
+    std::shared_ptr<const RouteIndex> m_index;
+
+    // Time profile: strictly increasing km, non-decreasing seconds
+    QVector<double> m_profileKm;
+    QVector<double> m_profileSec;
+    QVector<double> m_waypointKms;
+
+    mutable QMutex m_cacheMutex;
+    mutable QHash<QString, QVector<Sample>> m_cache;
+};
+
+#endif // ROUTESAMPLER_H
@@ -1,47 +1,53 @@
 #include "RouteWeatherManager.h"
 #include "ContextAggregator.h"
-#include "GeoUtils.h"
+#include "RefreshScheduler.h"
+#include "Route.h"
+#include "RouteProgressTracker.h"
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrlQuery>
 #include <QtMath>
 #include <QDateTime>
+#include <QTimer>
 
 RouteWeatherManager::RouteWeatherManager(QObject *parent)
     : QObject(parent)
     , m_network(new QNetworkAccessManager(this))
-    , m_refreshTimer(new QTimer(this))
 {
     connect(m_network, &QNetworkAccessManager::finished,
             this, &RouteWeatherManager::onWeatherReply);
 
-    m_refreshTimer->setInterval(REFRESH_INTERVAL_MS);
-    connect(m_refreshTimer, &QTimer::timeout, this, &RouteWeatherManager::refreshForecasts);
-
-    qDebug() << "RouteWeatherManager: Initialized (30min refresh, 2hr lookahead, 15km sampling)";
+    qDebug() << "RouteWeatherManager: Initialized (30min refresh, 2hr lookahead, 15min sampling)";
 }
 
 void RouteWeatherManager::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+void RouteWeatherManager::setRouteProgressTracker(RouteProgressTracker *tracker) { m_tracker = tracker; }
 
-void RouteWeatherManager::setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent)
+void RouteWeatherManager::setRefreshScheduler(RefreshScheduler *scheduler)
 {
-    if (coordinates.size() < 2) {
+    m_scheduler = scheduler;
+    m_refreshTask = scheduler->add("routeWeather", REFRESH_INTERVAL_MS, this, [this]() { refreshForecasts(); });
+}
+
+void RouteWeatherManager::setRoute(const std::shared_ptr<const Route> &route, bool silent)
+{
+    if (!route) {
         clearRoute();
         return;
     }
 
     m_suppressNextAlert = silent;
     ++m_generation;
-    m_routeCoordinates = coordinates;
-    m_totalDurationSec = durationSec;
-    sampleRoutePoints(coordinates, durationSec);
+    m_route = route;
+    sampleRoutePoints();
 
     m_active = true;
     emit activeChanged();
 
     fetchWeather();
-    m_refreshTimer->start();
+    if (m_scheduler) m_scheduler->start(m_refreshTask);
 
     qDebug() << "RouteWeatherManager: Tracking" << m_points.size()
              << "points along route (2hr lookahead)";
@@ -51,10 +57,10 @@ void RouteWeatherManager::clearRoute()
 {
     ++m_generation;
     m_active = false;
-    m_routeCoordinates = QJsonArray();
+    m_route.reset();
     m_points.clear();
     m_summary.clear();
-    m_refreshTimer->stop();
+    if (m_scheduler) m_scheduler->stop(m_refreshTask);
     emit activeChanged();
     emit summaryChanged();
 
@@ -68,83 +74,59 @@ void RouteWeatherManager::clearRoute()
     qDebug() << "RouteWeatherManager: Route cleared";
 }
 
-void RouteWeatherManager::sampleRoutePoints(const QJsonArray &coordinates, double durationSec)
+void RouteWeatherManager::sampleRoutePoints()
 {
     m_points.clear();
-
-    int numCoords = coordinates.size();
-    if (numCoords < 2) return;
-
-    // Walk the route, accumulating distance, and drop a sample point every SAMPLE_INTERVAL_KM.
-    // Stop at the 2-hour lookahead mark.
-    double totalDistKm = 0.0;
-    double lastSampleDist = -SAMPLE_INTERVAL_KM; // force first point
-
-    // First pass: compute total route distance for speed estimation
-    double routeTotalKm = 0.0;
-    double prevLat = 0, prevLon = 0;
-    for (int i = 0; i < numCoords; ++i) {
-        QJsonArray c = coordinates[i].toArray();
-        if (c.size() < 2) continue;
-        double lat = c[1].toDouble();
-        double lon = c[0].toDouble();
-        if (i > 0) {
-            routeTotalKm += GeoUtils::haversineKm(prevLat, prevLon, lat, lon);
-        }
-        prevLat = lat;
-        prevLon = lon;
+    if (!m_route) return;
+
+    // Equal driving time rather than equal distance: the forecast is in
+    // 15-minute slots, so a slow stretch through town gets as many points
+    // per slot as the highway. Stop at the 2-hour lookahead mark.
+    const RouteSampler &sampler = m_route->sampler();
+
+    // Sample ahead of the car, not from the start of the route
+    double startKm = 0.0;
+    if (m_tracker && m_tracker->tracking() && m_tracker->routeIndex() == m_route->index())
+        startKm = m_tracker->travelledKm();
+    const double startSec = sampler.etaSecAt(startKm);
+    const double intervalSec = SAMPLE_INTERVAL_MIN * 60.0;
+
+    qDebug() << "RouteWeatherManager: Route" << m_route->totalKm() << "km,"
+             << sampler.totalSec() / 60.0 << "min, sampling from" << startKm << "km";
+
+    // The car's position, then the route's cached time samples ahead of it,
+    // skipping one too close behind the car's to be worth a fetch
+    QVector<RouteSampler::Sample> samples { sampler.sampleAt(startKm) };
+    for (const RouteSampler::Sample &s : sampler.byTime(intervalSec)) {
+        const double aheadSec = s.etaSec - startSec;
+        if (aheadSec > LOOKAHEAD_HOURS * 3600.0) break;
+        if (aheadSec >= intervalSec / 2) samples.append(s);
     }
 
-    double avgSpeedKmh = (durationSec > 0) ? (routeTotalKm / (durationSec / 3600.0)) : 80.0;
-    double lookaheadKm = avgSpeedKmh * LOOKAHEAD_HOURS;
-
-    qDebug() << "RouteWeatherManager: Route" << routeTotalKm << "km, avg speed"
-             << avgSpeedKmh << "km/h, lookahead" << lookaheadKm << "km";
-
-    // Second pass: sample points
-    prevLat = 0; prevLon = 0;
-    totalDistKm = 0.0;
-    for (int i = 0; i < numCoords; ++i) {
-        QJsonArray c = coordinates[i].toArray();
-        if (c.size() < 2) continue;
-        double lat = c[1].toDouble();
-        double lon = c[0].toDouble();
-
-        if (i > 0) {
-            totalDistKm += GeoUtils::haversineKm(prevLat, prevLon, lat, lon);
-        }
-        prevLat = lat;
-        prevLon = lon;
-
-        // Stop if beyond 2-hour lookahead
-        if (totalDistKm > lookaheadKm) break;
-
-        // Sample at every SAMPLE_INTERVAL_KM
-        if (totalDistKm - lastSampleDist >= SAMPLE_INTERVAL_KM || i == 0) {
-            RoutePoint pt;
-            pt.lat = lat;
-            pt.lon = lon;
-            pt.etaMinutes = (avgSpeedKmh > 0) ? (totalDistKm / avgSpeedKmh) * 60.0 : 0.0;
-
-            if (i == 0) {
-                pt.locationLabel = "Current location";
+    for (const RouteSampler::Sample &s : samples) {
+        RoutePoint pt;
+        pt.lat = s.lat;
+        pt.lon = s.lon;
+        pt.alongKm = s.alongKm;
+        pt.etaMinutes = (s.etaSec - startSec) / 60.0;
+
+        if (m_points.isEmpty()) {
+            pt.locationLabel = "Current location";
+        } else {
+            int mins = qRound(pt.etaMinutes);
+            if (mins < 60) {
+                pt.locationLabel = QString("%1 min ahead").arg(mins);
             } else {
-                int mins = qRound(pt.etaMinutes);
-                if (mins < 60) {
-                    pt.locationLabel = QString("%1 min ahead").arg(mins);
-                } else {
-                    pt.locationLabel = QString("%1h %2m ahead")
-                        .arg(mins / 60).arg(mins % 60);
-                }
+                pt.locationLabel = QString("%1h %2m ahead")
+                    .arg(mins / 60).arg(mins % 60);
             }
-
-            m_points.append(pt);
-            lastSampleDist = totalDistKm;
         }
+
+        m_points.append(pt);
     }
 
     qDebug() << "RouteWeatherManager: Sampled" << m_points.size()
-             << "points over" << qMin(totalDistKm, lookaheadKm) << "km";
+             << "points over" << m_points.last().alongKm - startKm << "km";
 }
 
 void RouteWeatherManager::fetchWeather()
@@ -292,6 +274,15 @@ void RouteWeatherManager::buildSummary()
     m_summary = summary;
     emit summaryChanged();
 
+    // Severe weather ahead: refresh more often on the approach
+    if (m_scheduler) {
+        QVector<double> severeKms;
+        for (const auto &pt : m_points) {
+            if (isSevereWeather(pt.weatherCode) || pt.windSpeed > 80.0) severeKms.append(pt.alongKm);
+        }
+        m_scheduler->setUpcoming(m_refreshTask, severeKms, "severe weather");
+    }
+
     // Always update ContextAggregator — keeps context current for user questions
     if (m_context) {
         m_context->setRouteWeatherSummary(summary);
@@ -336,10 +327,10 @@ void RouteWeatherManager::buildSummary()
 
 void RouteWeatherManager::refreshForecasts()
 {
-    if (!m_active || m_routeCoordinates.isEmpty()) return;
+    if (!m_active || !m_route) return;
 
     // Re-sample points (driver has moved, ETAs have shifted)
-    sampleRoutePoints(m_routeCoordinates, m_totalDurationSec);
+    sampleRoutePoints();
     fetchWeather();
 
     qDebug() << "RouteWeatherManager: Refreshing forecasts (" << m_points.size() << "points)";
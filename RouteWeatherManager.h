@@ -4,12 +4,14 @@
 #include <QObject>
 #include <QString>
 #include <QSet>
-#include <QJsonArray>
-#include <QTimer>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <memory>
 
 class ContextAggregator;
+class RefreshScheduler;
+class Route;
+class RouteProgressTracker;
 
 class RouteWeatherManager : public QObject
 {
@@ -21,12 +23,16 @@ public:
     explicit RouteWeatherManager(QObject *parent = nullptr);
 
     void setContextAggregator(ContextAggregator *ctx);
+    void setRouteProgressTracker(RouteProgressTracker *tracker);
+    void setRefreshScheduler(RefreshScheduler *scheduler);
 
     bool active() const { return m_active; }
     QString summary() const { return m_summary; }
 
+    // From RouteLoader::routeChanged. silent suppresses the first alert.
+    void setRoute(const std::shared_ptr<const Route> &route, bool silent = false);
+
 public slots:
-    void setRouteCoordinates(const QJsonArray &coordinates, double durationSec, bool silent = false);
     void clearRoute();
 
 signals:
@@ -42,6 +48,7 @@ private:
     struct RoutePoint {
         double lat = 0.0;
         double lon = 0.0;
+        double alongKm = 0.0;    // Along the route
         double etaMinutes = 0.0; // minutes from now to reach this point
         QString weatherDesc;
         double tempC = 0.0;
@@ -51,20 +58,21 @@ private:
         QString locationLabel;
     };
 
-    void sampleRoutePoints(const QJsonArray &coordinates, double durationSec);
+    void sampleRoutePoints();
     void fetchWeather();
     void buildSummary();
     QString descriptionForCode(int code) const;
     bool isSevereWeather(int code) const;
     QNetworkAccessManager *m_network;
-    QTimer *m_refreshTimer;
+    RefreshScheduler *m_scheduler = nullptr;
+    int m_refreshTask = -1;
     ContextAggregator *m_context = nullptr;
+    RouteProgressTracker *m_tracker = nullptr;
 
     bool m_active = false;
     QString m_summary;
     QList<RoutePoint> m_points;
-    QJsonArray m_routeCoordinates;
-    double m_totalDurationSec = 0.0;
+    std::shared_ptr<const Route> m_route;
     int m_generation = 0;
 
     // Change detection — only emit alertDetected when conditions differ
@@ -72,7 +80,7 @@ private:
     bool m_lastHadHighWind = false;
     bool m_suppressNextAlert = false;
 
-    static constexpr double SAMPLE_INTERVAL_KM = 15.0;   // sample every 15km
+    static constexpr double SAMPLE_INTERVAL_MIN = 15.0;  // sample every 15 min of driving
     static constexpr double LOOKAHEAD_HOURS = 2.0;        // only look 2 hours ahead
     static constexpr int REFRESH_INTERVAL_MS = 30 * 60 * 1000; // 30 minutes
 };
@@ -0,0 +1,383 @@
+#include "SpatialTileCache.h"
+#include "GeoUtils.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr quint32 kCacheMagic = 0x53544331;   // "STC1"
+constexpr quint16 kCacheVersion = 1;
+constexpr int kTilesLon = 3600;               // 360° / kTileDeg
+constexpr int kTilesLat = 1800;
+constexpr int kMaxCoverings = 8;
+constexpr int kSaveDelayMs = 10 * 1000;
+
+int tileX(double lon) { return qBound(0, int(std::floor((lon + 180.0) / SpatialTileCache::kTileDeg)), kTilesLon - 1); }
+int tileY(double lat) { return qBound(0, int(std::floor((lat + 90.0) / SpatialTileCache::kTileDeg)), kTilesLat - 1); }
+
+} // namespace
+
+SpatialTileCache::SpatialTileCache(QObject *parent)
+    : QObject(parent)
+    , m_saveTimer(new QTimer(this))
+{
+    // Feeds sync a few at a time; one write covers the whole burst
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(kSaveDelayMs);
+    connect(m_saveTimer, &QTimer::timeout, this, &SpatialTileCache::save);
+
+    load();
+    qDebug() << "SpatialTileCache: Initialized";
+}
+
+SpatialTileCache::~SpatialTileCache()
+{
+    if (m_dirty) save();
+}
+
+// ============================================================================
+// Tiles
+// ============================================================================
+
+quint32 SpatialTileCache::tileKey(double lat, double lon)
+{
+    return quint32(tileY(lat)) * kTilesLon + quint32(tileX(lon));
+}
+
+void SpatialTileCache::addTileRange(double minLat, double maxLat, double minLon, double maxLon,
+                                    QVector<quint32> &out)
+{
+    const int y0 = tileY(minLat), y1 = tileY(maxLat);
+    const int x0 = tileX(minLon), x1 = tileX(maxLon);
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+            out.append(quint32(y) * kTilesLon + quint32(x));
+}
+
+const QVector<quint32> &SpatialTileCache::coveringTiles(const std::shared_ptr<const RouteIndex> &route,
+                                                        double radiusKm) const
+{
+    for (int i = 0; i < m_coverings.size(); ++i) {
+        const Covering &c = m_coverings[i];
+        if (c.radiusKm == radiusKm && c.route.lock() == route) {
+            if (i > 0) m_coverings.move(i, 0);
+            return m_coverings.first().tiles;
+        }
+    }
+
+    // Walk the route in chunks about one tile across and cover each chunk's
+    // bounding box grown by the radius. Every segment lies inside the box of
+    // the chunk holding both its ends, and chunks this size keep the boxes
+    // tight without emitting a tile range per segment.
+    Covering c;
+    c.route = route;
+    c.radiusKm = radiusKm;
+
+    const double padLat = radiusKm / 110.574;
+    auto emitChunk = [&](double minLat, double maxLat, double minLon, double maxLon) {
+        const double edgeLat = qMin(qMax(qAbs(minLat), qAbs(maxLat)) + padLat, 89.0);
+        const double padLon = radiusKm / (111.320 * qCos(qDegreesToRadians(edgeLat)));
+        addTileRange(minLat - padLat, maxLat + padLat, minLon - padLon, maxLon + padLon, c.tiles);
+    };
+
+    QVector<double> lats, lons;
+    route->points().decode(lats, lons);
+    double minLat = lats[0], maxLat = minLat;
+    double minLon = lons[0], maxLon = minLon;
+    for (int i = 1; i < lats.size(); ++i) {
+        const double lat = lats[i], lon = lons[i];
+        const double nMinLat = qMin(minLat, lat), nMaxLat = qMax(maxLat, lat);
+        const double nMinLon = qMin(minLon, lon), nMaxLon = qMax(maxLon, lon);
+        if (nMaxLat - nMinLat > kTileDeg || nMaxLon - nMinLon > kTileDeg) {
+            // Close the chunk through this vertex, start the next one at it
+            emitChunk(nMinLat, nMaxLat, nMinLon, nMaxLon);
+            minLat = maxLat = lat;
+            minLon = maxLon = lon;
+        } else {
+            minLat = nMinLat; maxLat = nMaxLat;
+            minLon = nMinLon; maxLon = nMaxLon;
+        }
+    }
+    emitChunk(minLat, maxLat, minLon, maxLon);
+
+    std::sort(c.tiles.begin(), c.tiles.end());
+    c.tiles.erase(std::unique(c.tiles.begin(), c.tiles.end()), c.tiles.end());
+
+    m_coverings.prepend(std::move(c));
+    while (m_coverings.size() > kMaxCoverings) m_coverings.removeLast();
+    return m_coverings.first().tiles;
+}
+
+// ============================================================================
+// Updates
+// ============================================================================
+
+void SpatialTileCache::insert(Layer &layer, const Feature &f)
+{
+    layer.features.insert(f.id, f);
+    layer.tiles[tileKey(f.lat, f.lon)].insert(f.id);
+}
+
+void SpatialTileCache::remove(Layer &layer, const QString &id)
+{
+    const auto it = layer.features.constFind(id);
+    if (it == layer.features.constEnd()) return;
+
+    const quint32 key = tileKey(it->lat, it->lon);
+    auto tile = layer.tiles.find(key);
+    if (tile != layer.tiles.end()) {
+        tile->remove(id);
+        if (tile->isEmpty()) layer.tiles.erase(tile);
+    }
+    layer.features.erase(it);
+}
+
+SpatialTileCache::SyncStats SpatialTileCache::syncSource(const QString &layerName, const QString &source,
+                                                         const QList<Feature> &snapshot, const Bounds &scope)
+{
+    Layer &layer = m_layers[layerName];
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    SyncStats stats;
+
+    QSet<QString> seen;
+    seen.reserve(snapshot.size());
+    for (Feature f : snapshot) {
+        f.source = source;
+        f.updatedMs = now;
+        seen.insert(f.id);
+
+        auto it = layer.features.find(f.id);
+        if (it == layer.features.end()) {
+            insert(layer, f);
+            ++stats.added;
+        } else if (it->lat != f.lat || it->lon != f.lon) {
+            remove(layer, f.id);
+            insert(layer, f);
+            ++stats.updated;
+        } else if (it->data != f.data || it->source != f.source) {
+            it->data = f.data;
+            it->source = f.source;
+            it->updatedMs = now;
+            ++stats.updated;
+        } else {
+            it->updatedMs = now;
+            ++stats.unchanged;
+        }
+    }
+
+    QStringList gone;
+    for (auto it = layer.features.cbegin(); it != layer.features.cend(); ++it) {
+        if (it->source == source && !seen.contains(it.key()) && scope.contains(it->lat, it->lon))
+            gone.append(it.key());
+    }
+    for (const QString &id : gone) remove(layer, id);
+    stats.removed = gone.size();
+
+    // Timestamps change on every sync, so always persist
+    m_dirty = true;
+    m_saveTimer->start();
+
+    qDebug() << "SpatialTileCache:" << layerName << source << "+" << stats.added << "~" << stats.updated
+             << "-" << stats.removed << "=" << stats.unchanged << "(" << layer.features.size() << "total)";
+
+    if (stats.added || stats.updated || stats.removed)
+        emit layerChanged(layerName);
+    return stats;
+}
+
+void SpatialTileCache::touchSource(const QString &layerName, const QString &source, const Bounds &scope)
+{
+    const auto layerIt = m_layers.find(layerName);
+    if (layerIt == m_layers.end()) return;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    int touched = 0;
+    for (Feature &f : layerIt->features) {
+        if (f.source != source || !scope.contains(f.lat, f.lon)) continue;
+        f.updatedMs = now;
+        ++touched;
+    }
+
+    m_dirty = true;
+    m_saveTimer->start();
+    qDebug() << "SpatialTileCache:" << layerName << source << "unchanged," << touched << "confirmed";
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+QList<SpatialTileCache::Hit> SpatialTileCache::nearRoute(const QString &layerName,
+                                                         const std::shared_ptr<const RouteIndex> &route,
+                                                         double radiusKm, qint64 maxAgeMs) const
+{
+    QList<Hit> hits;
+    const auto layerIt = m_layers.constFind(layerName);
+    if (!route || layerIt == m_layers.constEnd()) return hits;
+    const Layer &layer = *layerIt;
+
+    const qint64 oldest = maxAgeMs > 0 ? QDateTime::currentMSecsSinceEpoch() - maxAgeMs : 0;
+    auto check = [&](const QSet<QString> &ids) {
+        for (const QString &id : ids) {
+            const Feature &f = *layer.features.constFind(id);
+            if (f.updatedMs < oldest) continue;
+            const RouteIndex::Match match = route->nearest(f.lat, f.lon, radiusKm);
+            if (match.valid) hits.append(Hit { f, match });
+        }
+    };
+
+    // Walk whichever side is smaller: the corridor's tiles or the layer's
+    // occupied ones
+    const QVector<quint32> &covering = coveringTiles(route, radiusKm);
+    if (covering.size() <= layer.tiles.size()) {
+        for (const quint32 key : covering) {
+            const auto tile = layer.tiles.constFind(key);
+            if (tile != layer.tiles.constEnd()) check(*tile);
+        }
+    } else {
+        for (auto tile = layer.tiles.cbegin(); tile != layer.tiles.cend(); ++tile) {
+            if (std::binary_search(covering.cbegin(), covering.cend(), tile.key())) check(*tile);
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) {
+        return a.match.alongKm < b.match.alongKm;
+    });
+    return hits;
+}
+
+QList<SpatialTileCache::Hit> SpatialTileCache::nearPoint(const QString &layerName, double lat, double lon,
+                                                         double radiusKm, qint64 maxAgeMs) const
+{
+    QList<Hit> hits;
+    const auto layerIt = m_layers.constFind(layerName);
+    if (layerIt == m_layers.constEnd()) return hits;
+    const Layer &layer = *layerIt;
+
+    const qint64 oldest = maxAgeMs > 0 ? QDateTime::currentMSecsSinceEpoch() - maxAgeMs : 0;
+    const double padLat = radiusKm / 110.574;
+    const double edgeLat = qMin(qAbs(lat) + padLat, 89.0);
+    const double padLon = radiusKm / (111.320 * qCos(qDegreesToRadians(edgeLat)));
+    QVector<quint32> keys;
+    addTileRange(lat - padLat, lat + padLat, lon - padLon, lon + padLon, keys);
+
+    for (const quint32 key : keys) {
+        const auto tile = layer.tiles.constFind(key);
+        if (tile == layer.tiles.constEnd()) continue;
+        for (const QString &id : *tile) {
+            const Feature &f = *layer.features.constFind(id);
+            if (f.updatedMs < oldest) continue;
+            Hit hit { f, RouteIndex::Match() };
+            hit.match.distanceKm = GeoUtils::haversineKm(lat, lon, f.lat, f.lon);
+            if (hit.match.distanceKm > radiusKm) continue;
+            hit.match.valid = true;
+            hit.match.lat = f.lat;
+            hit.match.lon = f.lon;
+            hits.append(hit);
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) {
+        return a.match.distanceKm < b.match.distanceKm;
+    });
+    return hits;
+}
+
+int SpatialTileCache::size(const QString &layer) const
+{
+    const auto it = m_layers.constFind(layer);
+    return it == m_layers.constEnd() ? 0 : it->features.size();
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+QString SpatialTileCache::cacheFile() const
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(cacheDir);
+    return cacheDir + "/spatial-tiles.cache";
+}
+
+void SpatialTileCache::load()
+{
+    QFile file(cacheFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "SpatialTileCache: No cache on disk";
+        return;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_2);
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != kCacheMagic || version != kCacheVersion) {
+        qWarning() << "SpatialTileCache: Ignoring cache with unknown format";
+        return;
+    }
+
+    m_layers.clear();
+    int layerCount = 0;
+    in >> layerCount;
+    int total = 0;
+    for (int l = 0; l < layerCount && in.status() == QDataStream::Ok; ++l) {
+        QString name;
+        int count = 0;
+        in >> name >> count;
+        Layer &layer = m_layers[name];
+        layer.features.reserve(count);
+        for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            Feature f;
+            in >> f.id >> f.source >> f.lat >> f.lon >> f.data >> f.updatedMs;
+            insert(layer, f);
+        }
+        total += layer.features.size();
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "SpatialTileCache: Cache truncated, starting empty";
+        m_layers.clear();
+        return;
+    }
+    qDebug() << "SpatialTileCache: Loaded" << total << "features in" << m_layers.size() << "layers";
+}
+
+void SpatialTileCache::save()
+{
+    m_saveTimer->stop();
+
+    // QSaveFile so a power cut mid-write leaves the previous cache intact
+    QSaveFile file(cacheFile());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "SpatialTileCache: Failed to save cache";
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_2);
+    out << kCacheMagic << kCacheVersion << int(m_layers.size());
+    int total = 0;
+    for (auto it = m_layers.cbegin(); it != m_layers.cend(); ++it) {
+        out << it.key() << int(it->features.size());
+        for (const Feature &f : it->features)
+            out << f.id << f.source << f.lat << f.lon << f.data << f.updatedMs;
+        total += it->features.size();
+    }
+
+    if (!file.commit()) {
+        qWarning() << "SpatialTileCache: Failed to save cache";
+        return;
+    }
+    m_dirty = false;
+    qDebug() << "SpatialTileCache: Saved" << total << "features";
+}
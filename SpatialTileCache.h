@@ -0,0 +1,130 @@
+#ifndef SPATIALTILECACHE_H
+#define SPATIALTILECACHE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+#include <memory>
+
+#include "RouteIndex.h"
+
+// Shared, persistent store of point features from the road-data feeds
+// (511 events, cameras, surface stations, border crossings).
+//
+// Features live in named layers, one per manager, and are bucketed into
+// fixed 0.1° lat/lon tiles. A route query first collects the tiles its
+// corridor covers, then runs the exact distance check only against the
+// features in those tiles, so the cost scales with what is near the route
+// rather than with the size of a provincial feed.
+//
+// Each feed is one source within a layer. syncSource() diffs a fresh
+// snapshot against what the store holds: new and changed features are
+// upserted, ones the feed dropped are deleted, unchanged ones only have
+// their timestamp bumped. A failed fetch simply doesn't sync, so the last
+// good data stays queryable. The store is written to the cache directory
+// shortly after each change and read back at startup, so a route planned
+// right after boot is answered before the first fetch completes.
+class SpatialTileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Feature {
+        QString id;           // Unique within its layer
+        QString source;       // Feed that owns it ("511AB", "DriveBC", ...)
+        double lat = 0.0;
+        double lon = 0.0;
+        QVariantMap data;     // Manager-defined payload
+        qint64 updatedMs = 0; // Last time its feed confirmed it
+    };
+
+    struct Hit {
+        Feature feature;
+        RouteIndex::Match match;   // Against the queried route
+    };
+
+    struct SyncStats {
+        int added = 0;
+        int updated = 0;
+        int removed = 0;
+        int unchanged = 0;
+    };
+
+    // Limits the deletions of a sync to a bounding box, for feeds that are
+    // queried by area rather than downloaded whole
+    struct Bounds {
+        double minLat = -90.0;
+        double maxLat = 90.0;
+        double minLon = -180.0;
+        double maxLon = 180.0;
+        bool contains(double lat, double lon) const
+        {
+            return lat >= minLat && lat <= maxLat && lon >= minLon && lon <= maxLon;
+        }
+    };
+
+    static constexpr double kTileDeg = 0.1;
+
+    explicit SpatialTileCache(QObject *parent = nullptr);
+    ~SpatialTileCache();
+
+    // Replaces everything `source` owns in `layer` (within `scope`) with
+    // `snapshot`
+    SyncStats syncSource(const QString &layer, const QString &source,
+                         const QList<Feature> &snapshot, const Bounds &scope = Bounds());
+
+    // Features within radiusKm of the route line, ordered by distance along
+    // it. maxAgeMs > 0 skips features their feed hasn't confirmed recently.
+    QList<Hit> nearRoute(const QString &layer, const std::shared_ptr<const RouteIndex> &route,
+                         double radiusKm, qint64 maxAgeMs = 0) const;
+
+    // Features within radiusKm of a point, nearest first. Hit::match only
+    // has distanceKm set.
+    QList<Hit> nearPoint(const QString &layer, double lat, double lon,
+                         double radiusKm, qint64 maxAgeMs = 0) const;
+
+    // The feed reported no change: confirms everything `source` owns in
+    // `layer` (within `scope`) without a diff
+    void touchSource(const QString &layer, const QString &source, const Bounds &scope = Bounds());
+
+    int size(const QString &layer) const;
+
+    void load();
+    void save();
+
+signals:
+    void layerChanged(const QString &layer);
+
+private:
+    struct Layer {
+        QHash<QString, Feature> features;       // By id
+        QHash<quint32, QSet<QString>> tiles;    // Tile key -> feature ids
+    };
+
+    struct Covering {
+        std::weak_ptr<const RouteIndex> route;
+        double radiusKm = 0.0;
+        QVector<quint32> tiles;                 // Sorted
+    };
+
+    static quint32 tileKey(double lat, double lon);
+    static void addTileRange(double minLat, double maxLat, double minLon, double maxLon,
+                             QVector<quint32> &out);
+    const QVector<quint32> &coveringTiles(const std::shared_ptr<const RouteIndex> &route,
+                                          double radiusKm) const;
+    void insert(Layer &layer, const Feature &f);
+    void remove(Layer &layer, const QString &id);
+    QString cacheFile() const;
+
+    QHash<QString, Layer> m_layers;
+    mutable QList<Covering> m_coverings;        // Most recent first
+    QTimer *m_saveTimer;
+    bool m_dirty = false;
+};
+
+#endif // SPATIALTILECACHE_H
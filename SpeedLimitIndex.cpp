@@ -0,0 +1,153 @@
+#include "SpeedLimitIndex.h"
+#include <QDebug>
+#include <QtMath>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr double kMPerDegLat = 110574.0;
+constexpr double kMPerDegLonEquator = 111320.0;
+
+// Score added to a segment running across the GPS heading (more than 60°
+// off), enough to lose to a parallel road a lane's width further away
+constexpr double kCrossHeadingPenaltyM = 15.0;
+constexpr double kCosCrossHeading = 0.5;
+
+} // namespace
+
+SpeedLimitIndex::SpeedLimitIndex() = default;
+
+SpeedLimitIndex::~SpeedLimitIndex()
+{
+    close();
+}
+
+bool SpeedLimitIndex::open(const QString &path)
+{
+    close();
+
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        qDebug() << "SpeedLimitIndex: No index at" << path;
+        return false;
+    }
+
+    const qint64 size = file->size();
+    if (size < qint64(sizeof(FileHeader))) {
+        qWarning() << "SpeedLimitIndex:" << path << "is too short";
+        return false;
+    }
+
+    const uchar *data = file->map(0, size);
+    if (!data) {
+        qWarning() << "SpeedLimitIndex: Could not map" << path << file->errorString();
+        return false;
+    }
+
+    const auto *header = reinterpret_cast<const FileHeader *>(data);
+    const qint64 expected = qint64(sizeof(FileHeader))
+                          + qint64(header->tileCount) * qint64(sizeof(TileEntry))
+                          + qint64(header->segmentCount) * qint64(sizeof(Segment));
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion
+        || header->tilesPerDeg <= 0 || header->tilesPerDeg > 1000 || size != expected) {
+        qWarning() << "SpeedLimitIndex:" << path << "is not a version" << kVersion << "index";
+        return false;
+    }
+
+    m_file = std::move(file);
+    m_header = header;
+    m_tiles = reinterpret_cast<const TileEntry *>(data + sizeof(FileHeader));
+    m_segments = reinterpret_cast<const Segment *>(m_tiles + header->tileCount);
+
+    qDebug() << "SpeedLimitIndex: Mapped" << path << "-" << header->tileCount << "tiles,"
+             << header->segmentCount << "segments," << size / 1024 << "KiB";
+    return true;
+}
+
+void SpeedLimitIndex::close()
+{
+    m_header = nullptr;
+    m_tiles = nullptr;
+    m_segments = nullptr;
+    m_file.reset();   // Unmaps
+}
+
+quint32 SpeedLimitIndex::tileKey(double lat, double lon, int tilesPerDeg)
+{
+    const quint32 y = quint32(qFloor((lat + 90.0) * tilesPerDeg));
+    const quint32 x = quint32(qFloor((lon + 180.0) * tilesPerDeg));
+    return y * quint32(360 * tilesPerDeg) + x;
+}
+
+SpeedLimitIndex::Match SpeedLimitIndex::lookup(double lat, double lon, double headingDeg,
+                                               double maxDistanceM) const
+{
+    Match best;
+    if (!m_header) return best;
+
+    const quint32 key = tileKey(lat, lon, m_header->tilesPerDeg);
+    const TileEntry *tilesEnd = m_tiles + m_header->tileCount;
+    const TileEntry *tile = std::lower_bound(m_tiles, tilesEnd, key,
+                                             [](const TileEntry &t, quint32 k) { return t.key < k; });
+    if (tile == tilesEnd || tile->key != key) return best;
+
+    // Anything past the margin may live in a neighbouring tile
+    const double marginM = m_header->marginE6 * 1e-6 * kMPerDegLat;
+    const double radiusM = qMin(maxDistanceM, marginM);
+
+    // Flat frame in metres around the query point
+    const double mPerE6Lat = kMPerDegLat * 1e-6;
+    const double mPerE6Lon = kMPerDegLonEquator * qCos(qDegreesToRadians(lat)) * 1e-6;
+    const double latE6 = lat * 1e6;
+    const double lonE6 = lon * 1e6;
+
+    // Most of a tile's segments are rejected on their bounding box alone
+    const qint32 qLat = qint32(latE6), qLon = qint32(lonE6);
+    const qint32 reachLat = qint32(radiusM / mPerE6Lat) + 1;
+    const qint32 reachLon = qint32(radiusM / mPerE6Lon) + 1;
+
+    const bool haveHeading = headingDeg >= 0.0;
+    const double hx = haveHeading ? qSin(qDegreesToRadians(headingDeg)) : 0.0;
+    const double hy = haveHeading ? qCos(qDegreesToRadians(headingDeg)) : 0.0;
+
+    double bestScore = radiusM + kCrossHeadingPenaltyM;
+    const Segment *seg = m_segments + tile->first;
+    const Segment *end = seg + tile->count;
+    for (; seg != end; ++seg) {
+        if (qMin(seg->lat0, seg->lat1) - reachLat > qLat || qMax(seg->lat0, seg->lat1) + reachLat < qLat
+            || qMin(seg->lon0, seg->lon1) - reachLon > qLon || qMax(seg->lon0, seg->lon1) + reachLon < qLon)
+            continue;
+
+        const double ax = (seg->lon0 - lonE6) * mPerE6Lon;
+        const double ay = (seg->lat0 - latE6) * mPerE6Lat;
+        const double dx = (seg->lon1 - seg->lon0) * mPerE6Lon;
+        const double dy = (seg->lat1 - seg->lat0) * mPerE6Lat;
+        const double lenSq = dx * dx + dy * dy;
+
+        // Closest point to the origin on A + t * D
+        const double t = lenSq > 0.0 ? qBound(0.0, -(ax * dx + ay * dy) / lenSq, 1.0) : 0.0;
+        const double cx = ax + t * dx;
+        const double cy = ay + t * dy;
+        const double distSq = cx * cx + cy * cy;
+        if (distSq > radiusM * radiusM) continue;
+
+        const double dist = qSqrt(distSq);
+        double score = dist;
+        if (haveHeading && lenSq > 0.0) {
+            const double cosAngle = (hx * dx + hy * dy) / qSqrt(lenSq);
+            // A direction-specific limit never applies to the other carriageway
+            if ((seg->flags & Forward) && cosAngle < 0.0) continue;
+            if ((seg->flags & Backward) && cosAngle > 0.0) continue;
+            if (qAbs(cosAngle) < kCosCrossHeading) score += kCrossHeadingPenaltyM;
+        }
+
+        // Equal scores are the two directions of one road: take the lower
+        if (score < bestScore || (score == bestScore && seg->kmh < best.kmh)) {
+            bestScore = score;
+            best.kmh = seg->kmh;
+            best.distanceM = dist;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,89 @@
+#ifndef SPEEDLIMITINDEX_H
+#define SPEEDLIMITINDEX_H
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+#include <memory>
+
+// Read-only speed-limit lookup over a file built offline from an OSM
+// extract by tools/build_speed_limits.py.
+//
+// The file is memory-mapped and used in place. Every OSM way with a
+// maxspeed is cut into straight segments, and each segment is filed under
+// every tile (1 / tilesPerDeg degrees square) that its bounding box,
+// grown by the header's margin, touches. A lookup therefore reads one tile:
+// a binary search of the sorted tile directory, then a distance check
+// against the few dozen segments stored contiguously for that tile.
+//
+// Layout, little-endian and naturally aligned:
+//   FileHeader
+//   TileEntry[tileCount]        sorted by key
+//   Segment[segmentCount]       grouped by tile
+class SpeedLimitIndex
+{
+public:
+    static constexpr char kMagic[4] = { 'H', 'U', 'S', 'L' };
+    static constexpr quint32 kVersion = 1;
+
+    struct FileHeader {
+        char magic[4];
+        quint32 version;
+        qint32 tilesPerDeg;
+        qint32 marginE6;        // Segments are filed in tiles within this margin
+        quint32 tileCount;
+        quint32 segmentCount;
+        quint32 reserved[2];
+    };
+
+    struct TileEntry {
+        quint32 key;            // tileKey()
+        quint32 first;          // Into the segment array
+        quint32 count;
+    };
+
+    enum SegmentFlags : quint16 {
+        Forward = 1,            // Limit only applies driving lat0/lon0 -> lat1/lon1
+        Backward = 2,           // Only driving the other way
+    };
+
+    struct Segment {
+        qint32 lat0;            // Microdegrees
+        qint32 lon0;
+        qint32 lat1;
+        qint32 lon1;
+        quint16 kmh;
+        quint16 flags;
+    };
+
+    struct Match {
+        int kmh = 0;            // 0 when nothing is in range
+        double distanceM = 0.0;
+    };
+
+    SpeedLimitIndex();
+    ~SpeedLimitIndex();
+
+    // Maps the file; false (and stays closed) if it is missing or malformed
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    int tileCount() const { return m_header ? int(m_header->tileCount) : 0; }
+    int segmentCount() const { return m_header ? int(m_header->segmentCount) : 0; }
+
+    // Limit of the segment nearest the point, within maxDistanceM (capped
+    // by the file's margin). headingDeg >= 0 prefers segments running the
+    // same way and rules out direction-specific limits for the opposite one.
+    Match lookup(double lat, double lon, double headingDeg = -1.0, double maxDistanceM = 25.0) const;
+
+    static quint32 tileKey(double lat, double lon, int tilesPerDeg);
+
+private:
+    std::unique_ptr<QFile> m_file;
+    const FileHeader *m_header = nullptr;
+    const TileEntry *m_tiles = nullptr;
+    const Segment *m_segments = nullptr;
+};
+
+#endif // SPEEDLIMITINDEX_H
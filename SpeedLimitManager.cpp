@@ -1,8 +1,8 @@
 #include "SpeedLimitManager.h"
 #include "ContextAggregator.h"
-#include "GeoUtils.h"
+#include "Route.h"
+#include "RouteProgressTracker.h"
 #include <QDebug>
-#include <QJsonObject>
 #include <QtMath>
 
 SpeedLimitManager::SpeedLimitManager(QObject *parent)
@@ -12,109 +12,68 @@ SpeedLimitManager::SpeedLimitManager(QObject *parent)
 }
 
 void SpeedLimitManager::setContextAggregator(ContextAggregator *ctx) { m_context = ctx; }
+void SpeedLimitManager::setRouteProgressTracker(RouteProgressTracker *tracker) { m_tracker = tracker; }
 
-void SpeedLimitManager::setSpeedLimitData(const QJsonArray &maxspeedAnnotations, const QJsonArray &routeCoordinates, double durationSec)
+bool SpeedLimitManager::loadSpeedLimitIndex(const QString &path)
 {
-    Q_UNUSED(durationSec)
-
-    m_segments.clear();
-    m_lastSegmentIndex = 0;
-    m_speedingStarted = false;
-    m_speedingAlertSent = false;
-
-    int numCoords = routeCoordinates.size();
-    int numAnnotations = maxspeedAnnotations.size();
+    if (!m_index.open(path)) return false;
+    if (!m_active) {
+        m_active = true;
+        emit activeChanged();
+    }
+    return true;
+}
 
-    // Annotations array has N-1 elements for N coordinates (one per segment)
-    if (numCoords < 2 || numAnnotations < 1) {
+void SpeedLimitManager::setRoute(const std::shared_ptr<const Route> &route)
+{
+    if (!route || (!route->hasMaxspeed() && !m_index.isOpen())) {
         clearRoute();
         return;
     }
 
-    for (int i = 0; i < numAnnotations && i < numCoords - 1; ++i) {
-        QJsonObject ann = maxspeedAnnotations[i].toObject();
-
-        // Get the two endpoints of this segment
-        QJsonArray coordA = routeCoordinates[i].toArray();
-        QJsonArray coordB = routeCoordinates[i + 1].toArray();
-        if (coordA.size() < 2 || coordB.size() < 2) continue;
-
-        // Store midpoint of segment (Mapbox coords are [lon, lat])
-        double latA = coordA[1].toDouble();
-        double lonA = coordA[0].toDouble();
-        double latB = coordB[1].toDouble();
-        double lonB = coordB[0].toDouble();
-
-        SpeedSegment seg;
-        seg.lat = (latA + latB) / 2.0;
-        seg.lon = (lonA + lonB) / 2.0;
-        seg.speedKmh = 0;
-        seg.isNone = false;
-
-        if (ann.contains("none") && ann["none"].toBool()) {
-            // "none" means no speed limit (e.g. autobahn)
-            seg.isNone = true;
-        } else if (ann.contains("unknown") && ann["unknown"].toBool()) {
-            // Unknown speed limit
-            seg.speedKmh = 0;
-        } else if (ann.contains("speed")) {
-            int speed = ann["speed"].toInt();
-            QString unit = ann["unit"].toString();
-            if (unit == "mph") {
-                seg.speedKmh = qRound(speed * 1.60934);
-            } else {
-                seg.speedKmh = speed; // km/h is the default
-            }
-        }
-
-        m_segments.append(seg);
-    }
+    m_route = route;
+    m_speedingStarted = false;
+    m_speedingAlertSent = false;
 
     m_active = true;
     emit activeChanged();
 
     buildSummary();
-    qDebug() << "SpeedLimitManager: Loaded" << m_segments.size() << "speed segments";
+    qDebug() << "SpeedLimitManager: Loaded" << m_route->size() - 1 << "speed segments";
 }
 
-void SpeedLimitManager::updateGpsPosition(double lat, double lon, double speedKmh)
+int SpeedLimitManager::routeLimitAt(double lat, double lon) const
 {
-    if (!m_active || m_segments.isEmpty()) return;
+    if (!m_route || !m_route->hasMaxspeed()) return 0;
 
-    // Find nearest segment using sequential search from last known position
     int bestIdx = -1;
-    double bestDist = 1e9;
-
-    // Search forward from last index, up to 30 segments
-    int searchEnd = qMin(m_lastSegmentIndex + 30, m_segments.size());
-    for (int i = m_lastSegmentIndex; i < searchEnd; ++i) {
-        double d = GeoUtils::haversineKm(lat, lon, m_segments[i].lat, m_segments[i].lon);
-        if (d < bestDist) {
-            bestDist = d;
-            bestIdx = i;
-        }
-    }
 
-    // If nothing close found in forward window, do a full search
-    if (bestIdx < 0 || bestDist > 1.0) {
-        for (int i = 0; i < m_segments.size(); ++i) {
-            double d = GeoUtils::haversineKm(lat, lon, m_segments[i].lat, m_segments[i].lon);
-            if (d < bestDist) {
-                bestDist = d;
-                bestIdx = i;
-            }
-        }
-    }
+    // On route: the tracker has already matched the car to a segment
+    if (m_tracker && m_tracker->tracking() && m_tracker->routeIndex() == m_route->index())
+        bestIdx = m_tracker->progress().segment;
+
+    // Not tracking (yet, or off route): nearest segment
+    if (bestIdx < 0)
+        bestIdx = m_route->index()->nearest(lat, lon).segment;
 
-    if (bestIdx < 0) return;
+    return bestIdx >= 0 ? m_route->maxspeedKmh(bestIdx) : 0;
+}
+
+void SpeedLimitManager::updateGpsPosition(double lat, double lon, double speedKmh, double headingDeg)
+{
+    if (!m_active) return;
 
-    m_lastSegmentIndex = bestIdx;
-    const SpeedSegment &seg = m_segments[bestIdx];
+    // The offline index knows the road under the car; the route only knows
+    // the limit of the route segment it was annotated with. A heading from
+    // a near-stationary car would pick the wrong carriageway.
+    int limitKmh = m_index.lookup(lat, lon, RouteProgressTracker::usableHeading(headingDeg, speedKmh)).kmh;
+    if (limitKmh <= 0)
+        limitKmh = routeLimitAt(lat, lon);
 
-    if (seg.speedKmh > 0 && !seg.isNone) {
+    if (limitKmh > 0) {
         // Valid speed limit
-        if (m_currentSpeedLimit != seg.speedKmh) {
-            m_currentSpeedLimit = seg.speedKmh;
+        if (m_currentSpeedLimit != limitKmh) {
+            m_currentSpeedLimit = limitKmh;
             emit currentSpeedLimitChanged();
         }
 
@@ -159,9 +118,9 @@ void SpeedLimitManager::updateGpsPosition(double lat, double lon, double speedKm
 
 void SpeedLimitManager::clearRoute()
 {
-    m_active = false;
-    m_segments.clear();
-    m_lastSegmentIndex = 0;
+    // The offline index keeps working without a route
+    m_active = m_index.isOpen();
+    m_route.reset();
     m_currentSpeedLimit = 0;
     m_speeding = false;
     m_speedingStarted = false;
@@ -185,11 +144,13 @@ void SpeedLimitManager::buildSummary()
     int minSpeed = INT_MAX;
     int maxSpeed = 0;
 
-    for (const auto &seg : m_segments) {
-        if (seg.speedKmh > 0 && !seg.isNone) {
+    const int segments = m_route ? m_route->size() - 1 : 0;
+    for (int i = 0; i < segments; ++i) {
+        const int limitKmh = m_route->maxspeedKmh(i);
+        if (limitKmh > 0) {
             withData++;
-            minSpeed = qMin(minSpeed, seg.speedKmh);
-            maxSpeed = qMax(maxSpeed, seg.speedKmh);
+            minSpeed = qMin(minSpeed, limitKmh);
+            maxSpeed = qMax(maxSpeed, limitKmh);
         } else {
             withoutData++;
         }
@@ -199,7 +160,8 @@ void SpeedLimitManager::buildSummary()
     if (total == 0) {
         m_summary = "No speed limit data available";
     } else if (withData == 0) {
-        m_summary = "No speed limit data available for this route";
+        m_summary = m_index.isOpen() ? "Speed limits from offline map data"
+                                     : "No speed limit data available for this route";
     } else {
         int pct = qRound(100.0 * withData / total);
         if (minSpeed == maxSpeed) {
@@ -217,7 +179,7 @@ void SpeedLimitManager::buildSummary()
         m_context->setSpeedLimitSummary(m_summary);
     }
 
-    qDebug() << "SpeedLimitManager: Summary updated," << m_segments.size() << "segments,"
+    qDebug() << "SpeedLimitManager: Summary updated," << segments << "segments,"
              << withData << "with data";
 }
 
@@ -3,10 +3,14 @@
 
 #include <QObject>
 #include <QString>
-#include <QJsonArray>
 #include <QElapsedTimer>
+#include <memory>
+
+#include "SpeedLimitIndex.h"
 
 class ContextAggregator;
+class Route;
+class RouteProgressTracker;
 
 class SpeedLimitManager : public QObject
 {
@@ -20,17 +24,25 @@ public:
     explicit SpeedLimitManager(QObject *parent = nullptr);
 
     void setContextAggregator(ContextAggregator *ctx);
+    void setRouteProgressTracker(RouteProgressTracker *tracker);
+
+    // Offline index from tools/build_speed_limits.py. With it the manager
+    // is active without a route, and its limits take precedence over the
+    // route's maxspeed annotations.
+    bool loadSpeedLimitIndex(const QString &path);
 
     bool active() const { return m_active; }
     int currentSpeedLimit() const { return m_currentSpeedLimit; }
     bool speeding() const { return m_speeding; }
     QString summary() const { return m_summary; }
 
+    // From RouteLoader::routeChanged. Without an index, inactive when the
+    // route has no maxspeed annotations.
+    void setRoute(const std::shared_ptr<const Route> &route);
+
 public slots:
-    // Called from Maps.qml with Mapbox maxspeed annotation data + route geometry
-    void setSpeedLimitData(const QJsonArray &maxspeedAnnotations, const QJsonArray &routeCoordinates, double durationSec);
-    // Called from Maps.qml onPositionChanged
-    void updateGpsPosition(double lat, double lon, double speedKmh);
+    // Called from Maps.qml onPositionChanged. headingDeg < 0 when unknown.
+    void updateGpsPosition(double lat, double lon, double speedKmh, double headingDeg = -1.0);
     void clearRoute();
 
 signals:
@@ -41,23 +53,18 @@ signals:
     void alertDetected(const QString &message);
 
 private:
-    struct SpeedSegment {
-        double lat = 0.0;
-        double lon = 0.0;
-        int speedKmh = 0;  // 0 if unknown
-        bool isNone = false;    // true if maxspeed was "none" (no limit)
-    };
-
+    int routeLimitAt(double lat, double lon) const;
     void buildSummary();
 
     ContextAggregator *m_context = nullptr;
+    RouteProgressTracker *m_tracker = nullptr;
     bool m_active = false;
     int m_currentSpeedLimit = 0;
     bool m_speeding = false;
     QString m_summary;
 
-    QList<SpeedSegment> m_segments;
-    int m_lastSegmentIndex = 0; // sequential tracking - only search forward
+    std::shared_ptr<const Route> m_route;
+    SpeedLimitIndex m_index;
 
     // Speeding alert: only alert after sustained speeding (10+ seconds)
     bool m_speedingStarted = false;
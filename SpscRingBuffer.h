@@ -0,0 +1,95 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <QtGlobal>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+// Fixed-capacity single-producer / single-consumer ring of trivially
+// copyable samples.
+//
+// Storage is allocated once by the constructor. The producer writes
+// straight into the free space (writeSpan() + commitWrite()) and the
+// consumer copies out whole frames with read(); the two indices are the
+// only shared state, published with acquire/release, so neither side ever
+// takes a lock or waits on the other.
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRingBuffer(int capacity)
+    {
+        int size = 1;
+        while (size < capacity) size <<= 1;
+        m_capacity = size;
+        m_mask = size - 1;
+        m_data.reset(new T[size]);
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    int capacity() const { return m_capacity; }
+
+    // Samples ready to read; exact on the consumer side, a lower bound
+    // anywhere else
+    int size() const
+    {
+        return int(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+    }
+
+    // Producer: contiguous free space at the write position (may be less
+    // than all of it when the free space wraps)
+    T *writeSpan(int *count)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        const quint64 tail = m_tail.load(std::memory_order_acquire);
+        const int free = m_capacity - int(head - tail);
+        const int offset = int(head & m_mask);
+        *count = std::min(free, m_capacity - offset);
+        return m_data.get() + offset;
+    }
+
+    // Producer: publishes count samples written into the last writeSpan()
+    void commitWrite(int count)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + quint64(count), std::memory_order_release);
+    }
+
+    // Consumer: copies exactly count samples into out, or nothing (false)
+    // if fewer are ready
+    bool read(T *out, int count)
+    {
+        const quint64 tail = m_tail.load(std::memory_order_relaxed);
+        const quint64 head = m_head.load(std::memory_order_acquire);
+        if (int(head - tail) < count) return false;
+
+        const int offset = int(tail & m_mask);
+        const int first = std::min(count, m_capacity - offset);
+        std::memcpy(out, m_data.get() + offset, size_t(first) * sizeof(T));
+        std::memcpy(out + first, m_data.get(), size_t(count - first) * sizeof(T));
+        m_tail.store(tail + quint64(count), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: drops everything written so far
+    void clear()
+    {
+        m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::unique_ptr<T[]> m_data;
+    int m_capacity = 0;
+    quint64 m_mask = 0;
+
+    // Free-running; the difference is the fill level. Kept on separate
+    // cache lines so the two sides don't bounce one between cores.
+    alignas(64) std::atomic<quint64> m_head { 0 };   // Written by the producer
+    alignas(64) std::atomic<quint64> m_tail { 0 };   // Written by the consumer
+};
+
+#endif // SPSCRINGBUFFER_H
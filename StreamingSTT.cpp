@@ -0,0 +1,260 @@
+#include "StreamingSTT.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#if HAS_WEB_SOCKETS
+#include <QtWebSockets/QWebSocket>
+#endif
+
+StreamingSTT::StreamingSTT(QObject *parent)
+    : QObject(parent)
+    , m_languageCode("en-US")
+{
+    if (!isSupported())
+        qDebug() << "StreamingSTT: Qt WebSockets not available - streaming recognition disabled";
+}
+
+StreamingSTT::~StreamingSTT()
+{
+#if HAS_WEB_SOCKETS
+    // The event loop won't run again, so deleteLater wouldn't either
+    if (m_socket) {
+        disconnect(m_socket, nullptr, this, nullptr);
+        m_socket->abort();
+        delete m_socket;
+        m_socket = nullptr;
+    }
+#endif
+}
+
+// ========================================================================
+// CONFIGURATION
+// ========================================================================
+
+void StreamingSTT::setEndpoint(const QUrl &url)
+{
+    m_endpoint = url;
+    if (isConfigured())
+        qDebug() << "StreamingSTT: Endpoint set to" << url.toString(QUrl::RemoveQuery);
+}
+
+void StreamingSTT::setLanguageCode(const QString &languageCode)
+{
+    m_languageCode = languageCode;
+}
+
+void StreamingSTT::setSpeechContextHints(const QStringList &phrases)
+{
+    m_speechContextHints = phrases;
+}
+
+// ========================================================================
+// STREAM
+// ========================================================================
+
+void StreamingSTT::begin(int sampleRate)
+{
+    closeSocket();
+    m_sampleRate = sampleRate;
+
+#if HAS_WEB_SOCKETS
+    if (!isConfigured()) {
+        emit error("Streaming STT not configured");
+        return;
+    }
+
+    m_socket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+    connect(m_socket, &QWebSocket::connected, this, &StreamingSTT::onConnected);
+    connect(m_socket, &QWebSocket::disconnected, this, &StreamingSTT::onDisconnected);
+    connect(m_socket, &QWebSocket::textMessageReceived, this, &StreamingSTT::onTextMessage);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    connect(m_socket, &QWebSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+#else
+    connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this,
+            [this](QAbstractSocket::SocketError) {
+#endif
+        const QString message = m_socket->errorString();
+        qWarning() << "StreamingSTT: Socket error:" << message;
+        closeSocket();
+        emit error("Network error: " + message);
+    });
+
+    m_socket->open(m_endpoint);
+#else
+    emit error("Streaming STT not available");
+#endif
+}
+
+void StreamingSTT::sendAudio(const QVector<int16_t> &samples)
+{
+    if (!m_socket || m_finishing || samples.isEmpty()) return;
+
+    const QByteArray bytes(reinterpret_cast<const char *>(samples.constData()),
+                           samples.size() * int(sizeof(int16_t)));
+#if HAS_WEB_SOCKETS
+    if (m_connected) {
+        m_socket->sendBinaryMessage(bytes);
+        return;
+    }
+#endif
+    m_pending.append(bytes);
+}
+
+void StreamingSTT::finish()
+{
+    if (!m_socket || m_finishing) return;
+    m_finishing = true;
+
+#if HAS_WEB_SOCKETS
+    // Still connecting: onConnected() flushes the audio, then ends it
+    if (m_connected)
+        m_socket->sendTextMessage(QStringLiteral("{\"audioEnd\":true}"));
+#endif
+}
+
+void StreamingSTT::cancel()
+{
+    closeSocket();
+}
+
+void StreamingSTT::closeSocket()
+{
+#if HAS_WEB_SOCKETS
+    if (m_socket) {
+        disconnect(m_socket, nullptr, this, nullptr);
+        m_socket->abort();
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+#endif
+    m_pending.clear();
+    m_connected = false;
+    m_finishing = false;
+    m_gotFinal = false;
+}
+
+// ========================================================================
+// SOCKET HANDLING
+// ========================================================================
+
+void StreamingSTT::onConnected()
+{
+#if HAS_WEB_SOCKETS
+    m_connected = true;
+    sendConfig();
+
+    if (!m_pending.isEmpty()) {
+        qDebug() << "StreamingSTT: Connected, sending" << m_pending.size() << "queued bytes";
+        m_socket->sendBinaryMessage(m_pending);
+        m_pending.clear();
+    }
+    if (m_finishing)
+        m_socket->sendTextMessage(QStringLiteral("{\"audioEnd\":true}"));
+#endif
+}
+
+void StreamingSTT::sendConfig()
+{
+#if HAS_WEB_SOCKETS
+    // Same RecognitionConfig as GoogleSTT's batch request
+    QJsonObject config;
+    config["encoding"] = "LINEAR16";
+    config["sampleRateHertz"] = m_sampleRate;
+    config["languageCode"] = m_languageCode;
+    config["enableAutomaticPunctuation"] = true;
+    config["model"] = "latest_short";
+    config["useEnhanced"] = true;
+
+    QJsonObject metadata;
+    metadata["interactionType"] = "VOICE_COMMAND";
+    metadata["microphoneDistance"] = "NEARFIELD";
+    metadata["recordingDeviceType"] = "VEHICLE";
+    config["metadata"] = metadata;
+
+    if (!m_speechContextHints.isEmpty()) {
+        QJsonArray phrases;
+        const int maxHints = qMin(m_speechContextHints.size(), 500);
+        for (int i = 0; i < maxHints; ++i) {
+            phrases.append(m_speechContextHints[i]);
+        }
+
+        QJsonObject speechContext;
+        speechContext["phrases"] = phrases;
+        speechContext["boost"] = 20;
+        config["speechContexts"] = QJsonArray{ speechContext };
+    }
+
+    // One utterance per stream: the recognizer endpoints it and stops
+    QJsonObject streamingConfig;
+    streamingConfig["config"] = config;
+    streamingConfig["interimResults"] = true;
+    streamingConfig["singleUtterance"] = true;
+
+    QJsonObject request;
+    request["streamingConfig"] = streamingConfig;
+    m_socket->sendTextMessage(QString::fromUtf8(QJsonDocument(request).toJson(QJsonDocument::Compact)));
+#endif
+}
+
+void StreamingSTT::onTextMessage(const QString &message)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8());
+    if (!doc.isObject()) {
+        qWarning() << "StreamingSTT: Ignoring invalid message:" << message.left(200);
+        return;
+    }
+    const QJsonObject json = doc.object();
+
+    if (json.contains("error")) {
+        const QString errorMessage = json["error"].toObject()["message"].toString();
+        qWarning() << "StreamingSTT: API error:" << errorMessage;
+        closeSocket();
+        emit error("API error: " + errorMessage);
+        return;
+    }
+
+    if (json["speechEventType"].toString() == QLatin1String("END_OF_SINGLE_UTTERANCE")) {
+        qDebug() << "StreamingSTT: End of speech";
+        emit endOfSpeech();
+    }
+
+    // Interim responses split the hypothesis into a stable head and an
+    // unstable tail; together they are the current guess
+    QString interim;
+    float stability = 0.0f;
+    const QJsonArray results = json["results"].toArray();
+    for (const QJsonValue &value : results) {
+        const QJsonObject result = value.toObject();
+        const QJsonArray alternatives = result["alternatives"].toArray();
+        if (alternatives.isEmpty()) continue;   // A result may carry no hypothesis
+        const QJsonObject alternative = alternatives.first().toObject();
+        const QString transcript = alternative["transcript"].toString();
+
+        if (result["isFinal"].toBool()) {
+            m_gotFinal = true;
+            const float confidence = float(alternative["confidence"].toDouble());
+            qDebug() << "StreamingSTT: Final:" << transcript << "confidence:" << confidence;
+            emit finalResult(transcript.trimmed(), confidence);
+            return;
+        }
+        if (interim.isEmpty()) stability = float(result["stability"].toDouble());
+        interim += transcript;
+    }
+
+    if (!interim.isEmpty()) emit interimResult(interim.trimmed(), stability);
+}
+
+void StreamingSTT::onDisconnected()
+{
+    // A single-utterance stream ends itself after its final result
+    const bool complete = m_finishing || m_gotFinal;
+    closeSocket();
+    if (complete) {
+        emit finished();
+    } else {
+        qWarning() << "StreamingSTT: Stream closed before a result";
+        emit error("Stream closed by server");
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef STREAMINGSTT_H
+#define STREAMINGSTT_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QUrl>
+#include <QVector>
+
+// WebSockets is optional - streaming is disabled without it
+#if __has_include(<QtWebSockets/QWebSocket>)
+#define HAS_WEB_SOCKETS 1
+#else
+#define HAS_WEB_SOCKETS 0
+#endif
+
+class QWebSocket;
+
+/**
+ * StreamingSTT - speech recognition while the user is still talking
+ *
+ * Audio goes up in small chunks as it is captured, and the recognizer
+ * answers with interim hypotheses, an end-of-speech event and the final
+ * transcript. Compared with GoogleSTT (one POST once the utterance is
+ * over), recognition overlaps the speech, and the recognizer's own
+ * endpointing can end the utterance instead of a fixed silence timer.
+ *
+ * Google only streams over gRPC, so this speaks a thin WebSocket protocol
+ * that a bridge to StreamingRecognize (or any other streaming recognizer)
+ * can serve; tools/mock_stt_server.py implements it for testing:
+ *
+ *   -> text    {"streamingConfig": {"config": {...}, "interimResults": true,
+ *                                   "singleUtterance": true}}
+ *   -> binary  LINEAR16 mono audio, any number of frames
+ *   -> text    {"audioEnd": true}
+ *   <- text    StreamingRecognizeResponse JSON: {"results": [{"alternatives":
+ *              [{"transcript", "confidence"}], "isFinal", "stability"}],
+ *              "speechEventType": "END_OF_SINGLE_UTTERANCE"} or {"error": {...}}
+ *
+ * The server closes the socket once the final result is sent. Each
+ * begin() opens a fresh connection; audio sent before it is up is queued.
+ *
+ * Usage:
+ *   stt->setEndpoint(QUrl("ws://127.0.0.1:8765/"));
+ *   stt->begin(16000);
+ *   stt->sendAudio(chunk);   // repeatedly
+ *   stt->finish();           // finalResult() then finished()
+ */
+class StreamingSTT : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StreamingSTT(QObject *parent = nullptr);
+    ~StreamingSTT();
+
+    static bool isSupported() { return HAS_WEB_SOCKETS; }
+    bool isConfigured() const { return isSupported() && m_endpoint.isValid(); }
+    bool isActive() const { return m_socket != nullptr; }
+
+    void setEndpoint(const QUrl &url);
+    void setLanguageCode(const QString &languageCode);
+    void setSpeechContextHints(const QStringList &phrases);
+
+    // Opens a stream, dropping any previous one
+    void begin(int sampleRate);
+    void sendAudio(const QVector<int16_t> &samples);
+    // No more audio; the final result follows
+    void finish();
+    // Closes the stream; nothing more is emitted for it
+    void cancel();
+
+signals:
+    // Best guess so far; stability 0..1 as reported by the recognizer
+    void interimResult(const QString &text, float stability);
+    // The recognizer heard the speaker stop
+    void endOfSpeech();
+    void finalResult(const QString &text, float confidence);
+    // The server closed the stream after finish(), all results delivered
+    void finished();
+    void error(const QString &message);
+
+private:
+    void onConnected();
+    void onDisconnected();
+    void onTextMessage(const QString &message);
+    void sendConfig();
+    void closeSocket();
+
+    QWebSocket *m_socket = nullptr;
+    QByteArray m_pending;           // Audio sent before the socket is up
+    bool m_connected = false;
+    bool m_finishing = false;
+    bool m_gotFinal = false;
+    int m_sampleRate = 16000;
+
+    // Configuration
+    QUrl m_endpoint;
+    QString m_languageCode;
+    QStringList m_speechContextHints;
+};
+
+#endif // STREAMINGSTT_H
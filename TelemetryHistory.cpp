@@ -0,0 +1,215 @@
+#include "TelemetryHistory.h"
+#include <QLatin1String>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+struct ChannelInfo {
+    const char *name;
+    uint32_t group;  // VehicleGroup that carries this channel
+    double (*value)(const VehicleState &s);
+};
+
+const ChannelInfo kChannelInfo[] = {
+    { "rpm",            VehGroupTelemetry, [](const VehicleState &s) -> double { return s.rpm; } },
+    { "tps",            VehGroupTelemetry, [](const VehicleState &s) -> double { return s.tps; } },
+    { "mapKpa",         VehGroupTelemetry, [](const VehicleState &s) -> double { return s.mapKpa; } },
+    { "timing",         VehGroupTelemetry | VehGroupIgnition, [](const VehicleState &s) -> double { return s.timing; } },
+    { "coolantTemp",    VehGroupTelemetry, [](const VehicleState &s) -> double { return s.coolantTemp; } },
+    { "iatTemp",        VehGroupTelemetry, [](const VehicleState &s) -> double { return s.iatTemp; } },
+    { "batteryVoltage", VehGroupTelemetry, [](const VehicleState &s) -> double { return s.batteryVoltage; } },
+    { "oilPressureKpa", VehGroupPressures, [](const VehicleState &s) -> double { return s.oilPressureKpa; } },
+    { "fuelPressureKpa", VehGroupPressures, [](const VehicleState &s) -> double { return s.fuelPressureKpa; } },
+    { "lambdaB1",       VehGroupFuel, [](const VehicleState &s) -> double { return s.lambdaB1; } },
+    { "lambdaB2",       VehGroupFuel, [](const VehicleState &s) -> double { return s.lambdaB2; } },
+    { "lambdaTarget",   VehGroupFuel, [](const VehicleState &s) -> double { return s.lambdaTarget; } },
+    { "stft",           VehGroupFuel, [](const VehicleState &s) -> double { return s.stft; } },
+    { "ltft",           VehGroupFuel, [](const VehicleState &s) -> double { return s.ltft; } },
+    { "injectorDuty",   VehGroupFuel, [](const VehicleState &s) -> double { return s.injectorDuty; } },
+    { "knockRetard",    VehGroupIgnition, [](const VehicleState &s) -> double { return s.knockRetard; } },
+    { "knockB1",        VehGroupIgnition, [](const VehicleState &s) -> double { return s.knockB1; } },
+    { "knockB2",        VehGroupIgnition, [](const VehicleState &s) -> double { return s.knockB2; } },
+};
+
+static_assert(sizeof(kChannelInfo) / sizeof(kChannelInfo[0]) == static_cast<size_t>(TelemetryChannel::Count),
+              "kChannelInfo must list every TelemetryChannel");
+
+} // namespace
+
+// ============================================================================
+// TelemetryRing
+// ============================================================================
+
+uint64_t TelemetryRing::pack(uint32_t timeMs, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (static_cast<uint64_t>(timeMs) << 32) | bits;
+}
+
+float TelemetryRing::valueOf(uint64_t slot)
+{
+    uint32_t bits = static_cast<uint32_t>(slot);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void TelemetryRing::push(uint32_t timeMs, float value)
+{
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    m_slots[head & (kCapacity - 1)].store(pack(timeMs, value), std::memory_order_relaxed);
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void TelemetryRing::clear()
+{
+    m_head.store(0, std::memory_order_release);
+}
+
+uint32_t TelemetryRing::latestMs() const
+{
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    if (head == 0) return 0;
+    return timeOf(m_slots[(head - 1) & (kCapacity - 1)].load(std::memory_order_relaxed));
+}
+
+QVector<QPointF> TelemetryRing::query(uint32_t endMs, uint32_t windowMs, int buckets) const
+{
+    QVector<QPointF> points;
+    if (buckets <= 0 || windowMs == 0) return points;
+
+    const uint32_t startMs = endMs > windowMs ? endMs - windowMs : 0;
+
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        if (head == 0) return points;
+        const uint64_t oldest = head > kCapacity ? head - kCapacity : 0;
+
+        auto slotAt = [this](uint64_t index) {
+            return m_slots[index & (kCapacity - 1)].load(std::memory_order_relaxed);
+        };
+
+        // Timestamps are monotonic — binary search for the first sample in the window
+        uint64_t lo = oldest, hi = head;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (timeOf(slotAt(mid)) <= startMs) lo = mid + 1;
+            else hi = mid;
+        }
+        const uint64_t first = lo;
+
+        points.clear();
+        points.reserve(qMin<qint64>(static_cast<qint64>(head - first), buckets * 2));
+
+        const double bucketMs = static_cast<double>(windowMs) / buckets;
+        int currentBucket = -1;
+        uint64_t minSlot = 0, maxSlot = 0;
+
+        auto emitBucket = [&]() {
+            if (currentBucket < 0) return;
+            // Keep the pair in time order so the trace doesn't zig-zag backwards
+            uint64_t a = minSlot, b = maxSlot;
+            if (timeOf(a) > timeOf(b)) std::swap(a, b);
+            points.append(QPointF((static_cast<double>(timeOf(a)) - endMs) / 1000.0, valueOf(a)));
+            if (a != b)
+                points.append(QPointF((static_cast<double>(timeOf(b)) - endMs) / 1000.0, valueOf(b)));
+        };
+
+        for (uint64_t i = first; i < head; ++i) {
+            const uint64_t slot = slotAt(i);
+            const uint32_t t = timeOf(slot);
+            if (t > endMs) break;
+
+            int bucket = qMin(buckets - 1, static_cast<int>((t - startMs) / bucketMs));
+            if (bucket != currentBucket) {
+                emitBucket();
+                currentBucket = bucket;
+                minSlot = maxSlot = slot;
+                continue;
+            }
+            if (valueOf(slot) < valueOf(minSlot)) minSlot = slot;
+            if (valueOf(slot) > valueOf(maxSlot)) maxSlot = slot;
+        }
+        emitBucket();
+
+        // If the producer lapped the part we scanned, those slots may hold
+        // newer samples — scan again from a fresh head
+        const uint64_t headAfter = m_head.load(std::memory_order_acquire);
+        if (headAfter <= kCapacity || headAfter - kCapacity <= first)
+            return points;
+    }
+
+    return points;
+}
+
+// ============================================================================
+// TelemetryHistory
+// ============================================================================
+
+TelemetryHistory::TelemetryHistory()
+{
+    m_clock.start();
+}
+
+void TelemetryHistory::record(const VehicleState &state, uint32_t groups, uint32_t timeMs)
+{
+    for (int i = 0; i < channelCount(); ++i) {
+        if (!(kChannelInfo[i].group & groups)) continue;
+
+        const float value = static_cast<float>(kChannelInfo[i].value(state));
+        LastSample &last = m_last[i];
+        if (last.valid && value == last.value && timeMs - last.timeMs < kHeartbeatMs) continue;
+
+        m_rings[i].push(timeMs, value);
+        last = { true, value, timeMs };
+    }
+}
+
+void TelemetryHistory::clear()
+{
+    for (TelemetryRing &ring : m_rings)
+        ring.clear();
+    m_last.fill(LastSample());
+}
+
+QVector<QPointF> TelemetryHistory::query(TelemetryChannel channel, double seconds, int buckets) const
+{
+    const int index = static_cast<int>(channel);
+    if (index < 0 || index >= channelCount() || seconds <= 0.0) return {};
+
+    const TelemetryRing &ring = m_rings[index];
+    const double windowMs = qMin(seconds * 1000.0, static_cast<double>(std::numeric_limits<uint32_t>::max()));
+    return ring.query(ring.latestMs(), static_cast<uint32_t>(windowMs), buckets);
+}
+
+QString TelemetryHistory::channelName(TelemetryChannel channel)
+{
+    const int index = static_cast<int>(channel);
+    if (index < 0 || index >= channelCount()) return QString();
+    return QLatin1String(kChannelInfo[index].name);
+}
+
+uint32_t TelemetryHistory::channelGroups(TelemetryChannel channel)
+{
+    const int index = static_cast<int>(channel);
+    if (index < 0 || index >= channelCount()) return 0;
+    return kChannelInfo[index].group;
+}
+
+double TelemetryHistory::channelValue(TelemetryChannel channel, const VehicleState &state)
+{
+    const int index = static_cast<int>(channel);
+    if (index < 0 || index >= channelCount()) return 0.0;
+    return kChannelInfo[index].value(state);
+}
+
+int TelemetryHistory::channelFromName(const QString &name)
+{
+    for (int i = 0; i < channelCount(); ++i) {
+        if (name == QLatin1String(kChannelInfo[i].name)) return i;
+    }
+    return -1;
+}
@@ -0,0 +1,115 @@
+#ifndef TELEMETRYHISTORY_H
+#define TELEMETRYHISTORY_H
+
+#include <QElapsedTimer>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "VehicleState.h"
+
+// Recorded telemetry channels. Order matches kChannelInfo in the .cpp.
+enum class TelemetryChannel : int {
+    Rpm,
+    Tps,
+    MapKpa,
+    Timing,
+    CoolantTemp,
+    IatTemp,
+    BatteryVoltage,
+    OilPressure,
+    FuelPressure,
+    LambdaB1,
+    LambdaB2,
+    LambdaTarget,
+    Stft,
+    Ltft,
+    InjectorDuty,
+    KnockRetard,
+    KnockB1,
+    KnockB2,
+    Count
+};
+
+// Fixed-capacity single-producer ring of (time, value) samples.
+//
+// The producer never blocks and overwrites the oldest sample when full.
+// Each slot is one 64-bit atomic (uint32 ms timestamp | float value), so a
+// reader can never observe a torn sample; readers detect being lapped by
+// re-checking the head after a scan.
+class TelemetryRing
+{
+public:
+    static constexpr uint32_t kCapacity = 16384;  // >= 160 s at 100 Hz
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of two");
+
+    void push(uint32_t timeMs, float value);
+    void clear();
+
+    // Min/max decimation of the samples in (endMs - windowMs, endMs] into
+    // at most 2 * buckets points, in time order. x is seconds relative to
+    // endMs (so <= 0).
+    QVector<QPointF> query(uint32_t endMs, uint32_t windowMs, int buckets) const;
+
+    // Timestamp of the newest sample, or 0 if empty
+    uint32_t latestMs() const;
+
+private:
+    static uint64_t pack(uint32_t timeMs, float value);
+    static uint32_t timeOf(uint64_t slot) { return static_cast<uint32_t>(slot >> 32); }
+    static float valueOf(uint64_t slot);
+
+    std::array<std::atomic<uint64_t>, kCapacity> m_slots{};
+    std::atomic<uint64_t> m_head{0};  // Total samples ever pushed
+};
+
+// One ring per TelemetryChannel, fed from the decoded VehicleState.
+//
+// A frame updates a group, but usually only some of its channels, so a
+// channel is pushed only when its value changed — or kHeartbeatMs after
+// its last sample, which keeps a steady channel's trace continuous. A
+// ring therefore fills at most at the rate of the frames that actually
+// carry its channel.
+class TelemetryHistory
+{
+public:
+    static constexpr uint32_t kHeartbeatMs = 500;
+
+    TelemetryHistory();
+
+    // Producer side — called on whichever thread decodes frames (the CAN
+    // reader, or the GUI thread during replay; never both at once).
+    void record(const VehicleState &state, uint32_t groups, uint32_t timeMs);
+    uint32_t nowMs() const { return static_cast<uint32_t>(m_clock.elapsed()); }
+
+    // Only while no producer is running (between connect/replay sessions)
+    void clear();
+
+    // Consumer side — any thread. The window ends at the channel's newest
+    // sample so live and replayed logs read the same way.
+    QVector<QPointF> query(TelemetryChannel channel, double seconds, int buckets) const;
+
+    static int channelCount() { return static_cast<int>(TelemetryChannel::Count); }
+    static QString channelName(TelemetryChannel channel);
+    static int channelFromName(const QString &name);  // -1 if unknown
+
+    // VehicleGroup bits that carry a channel, and its value in a state
+    static uint32_t channelGroups(TelemetryChannel channel);
+    static double channelValue(TelemetryChannel channel, const VehicleState &state);
+
+private:
+    struct LastSample {
+        bool valid = false;
+        float value = 0.0f;
+        uint32_t timeMs = 0;
+    };
+
+    std::array<TelemetryRing, static_cast<int>(TelemetryChannel::Count)> m_rings;
+    std::array<LastSample, static_cast<int>(TelemetryChannel::Count)> m_last{};   // Producer-owned
+    QElapsedTimer m_clock;
+};
+
+#endif // TELEMETRYHISTORY_H
@@ -0,0 +1,527 @@
+#include "TelemetryLog.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = { 'H', 'U', 'T', 'L', 'O', 'G', '0', '1' };
+constexpr quint32 kVersion = 1;
+constexpr quint32 kIndexMagic = 0x58444954;    // "TIDX"
+constexpr quint32 kTrailerMagic = 0x444E4554;  // "TEND"
+constexpr int kTrailerSize = 12;
+
+// fdatasync and a retention sweep at most this often
+constexpr int kSyncIntervalMs = 2000;
+constexpr qint64 kRetentionCheckBytes = 4 * 1024 * 1024;
+
+void putVarint(QByteArray &out, uint64_t v)
+{
+    char buf[10];
+    int n = 0;
+    while (v >= 0x80) {
+        buf[n++] = static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = static_cast<char>(v);
+    out.append(buf, n);
+}
+
+bool getVarint(const uchar *&p, const uchar *end, uint64_t &v)
+{
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uchar b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+int64_t quantize(double value)
+{
+    const double q = std::round(value * TelemetryLog::kValueScale);
+    return static_cast<int64_t>(qBound<double>(std::numeric_limits<int32_t>::min(), q,
+                                               std::numeric_limits<int32_t>::max()));
+}
+
+} // namespace
+
+// ============================================================================
+// Retention
+// ============================================================================
+
+QStringList TelemetryLog::sessions(const QString &dir)
+{
+    QStringList result;
+    const QFileInfoList files = QDir(dir).entryInfoList({ QStringLiteral("*") + kSuffix },
+                                                        QDir::Files, QDir::Name);
+    for (const QFileInfo &info : files)
+        result.append(info.absoluteFilePath());
+    return result;  // Names are timestamped, so name order is age order
+}
+
+qint64 TelemetryLog::enforceRetention(const QString &dir, qint64 maxBytes, const QString &keep)
+{
+    const QStringList files = sessions(dir);
+    qint64 total = 0;
+    for (const QString &f : files)
+        total += QFileInfo(f).size();
+
+    qint64 freed = 0;
+    for (const QString &f : files) {
+        if (total <= maxBytes) break;
+        if (f == keep) continue;
+        const qint64 size = QFileInfo(f).size();
+        if (QFile::remove(f)) {
+            total -= size;
+            freed += size;
+            qDebug() << "TelemetryLog: Retention removed" << QFileInfo(f).fileName();
+        }
+    }
+    return freed;
+}
+
+// ============================================================================
+// TelemetryLogWriter
+// ============================================================================
+
+TelemetryLogWriter::TelemetryLogWriter(const QString &dir, qint64 retentionBytes, QObject *parent)
+    : QThread(parent)
+    , m_dir(dir)
+    , m_retentionBytes(retentionBytes)
+{
+}
+
+TelemetryLogWriter::~TelemetryLogWriter()
+{
+    close();
+    wait();
+}
+
+void TelemetryLogWriter::open()
+{
+    if (m_opened || isRunning()) return;
+
+    // Millisecond stamp; the thread adds a suffix if a session of the same
+    // name already exists (a reconnect within the same millisecond, or a
+    // clock stepped back), so nothing is ever overwritten
+    m_baseName = QStringLiteral("session-")
+               + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz");
+
+    for (OpenBlock &block : m_open) {
+        block.header.count = 0;
+        block.payload.clear();
+    }
+    m_index.clear();
+    m_pending.clear();
+    m_path.clear();
+    m_stopping = false;
+    m_sinceRetentionCheck = 0;
+    m_opened = true;
+
+    m_clock.start();
+    start(QThread::LowPriority);
+}
+
+void TelemetryLogWriter::close()
+{
+    if (!m_opened) return;
+    m_opened = false;
+
+    for (int i = 0; i < TelemetryHistory::channelCount(); ++i)
+        seal(i);
+
+    QMutexLocker lock(&m_mutex);
+    m_stopping = true;
+    m_wake.wakeOne();
+}
+
+QString TelemetryLogWriter::path() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_path;
+}
+
+void TelemetryLogWriter::setRetentionBytes(qint64 retentionBytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_retentionBytes = retentionBytes;
+    m_retentionChanged = true;
+    m_wake.wakeOne();
+}
+
+bool TelemetryLogWriter::createFile()
+{
+    if (!QDir().mkpath(m_dir)) {
+        emit failed(QStringLiteral("Cannot create ") + m_dir);
+        return false;
+    }
+
+    // NewOnly: an existing session is never truncated; '_' sorts after the
+    // suffix's '.', so a renamed session still lists after its namesake
+    const QDir dir(m_dir);
+    QString path;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        path = dir.filePath(m_baseName + (attempt ? QStringLiteral("_%1").arg(attempt) : QString())
+                            + TelemetryLog::kSuffix);
+        m_file.setFileName(path);
+        if (m_file.open(QIODevice::WriteOnly | QIODevice::NewOnly)) break;
+        if (!QFile::exists(path)) break;   // Failed for another reason
+    }
+    if (!m_file.isOpen()) {
+        qWarning() << "TelemetryLogWriter: Cannot open" << path << ":" << m_file.errorString();
+        emit failed(QStringLiteral("Cannot open ") + path + QStringLiteral(": ") + m_file.errorString());
+        return false;
+    }
+
+    QByteArray header(kMagic, sizeof(kMagic));
+    char words[8];
+    qToLittleEndian<quint32>(kVersion, words);
+    qToLittleEndian<quint32>(TelemetryHistory::channelCount(), words + 4);
+    header.append(words, sizeof(words));
+    for (int i = 0; i < TelemetryHistory::channelCount(); ++i) {
+        const QByteArray name = TelemetryHistory::channelName(static_cast<TelemetryChannel>(i)).toLatin1();
+        header.append(static_cast<char>(name.size()));
+        header.append(name);
+    }
+    m_file.write(header);
+    m_bytesWritten.store(header.size(), std::memory_order_relaxed);
+
+    qint64 retentionBytes;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_path = path;
+        retentionBytes = m_retentionBytes;
+        m_retentionChanged = false;
+    }
+
+    // Make room before the new session starts growing
+    TelemetryLog::enforceRetention(m_dir, retentionBytes, path);
+    qDebug() << "TelemetryLogWriter: Logging to" << path;
+    return true;
+}
+
+void TelemetryLogWriter::finishFile()
+{
+    // Everything is drained — append the index and trailer
+    const qint64 indexOffset = m_file.pos();
+    QByteArray tail;
+    char words[8];
+    qToLittleEndian<quint32>(kIndexMagic, words);
+    qToLittleEndian<quint32>(m_index.size(), words + 4);
+    tail.append(words, sizeof(words));
+    tail.append(reinterpret_cast<const char *>(m_index.constData()),
+                m_index.size() * static_cast<int>(sizeof(TelemetryLogIndexEntry)));
+    char trailer[kTrailerSize];
+    qToLittleEndian<quint64>(indexOffset, trailer);
+    qToLittleEndian<quint32>(kTrailerMagic, trailer + 8);
+    tail.append(trailer, kTrailerSize);
+    m_file.write(tail);
+    m_file.flush();
+    ::fdatasync(m_file.handle());
+    m_file.close();
+
+    qDebug() << "TelemetryLogWriter: Closed" << m_file.fileName() << "-" << m_file.size() << "bytes,"
+             << m_index.size() << "blocks";
+}
+
+void TelemetryLogWriter::record(const VehicleState &state, uint32_t groups, uint32_t timeMs)
+{
+    for (int i = 0; i < TelemetryHistory::channelCount(); ++i) {
+        const auto channel = static_cast<TelemetryChannel>(i);
+        if (TelemetryHistory::channelGroups(channel) & groups)
+            append(i, timeMs, TelemetryHistory::channelValue(channel, state));
+    }
+}
+
+void TelemetryLogWriter::append(int channel, uint32_t timeMs, double value)
+{
+    OpenBlock &block = m_open[channel];
+    const int64_t q = quantize(value);
+    const float f = static_cast<float>(value);
+
+    // Same rule as TelemetryHistory: unchanged values only as a heartbeat
+    if (block.header.count > 0 && q == block.lastValue
+        && timeMs - block.lastMs < TelemetryHistory::kHeartbeatMs)
+        return;
+
+    if (block.header.count == 0) {
+        block.header.magic = TelemetryLogBlock::kMagic;
+        block.header.channel = static_cast<uint16_t>(channel);
+        block.header.firstMs = timeMs;
+        block.header.minValue = block.header.maxValue = f;
+        block.header.firstValue = static_cast<int32_t>(q);
+        block.lastMs = timeMs;
+        block.payload.reserve(4096);
+    } else {
+        putVarint(block.payload, timeMs > block.lastMs ? timeMs - block.lastMs : 0);
+        putVarint(block.payload, zigzag(q - block.lastValue));
+        block.header.minValue = qMin(block.header.minValue, f);
+        block.header.maxValue = qMax(block.header.maxValue, f);
+    }
+    block.header.lastMs = qMax(timeMs, block.lastMs);
+    block.lastMs = block.header.lastMs;
+    block.lastValue = q;
+    ++block.header.count;
+
+    if (block.header.count >= kBlockSamples || block.lastMs - block.header.firstMs >= kBlockSpanMs)
+        seal(channel);
+}
+
+void TelemetryLogWriter::seal(int channel)
+{
+    OpenBlock &block = m_open[channel];
+    if (block.header.count == 0) return;
+
+    block.header.payloadBytes = static_cast<uint32_t>(block.payload.size());
+    QByteArray sealed(reinterpret_cast<const char *>(&block.header), sizeof(TelemetryLogBlock));
+    sealed.append(block.payload);
+
+    block.header.count = 0;
+    block.payload = QByteArray();
+
+    QMutexLocker lock(&m_mutex);
+    m_pending.append(std::move(sealed));
+    m_wake.wakeOne();
+}
+
+void TelemetryLogWriter::run()
+{
+    if (!createFile()) return;
+
+    QElapsedTimer sinceSync;
+    sinceSync.start();
+
+    for (;;) {
+        QVector<QByteArray> blocks;
+        bool stopping;
+        bool retentionChanged;
+        qint64 retentionBytes;
+        QString keep;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (m_pending.isEmpty() && !m_stopping && !m_retentionChanged)
+                m_wake.wait(&m_mutex, kSyncIntervalMs);
+            blocks.swap(m_pending);
+            stopping = m_stopping;
+            retentionChanged = m_retentionChanged;
+            m_retentionChanged = false;
+            retentionBytes = m_retentionBytes;
+            keep = m_path;
+        }
+
+        writePending(blocks);
+
+        if (sinceSync.elapsed() >= kSyncIntervalMs) {
+            m_file.flush();
+            ::fdatasync(m_file.handle());
+            sinceSync.restart();
+        }
+        if (retentionChanged || m_sinceRetentionCheck >= kRetentionCheckBytes) {
+            m_sinceRetentionCheck = 0;
+            TelemetryLog::enforceRetention(m_dir, retentionBytes, keep);
+        }
+
+        if (stopping) {
+            QMutexLocker lock(&m_mutex);
+            if (m_pending.isEmpty()) break;
+        }
+    }
+
+    finishFile();
+}
+
+void TelemetryLogWriter::writePending(QVector<QByteArray> &blocks)
+{
+    for (const QByteArray &block : std::as_const(blocks)) {
+        TelemetryLogBlock header;
+        memcpy(&header, block.constData(), sizeof(header));
+
+        TelemetryLogIndexEntry entry;
+        entry.channel = header.channel;
+        entry.reserved = 0;
+        entry.firstMs = header.firstMs;
+        entry.lastMs = header.lastMs;
+        entry.offset = static_cast<uint64_t>(m_file.pos());
+
+        if (m_file.write(block) != block.size()) {
+            qWarning() << "TelemetryLogWriter: Write failed:" << m_file.errorString();
+            continue;
+        }
+        m_index.append(entry);
+        m_sinceRetentionCheck += block.size();
+        m_bytesWritten.fetch_add(block.size(), std::memory_order_relaxed);
+    }
+}
+
+// ============================================================================
+// TelemetryLogReader
+// ============================================================================
+
+bool TelemetryLogReader::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "TelemetryLogReader: Cannot open" << path << ":" << m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data || m_size < 16 || memcmp(m_data, kMagic, sizeof(kMagic)) != 0) {
+        qWarning() << "TelemetryLogReader:" << path << "is not a telemetry log";
+        close();
+        return false;
+    }
+
+    // Channel table
+    const quint32 channelCount = qFromLittleEndian<quint32>(m_data + 12);
+    qint64 offset = 16;
+    for (quint32 i = 0; i < channelCount; ++i) {
+        if (offset >= m_size) { close(); return false; }
+        const int len = m_data[offset++];
+        if (offset + len > m_size) { close(); return false; }
+        m_channelNames.append(QString::fromLatin1(reinterpret_cast<const char *>(m_data + offset), len));
+        offset += len;
+    }
+    m_blocks.resize(channelCount);
+
+    if (!loadIndex(offset)) {
+        qDebug() << "TelemetryLogReader: No index in" << QFileInfo(path).fileName() << "- scanning blocks";
+        scanBlocks(offset);
+    }
+
+    for (QVector<BlockRef> &refs : m_blocks) {
+        std::sort(refs.begin(), refs.end(), [](const BlockRef &a, const BlockRef &b) { return a.firstMs < b.firstMs; });
+        if (!refs.isEmpty()) m_durationMs = qMax(m_durationMs, refs.last().lastMs);
+    }
+    return true;
+}
+
+void TelemetryLogReader::close()
+{
+    if (m_data) m_file.unmap(const_cast<uchar *>(m_data));
+    m_data = nullptr;
+    m_size = 0;
+    if (m_file.isOpen()) m_file.close();
+    m_channelNames.clear();
+    m_blocks.clear();
+    m_durationMs = 0;
+}
+
+const TelemetryLogBlock *TelemetryLogReader::blockAt(qint64 offset) const
+{
+    if (offset < 0 || offset + static_cast<qint64>(sizeof(TelemetryLogBlock)) > m_size) return nullptr;
+    auto block = reinterpret_cast<const TelemetryLogBlock *>(m_data + offset);
+    if (block->magic != TelemetryLogBlock::kMagic || block->count == 0) return nullptr;
+    if (offset + static_cast<qint64>(sizeof(TelemetryLogBlock)) + block->payloadBytes > m_size) return nullptr;
+    return block;
+}
+
+bool TelemetryLogReader::loadIndex(qint64 dataStart)
+{
+    if (m_size < dataStart + kTrailerSize) return false;
+    const uchar *trailer = m_data + m_size - kTrailerSize;
+    if (qFromLittleEndian<quint32>(trailer + 8) != kTrailerMagic) return false;
+
+    const qint64 indexOffset = static_cast<qint64>(qFromLittleEndian<quint64>(trailer));
+    if (indexOffset < dataStart || indexOffset + 8 > m_size - kTrailerSize) return false;
+    if (qFromLittleEndian<quint32>(m_data + indexOffset) != kIndexMagic) return false;
+
+    const quint32 count = qFromLittleEndian<quint32>(m_data + indexOffset + 4);
+    const qint64 entriesEnd = indexOffset + 8 + qint64(count) * qint64(sizeof(TelemetryLogIndexEntry));
+    if (entriesEnd > m_size - kTrailerSize) return false;
+
+    for (quint32 i = 0; i < count; ++i) {
+        TelemetryLogIndexEntry entry;
+        memcpy(&entry, m_data + indexOffset + 8 + i * sizeof(entry), sizeof(entry));
+        if (entry.channel >= static_cast<uint16_t>(m_blocks.size()) || !blockAt(static_cast<qint64>(entry.offset))) continue;
+        m_blocks[entry.channel].append({ entry.firstMs, entry.lastMs, static_cast<qint64>(entry.offset) });
+    }
+    return true;
+}
+
+void TelemetryLogReader::scanBlocks(qint64 dataStart)
+{
+    qint64 offset = dataStart;
+    while (const TelemetryLogBlock *block = blockAt(offset)) {
+        if (block->channel < static_cast<uint16_t>(m_blocks.size()))
+            m_blocks[block->channel].append({ block->firstMs, block->lastMs, offset });
+        offset += sizeof(TelemetryLogBlock) + block->payloadBytes;
+    }
+}
+
+QVector<QPointF> TelemetryLogReader::query(int channel, uint32_t startMs, uint32_t endMs, int buckets) const
+{
+    QVector<QPointF> points;
+    if (channel < 0 || channel >= m_blocks.size() || buckets <= 0 || endMs <= startMs) return points;
+
+    const QVector<BlockRef> &refs = m_blocks[channel];
+    const double bucketMs = static_cast<double>(endMs - startMs) / buckets;
+    QVector<float> lo(buckets, std::numeric_limits<float>::max());
+    QVector<float> hi(buckets, std::numeric_limits<float>::lowest());
+
+    auto bucketOf = [&](uint32_t t) {
+        return qBound(0, static_cast<int>((t - startMs) / bucketMs), buckets - 1);
+    };
+    auto add = [&](int b, float v) {
+        lo[b] = qMin(lo[b], v);
+        hi[b] = qMax(hi[b], v);
+    };
+
+    // First block that can overlap the window
+    auto it = std::lower_bound(refs.begin(), refs.end(), startMs,
+                               [](const BlockRef &r, uint32_t t) { return r.lastMs < t; });
+
+    for (; it != refs.end() && it->firstMs <= endMs; ++it) {
+        const TelemetryLogBlock *block = blockAt(it->offset);
+        if (!block) continue;
+
+        // Entirely inside the window and inside one bucket — header summary is enough
+        if (block->firstMs >= startMs && block->lastMs <= endMs
+            && bucketOf(block->firstMs) == bucketOf(block->lastMs)) {
+            const int b = bucketOf(block->firstMs);
+            add(b, block->minValue);
+            add(b, block->maxValue);
+            continue;
+        }
+
+        const uchar *p = reinterpret_cast<const uchar *>(block + 1);
+        const uchar *end = p + block->payloadBytes;
+        uint32_t t = block->firstMs;
+        int64_t q = block->firstValue;
+        for (int i = 0; i < block->count; ++i) {
+            if (i > 0) {
+                uint64_t dt, dv;
+                if (!getVarint(p, end, dt) || !getVarint(p, end, dv)) break;
+                t += static_cast<uint32_t>(dt);
+                q += unzigzag(dv);
+            }
+            if (t < startMs) continue;
+            if (t > endMs) break;
+            add(bucketOf(t), static_cast<float>(q / TelemetryLog::kValueScale));
+        }
+    }
+
+    points.reserve(buckets * 2);
+    for (int b = 0; b < buckets; ++b) {
+        if (lo[b] > hi[b]) continue;
+        const double x = (startMs + (b + 0.5) * bucketMs) / 1000.0;
+        points.append(QPointF(x, lo[b]));
+        if (hi[b] != lo[b]) points.append(QPointF(x, hi[b]));
+    }
+    return points;
+}
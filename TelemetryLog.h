@@ -0,0 +1,193 @@
+#ifndef TELEMETRYLOG_H
+#define TELEMETRYLOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "TelemetryHistory.h"
+
+// Persistent telemetry session log — columnar, append-only.
+//
+// Layout (little-endian):
+//   header:  "HUTLOG01" (8 bytes), uint32 version, uint32 channel count,
+//            then per channel: uint8 name length, name bytes
+//   block:   TelemetryLogBlock header + payload, one channel per block.
+//            The first sample lives in the header; each later sample is a
+//            varint time delta (ms) and a zigzag varint value delta, with
+//            values quantized to 1/kValueScale.
+//   index:   written on close — "TIDX", uint32 count, TelemetryLogIndexEntry[]
+//   trailer: uint64 index offset, "TEND"
+//
+// A session cut short by a power loss has no index; the reader rebuilds it
+// by walking blocks and stops at the first truncated one.
+
+#pragma pack(push, 1)
+struct TelemetryLogBlock {
+    static constexpr uint32_t kMagic = 0x4B4C4254;  // "TBLK"
+
+    uint32_t magic;
+    uint16_t channel;
+    uint16_t count;
+    uint32_t firstMs;
+    uint32_t lastMs;
+    float minValue;
+    float maxValue;
+    int32_t firstValue;     // Quantized
+    uint32_t payloadBytes;
+};
+
+struct TelemetryLogIndexEntry {
+    uint16_t channel;
+    uint16_t reserved;
+    uint32_t firstMs;
+    uint32_t lastMs;
+    uint64_t offset;        // Of the block header
+};
+#pragma pack(pop)
+
+namespace TelemetryLog {
+
+constexpr double kValueScale = 1000.0;
+constexpr const char *kSuffix = ".hutlog";
+
+// Session files in dir, oldest first
+QStringList sessions(const QString &dir);
+
+// Deletes the oldest sessions until the directory fits in maxBytes. keep
+// (the session being written) is never deleted. Returns bytes freed.
+qint64 enforceRetention(const QString &dir, qint64 maxBytes, const QString &keep = QString());
+
+} // namespace TelemetryLog
+
+// Writer. record() is the producer side and runs on whichever thread
+// decodes frames; it only encodes into per-channel open blocks. Sealed
+// blocks are handed to this thread, which owns the file — creating it,
+// retention, appends, the index on close — so neither the producer nor the
+// GUI thread ever waits on storage.
+class TelemetryLogWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kBlockSamples = 1024;
+    static constexpr uint32_t kBlockSpanMs = 5000;   // Bounds data lost on power cut
+
+    TelemetryLogWriter(const QString &dir, qint64 retentionBytes, QObject *parent = nullptr);
+    ~TelemetryLogWriter() override;
+
+    // Starts the writer thread, which creates a new session file. failed()
+    // is emitted if it can't.
+    void open();
+
+    // Seals open blocks and tells the thread to write the index and finish;
+    // returns without waiting (finished() follows). The producer must be
+    // detached first.
+    void close();
+
+    // Empty until the thread has created the file
+    QString path() const;
+
+    // Deletes old sessions down to retentionBytes, on the writer thread
+    void setRetentionBytes(qint64 retentionBytes);
+
+    // Producer side
+    void record(const VehicleState &state, uint32_t groups, uint32_t timeMs);
+    uint32_t nowMs() const { return static_cast<uint32_t>(m_clock.elapsed()); }
+
+    quint64 bytesWritten() const { return m_bytesWritten.load(std::memory_order_relaxed); }
+
+signals:
+    void failed(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    struct OpenBlock {
+        TelemetryLogBlock header{};
+        QByteArray payload;
+        int64_t lastValue = 0;
+        uint32_t lastMs = 0;
+    };
+
+    void append(int channel, uint32_t timeMs, double value);
+    void seal(int channel);
+    bool createFile();
+    void finishFile();
+    void writePending(QVector<QByteArray> &blocks);
+
+    QString m_dir;
+    QString m_baseName;              // Chosen by open(); the thread makes it unique
+    QElapsedTimer m_clock;
+    bool m_opened = false;           // open() called and close() not yet
+
+    // Producer-owned
+    std::array<OpenBlock, static_cast<int>(TelemetryChannel::Count)> m_open;
+
+    // Handoff
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QVector<QByteArray> m_pending;   // Guarded by m_mutex
+    bool m_stopping = false;         // Guarded by m_mutex
+    QString m_path;                  // Guarded by m_mutex
+    qint64 m_retentionBytes;         // Guarded by m_mutex
+    bool m_retentionChanged = false; // Guarded by m_mutex
+
+    // Writer-thread-owned
+    QFile m_file;
+    QVector<TelemetryLogIndexEntry> m_index;
+    qint64 m_sinceRetentionCheck = 0;
+
+    std::atomic<quint64> m_bytesWritten{0};
+};
+
+// Memory-mapped reader for one session. Seeks by binary search over each
+// channel's blocks and decodes only blocks that straddle a bucket boundary;
+// whole blocks inside one bucket contribute their header min/max.
+class TelemetryLogReader
+{
+public:
+    TelemetryLogReader() = default;
+
+    bool open(const QString &path);
+    void close();
+
+    QString path() const { return m_file.fileName(); }
+    uint32_t durationMs() const { return m_durationMs; }
+    QStringList channels() const { return m_channelNames; }
+    int channelIndex(const QString &name) const { return m_channelNames.indexOf(name); }
+
+    // Min/max per bucket over [startMs, endMs], x in seconds from session start
+    QVector<QPointF> query(int channel, uint32_t startMs, uint32_t endMs, int buckets) const;
+
+private:
+    struct BlockRef {
+        uint32_t firstMs;
+        uint32_t lastMs;
+        qint64 offset;
+    };
+
+    bool loadIndex(qint64 dataStart);
+    void scanBlocks(qint64 dataStart);
+    const TelemetryLogBlock *blockAt(qint64 offset) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    QStringList m_channelNames;
+    QVector<QVector<BlockRef>> m_blocks;   // Per channel, in time order
+    uint32_t m_durationMs = 0;
+};
+
+#endif // TELEMETRYLOG_H
@@ -0,0 +1,372 @@
+#include "TtsAudioCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr quint32 kIndexMagic = 0x54544331;   // "TTC1"
+constexpr quint16 kIndexVersion = 1;
+constexpr int kSaveDelayMs = 5 * 1000;
+constexpr const char *kIndexFile = "index";
+constexpr const char *kEntrySuffix = ".pcmz";
+
+} // namespace
+
+TtsAudioCache::TtsAudioCache(QObject *parent)
+    : QObject(parent)
+    , m_saveTimer(new QTimer(this))
+    , m_writer(new TtsCacheWriter(this))
+{
+    m_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tts";
+    QDir().mkpath(m_dir);
+
+    // Hits only bump counters; one index write covers a whole conversation
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(kSaveDelayMs);
+    connect(m_saveTimer, &QTimer::timeout, this, &TtsAudioCache::save);
+    connect(m_writer, &TtsCacheWriter::written, this, &TtsAudioCache::onWritten);
+
+    load();
+}
+
+TtsAudioCache::~TtsAudioCache()
+{
+    if (m_dirty) save();
+}
+
+QString TtsAudioCache::makeKey(const QString &text, const QString &voice, double rate, double pitch)
+{
+    // Unit separators so ("ab", "c") and ("a", "bc") can't collide
+    QByteArray material = text.toUtf8();
+    material += '\x1f' + voice.toUtf8();
+    material += '\x1f' + QByteArray::number(rate, 'f', 3);
+    material += '\x1f' + QByteArray::number(pitch, 'f', 3);
+    return QString::fromLatin1(QCryptographicHash::hash(material, QCryptographicHash::Sha1).toHex());
+}
+
+// ============================================================================
+// Lookup / store
+// ============================================================================
+
+QByteArray TtsAudioCache::lookup(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return QByteArray();
+
+    QByteArray audio = m_memory.value(key);
+    if (audio.isEmpty()) {
+        audio = readEntry(key);
+        if (audio.isEmpty()) {
+            // File gone or corrupt - forget it so it is synthesized again
+            m_diskBytes -= it->bytes;
+            m_entries.erase(it);
+            QFile::remove(entryFile(key));
+            scheduleSave();
+            return QByteArray();
+        }
+        remember(key, audio);
+    }
+
+    it->lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+    it->hits++;
+    scheduleSave();
+    return audio;
+}
+
+void TtsAudioCache::store(const QString &key, const QString &text, const QByteArray &audio)
+{
+    if (audio.isEmpty()) return;
+
+    // Indexed and playable from memory now; the size on disk is counted
+    // once the writer reports it
+    Entry &entry = m_entries[key];
+    entry.text = text;
+    entry.lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+    m_writing[key]++;
+    remember(key, audio);
+    scheduleSave();
+
+    m_writer->submit(key, entryFile(key), audio);
+}
+
+void TtsAudioCache::onWritten(const QString &key, qint64 bytes)
+{
+    if (--m_writing[key] <= 0) m_writing.remove(key);
+
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return;
+
+    if (bytes < 0) {
+        m_diskBytes -= it->bytes;
+        m_entries.erase(it);
+        if (m_memory.contains(key)) m_memoryBytes -= m_memory.take(key).size();
+        scheduleSave();
+        return;
+    }
+
+    m_diskBytes += bytes - it->bytes;
+    it->bytes = bytes;
+
+    qDebug() << "TtsAudioCache: Stored" << it->text.left(40) << "-" << m_memory.value(key).size() << "->"
+             << bytes << "bytes," << m_entries.size() << "entries";
+
+    evict();
+    scheduleSave();
+}
+
+bool TtsAudioCache::preload(const QString &key)
+{
+    if (!m_entries.contains(key)) return false;
+    if (m_memory.contains(key)) return true;
+
+    const QByteArray audio = readEntry(key);
+    if (audio.isEmpty()) return false;
+    remember(key, audio);
+    return true;
+}
+
+QStringList TtsAudioCache::mostUsed(int count) const
+{
+    // The same text may be cached in several voices; count its hits once
+    QHash<QString, quint32> hitsByText;
+    for (const Entry &entry : m_entries) {
+        if (entry.hits > 0) hitsByText[entry.text] += entry.hits;
+    }
+
+    QList<QPair<quint32, QString>> ranked;
+    ranked.reserve(hitsByText.size());
+    for (auto it = hitsByText.cbegin(); it != hitsByText.cend(); ++it)
+        ranked.append({ it.value(), it.key() });
+    std::sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+        return a.first > b.first;
+    });
+
+    QStringList texts;
+    for (int i = 0; i < ranked.size() && i < count; ++i)
+        texts.append(ranked[i].second);
+    return texts;
+}
+
+void TtsAudioCache::setMaxBytes(qint64 maxBytes)
+{
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+// ============================================================================
+// Storage
+// ============================================================================
+
+QString TtsAudioCache::entryFile(const QString &key) const
+{
+    return m_dir + '/' + key + kEntrySuffix;
+}
+
+QByteArray TtsAudioCache::readEntry(const QString &key) const
+{
+    QFile file(entryFile(key));
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return qUncompress(file.readAll());
+}
+
+void TtsAudioCache::remember(const QString &key, const QByteArray &audio)
+{
+    m_memoryBytes += audio.size() - m_memory.value(key).size();
+    m_memory.insert(key, audio);
+    trimMemory();
+}
+
+void TtsAudioCache::trimMemory()
+{
+    while (m_memoryBytes > kMemoryBytes && m_memory.size() > 1) {
+        // Least recently used of what is held in memory
+        auto victim = m_memory.end();
+        qint64 oldest = std::numeric_limits<qint64>::max();
+        for (auto it = m_memory.begin(); it != m_memory.end(); ++it) {
+            if (m_writing.contains(it.key())) continue;   // Not on disk yet
+            const qint64 used = m_entries.value(it.key()).lastUsedMs;
+            if (used < oldest) {
+                oldest = used;
+                victim = it;
+            }
+        }
+        if (victim == m_memory.end()) break;
+        m_memoryBytes -= victim->size();
+        m_memory.erase(victim);
+    }
+}
+
+void TtsAudioCache::evict()
+{
+    if (m_diskBytes <= m_maxBytes) return;
+
+    QList<QPair<qint64, QString>> byAge;
+    byAge.reserve(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+        byAge.append({ it->lastUsedMs, it.key() });
+    std::sort(byAge.begin(), byAge.end());
+
+    int removed = 0;
+    for (const auto &aged : byAge) {
+        if (m_diskBytes <= m_maxBytes) break;
+        const QString &key = aged.second;
+        if (m_writing.contains(key)) continue;
+        m_diskBytes -= m_entries.value(key).bytes;
+        m_entries.remove(key);
+        if (m_memory.contains(key)) m_memoryBytes -= m_memory.take(key).size();
+        QFile::remove(entryFile(key));
+        removed++;
+    }
+
+    qDebug() << "TtsAudioCache: Evicted" << removed << "entries, now" << m_diskBytes << "bytes";
+    scheduleSave();
+}
+
+void TtsAudioCache::scheduleSave()
+{
+    m_dirty = true;
+    if (!m_saveTimer->isActive()) m_saveTimer->start();
+}
+
+void TtsAudioCache::load()
+{
+    m_entries.clear();
+    m_memory.clear();
+    m_memoryBytes = 0;
+    m_diskBytes = 0;
+
+    QFile file(m_dir + '/' + kIndexFile);
+    if (file.open(QIODevice::ReadOnly)) {
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_6_2);
+        quint32 magic = 0;
+        quint16 version = 0;
+        in >> magic >> version;
+        if (magic == kIndexMagic && version == kIndexVersion) {
+            int count = 0;
+            in >> count;
+            for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+                QString key;
+                Entry entry;
+                in >> key >> entry.text >> entry.bytes >> entry.lastUsedMs >> entry.hits;
+                if (in.status() == QDataStream::Ok) m_entries.insert(key, entry);
+            }
+        } else {
+            qWarning() << "TtsAudioCache: Ignoring index with unknown format";
+        }
+    }
+
+    // Reconcile with what is actually on disk: entries whose file is gone
+    // are dropped, files the index doesn't know (written just before a
+    // power cut) are deleted
+    const QDir dir(m_dir);
+    const QStringList files = dir.entryList({ QStringLiteral("*") + kEntrySuffix }, QDir::Files);
+    QHash<QString, qint64> onDisk;
+    for (const QString &name : files) {
+        const QString key = name.chopped(int(qstrlen(kEntrySuffix)));
+        if (m_entries.contains(key)) {
+            onDisk.insert(key, QFileInfo(dir.filePath(name)).size());
+        } else {
+            dir.remove(name);
+        }
+    }
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (!onDisk.contains(it.key())) {
+            it = m_entries.erase(it);
+            continue;
+        }
+        it->bytes = onDisk.value(it.key());
+        m_diskBytes += it->bytes;
+        ++it;
+    }
+
+    qDebug() << "TtsAudioCache:" << m_entries.size() << "entries," << m_diskBytes << "bytes in" << m_dir;
+    evict();
+}
+
+void TtsAudioCache::save()
+{
+    m_saveTimer->stop();
+
+    QSaveFile file(m_dir + '/' + kIndexFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "TtsAudioCache: Failed to save index";
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_2);
+    out << kIndexMagic << kIndexVersion << int(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+        out << it.key() << it->text << it->bytes << it->lastUsedMs << it->hits;
+
+    if (!file.commit()) {
+        qWarning() << "TtsAudioCache: Failed to save index";
+        return;
+    }
+    m_dirty = false;
+}
+
+// ============================================================================
+// TtsCacheWriter
+// ============================================================================
+
+TtsCacheWriter::TtsCacheWriter(QObject *parent)
+    : QThread(parent)
+{
+}
+
+TtsCacheWriter::~TtsCacheWriter()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    wait();
+}
+
+void TtsCacheWriter::submit(const QString &key, const QString &path, const QByteArray &audio)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_tasks.append(Task { key, path, audio });
+        m_wake.wakeOne();
+    }
+    if (!isRunning()) start(QThread::LowPriority);
+}
+
+void TtsCacheWriter::run()
+{
+    forever {
+        Task task;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (m_tasks.isEmpty() && !m_stopping)
+                m_wake.wait(&m_mutex);
+            if (m_tasks.isEmpty()) return;   // Stopping, and nothing left to write
+            task = m_tasks.takeFirst();
+        }
+
+        const QByteArray compressed = qCompress(task.audio);
+
+        // QSaveFile so a power cut mid-write never leaves a truncated clip
+        QSaveFile file(task.path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(compressed) != compressed.size()
+            || !file.commit()) {
+            qWarning() << "TtsAudioCache: Failed to write" << task.path;
+            emit written(task.key, -1);
+            continue;
+        }
+        emit written(task.key, compressed.size());
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef TTSAUDIOCACHE_H
+#define TTSAUDIOCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+
+// Compresses and writes cache entries off the GUI thread, in the order they
+// were submitted. written() reports the bytes on disk, or -1 if the write
+// failed. Queued writes are finished before the thread is destroyed.
+class TtsCacheWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit TtsCacheWriter(QObject *parent = nullptr);
+    ~TtsCacheWriter();
+
+    void submit(const QString &key, const QString &path, const QByteArray &audio);
+
+signals:
+    void written(const QString &key, qint64 bytes);
+
+protected:
+    void run() override;
+
+private:
+    struct Task {
+        QString key;
+        QString path;
+        QByteArray audio;
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QList<Task> m_tasks;
+    bool m_stopping = false;
+};
+
+// Persistent store of synthesized speech, so phrases the head unit says
+// often (the ready prompt, acknowledgements, frequent answers) play
+// straight away instead of after a round trip to the TTS API - including
+// on the first wake word after boot.
+//
+// Entries are content-addressed: the key is a hash of the text and every
+// setting that changes the audio (voice, rate, pitch), so changing the
+// voice never plays stale audio; old entries just age out. Each entry is
+// one zlib-compressed file in the cache directory, and an index records
+// its text, size, last use and hit count. When the directory grows past
+// maxBytes the least recently used entries are deleted. Compression and
+// the file write happen on TtsCacheWriter; until then the entry is served
+// from memory.
+//
+// Recently used and pre-warmed entries are also held decompressed in
+// memory (up to kMemoryBytes), so the common hits cost no disk I/O at all.
+class TtsAudioCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr qint64 kDefaultMaxBytes = 32 * 1024 * 1024;
+    static constexpr qint64 kMemoryBytes = 4 * 1024 * 1024;
+
+    explicit TtsAudioCache(QObject *parent = nullptr);
+    ~TtsAudioCache();
+
+    static QString makeKey(const QString &text, const QString &voice, double rate, double pitch);
+
+    // Audio for key, or empty on a miss. Counts as a use.
+    QByteArray lookup(const QString &key);
+    bool contains(const QString &key) const { return m_entries.contains(key); }
+
+    void store(const QString &key, const QString &text, const QByteArray &audio);
+
+    // Reads an entry into memory ahead of its first use; true if it exists
+    bool preload(const QString &key);
+
+    // Texts with the most hits, across all voices
+    QStringList mostUsed(int count) const;
+
+    void setMaxBytes(qint64 maxBytes);
+    qint64 diskBytes() const { return m_diskBytes; }
+    int size() const { return m_entries.size(); }
+
+    void load();
+    void save();
+
+private:
+    struct Entry {
+        QString text;
+        qint64 bytes = 0;       // On disk, compressed
+        qint64 lastUsedMs = 0;
+        quint32 hits = 0;
+    };
+
+    QString entryFile(const QString &key) const;
+    QByteArray readEntry(const QString &key) const;
+    void remember(const QString &key, const QByteArray &audio);
+    void evict();
+    void trimMemory();
+    void scheduleSave();
+    void onWritten(const QString &key, qint64 bytes);
+
+    QString m_dir;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, QByteArray> m_memory;    // Decompressed, by key
+    qint64 m_memoryBytes = 0;
+    qint64 m_diskBytes = 0;
+    qint64 m_maxBytes = kDefaultMaxBytes;
+    QTimer *m_saveTimer;
+    TtsCacheWriter *m_writer;
+    QHash<QString, int> m_writing;          // Queued writes, by key; held in memory until done
+    bool m_dirty = false;
+};
+
+#endif // TTSAUDIOCACHE_H
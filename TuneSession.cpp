@@ -0,0 +1,344 @@
+#include "TuneSession.h"
+#include "VehicleBusManager.h"
+#include <QDebug>
+#include <QVariantMap>
+#include <cstring>
+
+TuneSession::TuneSession(QObject *parent)
+    : QObject(parent)
+    , m_ackTimer(new QTimer(this))
+{
+    // Window timeout sweep — only runs while patches are in flight
+    m_ackTimer->setInterval(50);
+    connect(m_ackTimer, &QTimer::timeout, this, &TuneSession::onAckTimeout);
+
+    qDebug() << "TuneSession: Initialized";
+}
+
+void TuneSession::setVehicleBusManager(VehicleBusManager *vehicle)
+{
+    if (m_vehicle) disconnect(m_vehicle, nullptr, this, nullptr);
+    m_vehicle = vehicle;
+    if (m_vehicle)
+        connect(m_vehicle, &VehicleBusManager::tuneAckReceived, this, &TuneSession::onTuneAck);
+}
+
+int TuneSession::cellIndex(int tableId, int rpmIdx, int mapIdx)
+{
+    return (tableId * kRpmBins + rpmIdx) * kMapBins + mapIdx;
+}
+
+bool TuneSession::validCell(int tableId, int rpmIdx, int mapIdx)
+{
+    return tableId >= 0 && tableId < kTables
+        && rpmIdx >= 0 && rpmIdx < kRpmBins
+        && mapIdx >= 0 && mapIdx < kMapBins;
+}
+
+// ============================================================================
+// Staging
+// ============================================================================
+
+int TuneSession::stagedCount() const
+{
+    int count = 0;
+    for (int16_t d : m_staged) {
+        if (d != 0) ++count;
+    }
+    return count;
+}
+
+void TuneSession::stageDelta(int tableId, int rpmIdx, int mapIdx, int delta)
+{
+    if (!validCell(tableId, rpmIdx, mapIdx)) {
+        qWarning() << "TuneSession: Cell out of range" << tableId << rpmIdx << mapIdx;
+        return;
+    }
+    int16_t &cell = m_staged[cellIndex(tableId, rpmIdx, mapIdx)];
+    cell = static_cast<int16_t>(qBound(-32768, cell + delta, 32767));
+    emit stagedChanged();
+}
+
+void TuneSession::clearStaged()
+{
+    m_staged.fill(0);
+    emit stagedChanged();
+}
+
+int TuneSession::stagedDelta(int tableId, int rpmIdx, int mapIdx) const
+{
+    if (!validCell(tableId, rpmIdx, mapIdx)) return 0;
+    return m_staged[cellIndex(tableId, rpmIdx, mapIdx)];
+}
+
+QVariantList TuneSession::stagedCells() const
+{
+    QVariantList cells;
+    for (int t = 0; t < kTables; ++t) {
+        for (int rpm = 0; rpm < kRpmBins; ++rpm) {
+            for (int map = 0; map < kMapBins; ++map) {
+                const int16_t delta = m_staged[cellIndex(t, rpm, map)];
+                if (delta == 0) continue;
+                cells.append(QVariantMap {
+                    { "tableId", t }, { "rpmIdx", rpm }, { "mapIdx", map }, { "delta", int(delta) }
+                });
+            }
+        }
+    }
+    return cells;
+}
+
+int TuneSession::committedDelta(int tableId, int rpmIdx, int mapIdx) const
+{
+    if (!validCell(tableId, rpmIdx, mapIdx)) return 0;
+    return m_committed[cellIndex(tableId, rpmIdx, mapIdx)];
+}
+
+// ============================================================================
+// Patch Building
+// ============================================================================
+
+QVector<TuneSession::Patch> TuneSession::buildPatches(int tableId, const int16_t *cells, int maxCells)
+{
+    QVector<Patch> patches;
+    bool covered[kRpmBins * kMapBins] = {};
+
+    auto changed = [&](int rpm, int map) {
+        const int i = rpm * kMapBins + map;
+        return cells[i] != 0 && !covered[i];
+    };
+
+    // Greedy cover: grow a run along the RPM axis, then extend it down the
+    // MAP axis while every cell in the next row is also changed
+    for (int map = 0; map < kMapBins; ++map) {
+        for (int rpm = 0; rpm < kRpmBins; ++rpm) {
+            if (!changed(rpm, map)) continue;
+
+            int width = 1;
+            while (rpm + width < kRpmBins && width < maxCells && changed(rpm + width, map))
+                ++width;
+
+            int height = 1;
+            while (map + height < kMapBins && (height + 1) * width <= maxCells) {
+                bool fullRow = true;
+                for (int r = rpm; r < rpm + width && fullRow; ++r)
+                    fullRow = changed(r, map + height);
+                if (!fullRow) break;
+                ++height;
+            }
+
+            Patch patch;
+            patch.tableId = tableId;
+            patch.rpmIdx = rpm;
+            patch.mapIdx = map;
+            patch.width = width;
+            patch.height = height;
+            for (int h = 0; h < height; ++h) {
+                for (int w = 0; w < width; ++w) {
+                    const int i = (rpm + w) * kMapBins + (map + h);
+                    patch.deltas[h * width + w] = cells[i];
+                    covered[i] = true;
+                }
+            }
+            patches.append(patch);
+        }
+    }
+
+    return patches;
+}
+
+// ============================================================================
+// Transactions
+// ============================================================================
+
+bool TuneSession::commit()
+{
+    if (busy()) {
+        qWarning() << "TuneSession: Transaction already in progress";
+        return false;
+    }
+    if (!m_vehicle || !m_vehicle->ecmOnline()) {
+        emit transactionFailed("ECM offline");
+        return false;
+    }
+
+    m_committedBefore = m_committed;
+    m_transaction = m_staged;
+    m_staged.fill(0);
+    emit stagedChanged();
+
+    return startTransaction(false);
+}
+
+bool TuneSession::startTransaction(bool restore)
+{
+    m_restoring = restore;
+    m_queue.clear();
+    m_transactionCells = 0;
+    // One cell per "patch" when the ECM can only take single-cell deltas
+    const int maxCells = VehicleBusManager::supportsTunePatches() ? TunePatchFrame::kMaxCells : 1;
+    for (int t = 0; t < kTables; ++t) {
+        const QVector<Patch> patches = buildPatches(t, m_transaction.data() + cellIndex(t, 0, 0), maxCells);
+        for (const Patch &p : patches) m_transactionCells += p.width * p.height;
+        m_queue += patches;
+    }
+    m_transactionPatches = m_queue.size();
+    if (m_queue.isEmpty()) return false;
+
+    qDebug() << "TuneSession:" << (restore ? "Restoring" : "Committing") << m_transactionCells
+             << "cells in" << m_transactionPatches << "patches";
+    pump();
+    return true;
+}
+
+void TuneSession::pump()
+{
+    while (m_inFlight.size() < kWindow && !m_queue.isEmpty()) {
+        InFlight entry;
+        entry.patch = m_queue.takeFirst();
+        entry.seq = m_vehicle->nextTuneSeq();
+        transmit(entry, m_queue.isEmpty());
+        m_inFlight.append(entry);
+    }
+    if (!m_inFlight.isEmpty() && !m_ackTimer->isActive()) m_ackTimer->start();
+    emit stateChanged();
+}
+
+void TuneSession::transmit(InFlight &entry, bool last)
+{
+    if (!VehicleBusManager::supportsTunePatches()) {
+        // Retransmits reuse the seq so the ECM can dedupe
+        m_vehicle->sendTuneDelta(entry.patch.tableId, entry.patch.rpmIdx, entry.patch.mapIdx,
+                                 entry.patch.deltas[0], entry.seq);
+        ++entry.attempts;
+        entry.sentAt.start();
+        return;
+    }
+
+    TunePatchFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.table_id = static_cast<uint8_t>(entry.patch.tableId);
+    frame.rpm_idx = static_cast<uint8_t>(entry.patch.rpmIdx);
+    frame.map_idx = static_cast<uint8_t>(entry.patch.mapIdx);
+    frame.width = static_cast<uint8_t>(entry.patch.width);
+    frame.height = static_cast<uint8_t>(entry.patch.height);
+    frame.flags = last ? TunePatchFrame::FlagLast : 0;
+    frame.session_seq = entry.seq;  // Retransmits reuse the seq so the ECM can dedupe
+    const int cells = entry.patch.width * entry.patch.height;
+    memcpy(frame.deltas, entry.patch.deltas, cells * sizeof(int16_t));
+
+    m_vehicle->sendTunePatch(frame, cells);
+    ++entry.attempts;
+    entry.sentAt.start();
+}
+
+void TuneSession::onTuneAck(int tableId, int rpmIdx, int mapIdx, bool accepted, int seq)
+{
+    Q_UNUSED(rpmIdx)
+    Q_UNUSED(mapIdx)
+
+    for (int i = 0; i < m_inFlight.size(); ++i) {
+        const InFlight &entry = m_inFlight[i];
+        if (entry.seq != static_cast<uint16_t>(seq) || entry.patch.tableId != tableId) continue;
+
+        if (!accepted) {
+            failTransaction(QString("ECM rejected patch at RPM %1 / MAP %2")
+                                .arg(entry.patch.rpmIdx).arg(entry.patch.mapIdx));
+            return;
+        }
+
+        // Fold the acknowledged patch into the shadow
+        const Patch &p = entry.patch;
+        for (int h = 0; h < p.height; ++h) {
+            for (int w = 0; w < p.width; ++w) {
+                int16_t &cell = m_committed[cellIndex(p.tableId, p.rpmIdx + w, p.mapIdx + h)];
+                cell = static_cast<int16_t>(cell + p.deltas[h * p.width + w]);
+            }
+        }
+        m_inFlight.removeAt(i);
+
+        if (m_inFlight.isEmpty() && m_queue.isEmpty())
+            finishTransaction();
+        else
+            pump();
+        return;
+    }
+    // Not ours — a per-cell delta ACK or a late duplicate
+}
+
+void TuneSession::onAckTimeout()
+{
+    for (InFlight &entry : m_inFlight) {
+        if (entry.sentAt.elapsed() < kAckTimeoutMs) continue;
+
+        if (entry.attempts >= kMaxAttempts) {
+            failTransaction(QString("No ACK for patch at RPM %1 / MAP %2")
+                                .arg(entry.patch.rpmIdx).arg(entry.patch.mapIdx));
+            return;
+        }
+        qDebug() << "TuneSession: Retransmitting seq" << entry.seq;
+        transmit(entry, m_queue.isEmpty() && &entry == &m_inFlight.last());
+    }
+}
+
+void TuneSession::finishTransaction()
+{
+    m_ackTimer->stop();
+    m_transaction.fill(0);
+
+    if (m_restoring) {
+        m_restoring = false;
+        qDebug() << "TuneSession: Previous tune restored";
+    } else {
+        qDebug() << "TuneSession: Transaction complete";
+        emit transactionCompleted(m_transactionPatches, m_transactionCells);
+    }
+    emit stateChanged();
+}
+
+void TuneSession::failTransaction(const QString &reason)
+{
+    qWarning() << "TuneSession: Transaction failed -" << reason;
+
+    m_ackTimer->stop();
+    m_queue.clear();
+    m_inFlight.clear();
+
+    const bool wasRestoring = m_restoring;
+    m_restoring = false;
+
+    // Part of the transaction may already be applied. Revert the ECM to its
+    // base tune in one frame, then re-stream what was acknowledged before
+    // this transaction so the ECM matches the shadow again.
+    m_vehicle->sendTuneRollback();
+    m_committed.fill(0);
+
+    if (!wasRestoring) {
+        // Hand the failed edits back so the user can retry them
+        for (size_t i = 0; i < m_staged.size(); ++i)
+            m_staged[i] = static_cast<int16_t>(m_staged[i] + m_transaction[i]);
+        emit stagedChanged();
+    }
+    emit transactionFailed(reason);
+
+    // A failed restore leaves the ECM on its base tune
+    m_transaction = wasRestoring ? Table{} : m_committedBefore;
+    if (!startTransaction(true)) {
+        m_transaction.fill(0);
+        emit stateChanged();
+    }
+}
+
+void TuneSession::rollback()
+{
+    m_ackTimer->stop();
+    m_queue.clear();
+    m_inFlight.clear();
+    m_transaction.fill(0);
+    m_committed.fill(0);
+    m_restoring = false;
+
+    if (m_vehicle) m_vehicle->sendTuneRollback();
+    qDebug() << "TuneSession: Rolled back all committed edits";
+    emit stateChanged();
+}
@@ -0,0 +1,140 @@
+#ifndef TUNESESSION_H
+#define TUNESESSION_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVariantList>
+#include <QVector>
+#include <array>
+#include <cstdint>
+
+class VehicleBusManager;
+
+// Packed rectangular tune patch, sent as one CAN FD frame on its own ID
+// (CAN_VEH_HMI_AI_TUNE_PATCH). It never goes out on the tune-delta ID: an
+// ECM that predates patches would take the header for a cell delta and
+// write it into the live table. Without the patch ID in the platform
+// headers, TuneSession sends single-cell deltas instead. Deltas are
+// row-major (rpm fastest), wire units (x10).
+#pragma pack(push, 1)
+struct TunePatchFrame {
+    static constexpr int kMaxCells = 28;
+    static constexpr uint8_t FlagLast = 0x01;  // Final patch of a transaction
+
+    uint8_t table_id;
+    uint8_t rpm_idx;     // Top-left corner
+    uint8_t map_idx;
+    uint8_t width;       // Cells along the RPM axis
+    uint8_t height;      // Cells along the MAP axis
+    uint8_t flags;
+    uint16_t session_seq;
+    int16_t deltas[kMaxCells];
+};
+#pragma pack(pop)
+static_assert(sizeof(TunePatchFrame) == 64, "TunePatchFrame must fill one CAN FD frame");
+
+// Streaming tune editor: keeps a shadow of what the ECM has acknowledged,
+// diffs staged edits into rectangular patches, and streams them with a
+// sliding window of outstanding acknowledgements. A transaction either
+// lands completely or is rolled back as a whole.
+class TuneSession : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool busy READ busy NOTIFY stateChanged)
+    Q_PROPERTY(int stagedCount READ stagedCount NOTIFY stagedChanged)
+    Q_PROPERTY(int inFlight READ inFlight NOTIFY stateChanged)
+    Q_PROPERTY(int queuedPatches READ queuedPatches NOTIFY stateChanged)
+
+public:
+    static constexpr int kTables = 3;     // VE, Ignition, Lambda
+    static constexpr int kRpmBins = 20;
+    static constexpr int kMapBins = 16;
+    static constexpr int kWindow = 4;     // Unacknowledged patches allowed in flight
+    static constexpr int kAckTimeoutMs = 300;
+    static constexpr int kMaxAttempts = 3;
+
+    struct Patch {
+        int tableId = 0;
+        int rpmIdx = 0;
+        int mapIdx = 0;
+        int width = 0;
+        int height = 0;
+        int16_t deltas[TunePatchFrame::kMaxCells] = {};
+    };
+
+    explicit TuneSession(QObject *parent = nullptr);
+
+    void setVehicleBusManager(VehicleBusManager *vehicle);
+
+    bool busy() const { return !m_queue.isEmpty() || !m_inFlight.isEmpty(); }
+    int stagedCount() const;
+    int inFlight() const { return m_inFlight.size(); }
+    int queuedPatches() const { return m_queue.size(); }
+
+    // Accumulates an edit (wire units) for the next commit
+    Q_INVOKABLE void stageDelta(int tableId, int rpmIdx, int mapIdx, int delta);
+    Q_INVOKABLE void clearStaged();
+    Q_INVOKABLE int stagedDelta(int tableId, int rpmIdx, int mapIdx) const;
+
+    // Every staged edit as {tableId, rpmIdx, mapIdx, delta}
+    Q_INVOKABLE QVariantList stagedCells() const;
+
+    // Total acknowledged delta for a cell since the last rollback
+    Q_INVOKABLE int committedDelta(int tableId, int rpmIdx, int mapIdx) const;
+
+    // Streams all staged edits as one transaction
+    Q_INVOKABLE bool commit();
+
+    // Reverts every committed edit with a single ECM rollback frame
+    Q_INVOKABLE void rollback();
+
+    // Splits the non-zero cells of one table into rectangles of at most
+    // maxCells cells
+    static QVector<Patch> buildPatches(int tableId, const int16_t *cells,
+                                       int maxCells = TunePatchFrame::kMaxCells);
+
+signals:
+    void stateChanged();
+    void stagedChanged();
+    void transactionCompleted(int patches, int cells);
+    void transactionFailed(const QString &reason);
+
+private slots:
+    void onTuneAck(int tableId, int rpmIdx, int mapIdx, bool accepted, int seq);
+    void onAckTimeout();
+
+private:
+    struct InFlight {
+        Patch patch;
+        uint16_t seq = 0;
+        int attempts = 0;
+        QElapsedTimer sentAt;
+    };
+
+    static int cellIndex(int tableId, int rpmIdx, int mapIdx);
+    static bool validCell(int tableId, int rpmIdx, int mapIdx);
+
+    bool startTransaction(bool restore);
+    void pump();
+    void transmit(InFlight &entry, bool last);
+    void failTransaction(const QString &reason);
+    void finishTransaction();
+
+    VehicleBusManager *m_vehicle = nullptr;
+
+    using Table = std::array<int16_t, kTables * kRpmBins * kMapBins>;
+    Table m_committed{};   // Acknowledged by the ECM
+    Table m_staged{};      // Edits not yet committed
+    Table m_transaction{}; // Edits in the current transaction
+    Table m_committedBefore{};  // Shadow at transaction start, for restore
+
+    QVector<Patch> m_queue;
+    QVector<InFlight> m_inFlight;
+    int m_transactionPatches = 0;
+    int m_transactionCells = 0;
+    bool m_restoring = false;
+    QTimer *m_ackTimer;
+};
+
+#endif // TUNESESSION_H
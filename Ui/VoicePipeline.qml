@@ -7,6 +7,7 @@ import HeadUnit
  * Wires PicovoiceManager, GoogleTTS, ClaudeClient, ToolExecutor, and CopilotMonitor.
  * ClaudeClient handles the tool loop internally; this layer manages:
  *   - TTS playback sequencing (ready prompt → response → follow-up / nav briefing)
+ *   - Speaking Claude's response sentence by sentence while it streams in
  *   - Music pause/resume around voice interactions
  *   - Proactive alert queuing and delivery
  *   - Navigation briefing coordination (short ack → wait for route data → full briefing)
@@ -27,6 +28,10 @@ Item {
     // Should the mic stay open after the current response? (set by ToolExecutor)
     property bool wantsFollowUp: false
 
+    // True once the current Claude response has started going to the TTS queue
+    // sentence by sentence; responseReceived then only closes the queue
+    property bool responseStreamed: false
+
     // Which music source was playing before Jarvis activated (for resume)
     property string musicSource: ""
 
@@ -122,6 +127,10 @@ Item {
             root.wantsFollowUp = false
             hideClaudeTimer.stop()
 
+            // A response still streaming in would be spoken over the new interaction
+            if (claudeClient.isProcessing) claudeClient.cancelRequest()
+            root.responseStreamed = false
+
             // Stop any ongoing TTS
             if (googleTTS.isSpeaking) googleTTS.stop()
 
@@ -199,7 +208,10 @@ Item {
                 hideIndicator()
                 resumeMusic()
             } else if (type === "response") {
-                // Response TTS failed — same cleanup as finishInteraction
+                // Response TTS failed — same cleanup as finishInteraction.
+                // Drop the rest of a response that is still streaming in.
+                if (claudeClient.isProcessing) claudeClient.cancelRequest()
+                root.responseStreamed = false
                 root.navActive = false
                 root.alertQueue = []
                 navBriefingTimer.stop()
@@ -288,8 +300,32 @@ Item {
             if (claudeClient.isProcessing) setIndicator("processing")
         }
 
+        function onSentenceReady(sentence) {
+            // Stale: the driver started a new interaction
+            if (root.speechType === "ready") return
+
+            var spokenSentence = stripMarkdown(sentence)
+            if (spokenSentence.length === 0) return
+
+            if (!root.responseStreamed) {
+                root.responseStreamed = true
+                setIndicator("speaking")
+                root.speechType = "response"
+                hideClaudeTimer.start()
+            }
+            googleTTS.enqueue(spokenSentence)
+        }
+
         function onResponseReceived(response, toolCalls) {
             console.log("Claude response:", response.substring(0, 200))
+
+            if (root.responseStreamed) {
+                // Already queued as it streamed in; speechFinished follows the last sentence
+                root.responseStreamed = false
+                googleTTS.finishQueue()
+                return
+            }
+
             setIndicator("speaking")
 
             var spokenText = stripMarkdown(response.trim())
@@ -302,6 +338,11 @@ Item {
 
         function onError(message) {
             console.log("Claude error:", message)
+            if (root.responseStreamed) {
+                // Don't leave half an answer playing
+                root.responseStreamed = false
+                googleTTS.stop()
+            }
             root.speechType = ""
             navBriefingTimer.stop()
             hideClaudeTimer.stop()
@@ -450,6 +491,7 @@ Item {
             root.navDest = ""
             root.navActive = false
             root.alertQueue = []
+            root.responseStreamed = false
             navBriefingTimer.stop()
             googleTTS.stop()
             picovoiceManager.resume()
@@ -504,6 +546,8 @@ Item {
     // Cancel current interaction
     function cancelInteraction() {
         console.log("Canceling interaction")
+        if (claudeClient.isProcessing) claudeClient.cancelRequest()
+        root.responseStreamed = false
         root.speechType = ""
         root.wantsFollowUp = false
         root.navDest = ""
@@ -34,7 +34,8 @@ Item {
     property var routeDestination: null   // {lat, lon, name} — final destination
     property var routeWaypoints: []       // Array of {lat, lon, name} intermediate stops
     property var routeOrigin: null        // {lat, lon} — origin used when route was first calculated
-    property var routeGeoJson: ({"type": "FeatureCollection", "features": []})  // GeoJSON for the route line
+    property var routeGeoJson: ({"type": "FeatureCollection", "features": []})  // GeoJSON for the route line (text from routeLoader)
+    property real routeStartBearing: 0
 
     // Weather overlay
     property bool radarVisible: false
@@ -44,8 +45,9 @@ Item {
     property real _preRadarZoom: -1   // saved zoom before radar zoom-out
     property var _preRadarCenter: null // saved center before radar zoom-out
 
-    // Directions request generation counter (guards in-flight XHR responses)
-    property int directionsGeneration: 0
+    // Directions request in flight via routeLoader: {fresh, origin, dest?}.
+    // Stale responses are dropped by routeLoader itself.
+    property var pendingDirections: null
 
     // Turn-by-turn state
     property var routeSteps: []           // Array of step objects from Directions API
@@ -83,14 +85,9 @@ Item {
                 mapLoader.item.map.bearing = gps.position.direction
             }
         } else if (routeOrigin) {
-            // No GPS fix — center on route start and compute bearing from first segment
+            // No GPS fix — center on route start, facing along the first segment
             mapLoader.item.map.center = QtPositioning.coordinate(routeOrigin.lat, routeOrigin.lon)
-            var coords = routeGeoJson.geometry.coordinates
-            if (coords && coords.length >= 2) {
-                var dx = coords[1][0] - coords[0][0]
-                var dy = coords[1][1] - coords[0][1]
-                mapLoader.item.map.bearing = (Math.atan2(dx, dy) * 180 / Math.PI + 360) % 360
-            }
+            mapLoader.item.map.bearing = routeStartBearing
         }
         console.log("Maps: Entered navigation mode")
     }
@@ -287,12 +284,21 @@ Item {
                 }
                 contextAggregator.gpsHeading = position.directionValid ? position.direction : -1.0
             }
+            // Match the fix to the route first — speed limits read its progress
+            if (position.coordinateValid && typeof routeProgressTracker !== 'undefined') {
+                routeProgressTracker.updatePosition(
+                    position.coordinate.latitude,
+                    position.coordinate.longitude,
+                    position.speedValid ? position.speed * 3.6 : 0,
+                    position.directionValid ? position.direction : -1.0)
+            }
             // Forward GPS to SpeedLimitManager for live speed limit tracking
             if (position.coordinateValid && typeof speedLimitManager !== 'undefined') {
                 speedLimitManager.updateGpsPosition(
                     position.coordinate.latitude,
                     position.coordinate.longitude,
-                    position.speedValid ? position.speed * 3.6 : 0)
+                    position.speedValid ? position.speed * 3.6 : 0,
+                    position.directionValid ? position.direction : -1.0)
             }
             if (position.coordinateValid && routeActive) {
                 advanceStepIfNeeded()
@@ -1019,9 +1025,6 @@ Item {
 
     // ── Directions (Mapbox Directions API) ──
     function getDirections(destLat, destLon, destName) {
-        directionsGeneration++
-        var myGeneration = directionsGeneration
-
         // Use GPS if available, otherwise use current map center
         var origin
         if (gps.position.coordinateValid) {
@@ -1033,161 +1036,103 @@ Item {
             console.warn("No GPS fix and no map — cannot calculate route")
             return
         }
-        var url = "https://api.mapbox.com/directions/v5/mapbox/driving/"
-            + origin.longitude + "," + origin.latitude + ";"
-            + destLon + "," + destLat
-            + "?geometries=geojson&overview=full&steps=true&banner_instructions=true&annotations=maxspeed&access_token=" + root.mapboxToken
-
-        var xhr = new XMLHttpRequest()
-        xhr.onreadystatechange = function() {
-            if (xhr.readyState === XMLHttpRequest.DONE && xhr.status !== 200) {
-                console.warn("Directions request failed with status:", xhr.status, xhr.statusText)
-                routeDistance = "Route failed"
-                routeDuration = "Tap to retry"
-                return
-            }
-            if (xhr.readyState === XMLHttpRequest.DONE && xhr.status === 200) {
-                // Discard stale response if a newer request was made or route was cleared
-                if (myGeneration !== root.directionsGeneration) {
-                    console.log("Directions: discarding stale response (gen", myGeneration, "vs", root.directionsGeneration, ")")
-                    return
-                }
-                try {
-                    var result = JSON.parse(xhr.responseText)
-                    if (!result.routes || result.routes.length === 0) {
-                        console.warn("No routes found")
-                        return
-                    }
-
-                    var route = result.routes[0]
-
-                    // Format distance
-                    var distM = route.distance || 0
-                    if (distM >= 1000) {
-                        routeDistance = (distM / 1000).toFixed(1) + " km"
-                    } else {
-                        routeDistance = Math.round(distM) + " m"
-                    }
-
-                    // Format duration
-                    var durSec = route.duration || 0
-                    if (durSec >= 3600) {
-                        var hrs = Math.floor(durSec / 3600)
-                        var mins = Math.round((durSec % 3600) / 60)
-                        routeDuration = hrs + " hr " + mins + " min"
-                    } else {
-                        routeDuration = Math.round(durSec / 60) + " min"
-                    }
 
-                    routeDestination = { lat: destLat, lon: destLon, name: destName }
-                    routeWaypoints = []  // Fresh navigate clears any previous stops
-                    _waypointCoords = []
-                    routeOrigin = { lat: origin.latitude, lon: origin.longitude }
-                    root._destCoord = QtPositioning.coordinate(destLat, destLon)
-                    markerUpdateTimer.restart()
-
-                    // Build GeoJSON for the route line
-                    routeGeoJson = {
-                        "type": "Feature",
-                        "geometry": route.geometry
-                    }
-
-
-                    routeActive = true
+        if (typeof routeLoader === 'undefined') return
+        pendingDirections = {
+            fresh: true,
+            origin: { lat: origin.latitude, lon: origin.longitude },
+            dest: { lat: destLat, lon: destLon, name: destName }
+        }
+        routeLoader.requestRoute([
+            { lat: origin.latitude, lon: origin.longitude },
+            { lat: destLat, lon: destLon }
+        ], false)
+    }
 
-                    // Feed route metadata to ContextAggregator for voice assistant awareness
-                    if (typeof contextAggregator !== 'undefined') {
-                        contextAggregator.routeActive = true
-                        contextAggregator.routeDestination = destName || searchInput.text
-                        contextAggregator.routeDistance = routeDistance
-                        contextAggregator.routeDuration = routeDuration
-                    }
+    // routeLoader fetches and parses the directions response off the GUI
+    // thread and hands the shared route to ContextAggregator and the
+    // route-aware managers itself; this only updates what the map shows
+    Connections {
+        target: typeof routeLoader !== 'undefined' ? routeLoader : null
 
-                    // Parse turn-by-turn steps from ALL legs
-                    var legs = route.legs
-                    var steps = []
-                    if (legs) {
-                        for (var l = 0; l < legs.length; l++) {
-                            if (legs[l].steps) {
-                                for (var s = 0; s < legs[l].steps.length; s++) {
-                                    var step = legs[l].steps[s]
-                                    var maneuver = step.maneuver || {}
-                                    steps.push({
-                                        instruction: maneuver.instruction || "",
-                                        type: maneuver.type || "",
-                                        modifier: maneuver.modifier || "",
-                                        distance: step.distance || 0,
-                                        duration: step.duration || 0,
-                                        name: step.name || "",
-                                        lat: maneuver.location ? maneuver.location[1] : 0,
-                                        lon: maneuver.location ? maneuver.location[0] : 0
-                                    })
-                                }
-                            }
-                        }
-                    }
-                    routeSteps = steps
-                    currentStep = 0
-                    updateCurrentStepDisplay()
-
-                    // Fit map to show entire route, then auto-enter nav mode
-                    fitRouteBounds(origin.latitude, origin.longitude, destLat, destLon)
-                    navModeTimer.restart()
-
-                    // Feed route coordinates to RouteWeatherManager for weather-along-route tracking
-                    if (typeof routeWeatherManager !== 'undefined' && route.geometry && route.geometry.coordinates) {
-                        var coords = route.geometry.coordinates
-                        routeWeatherManager.setRouteCoordinates(coords, durSec)
-                        console.log("Maps: Sent", coords.length, "route coords to RouteWeatherManager, duration:", durSec, "sec")
-                    }
+        function onRouteLoaded(route, silent) {
+            var pending = root.pendingDirections
+            root.pendingDirections = null
+            if (!pending) return
 
-                    // Feed route coordinates to RoadConditionManager for 511/DriveBC alerts
-                    if (typeof roadConditionManager !== 'undefined' && route.geometry && route.geometry.coordinates) {
-                        roadConditionManager.setRouteCoordinates(route.geometry.coordinates, durSec)
-                        console.log("Maps: Sent route coords to RoadConditionManager")
-                    }
+            // Format distance
+            var distM = route.distance || 0
+            if (distM >= 1000) {
+                routeDistance = (distM / 1000).toFixed(1) + " km"
+            } else {
+                routeDistance = Math.round(distM) + " m"
+            }
 
-                    // Feed speed limit annotations to SpeedLimitManager
-                    if (typeof speedLimitManager !== 'undefined' && route.legs && route.legs.length > 0) {
-                        var annotation = route.legs[0].annotation
-                        if (annotation && annotation.maxspeed) {
-                            speedLimitManager.setSpeedLimitData(annotation.maxspeed, route.geometry.coordinates, durSec)
-                            console.log("Maps: Sent", annotation.maxspeed.length, "speed limit segments to SpeedLimitManager")
-                        }
-                    }
+            // Format duration
+            var durSec = route.duration || 0
+            if (durSec >= 3600) {
+                var hrs = Math.floor(durSec / 3600)
+                var mins = Math.round((durSec % 3600) / 60)
+                routeDuration = hrs + " hr " + mins + " min"
+            } else {
+                routeDuration = Math.round(durSec / 60) + " min"
+            }
 
-                    // Feed route to RoadSurfaceManager for winter road conditions
-                    if (typeof roadSurfaceManager !== 'undefined' && route.geometry && route.geometry.coordinates) {
-                        roadSurfaceManager.setRouteCoordinates(route.geometry.coordinates, durSec)
-                    }
+            if (pending.fresh) {
+                routeDestination = pending.dest
+                routeWaypoints = []  // Fresh navigate clears any previous stops
+                _waypointCoords = []
+                routeOrigin = pending.origin
+                root._destCoord = QtPositioning.coordinate(pending.dest.lat, pending.dest.lon)
+                routeActive = true
+            }
 
-                    // Feed route to HighwayCameraManager
-                    if (typeof highwayCameraManager !== 'undefined' && route.geometry && route.geometry.coordinates) {
-                        highwayCameraManager.setRouteCoordinates(route.geometry.coordinates, durSec)
+            // Route line
+            routeGeoJson = route.geoJson
+            routeStartBearing = route.startBearing
+
+            // Feed route metadata to ContextAggregator for voice assistant awareness
+            if (typeof contextAggregator !== 'undefined') {
+                contextAggregator.routeActive = true
+                contextAggregator.routeDistance = routeDistance
+                contextAggregator.routeDuration = routeDuration
+                if (pending.fresh) {
+                    contextAggregator.routeDestination = pending.dest.name || searchInput.text
+                } else {
+                    // Build destination string with stops
+                    var destStr = ""
+                    for (var w = 0; w < routeWaypoints.length; w++) {
+                        destStr += routeWaypoints[w].name + " → "
                     }
+                    destStr += routeDestination.name
+                    contextAggregator.routeDestination = destStr
+                }
+            }
 
-                    // Feed route to AvalancheManager for mountain pass forecasts
-                    if (typeof avalancheManager !== 'undefined' && route.geometry && route.geometry.coordinates) {
-                        avalancheManager.setRouteCoordinates(route.geometry.coordinates, durSec)
-                    }
+            // Turn-by-turn steps from all legs
+            routeSteps = route.steps
+            currentStep = 0
+            updateCurrentStepDisplay()
 
-                    // Feed route to BorderWaitManager (only activates if route is near a crossing)
-                    if (typeof borderWaitManager !== 'undefined' && route.geometry && route.geometry.coordinates) {
-                        borderWaitManager.setRouteCoordinates(route.geometry.coordinates, durSec)
-                    }
+            // Fit map to show entire route, then auto-enter nav mode
+            fitRouteBounds(pending.origin.lat, pending.origin.lon,
+                           routeDestination.lat, routeDestination.lon)
+            navModeTimer.restart()
+            markerUpdateTimer.restart()
 
-                    // Feed route coords to ContextAggregator for along-route places search
-                    if (typeof contextAggregator !== 'undefined' && route.geometry && route.geometry.coordinates) {
-                        contextAggregator.setRouteCoordinates(route.geometry.coordinates, durSec)
-                    }
+            console.log("Maps: Route", pending.fresh ? "loaded" : "recalculated with " + routeWaypoints.length + " stop(s),",
+                        routeSteps.length, "steps,", routeDistance, routeDuration)
+        }
 
-                } catch (e) {
-                    console.error("Directions error:", e)
-                }
+        function onRouteFailed(error) {
+            var pending = root.pendingDirections
+            root.pendingDirections = null
+            console.warn("Directions request failed:", error)
+            if (pending && pending.fresh) {
+                routeDistance = "Route failed"
+                routeDuration = "Tap to retry"
             }
         }
-        xhr.open("GET", url)
-        xhr.send()
     }
 
     function addStopAlongRoute(stopLat, stopLon, stopName) {
@@ -1216,9 +1161,6 @@ Item {
     }
 
     function recalculateRouteWithWaypoints() {
-        directionsGeneration++
-        var myGeneration = directionsGeneration
-
         var origin
         if (gps.position.coordinateValid) {
             origin = gps.position.coordinate
@@ -1233,153 +1175,23 @@ Item {
             return
         }
 
-        // Build coordinate string: origin;wp1;wp2;...;destination
-        var coords = origin.longitude + "," + origin.latitude
+        // Origin → waypoints → destination
+        var points = [{ lat: origin.latitude, lon: origin.longitude }]
         for (var i = 0; i < routeWaypoints.length; i++) {
-            coords += ";" + routeWaypoints[i].lon + "," + routeWaypoints[i].lat
+            points.push({ lat: routeWaypoints[i].lat, lon: routeWaypoints[i].lon })
         }
-        coords += ";" + routeDestination.lon + "," + routeDestination.lat
-
-        var url = "https://api.mapbox.com/directions/v5/mapbox/driving/"
-            + coords
-            + "?geometries=geojson&overview=full&steps=true&banner_instructions=true&annotations=maxspeed&access_token=" + root.mapboxToken
+        points.push({ lat: routeDestination.lat, lon: routeDestination.lon })
 
         console.log("Maps: Recalculating route with", routeWaypoints.length, "waypoint(s)")
 
-        var xhr = new XMLHttpRequest()
-        xhr.onreadystatechange = function() {
-            if (xhr.readyState === XMLHttpRequest.DONE && xhr.status !== 200) {
-                console.warn("Directions request failed:", xhr.status, xhr.statusText)
-                return
-            }
-            if (xhr.readyState === XMLHttpRequest.DONE && xhr.status === 200) {
-                if (myGeneration !== root.directionsGeneration) return
-
-                try {
-                    var result = JSON.parse(xhr.responseText)
-                    if (!result.routes || result.routes.length === 0) {
-                        console.warn("No routes found with waypoints")
-                        return
-                    }
-
-                    var route = result.routes[0]
-
-                    // Format total distance (sum all legs)
-                    var distM = route.distance || 0
-                    if (distM >= 1000)
-                        routeDistance = (distM / 1000).toFixed(1) + " km"
-                    else
-                        routeDistance = Math.round(distM) + " m"
-
-                    // Format total duration
-                    var durSec = route.duration || 0
-                    if (durSec >= 3600) {
-                        var hrs = Math.floor(durSec / 3600)
-                        var mins = Math.round((durSec % 3600) / 60)
-                        routeDuration = hrs + " hr " + mins + " min"
-                    } else {
-                        routeDuration = Math.round(durSec / 60) + " min"
-                    }
-
-                    // Update route line
-                    routeGeoJson = { "type": "Feature", "geometry": route.geometry }
-
-
-                    // Update context aggregator
-                    if (typeof contextAggregator !== 'undefined') {
-                        contextAggregator.routeDistance = routeDistance
-                        contextAggregator.routeDuration = routeDuration
-                        // Build destination string with stops
-                        var destStr = ""
-                        for (var w = 0; w < routeWaypoints.length; w++) {
-                            destStr += routeWaypoints[w].name + " → "
-                        }
-                        destStr += routeDestination.name
-                        contextAggregator.routeDestination = destStr
-                    }
-
-                    // Parse turn-by-turn steps from ALL legs
-                    var legs = route.legs
-                    var steps = []
-                    if (legs) {
-                        for (var l = 0; l < legs.length; l++) {
-                            if (legs[l].steps) {
-                                for (var s = 0; s < legs[l].steps.length; s++) {
-                                    var step = legs[l].steps[s]
-                                    var maneuver = step.maneuver || {}
-                                    steps.push({
-                                        instruction: maneuver.instruction || "",
-                                        type: maneuver.type || "",
-                                        modifier: maneuver.modifier || "",
-                                        distance: step.distance || 0,
-                                        duration: step.duration || 0,
-                                        name: step.name || "",
-                                        lat: maneuver.location ? maneuver.location[1] : 0,
-                                        lon: maneuver.location ? maneuver.location[0] : 0
-                                    })
-                                }
-                            }
-                        }
-                    }
-                    routeSteps = steps
-                    currentStep = 0
-                    updateCurrentStepDisplay()
-
-                    // Fit map to show entire route, then auto-enter nav mode
-                    fitRouteBounds(origin.latitude, origin.longitude,
-                                   routeDestination.lat, routeDestination.lon)
-                    navModeTimer.restart()
-
-                    // Feed updated route to downstream managers (silent=true to suppress repeat alerts)
-                    if (route.geometry && route.geometry.coordinates) {
-                        var routeCoords = route.geometry.coordinates
-                        if (typeof routeWeatherManager !== 'undefined')
-                            routeWeatherManager.setRouteCoordinates(routeCoords, durSec, true)
-                        if (typeof roadConditionManager !== 'undefined')
-                            roadConditionManager.setRouteCoordinates(routeCoords, durSec, true)
-                        if (typeof roadSurfaceManager !== 'undefined')
-                            roadSurfaceManager.setRouteCoordinates(routeCoords, durSec, true)
-                        if (typeof highwayCameraManager !== 'undefined')
-                            highwayCameraManager.setRouteCoordinates(routeCoords, durSec)
-                        if (typeof avalancheManager !== 'undefined')
-                            avalancheManager.setRouteCoordinates(routeCoords, durSec, true)
-                        if (typeof borderWaitManager !== 'undefined')
-                            borderWaitManager.setRouteCoordinates(routeCoords, durSec, true)
-                        if (typeof contextAggregator !== 'undefined')
-                            contextAggregator.setRouteCoordinates(routeCoords, durSec)
-                    }
-
-                    if (typeof speedLimitManager !== 'undefined' && route.legs) {
-                        // Combine maxspeed annotations from all legs
-                        var allMaxspeed = []
-                        var allCoords = []
-                        for (var sl = 0; sl < route.legs.length; sl++) {
-                            var ann = route.legs[sl].annotation
-                            if (ann && ann.maxspeed) {
-                                allMaxspeed = allMaxspeed.concat(ann.maxspeed)
-                            }
-                        }
-                        if (allMaxspeed.length > 0 && route.geometry && route.geometry.coordinates) {
-                            speedLimitManager.setSpeedLimitData(allMaxspeed, route.geometry.coordinates, durSec)
-                        }
-                    }
-
-                    console.log("Maps: Route recalculated with", routeWaypoints.length, "stop(s),",
-                                steps.length, "steps,", routeDistance, routeDuration)
-
-                    markerUpdateTimer.restart()
-
-                } catch (e) {
-                    console.error("Directions recalculate error:", e)
-                }
-            }
-        }
-        xhr.open("GET", url)
-        xhr.send()
+        if (typeof routeLoader === 'undefined') return
+        pendingDirections = { fresh: false, origin: { lat: origin.latitude, lon: origin.longitude } }
+        // silent — managers suppress repeat alerts for a recalculated route
+        routeLoader.requestRoute(points, true)
     }
 
     function clearRoute() {
-        directionsGeneration++
+        pendingDirections = null
         arrivalClearTimer.stop()
         navModeTimer.stop()
         exitNavMode()
@@ -1393,6 +1205,7 @@ Item {
         root._waypointCoords = []
         root._searchCoord = null
         routeGeoJson = { "type": "FeatureCollection", "features": [] }
+        routeStartBearing = 0
         routeSteps = []
         currentStep = 0
         nextManeuver = ""
@@ -1406,25 +1219,11 @@ Item {
             contextAggregator.routeDestination = ""
             contextAggregator.routeDistance = ""
             contextAggregator.routeDuration = ""
-            contextAggregator.clearRouteCoordinates()
-        }
-
-        // Clear route weather tracking
-        if (typeof routeWeatherManager !== 'undefined') {
-            routeWeatherManager.clearRoute()
-        }
-
-        // Clear road condition tracking
-        if (typeof roadConditionManager !== 'undefined') {
-            roadConditionManager.clearRoute()
         }
 
-        // Clear all other route-aware managers
-        if (typeof speedLimitManager !== 'undefined') speedLimitManager.clearRoute()
-        if (typeof roadSurfaceManager !== 'undefined') roadSurfaceManager.clearRoute()
-        if (typeof highwayCameraManager !== 'undefined') highwayCameraManager.clearRoute()
-        if (typeof avalancheManager !== 'undefined') avalancheManager.clearRoute()
-        if (typeof borderWaitManager !== 'undefined') borderWaitManager.clearRoute()
+        // Drops any request in flight and clears the route from
+        // ContextAggregator and every route-aware manager
+        if (typeof routeLoader !== 'undefined') routeLoader.clear()
 
         // Clear stale route alerts so they don't leak after route clear
         if (typeof copilotMonitor !== 'undefined') copilotMonitor.clearPendingAlerts()
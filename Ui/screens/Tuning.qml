@@ -87,6 +87,8 @@ Item {
     }
 
     function applyDeltas() {
+        // pendingDeltas mirrors the whole staged set, so restage from scratch
+        tuneSession.clearStaged()
         for (var key in pendingDeltas) {
             var parts = key.split(",")
             var tableId = parseInt(parts[0])
@@ -94,25 +96,45 @@ Item {
             var mapIdx = parseInt(parts[2])
             var delta = pendingDeltas[key]
             // Delta is ×10 on wire (VE: 0.1% resolution, Ign: 0.1° resolution)
-            vehicleBusManager.sendTuneDelta(tableId, rpmIdx, mapIdx, delta * 10)
+            tuneSession.stageDelta(tableId, rpmIdx, mapIdx, Math.round(delta * 10))
         }
-        pendingDeltas = ({})
-        pendingCount = 0
+        // Streamed as batched patches; failed edits come back as staged
+        if (tuneSession.commit()) {
+            pendingDeltas = ({})
+            pendingCount = 0
+        } else {
+            loadStaged()
+        }
+    }
+
+    // Rebuild the pending edits from what TuneSession still has staged
+    function loadStaged() {
+        var updated = {}
+        var cells = tuneSession.stagedCells()
+        for (var i = 0; i < cells.length; i++) {
+            var c = cells[i]
+            updated[c.tableId + "," + c.rpmIdx + "," + c.mapIdx] = c.delta / 10
+        }
+        pendingDeltas = updated
+        pendingCount = Object.keys(pendingDeltas).length
     }
 
     function rollbackAll() {
-        vehicleBusManager.sendTuneRollback()
+        tuneSession.clearStaged()
+        tuneSession.rollback()
         pendingDeltas = ({})
         pendingCount = 0
     }
 
     // Handle tune ACKs from ECM
     Connections {
-        target: vehicleBusManager
-        function onTuneAckReceived(tableId, rpmIdx, mapIdx, accepted) {
-            if (!accepted) {
-                console.warn("Tuning: ECM rejected delta at", rpmIdx, mapIdx)
-            }
+        target: tuneSession
+        function onTransactionCompleted(patches, cells) {
+            console.log("Tuning: Applied", cells, "cells in", patches, "patches")
+        }
+        function onTransactionFailed(reason) {
+            console.warn("Tuning: Tune transaction failed -", reason)
+            loadStaged()
         }
     }
 
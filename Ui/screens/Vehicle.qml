@@ -194,14 +194,14 @@ Item {
                     GaugeCard {
                         width: (parent.width - 24) / 4; height: 100
                         label: "AFR B1"
-                        value: (vehicleBusManager.lambdaB1 * 14.7).toFixed(1)
+                        value: vehicleBusManager.afrB1.toFixed(1)
                         unit: ""
                         highlight: vehicleBusManager.lambdaB1 < 0.75 || vehicleBusManager.lambdaB1 > 1.1
                     }
                     GaugeCard {
                         width: (parent.width - 24) / 4; height: 100
                         label: "AFR B2"
-                        value: (vehicleBusManager.lambdaB2 * 14.7).toFixed(1)
+                        value: vehicleBusManager.afrB2.toFixed(1)
                         unit: ""
                         highlight: vehicleBusManager.lambdaB2 < 0.75 || vehicleBusManager.lambdaB2 > 1.1
                     }
@@ -283,6 +283,98 @@ Item {
                     }
                 }
 
+                // ---- Session Review ----
+                Rectangle {
+                    id: reviewCard
+                    width: parent.width; height: 160; radius: 10
+                    color: Qt.rgba(ThemeValues.primaryCol.r, ThemeValues.primaryCol.g, ThemeValues.primaryCol.b, 0.06)
+                    border.color: Qt.rgba(ThemeValues.primaryCol.r, ThemeValues.primaryCol.g, ThemeValues.primaryCol.b, 0.15)
+                    border.width: 1
+
+                    property string channel: "rpm"
+
+                    // Newest finished session — the one being written isn't listed
+                    function loadLatest() {
+                        var sessions = vehicleBusManager.logSessions()
+                        if (sessions.length > 0 && vehicleBusManager.openLog(sessions[sessions.length - 1]))
+                            traceCanvas.requestPaint()
+                    }
+
+                    Row {
+                        id: reviewHeader
+                        anchors.left: parent.left; anchors.top: parent.top
+                        anchors.margins: 10
+                        spacing: 10
+
+                        Text {
+                            text: vehicleBusManager.loadedLogDuration > 0
+                                  ? "LAST SESSION  " + (vehicleBusManager.loadedLogDuration / 60).toFixed(1) + " min"
+                                  : "LAST SESSION"
+                            color: ThemeValues.primaryCol
+                            font.pixelSize: 10; font.family: ThemeValues.fontFamily; font.bold: true
+                            opacity: 0.7
+                            anchors.verticalCenter: parent.verticalCenter
+                        }
+
+                        Repeater {
+                            model: ["rpm", "mapKpa", "lambdaB1", "knockRetard"]
+                            Text {
+                                text: modelData
+                                color: reviewCard.channel === modelData ? ThemeValues.accentCol : ThemeValues.textCol
+                                font.pixelSize: 11; font.family: ThemeValues.fontFamily
+                                opacity: reviewCard.channel === modelData ? 1.0 : 0.5
+                                anchors.verticalCenter: parent.verticalCenter
+                                MouseArea {
+                                    anchors.fill: parent
+                                    onClicked: { reviewCard.channel = modelData; traceCanvas.requestPaint() }
+                                }
+                            }
+                        }
+                    }
+
+                    Canvas {
+                        id: traceCanvas
+                        anchors.left: parent.left; anchors.right: parent.right
+                        anchors.top: reviewHeader.bottom; anchors.bottom: parent.bottom
+                        anchors.margins: 10
+
+                        onWidthChanged: requestPaint()
+                        onPaint: {
+                            var ctx = getContext("2d")
+                            ctx.clearRect(0, 0, width, height)
+                            var duration = vehicleBusManager.loadedLogDuration
+                            if (duration <= 0) return
+
+                            // One min/max pair per pixel column, decimated in C++
+                            var pts = vehicleBusManager.logTrace(reviewCard.channel, 0, duration, Math.floor(width))
+                            if (pts.length === 0) return
+                            var lo = pts[0].y, hi = pts[0].y
+                            for (var i = 1; i < pts.length; i++) {
+                                lo = Math.min(lo, pts[i].y); hi = Math.max(hi, pts[i].y)
+                            }
+                            var span = Math.max(hi - lo, 1e-6)
+
+                            ctx.strokeStyle = ThemeValues.primaryCol
+                            ctx.lineWidth = 1
+                            ctx.beginPath()
+                            for (var j = 0; j < pts.length; j++) {
+                                var x = pts[j].x / duration * width
+                                var y = height - (pts[j].y - lo) / span * height
+                                if (j === 0) ctx.moveTo(x, y); else ctx.lineTo(x, y)
+                            }
+                            ctx.stroke()
+                        }
+                    }
+
+                    Connections {
+                        target: vehicleBusManager
+                        function onLoadedLogChanged() { traceCanvas.requestPaint() }
+                        function onLogSessionClosed(path) { if (vehicleBusManager.openLog(path)) traceCanvas.requestPaint() }
+                    }
+
+                    Component.onCompleted: loadLatest()
+                }
+
                 // Module status footer
                 Row {
                     width: parent.width
@@ -1,5 +1,11 @@
 #include "VehicleBusManager.h"
+#include "CanBusReader.h"
+#include "CanTxScheduler.h"
+#include "TuneSession.h"
+#include "VehicleDecoders.h"
 #include <QDebug>
+#include <QStandardPaths>
+#include <cstddef>
 #include <cstring>
 
 #include <sys/socket.h>
@@ -14,10 +20,50 @@
 #include <linux/can/raw.h>
 #endif
 
+namespace {
+
+// QML-facing group names, indexed by VehicleGroup bit position
+const char *const kGroupNames[VehGroupCount] = {
+    "telemetry", "pressures", "fuel", "ignition", "driveMode", "faults", "moduleStatus", "derived"
+};
+
+// Default flush rates (Hz) — gauges fast, slow-moving state slow
+const double kDefaultGroupRateHz[VehGroupCount] = {
+    60.0,   // telemetry
+    20.0,   // pressures
+    30.0,   // fuel
+    30.0,   // ignition
+    10.0,   // driveMode
+    2.0,    // faults
+    10.0,   // moduleStatus
+    30.0,   // derived
+};
+
+int groupIndex(VehicleGroup group)
+{
+    for (int i = 0; i < VehGroupCount; ++i) {
+        if (static_cast<uint32_t>(group) == (1u << i)) return i;
+    }
+    return -1;
+}
+
+int groupIndex(const QString &name)
+{
+    for (int i = 0; i < VehGroupCount; ++i) {
+        if (name == QLatin1String(kGroupNames[i])) return i;
+    }
+    return -1;
+}
+
+} // namespace
+
 VehicleBusManager::VehicleBusManager(QObject *parent)
     : QObject(parent)
     , m_heartbeatTimer(new QTimer(this))
     , m_timeoutTimer(new QTimer(this))
+    , m_busStatsTimer(new QTimer(this))
+    , m_history(std::make_unique<TelemetryHistory>())
+    , m_replayTimer(new QTimer(this))
 {
     // HMI heartbeat at 1000ms per platform spec
     m_heartbeatTimer->setInterval(VEH_RATE_HEARTBEAT_MODULE);
@@ -27,12 +73,32 @@ VehicleBusManager::VehicleBusManager(QObject *parent)
     m_timeoutTimer->setInterval(500);
     connect(m_timeoutTimer, &QTimer::timeout, this, &VehicleBusManager::onModuleTimeoutCheck);
 
+    // Reader frame-rate / drop statistics once per second
+    m_busStatsTimer->setInterval(1000);
+    connect(m_busStatsTimer, &QTimer::timeout, this, &VehicleBusManager::onBusStatsTimer);
+
+    // UI flush tick — runs at the fastest configured group rate
+    m_uiUpdateTimer = new QTimer(this);
+    m_uiUpdateTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_uiUpdateTimer, &QTimer::timeout, this, &VehicleBusManager::onUiUpdateTimer);
+    for (int i = 0; i < VehGroupCount; ++i)
+        m_groupFlush[i].intervalMs = qRound(1000.0 / kDefaultGroupRateHz[i]);
+    restartUiUpdateTimer();
+    m_flushClock.start();
+
+    connect(m_replayTimer, &QTimer::timeout, this, &VehicleBusManager::onReplayTimer);
+
+    m_logDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/telemetry";
+
     qDebug() << "VehicleBusManager: Initialized (not connected)";
 }
 
 VehicleBusManager::~VehicleBusManager()
 {
+    stopReplay();
     disconnectBus();
+    stopCapture();
+    stopLogging();
 }
 
 void VehicleBusManager::connectBus(const QString &iface)
@@ -41,6 +107,10 @@ void VehicleBusManager::connectBus(const QString &iface)
         qWarning() << "VehicleBusManager: Already connected to" << m_interface;
         return;
     }
+    if (m_replayLog) {
+        qWarning() << "VehicleBusManager: Stop replay before connecting to a live bus";
+        return;
+    }
 
     m_interface = iface;
 
@@ -81,9 +151,21 @@ void VehicleBusManager::connectBus(const QString &iface)
         return;
     }
 
-    // Set up Qt socket notifier for async reads
-    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
-    connect(m_notifier, &QSocketNotifier::activated, this, &VehicleBusManager::onCanData);
+    // Frames are read and decoded on a dedicated thread; the GUI thread only
+    // picks up coalesced snapshots
+    m_state = VehicleState();
+    m_ecmHeartbeatsSeen = m_tcmHeartbeatsSeen = m_pdcmHeartbeatsSeen = m_gcmHeartbeatsSeen = 0;
+    m_lastStatsFrames = 0;
+    m_lastStatsBatches = 0;
+    m_history->clear();
+    m_reader = new CanBusReader(m_socket, &VehicleBusManager::processFrame, m_history.get(), this);
+    connect(m_reader, &CanBusReader::snapshotReady, this, &VehicleBusManager::onBusSnapshot, Qt::QueuedConnection);
+    if (m_captureWriter) m_reader->setRecorder(m_captureWriter.get());
+    startLogging();
+
+    // Non-blocking prioritized transmit queue on the same socket
+    m_tx = new CanTxScheduler(m_socket, this);
+    m_reader->start(QThread::HighestPriority);
 
     m_connected = true;
     emit connectedChanged();
@@ -92,6 +174,10 @@ void VehicleBusManager::connectBus(const QString &iface)
     // Start heartbeat and timeout monitoring
     m_heartbeatTimer->start();
     m_timeoutTimer->start();
+    m_busStatsClock.start();
+    m_busStatsTimer->start();
+    m_pendingDirty = 0;
+    m_uiUpdateTimer->start();
 
     qDebug() << "VehicleBusManager: Connected to" << iface;
 
@@ -103,13 +189,26 @@ void VehicleBusManager::disconnectBus()
 {
     m_heartbeatTimer->stop();
     m_timeoutTimer->stop();
+    m_busStatsTimer->stop();
+    m_uiUpdateTimer->stop();
+
+    if (m_tx) {
+        if (m_tx->pending() > 0)
+            qWarning() << "VehicleBusManager: Discarding" << m_tx->pending() << "unsent frames";
+        delete m_tx;
+        m_tx = nullptr;
+    }
 
-    if (m_notifier) {
-        m_notifier->setEnabled(false);
-        delete m_notifier;
-        m_notifier = nullptr;
+    // Stop the reader before closing the socket it polls
+    if (m_reader) {
+        m_reader->stop();
+        delete m_reader;
+        m_reader = nullptr;
     }
 
+    // No producer left — seal and index the session
+    stopLogging();
+
     if (m_socket >= 0) {
         ::close(m_socket);
         m_socket = -1;
@@ -121,8 +220,10 @@ void VehicleBusManager::disconnectBus()
         m_tcmOnline = false;
         m_pdcmOnline = false;
         m_gcmOnline = false;
+        m_busFrameRate = 0;
         emit connectedChanged();
         emit moduleStatusChanged();
+        emit busStatsChanged();
         qDebug() << "VehicleBusManager: Disconnected";
     }
 }
@@ -131,202 +232,476 @@ void VehicleBusManager::disconnectBus()
 // CAN Frame I/O
 // ============================================================================
 
-void VehicleBusManager::onCanData()
+void VehicleBusManager::onBusSnapshot()
 {
-    struct canfd_frame frame;
-    ssize_t nbytes = read(m_socket, &frame, sizeof(frame));
+    if (!m_reader) return;
+    m_reader->takeSnapshot(m_state);
+    applySnapshot(m_history->nowMs());
+}
 
-    if (nbytes < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            qWarning() << "VehicleBusManager: Read error:" << strerror(errno);
+void VehicleBusManager::applySnapshot(uint32_t timeMs)
+{
+    uint32_t dirty = m_state.dirty;
+
+    // Heartbeats — any new beat since the last snapshot restarts that
+    // module's timeout clock
+    auto checkHeartbeat = [&dirty](uint32_t count, uint32_t &seen, QElapsedTimer &clock,
+                                   bool &online, const char *name) {
+        if (count == seen) return;
+        seen = count;
+        clock.restart();
+        if (!online) {
+            online = true;
+            dirty |= VehGroupModuleStatus;
+            qDebug() << "VehicleBusManager:" << name << "online";
         }
+    };
+    checkHeartbeat(m_state.ecmHeartbeats, m_ecmHeartbeatsSeen, m_ecmLastHeartbeat, m_ecmOnline, "ECM");
+    checkHeartbeat(m_state.tcmHeartbeats, m_tcmHeartbeatsSeen, m_tcmLastHeartbeat, m_tcmOnline, "TCM");
+    checkHeartbeat(m_state.pdcmHeartbeats, m_pdcmHeartbeatsSeen, m_pdcmLastHeartbeat, m_pdcmOnline, "PDCM");
+    checkHeartbeat(m_state.gcmHeartbeats, m_gcmHeartbeatsSeen, m_gcmLastHeartbeat, m_gcmOnline, "GCM");
+
+    // Tune ACKs are events, not state — deliver every one immediately, in order
+    for (const VehicleTuneAck &ack : std::as_const(m_state.tuneAcks))
+        emit tuneAckReceived(ack.tableId, ack.rpmIdx, ack.mapIdx, ack.accepted, ack.seq);
+    m_state.tuneAcks.clear();
+
+    // Derived channels recompute only where their inputs moved
+    if (m_derived.update(m_state, dirty, timeMs)) dirty |= VehGroupDerived;
+
+    // State changes wait for the flush tick
+    m_pendingDirty |= dirty;
+    m_state.dirty = 0;
+}
+
+// ============================================================================
+// UI Update Coalescing
+// ============================================================================
+
+void VehicleBusManager::onUiUpdateTimer()
+{
+    if (!m_pendingDirty) return;
+
+    qint64 now = m_flushClock.elapsed();
+    for (int i = 0; i < VehGroupCount; ++i) {
+        const uint32_t bit = 1u << i;
+        if (!(m_pendingDirty & bit)) continue;
+
+        GroupFlush &group = m_groupFlush[i];
+        if (now - group.lastFlushMs < group.intervalMs) continue;
+
+        group.lastFlushMs = now;
+        m_pendingDirty &= ~bit;
+        emitGroup(i);
+    }
+}
+
+void VehicleBusManager::emitGroup(int index)
+{
+    switch (1u << index) {
+    case VehGroupTelemetry:    emit telemetryUpdated(); break;
+    case VehGroupPressures:    emit pressuresUpdated(); break;
+    case VehGroupFuel:         emit fuelUpdated(); break;
+    case VehGroupIgnition:     emit ignitionUpdated(); break;
+    case VehGroupDriveMode:    emit driveModeChanged(); break;
+    case VehGroupFaults:       emit faultsUpdated(); break;
+    case VehGroupModuleStatus: emit moduleStatusChanged(); break;
+    case VehGroupDerived:      emit derivedUpdated(); break;
+    default: break;
+    }
+}
+
+void VehicleBusManager::restartUiUpdateTimer()
+{
+    // Tick at the fastest group's interval; slower groups skip ticks
+    int tickMs = m_groupFlush[0].intervalMs;
+    for (int i = 1; i < VehGroupCount; ++i)
+        tickMs = qMin(tickMs, m_groupFlush[i].intervalMs);
+    m_uiUpdateTimer->setInterval(tickMs);
+}
+
+void VehicleBusManager::setUpdateRate(VehicleGroup group, double hz)
+{
+    int index = groupIndex(group);
+    if (index < 0 || !(hz > 0.0)) {
+        qWarning() << "VehicleBusManager: Invalid update rate" << hz << "for group" << group;
         return;
     }
 
-    // Determine payload length
-    uint8_t len = (nbytes == CANFD_MTU) ? frame.len : frame.len;
+    m_groupFlush[index].intervalMs = qMax(1, qRound(1000.0 / qMin(hz, 1000.0)));
+    restartUiUpdateTimer();
+    qDebug() << "VehicleBusManager:" << kGroupNames[index] << "updates at" << hz << "Hz";
+}
 
-    processFrame(frame.can_id & CAN_EFF_MASK, frame.data, len);
+void VehicleBusManager::setUpdateRate(const QString &group, double hz)
+{
+    int index = groupIndex(group);
+    if (index < 0) {
+        qWarning() << "VehicleBusManager: Unknown signal group" << group;
+        return;
+    }
+    setUpdateRate(static_cast<VehicleGroup>(1u << index), hz);
 }
 
-void VehicleBusManager::sendFrame(uint32_t canId, const void *data, uint8_t len)
+double VehicleBusManager::updateRate(const QString &group) const
 {
-    if (m_socket < 0) return;
+    int index = groupIndex(group);
+    if (index < 0) return 0.0;
+    return 1000.0 / m_groupFlush[index].intervalMs;
+}
 
-    if (len <= 8) {
-        // Classic CAN frame
-        struct can_frame frame;
-        memset(&frame, 0, sizeof(frame));
-        frame.can_id = canId;
-        frame.can_dlc = len;
-        memcpy(frame.data, data, len);
+void VehicleBusManager::onBusStatsTimer()
+{
+    if (!m_reader) return;
+
+    quint64 frames = m_reader->framesReceived();
+    quint64 batches = m_reader->batches();
+    qint64 elapsedMs = m_busStatsClock.restart();
+
+    quint64 deltaFrames = frames - m_lastStatsFrames;
+    quint64 deltaBatches = batches - m_lastStatsBatches;
+    m_lastStatsFrames = frames;
+    m_lastStatsBatches = batches;
+
+    m_busFrameRate = elapsedMs > 0 ? static_cast<int>(deltaFrames * 1000 / elapsedMs) : 0;
+    m_busAvgBatch = deltaBatches > 0 ? static_cast<double>(deltaFrames) / deltaBatches : 0.0;
+    m_busFramesReceived = static_cast<qint64>(frames);
+    m_busReadErrors = static_cast<qint64>(m_reader->readErrors());
+
+    qint64 dropped = static_cast<qint64>(m_reader->framesDropped());
+    if (dropped > m_busFramesDropped) {
+        qWarning() << "VehicleBusManager: Kernel dropped" << (dropped - m_busFramesDropped)
+                   << "frames (rx queue overflow)";
+    }
+    m_busFramesDropped = dropped;
 
-        if (write(m_socket, &frame, sizeof(frame)) < 0) {
-            qWarning() << "VehicleBusManager: Send failed for 0x" << Qt::hex << canId << ":" << strerror(errno);
-        }
-    } else {
-        // CAN FD frame (>8 bytes)
-        struct canfd_frame frame;
-        memset(&frame, 0, sizeof(frame));
-        frame.can_id = canId;
-        frame.flags = CANFD_BRS;  // Bit rate switch for data phase
-        frame.len = len;
-        memcpy(frame.data, data, len);
-
-        if (write(m_socket, &frame, sizeof(frame)) < 0) {
-            qWarning() << "VehicleBusManager: Send FD failed for 0x" << Qt::hex << canId << ":" << strerror(errno);
-        }
+    if (m_tx) {
+        m_txQueued = static_cast<qint64>(m_tx->framesQueued());
+        m_txSent = static_cast<qint64>(m_tx->framesSent());
+        m_txRetried = static_cast<qint64>(m_tx->framesRetried());
+        m_txDropped = static_cast<qint64>(m_tx->framesDropped());
     }
+
+    emit busStatsChanged();
+}
+
+void VehicleBusManager::sendFrame(CanTxScheduler::Priority priority, uint32_t canId, const void *data, uint8_t len)
+{
+    if (!m_tx) return;
+    m_tx->send(priority, canId, data, len);
 }
 
 // ============================================================================
 // Message Processing
 // ============================================================================
 
-void VehicleBusManager::processFrame(uint32_t canId, const uint8_t *data, uint8_t len)
-{
-    switch (canId) {
-
-    // ---- ECM Telemetry ----
-
-    case CAN_VEH_ECM_RPM_TPS_MAP: {
-        if (len < sizeof(VehMsgRpmTpsMap)) break;
-        const auto *msg = reinterpret_cast<const VehMsgRpmTpsMap *>(data);
-        m_rpm = msg->rpm;
-        m_tps = msg->tps / 10.0;
-        m_mapKpa = msg->map_kpa;
-        m_timing = msg->timing;
-        emit telemetryUpdated();
-        break;
-    }
-
-    case CAN_VEH_ECM_TEMPS_BATT: {
-        if (len < sizeof(VehMsgTempsBatt)) break;
-        const auto *msg = reinterpret_cast<const VehMsgTempsBatt *>(data);
-        m_coolantTemp = msg->coolant / 10.0;
-        m_iatTemp = msg->iat / 10.0;
-        m_batteryVoltage = msg->battery_mv / 1000.0;
-        emit telemetryUpdated();
-        break;
-    }
-
-    case CAN_VEH_ECM_O2_FUELTRIM: {
-        if (len < sizeof(VehMsgO2FuelTrim)) break;
-        const auto *msg = reinterpret_cast<const VehMsgO2FuelTrim *>(data);
-        m_lambdaB1 = msg->lambda_b1 / 1000.0;
-        m_lambdaB2 = msg->lambda_b2 / 1000.0;
-        m_lambdaTarget = msg->lambda_target / 1000.0;
-        m_stft = msg->stft;
-        m_ltft = msg->ltft;
-        emit fuelUpdated();
-        break;
-    }
-
-    case CAN_VEH_ECM_IGN_KNOCK: {
-        if (len < sizeof(VehMsgIgnKnock)) break;
-        const auto *msg = reinterpret_cast<const VehMsgIgnKnock *>(data);
-        m_timing = msg->timing;
-        m_knockRetard = msg->knock_retard;
-        m_knockB1 = msg->knock_b1;
-        m_knockB2 = msg->knock_b2;
-        emit ignitionUpdated();
-        break;
-    }
-
-    case CAN_VEH_ECM_PRESSURES: {
-        if (len < sizeof(VehMsgPressures)) break;
-        const auto *msg = reinterpret_cast<const VehMsgPressures *>(data);
-        m_oilPressureKpa = msg->oil_kpa;
-        m_fuelPressureKpa = msg->fuel_kpa;
-        emit pressuresUpdated();
-        break;
-    }
-
-    case CAN_VEH_ECM_INJ_VE: {
-        if (len < sizeof(VehMsgInjVe)) break;
-        const auto *msg = reinterpret_cast<const VehMsgInjVe *>(data);
-        m_injectorPwUs = msg->injector_pw_us;
-        m_ve = msg->ve_pct / 10.0;
-        m_engineState = msg->engine_state;
-        m_injectorDuty = msg->duty_cycle / 10.0;
-        emit fuelUpdated();
-        break;
-    }
-
-    case CAN_VEH_ECM_FAULTS: {
-        if (len < sizeof(VehMsgFaults)) break;
-        const auto *msg = reinterpret_cast<const VehMsgFaults *>(data);
-        m_sensorFaults = msg->sensor_faults;
-        m_faultCount = msg->fault_count;
-        emit faultsUpdated();
-        break;
-    }
-
-    case CAN_VEH_ECM_DRIVE_MODE: {
-        if (len < sizeof(VehMsgDriveMode)) break;
-        const auto *msg = reinterpret_cast<const VehMsgDriveMode *>(data);
-        m_driveMode = msg->drive_mode;
-        m_launchState = msg->launch_state;
-        m_tractionMode = msg->traction_mode;
-        emit driveModeChanged();
-        break;
-    }
-
-    // ---- Tune ACK from ECM ----
-
-    case CAN_VEH_HMI_TUNE_ACK: {
-        if (len < sizeof(VehMsgTuneDelta)) break;
-        const auto *msg = reinterpret_cast<const VehMsgTuneDelta *>(data);
-        emit tuneAckReceived(msg->table_id, msg->rpm_idx, msg->map_idx, msg->delta != 0);
-        break;
-    }
-
-    // ---- Heartbeats ----
-
-    case CAN_VEH_ECM_HEARTBEAT: {
-        m_ecmLastHeartbeat.restart();
-        if (!m_ecmOnline) {
-            m_ecmOnline = true;
-            emit moduleStatusChanged();
-            qDebug() << "VehicleBusManager: ECM online";
-        }
-        break;
+uint32_t VehicleBusManager::processFrame(VehicleState &state, uint32_t canId, const uint8_t *data, uint8_t len)
+{
+    // Table-driven dispatch — see VehicleDecoders.h for the registry.
+    // Unknown IDs and short frames are ignored silently.
+    return VehicleDecoders::decode(state, canId, data, len);
+}
+
+// ============================================================================
+// Capture & Replay
+// ============================================================================
+
+bool VehicleBusManager::startCapture(const QString &path)
+{
+    stopCapture();
+
+    auto writer = std::make_unique<CanLogWriter>();
+    if (!writer->open(path)) return false;
+
+    m_captureWriter = std::move(writer);
+    if (m_reader) m_reader->setRecorder(m_captureWriter.get());
+    emit captureChanged();
+    qDebug() << "VehicleBusManager: Capturing CAN frames to" << path;
+    return true;
+}
+
+void VehicleBusManager::stopCapture()
+{
+    if (!m_captureWriter) return;
+
+    // Detach first so the reader thread is no longer appending
+    if (m_reader) m_reader->setRecorder(nullptr);
+    m_captureWriter->close();
+    qDebug() << "VehicleBusManager: Capture stopped," << m_captureWriter->framesWritten() << "frames written";
+    m_captureWriter.reset();
+    emit captureChanged();
+}
+
+bool VehicleBusManager::startLogging()
+{
+    if (m_logWriter) return true;
+
+    // The session is fed by the reader thread; without one it would stay empty
+    if (!m_reader) {
+        qWarning() << "VehicleBusManager: Not logging - no bus connected";
+        return false;
     }
 
-    case CAN_VEH_TCM_HEARTBEAT: {
-        m_tcmLastHeartbeat.restart();
-        if (!m_tcmOnline) {
-            m_tcmOnline = true;
-            emit moduleStatusChanged();
-            qDebug() << "VehicleBusManager: TCM online";
-        }
-        break;
+    // The writer creates, seals and closes the file on its own thread and
+    // deletes itself once it has finished
+    auto *writer = new TelemetryLogWriter(m_logDir, m_logRetentionBytes, this);
+    connect(writer, &QThread::finished, this, [this, writer]() {
+        if (!writer->path().isEmpty()) emit logSessionClosed(writer->path());
+    });
+    connect(writer, &QThread::finished, writer, &QObject::deleteLater);
+    connect(writer, &TelemetryLogWriter::failed, this, [this, writer](const QString &error) {
+        qWarning() << "VehicleBusManager: Logging failed:" << error;
+        if (m_logWriter == writer) stopLogging();
+    });
+    writer->open();
+
+    m_logWriter = writer;
+    m_reader->setDataLogger(m_logWriter);
+    emit loggingChanged();
+    return true;
+}
+
+void VehicleBusManager::stopLogging()
+{
+    if (!m_logWriter) return;
+
+    // Detach first so the reader thread is no longer recording
+    if (m_reader) m_reader->setDataLogger(nullptr);
+    m_logWriter->close();
+    m_logWriter = nullptr;
+    emit loggingChanged();
+}
+
+void VehicleBusManager::setLogRetention(double megabytes)
+{
+    if (!(megabytes > 0.0)) return;
+    m_logRetentionBytes = static_cast<qint64>(megabytes * 1024 * 1024);
+
+    // Applied by the writer thread, or when the next session starts
+    if (m_logWriter) m_logWriter->setRetentionBytes(m_logRetentionBytes);
+}
+
+QStringList VehicleBusManager::logSessions() const
+{
+    QStringList sessions = TelemetryLog::sessions(m_logDir);
+    if (m_logWriter) sessions.removeOne(m_logWriter->path());
+    return sessions;
+}
+
+bool VehicleBusManager::openLog(const QString &path)
+{
+    auto reader = std::make_unique<TelemetryLogReader>();
+    if (!reader->open(path)) return false;
+
+    m_logReader = std::move(reader);
+    emit loadedLogChanged();
+    qDebug() << "VehicleBusManager: Opened log" << path << "-" << loadedLogDuration() << "s";
+    return true;
+}
+
+void VehicleBusManager::closeLog()
+{
+    if (!m_logReader) return;
+    m_logReader.reset();
+    emit loadedLogChanged();
+}
+
+QVariantList VehicleBusManager::logTrace(const QString &channel, double startSec, double endSec, int width) const
+{
+    QVariantList result;
+    if (!m_logReader) return result;
+
+    int index = m_logReader->channelIndex(channel);
+    if (index < 0) {
+        qWarning() << "VehicleBusManager: Unknown log channel" << channel;
+        return result;
     }
 
-    case CAN_VEH_PDCM_HEARTBEAT: {
-        m_pdcmLastHeartbeat.restart();
-        if (!m_pdcmOnline) {
-            m_pdcmOnline = true;
-            emit moduleStatusChanged();
-            qDebug() << "VehicleBusManager: PDCM online";
+    const uint32_t startMs = static_cast<uint32_t>(qMax(0.0, startSec) * 1000.0);
+    const uint32_t endMs = static_cast<uint32_t>(qMax(0.0, endSec) * 1000.0);
+    const QVector<QPointF> points = m_logReader->query(index, startMs, endMs, width);
+    result.reserve(points.size());
+    for (const QPointF &pt : points)
+        result.append(pt);
+    return result;
+}
+
+bool VehicleBusManager::startReplay(const QString &path, double speed)
+{
+    if (m_connected) {
+        qWarning() << "VehicleBusManager: Disconnect from" << m_interface << "before replaying a log";
+        return false;
+    }
+    stopReplay();
+
+    auto log = std::make_unique<CanLogReader>();
+    if (!log->open(path)) return false;
+
+    m_replayHasFrame = log->next(m_replayFrame);
+    if (!m_replayHasFrame) {
+        qWarning() << "VehicleBusManager: Log" << path << "contains no frames";
+        return false;
+    }
+
+    m_replayLog = std::move(log);
+    m_replaySpeed = speed;
+    m_replayStartUs = m_replayFrame.timestampUs;
+    m_replayProgressPct = 0;
+
+    m_state = VehicleState();
+    m_ecmHeartbeatsSeen = m_tcmHeartbeatsSeen = m_pdcmHeartbeatsSeen = m_gcmHeartbeatsSeen = 0;
+    m_pendingDirty = 0;
+
+    // History is stamped with log time so traces keep their shape at any speed
+    m_history->clear();
+    m_replayHistoryBaseMs = m_history->nowMs();
+    m_replayNowMs = m_replayHistoryBaseMs;
+    m_derived.reset();
+
+    // Realtime replay polls the log clock every 5ms; flat-out replay yields
+    // to the event loop between chunks
+    m_replayTimer->setInterval(speed > 0.0 ? 5 : 0);
+    m_replayClock.start();
+    m_replayTimer->start();
+    m_uiUpdateTimer->start();
+
+    emit replayChanged();
+    qDebug() << "VehicleBusManager: Replaying" << path
+             << (speed > 0.0 ? QString("at %1x").arg(speed) : QString("as fast as possible"));
+    return true;
+}
+
+void VehicleBusManager::stopReplay()
+{
+    if (!m_replayLog) return;
+
+    m_replayTimer->stop();
+    if (!m_connected) m_uiUpdateTimer->stop();
+    m_replayLog.reset();
+    m_replayHasFrame = false;
+
+    m_ecmOnline = m_tcmOnline = m_pdcmOnline = m_gcmOnline = false;
+    emit moduleStatusChanged();
+    emit replayChanged();
+    emit replayProgressChanged();
+}
+
+void VehicleBusManager::onReplayTimer()
+{
+    if (!m_replayLog) return;
+
+    // Frames per tick when replaying flat out — keeps the UI responsive
+    constexpr int kReplayChunkFrames = 5000;
+
+    auto feed = [this]() {
+        if (!(m_replayFrame.canId & (CAN_ERR_FLAG | CAN_RTR_FLAG))) {
+            uint32_t groups = processFrame(m_state, m_replayFrame.canId & CAN_EFF_MASK,
+                                           m_replayFrame.data, m_replayFrame.len);
+            uint32_t logMs = static_cast<uint32_t>((m_replayFrame.timestampUs - m_replayStartUs) / 1000);
+            m_replayNowMs = m_replayHistoryBaseMs + logMs;
+            if (groups) m_history->record(m_state, groups, m_replayNowMs);
+        }
+        m_replayHasFrame = m_replayLog->next(m_replayFrame);
+    };
+
+    int processed = 0;
+    if (m_replaySpeed <= 0.0) {
+        while (m_replayHasFrame && processed < kReplayChunkFrames) {
+            feed();
+            ++processed;
+        }
+    } else {
+        const quint64 targetUs = m_replayStartUs
+            + static_cast<quint64>(m_replayClock.nsecsElapsed() / 1000.0 * m_replaySpeed);
+        while (m_replayHasFrame && m_replayFrame.timestampUs <= targetUs) {
+            feed();
+            ++processed;
         }
-        break;
     }
 
-    case CAN_VEH_GCM_HEARTBEAT: {
-        m_gcmLastHeartbeat.restart();
-        if (!m_gcmOnline) {
-            m_gcmOnline = true;
-            emit moduleStatusChanged();
-            qDebug() << "VehicleBusManager: GCM online";
+    if (processed > 0) applySnapshot(m_replayNowMs);
+
+    int pct = qRound(m_replayLog->progress() * 100.0);
+    if (pct != m_replayProgressPct) {
+        m_replayProgressPct = pct;
+        emit replayProgressChanged();
+    }
+
+    if (!m_replayHasFrame) {
+        // Let the last frames reach QML regardless of group intervals
+        for (int i = 0; i < VehGroupCount; ++i) {
+            if (m_pendingDirty & (1u << i)) emitGroup(i);
         }
-        break;
+        m_pendingDirty = 0;
+        qDebug() << "VehicleBusManager: Replay finished";
+        stopReplay();
+        emit replayFinished();
+    }
+}
+
+QVariantList VehicleBusManager::history(const QString &channel, double seconds, int width) const
+{
+    QVariantList result;
+    int index = TelemetryHistory::channelFromName(channel);
+    if (index < 0) {
+        qWarning() << "VehicleBusManager: Unknown history channel" << channel;
+        return result;
+    }
+
+    const QVector<QPointF> points = m_history->query(static_cast<TelemetryChannel>(index), seconds, width);
+    result.reserve(points.size());
+    for (const QPointF &pt : points)
+        result.append(pt);
+    return result;
+}
+
+QStringList VehicleBusManager::historyChannels() const
+{
+    QStringList names;
+    for (int i = 0; i < TelemetryHistory::channelCount(); ++i)
+        names.append(TelemetryHistory::channelName(static_cast<TelemetryChannel>(i)));
+    return names;
+}
+
+double VehicleBusManager::derivedValue(const QString &channel) const
+{
+    int index = DerivedChannels::channelFromName(channel);
+    if (index < 0) {
+        qWarning() << "VehicleBusManager: Unknown derived channel" << channel;
+        return 0.0;
     }
+    return m_derived.value(static_cast<DerivedChannel>(index));
+}
 
-    default:
-        // Unhandled message — ignore silently
-        break;
+void VehicleBusManager::setFuelSystem(double injectorCcMin, int cylinders)
+{
+    if (!(injectorCcMin > 0.0) || cylinders <= 0) {
+        qWarning() << "VehicleBusManager: Invalid fuel system" << injectorCcMin << "cc/min x" << cylinders;
+        return;
     }
+    DerivedConfig config = m_derived.config();
+    config.injectorCcMin = injectorCcMin;
+    config.cylinders = cylinders;
+    m_derived.setConfig(config);
+}
+
+void VehicleBusManager::setBaroKpa(double kpa)
+{
+    DerivedConfig config = m_derived.config();
+    config.baroKpa = kpa;
+    m_derived.setConfig(config);
+}
+
+void VehicleBusManager::resetTrip()
+{
+    m_derived.resetTrip();
+    m_pendingDirty |= VehGroupDerived;
+    qDebug() << "VehicleBusManager: Trip fuel reset";
+}
+
+qint64 VehicleBusManager::convertLog(const QString &inPath, const QString &outPath)
+{
+    return CanFrameLog::convert(inPath, outPath, m_interface.isEmpty() ? QStringLiteral("can0") : m_interface);
 }
 
 // ============================================================================
@@ -343,7 +718,7 @@ void VehicleBusManager::sendHeartbeat()
     VehMsgHeartbeat hb;
     hb.module_id = ModuleID::HMI;
     hb.status = static_cast<uint8_t>(HeartbeatStatus::OK);
-    sendFrame(CAN_VEH_HMI_HEARTBEAT, &hb, sizeof(hb));
+    sendFrame(CanTxScheduler::Heartbeat, CAN_VEH_HMI_HEARTBEAT, &hb, sizeof(hb));
 }
 
 void VehicleBusManager::onModuleTimeoutCheck()
@@ -371,7 +746,7 @@ void VehicleBusManager::onModuleTimeoutCheck()
         qWarning() << "VehicleBusManager: GCM offline (heartbeat timeout)";
     }
 
-    if (changed) emit moduleStatusChanged();
+    if (changed) m_pendingDirty |= VehGroupModuleStatus;
 }
 
 // ============================================================================
@@ -384,7 +759,7 @@ void VehicleBusManager::setDriveMode(int mode)
     memset(&cmd, 0, sizeof(cmd));
     cmd.mode = static_cast<uint8_t>(mode);
     cmd.source = 0;  // HMI source
-    sendFrame(CAN_VEH_HMI_DRIVE_MODE_CMD, &cmd, sizeof(cmd));
+    sendFrame(CanTxScheduler::Safety, CAN_VEH_HMI_DRIVE_MODE_CMD, &cmd, sizeof(cmd));
     qDebug() << "VehicleBusManager: Drive mode command sent:" << mode;
 }
 
@@ -392,7 +767,7 @@ void VehicleBusManager::setLaunchControl(bool enable)
 {
     uint8_t data[4] = {};
     data[0] = enable ? 1 : 0;
-    sendFrame(CAN_VEH_HMI_LAUNCH_CMD, data, 4);
+    sendFrame(CanTxScheduler::Safety, CAN_VEH_HMI_LAUNCH_CMD, data, 4);
     qDebug() << "VehicleBusManager: Launch control" << (enable ? "enabled" : "disabled");
 }
 
@@ -400,7 +775,7 @@ void VehicleBusManager::setTractionControl(int mode)
 {
     uint8_t data[4] = {};
     data[0] = static_cast<uint8_t>(mode);
-    sendFrame(CAN_VEH_HMI_TRACTION_CMD, data, 4);
+    sendFrame(CanTxScheduler::Safety, CAN_VEH_HMI_TRACTION_CMD, data, 4);
     qDebug() << "VehicleBusManager: Traction control mode:" << mode;
 }
 
@@ -415,10 +790,15 @@ void VehicleBusManager::sendGps(double lat, double lon, double alt, double speed
     msg.fix_quality = static_cast<uint8_t>(fix);
     msg.satellites = static_cast<uint8_t>(sats);
     msg.heading = static_cast<uint16_t>(heading * 10);
-    sendFrame(CAN_VEH_HMI_GPS_ALTITUDE, &msg, sizeof(msg));
+    sendFrame(CanTxScheduler::Gps, CAN_VEH_HMI_GPS_ALTITUDE, &msg, sizeof(msg));
 }
 
 void VehicleBusManager::sendTuneDelta(int tableId, int rpmIdx, int mapIdx, int delta)
+{
+    sendTuneDelta(tableId, rpmIdx, mapIdx, delta, m_tuneSeq++);
+}
+
+void VehicleBusManager::sendTuneDelta(int tableId, int rpmIdx, int mapIdx, int delta, uint16_t seq)
 {
     if (!m_ecmOnline) {
         qWarning() << "VehicleBusManager: Cannot send tune delta - ECM offline";
@@ -431,17 +811,51 @@ void VehicleBusManager::sendTuneDelta(int tableId, int rpmIdx, int mapIdx, int d
     msg.rpm_idx = static_cast<uint8_t>(rpmIdx);
     msg.map_idx = static_cast<uint8_t>(mapIdx);
     msg.delta = static_cast<int16_t>(delta);
-    msg.session_seq = m_tuneSeq++;
-    sendFrame(CAN_VEH_HMI_AI_TUNE_DELTA, &msg, sizeof(msg));
+    msg.session_seq = seq;
+    sendFrame(CanTxScheduler::Safety, CAN_VEH_HMI_AI_TUNE_DELTA, &msg, sizeof(msg));
     qDebug() << "VehicleBusManager: Tune delta sent - table:" << tableId
              << "rpm:" << rpmIdx << "map:" << mapIdx << "delta:" << delta;
 }
 
+bool VehicleBusManager::supportsTunePatches()
+{
+#ifdef CAN_VEH_HMI_AI_TUNE_PATCH
+    return true;
+#else
+    return false;
+#endif
+}
+
+void VehicleBusManager::sendTunePatch(const TunePatchFrame &frame, int cells)
+{
+#ifdef CAN_VEH_HMI_AI_TUNE_PATCH
+    if (!m_ecmOnline) {
+        qWarning() << "VehicleBusManager: Cannot send tune patch - ECM offline";
+        return;
+    }
+
+    // CAN FD payloads above 8 bytes come in fixed steps
+    static const uint8_t kFdLengths[] = { 12, 16, 20, 24, 32, 48, 64 };
+    const int needed = static_cast<int>(offsetof(TunePatchFrame, deltas)) + cells * static_cast<int>(sizeof(int16_t));
+    uint8_t len = 64;
+    for (uint8_t l : kFdLengths) {
+        if (l >= needed) { len = l; break; }
+    }
+    // Never the tune-delta ID: an older ECM would read the patch header as
+    // a cell delta
+    sendFrame(CanTxScheduler::Safety, CAN_VEH_HMI_AI_TUNE_PATCH, &frame, len);
+#else
+    Q_UNUSED(frame)
+    Q_UNUSED(cells)
+    qWarning() << "VehicleBusManager: Tune patches not supported by this platform - use per-cell deltas";
+#endif
+}
+
 void VehicleBusManager::sendTuneRollback()
 {
     uint8_t data[4] = {};
     data[0] = 0xFF;  // Rollback all
-    sendFrame(CAN_VEH_HMI_AI_ROLLBACK, data, 4);
+    sendFrame(CanTxScheduler::Safety, CAN_VEH_HMI_AI_ROLLBACK, data, 4);
     m_tuneSeq = 0;
     qDebug() << "VehicleBusManager: Rollback command sent";
 }
@@ -2,15 +2,24 @@
 
 #include <QObject>
 #include <QTimer>
-#include <QSocketNotifier>
 #include <QElapsedTimer>
 #include <QJsonObject>
 #include <QVariantMap>
+#include <memory>
 
 #include "platform/can/VehicleCAN.h"
 #include "platform/can/VehicleMessages.h"
 #include "platform/types/VehicleTypes.h"
 #include "platform/types/ModuleIDs.h"
+#include "VehicleState.h"
+#include "CanFrameLog.h"
+#include "TelemetryHistory.h"
+#include "DerivedChannels.h"
+#include "TelemetryLog.h"
+#include "CanTxScheduler.h"
+
+class CanBusReader;
+struct TunePatchFrame;
 
 class VehicleBusManager : public QObject
 {
@@ -64,6 +73,38 @@ class VehicleBusManager : public QObject
     Q_PROPERTY(int faultCount READ faultCount NOTIFY faultsUpdated)
     Q_PROPERTY(int sensorFaults READ sensorFaults NOTIFY faultsUpdated)
 
+    // Derived channels — computed from the decoded state, see DerivedChannels.h
+    Q_PROPERTY(double afrB1 READ afrB1 NOTIFY derivedUpdated)
+    Q_PROPERTY(double afrB2 READ afrB2 NOTIFY derivedUpdated)
+    Q_PROPERTY(double afrTarget READ afrTarget NOTIFY derivedUpdated)
+    Q_PROPERTY(double boostKpa READ boostKpa NOTIFY derivedUpdated)
+    Q_PROPERTY(double fuelFlowLph READ fuelFlowLph NOTIFY derivedUpdated)
+    Q_PROPERTY(double tripFuelL READ tripFuelL NOTIFY derivedUpdated)
+    Q_PROPERTY(double rpmAvg READ rpmAvg NOTIFY derivedUpdated)
+    Q_PROPERTY(double knockRetardP95 READ knockRetardP95 NOTIFY derivedUpdated)
+    Q_PROPERTY(double injectorDutyP95 READ injectorDutyP95 NOTIFY derivedUpdated)
+
+    // Bus reader health — refreshed once per second
+    Q_PROPERTY(int busFrameRate READ busFrameRate NOTIFY busStatsChanged)
+    Q_PROPERTY(qint64 busFramesReceived READ busFramesReceived NOTIFY busStatsChanged)
+    Q_PROPERTY(qint64 busFramesDropped READ busFramesDropped NOTIFY busStatsChanged)
+    Q_PROPERTY(qint64 busReadErrors READ busReadErrors NOTIFY busStatsChanged)
+    Q_PROPERTY(double busAvgBatch READ busAvgBatch NOTIFY busStatsChanged)
+    Q_PROPERTY(qint64 txQueued READ txQueued NOTIFY busStatsChanged)
+    Q_PROPERTY(qint64 txSent READ txSent NOTIFY busStatsChanged)
+    Q_PROPERTY(qint64 txRetried READ txRetried NOTIFY busStatsChanged)
+    Q_PROPERTY(qint64 txDropped READ txDropped NOTIFY busStatsChanged)
+
+    // Capture / replay
+    Q_PROPERTY(bool capturing READ capturing NOTIFY captureChanged)
+    Q_PROPERTY(bool replaying READ replaying NOTIFY replayChanged)
+    Q_PROPERTY(double replayProgress READ replayProgress NOTIFY replayProgressChanged)
+
+    // Session datalogger
+    Q_PROPERTY(bool logging READ logging NOTIFY loggingChanged)
+    Q_PROPERTY(QString loadedLog READ loadedLog NOTIFY loadedLogChanged)
+    Q_PROPERTY(double loadedLogDuration READ loadedLogDuration NOTIFY loadedLogChanged)
+
 public:
     explicit VehicleBusManager(QObject *parent = nullptr);
     ~VehicleBusManager();
@@ -77,36 +118,64 @@ public:
     bool pdcmOnline() const { return m_pdcmOnline; }
     bool gcmOnline() const { return m_gcmOnline; }
 
-    int rpm() const { return m_rpm; }
-    double tps() const { return m_tps; }
-    int mapKpa() const { return m_mapKpa; }
-    int timing() const { return m_timing; }
-    double coolantTemp() const { return m_coolantTemp; }
-    double iatTemp() const { return m_iatTemp; }
-    double batteryVoltage() const { return m_batteryVoltage; }
-    int oilPressureKpa() const { return m_oilPressureKpa; }
-    int fuelPressureKpa() const { return m_fuelPressureKpa; }
-
-    double lambdaB1() const { return m_lambdaB1; }
-    double lambdaB2() const { return m_lambdaB2; }
-    double lambdaTarget() const { return m_lambdaTarget; }
-    int stft() const { return m_stft; }
-    int ltft() const { return m_ltft; }
-    int injectorPwUs() const { return m_injectorPwUs; }
-    double ve() const { return m_ve; }
-    double injectorDuty() const { return m_injectorDuty; }
-
-    int knockRetard() const { return m_knockRetard; }
-    int knockB1() const { return m_knockB1; }
-    int knockB2() const { return m_knockB2; }
-
-    int driveMode() const { return m_driveMode; }
-    int launchState() const { return m_launchState; }
-    int tractionMode() const { return m_tractionMode; }
-
-    int engineState() const { return m_engineState; }
-    int faultCount() const { return m_faultCount; }
-    int sensorFaults() const { return m_sensorFaults; }
+    int rpm() const { return m_state.rpm; }
+    double tps() const { return m_state.tps; }
+    int mapKpa() const { return m_state.mapKpa; }
+    int timing() const { return m_state.timing; }
+    double coolantTemp() const { return m_state.coolantTemp; }
+    double iatTemp() const { return m_state.iatTemp; }
+    double batteryVoltage() const { return m_state.batteryVoltage; }
+    int oilPressureKpa() const { return m_state.oilPressureKpa; }
+    int fuelPressureKpa() const { return m_state.fuelPressureKpa; }
+
+    double lambdaB1() const { return m_state.lambdaB1; }
+    double lambdaB2() const { return m_state.lambdaB2; }
+    double lambdaTarget() const { return m_state.lambdaTarget; }
+    int stft() const { return m_state.stft; }
+    int ltft() const { return m_state.ltft; }
+    int injectorPwUs() const { return m_state.injectorPwUs; }
+    double ve() const { return m_state.ve; }
+    double injectorDuty() const { return m_state.injectorDuty; }
+
+    int knockRetard() const { return m_state.knockRetard; }
+    int knockB1() const { return m_state.knockB1; }
+    int knockB2() const { return m_state.knockB2; }
+
+    int driveMode() const { return m_state.driveMode; }
+    int launchState() const { return m_state.launchState; }
+    int tractionMode() const { return m_state.tractionMode; }
+
+    int engineState() const { return m_state.engineState; }
+    int faultCount() const { return m_state.faultCount; }
+    int sensorFaults() const { return m_state.sensorFaults; }
+
+    double afrB1() const { return m_derived.value(DerivedChannel::AfrB1); }
+    double afrB2() const { return m_derived.value(DerivedChannel::AfrB2); }
+    double afrTarget() const { return m_derived.value(DerivedChannel::AfrTarget); }
+    double boostKpa() const { return m_derived.value(DerivedChannel::BoostKpa); }
+    double fuelFlowLph() const { return m_derived.value(DerivedChannel::FuelFlowLph); }
+    double tripFuelL() const { return m_derived.value(DerivedChannel::TripFuelL); }
+    double rpmAvg() const { return m_derived.value(DerivedChannel::RpmAvg); }
+    double knockRetardP95() const { return m_derived.value(DerivedChannel::KnockRetardP95); }
+    double injectorDutyP95() const { return m_derived.value(DerivedChannel::InjectorDutyP95); }
+
+    int busFrameRate() const { return m_busFrameRate; }
+    qint64 busFramesReceived() const { return m_busFramesReceived; }
+    qint64 busFramesDropped() const { return m_busFramesDropped; }
+    qint64 busReadErrors() const { return m_busReadErrors; }
+    double busAvgBatch() const { return m_busAvgBatch; }
+    qint64 txQueued() const { return m_txQueued; }
+    qint64 txSent() const { return m_txSent; }
+    qint64 txRetried() const { return m_txRetried; }
+    qint64 txDropped() const { return m_txDropped; }
+
+    bool capturing() const { return m_captureWriter != nullptr; }
+    bool replaying() const { return m_replayLog != nullptr; }
+    double replayProgress() const { return m_replayLog ? m_replayLog->progress() : 0.0; }
+
+    bool logging() const { return m_logWriter != nullptr; }
+    QString loadedLog() const { return m_logReader ? m_logReader->path() : QString(); }
+    double loadedLogDuration() const { return m_logReader ? m_logReader->durationMs() / 1000.0 : 0.0; }
 
     // Safe commands — callable from QML directly
     Q_INVOKABLE void sendGps(double lat, double lon, double alt, double speedKph, double heading, int fix, int sats);
@@ -131,10 +200,70 @@ public:
     void sendTuneDelta(int tableId, int rpmIdx, int mapIdx, int delta);
     void sendTuneRollback();
 
+    // Batched tune transfer (TuneSession). nextTuneSeq() reserves a
+    // session_seq; sendTunePatch() sends a patch covering `cells` cells as
+    // one CAN FD frame on the patch ID, trimmed to the smallest valid FD
+    // length. Patches are only available when the platform headers assign
+    // that ID; otherwise TuneSession streams single-cell deltas, each with
+    // its own reserved seq.
+    uint16_t nextTuneSeq() { return m_tuneSeq++; }
+    static bool supportsTunePatches();
+    void sendTunePatch(const TunePatchFrame &frame, int cells);
+    void sendTuneDelta(int tableId, int rpmIdx, int mapIdx, int delta, uint16_t seq);
+
+    // Per-group UI update rate. Frames only mutate state; each signal group is
+    // emitted at most once per its own flush interval. Group names:
+    // telemetry, pressures, fuel, ignition, driveMode, faults, moduleStatus, derived
+    Q_INVOKABLE void setUpdateRate(const QString &group, double hz);
+    Q_INVOKABLE double updateRate(const QString &group) const;
+    void setUpdateRate(VehicleGroup group, double hz);
+
     // Connection control
     Q_INVOKABLE void connectBus(const QString &iface = "can0");
     Q_INVOKABLE void disconnectBus();
 
+    // Capture every received frame to a binary log (see CanFrameLog.h).
+    // May be started before connectBus(); recording begins once connected.
+    Q_INVOKABLE bool startCapture(const QString &path);
+    Q_INVOKABLE void stopCapture();
+
+    // Replay a binary or candump log through the decoder as if it came off
+    // the bus. speed is a multiplier on log time; <= 0 replays as fast as
+    // possible. Not available while connected to a live bus.
+    Q_INVOKABLE bool startReplay(const QString &path, double speed = 1.0);
+    Q_INVOKABLE void stopReplay();
+
+    // Binary <-> candump conversion, format chosen by file extension
+    Q_INVOKABLE qint64 convertLog(const QString &inPath, const QString &outPath);
+
+    // Session datalogger — every telemetry channel to a columnar session file
+    // (see TelemetryLog.h). Starts automatically on connectBus() and needs a
+    // connected bus; the oldest sessions are deleted once the log directory
+    // exceeds the retention size.
+    Q_INVOKABLE bool startLogging();
+    Q_INVOKABLE void stopLogging();
+    Q_INVOKABLE void setLogRetention(double megabytes);
+    Q_INVOKABLE QStringList logSessions() const;   // Finished ones, oldest first
+
+    // Review a finished session. logTrace() returns min/max pairs per pixel
+    // column for [startSec, endSec], x in seconds from session start.
+    Q_INVOKABLE bool openLog(const QString &path);
+    Q_INVOKABLE void closeLog();
+    Q_INVOKABLE QVariantList logTrace(const QString &channel, double startSec, double endSec, int width) const;
+
+    // Telemetry history for traces. Returns at most 2 * width points (min/max
+    // per bucket) covering the last `seconds` of the channel, as QPointF with
+    // x in seconds relative to the newest sample (<= 0).
+    Q_INVOKABLE QVariantList history(const QString &channel, double seconds, int width) const;
+    Q_INVOKABLE QStringList historyChannels() const;
+    const TelemetryHistory &telemetryHistory() const { return *m_history; }
+
+    // Derived channels by name (e.g. "afrB1", "tripFuelL") and engine constants
+    Q_INVOKABLE double derivedValue(const QString &channel) const;
+    Q_INVOKABLE void setFuelSystem(double injectorCcMin, int cylinders);
+    Q_INVOKABLE void setBaroKpa(double kpa);
+    Q_INVOKABLE void resetTrip();
+
 signals:
     void connectedChanged();
     void interfaceChanged();
@@ -145,30 +274,48 @@ signals:
     void ignitionUpdated();
     void driveModeChanged();
     void faultsUpdated();
-    void tuneAckReceived(int tableId, int rpmIdx, int mapIdx, bool accepted);
+    void derivedUpdated();
+    void tuneAckReceived(int tableId, int rpmIdx, int mapIdx, bool accepted, int seq);
     void confirmationRequired(const QString &description);  // QML shows confirmation dialog
     void pendingCommandCancelled();
+    void busStatsChanged();
+    void captureChanged();
+    void replayChanged();
+    void replayProgressChanged();
+    void replayFinished();
+    void loggingChanged();
+    void logSessionClosed(const QString &path);   // Index written, ready to open
+    void loadedLogChanged();
 
 private slots:
-    void onCanData();
+    void onBusSnapshot();    // Reader thread has new decoded state
+    void onBusStatsTimer();
+    void onReplayTimer();
     void onHeartbeatTimer();
     void onModuleTimeoutCheck();
-    void onUiUpdateTimer();  // 30Hz coalescing timer — emits dirty signals to QML
+    void onUiUpdateTimer();  // Flush tick — emits due dirty groups to QML
 
 private:
-    void processFrame(uint32_t canId, const uint8_t *data, uint8_t len);
-    void sendFrame(uint32_t canId, const void *data, uint8_t len);
+    // Decodes one frame into state. Runs on the reader thread — must not
+    // touch members or emit signals.
+    static uint32_t processFrame(VehicleState &state, uint32_t canId, const uint8_t *data, uint8_t len);
+    void applySnapshot(uint32_t timeMs);
+    void emitGroup(int index);
+    void restartUiUpdateTimer();
+    void sendFrame(CanTxScheduler::Priority priority, uint32_t canId, const void *data, uint8_t len);
     void sendHeartbeat();
 
     // Socket
     int m_socket = -1;
-    QSocketNotifier *m_notifier = nullptr;
+    CanBusReader *m_reader = nullptr;
+    CanTxScheduler *m_tx = nullptr;
     bool m_connected = false;
     QString m_interface;
 
     // Timers
     QTimer *m_heartbeatTimer;
     QTimer *m_timeoutTimer;
+    QTimer *m_busStatsTimer;
 
     // Module heartbeat tracking
     bool m_ecmOnline = false;
@@ -179,50 +326,65 @@ private:
     QElapsedTimer m_tcmLastHeartbeat;
     QElapsedTimer m_pdcmLastHeartbeat;
     QElapsedTimer m_gcmLastHeartbeat;
-
-    // ECM telemetry state
-    int m_rpm = 0;
-    double m_tps = 0.0;
-    int m_mapKpa = 0;
-    int m_timing = 0;
-    double m_coolantTemp = 0.0;
-    double m_iatTemp = 0.0;
-    double m_batteryVoltage = 0.0;
-    int m_oilPressureKpa = 0;
-    int m_fuelPressureKpa = 0;
-
-    double m_lambdaB1 = 0.0;
-    double m_lambdaB2 = 0.0;
-    double m_lambdaTarget = 0.0;
-    int m_stft = 0;
-    int m_ltft = 0;
-    int m_injectorPwUs = 0;
-    double m_ve = 0.0;
-    double m_injectorDuty = 0.0;
-
-    int m_knockRetard = 0;
-    int m_knockB1 = 0;
-    int m_knockB2 = 0;
-
-    int m_driveMode = 1;  // NORMAL
-    int m_launchState = 0;
-    int m_tractionMode = 1;
-
-    int m_engineState = 0;
-    int m_faultCount = 0;
-    int m_sensorFaults = 0;
+    uint32_t m_ecmHeartbeatsSeen = 0;
+    uint32_t m_tcmHeartbeatsSeen = 0;
+    uint32_t m_pdcmHeartbeatsSeen = 0;
+    uint32_t m_gcmHeartbeatsSeen = 0;
+
+    // Latest decoded bus state (GUI-thread copy of the reader's snapshot)
+    VehicleState m_state;
+
+    // Bus reader statistics
+    int m_busFrameRate = 0;
+    qint64 m_busFramesReceived = 0;
+    qint64 m_busFramesDropped = 0;
+    qint64 m_busReadErrors = 0;
+    double m_busAvgBatch = 0.0;
+    qint64 m_txQueued = 0;
+    qint64 m_txSent = 0;
+    qint64 m_txRetried = 0;
+    qint64 m_txDropped = 0;
+    quint64 m_lastStatsFrames = 0;
+    quint64 m_lastStatsBatches = 0;
+    QElapsedTimer m_busStatsClock;
+
+    // Per-channel sample rings (written by the reader thread or replay)
+    std::unique_ptr<TelemetryHistory> m_history;
+
+    // Computed on the GUI thread from each snapshot's dirty groups
+    DerivedChannels m_derived;
+
+    // Capture / replay
+    std::unique_ptr<CanLogWriter> m_captureWriter;
+    std::unique_ptr<CanLogReader> m_replayLog;
+    QTimer *m_replayTimer;
+    QElapsedTimer m_replayClock;
+    double m_replaySpeed = 1.0;
+    quint64 m_replayStartUs = 0;
+    CanLogFrame m_replayFrame;
+    bool m_replayHasFrame = false;
+    int m_replayProgressPct = 0;
+    uint32_t m_replayHistoryBaseMs = 0;
+    uint32_t m_replayNowMs = 0;
+
+    // Session datalogger
+    TelemetryLogWriter *m_logWriter = nullptr;   // Deletes itself once closed
+    std::unique_ptr<TelemetryLogReader> m_logReader;
+    QString m_logDir;
+    qint64 m_logRetentionBytes = 512LL * 1024 * 1024;
 
     uint16_t m_tuneSeq = 0;
 
-    // UI update coalescing — CAN data stored immediately, signals emitted at 30Hz max
+    // UI update coalescing — snapshots only mutate state and set dirty bits;
+    // the flush tick emits each due group at most once
+    struct GroupFlush {
+        int intervalMs = 33;
+        qint64 lastFlushMs = 0;
+    };
     QTimer *m_uiUpdateTimer = nullptr;
-    bool m_dirtyTelemetry = false;
-    bool m_dirtyPressures = false;
-    bool m_dirtyFuel = false;
-    bool m_dirtyIgnition = false;
-    bool m_dirtyDriveMode = false;
-    bool m_dirtyFaults = false;
-    bool m_dirtyModuleStatus = false;
+    GroupFlush m_groupFlush[VehGroupCount];
+    uint32_t m_pendingDirty = 0;
+    QElapsedTimer m_flushClock;
 
     // Pending command gate — stores the command until user confirms
     enum class PendingCmd { None, DriveMode, LaunchControl, TractionControl, TuneDelta, TuneRollback };
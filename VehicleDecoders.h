@@ -0,0 +1,207 @@
+#ifndef VEHICLEDECODERS_H
+#define VEHICLEDECODERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "platform/can/VehicleCAN.h"
+#include "platform/can/VehicleMessages.h"
+#include "VehicleState.h"
+
+// Compile-time CAN decoder registry.
+//
+// Each entry maps a CAN ID to a typed handler and the signal group it
+// dirties. The minimum payload length comes from sizeof() of the message
+// struct, the table is sorted at compile time, and lookup is a fixed-depth
+// branchless binary search — one lookup per frame, no switch cascade.
+//
+// To add a message: write a handler below and add one line to kEntries.
+namespace VehicleDecoders {
+
+using DecodeFn = void (*)(VehicleState &state, const uint8_t *data);
+
+struct Entry {
+    uint32_t canId;
+    uint8_t minLen;
+    uint32_t group;   // VehicleGroup bits set after a successful decode
+    DecodeFn decode;
+};
+
+// Copies the payload into an aligned Msg before handing it to the handler
+template <typename Msg, void (*Handler)(VehicleState &, const Msg &)>
+void decodeAs(VehicleState &state, const uint8_t *data)
+{
+    Msg msg;
+    memcpy(&msg, data, sizeof(Msg));
+    Handler(state, msg);
+}
+
+template <typename Msg, void (*Handler)(VehicleState &, const Msg &)>
+constexpr Entry message(uint32_t canId, uint32_t group)
+{
+    static_assert(sizeof(Msg) <= 64, "message larger than a CAN FD payload");
+    return { canId, static_cast<uint8_t>(sizeof(Msg)), group, &decodeAs<Msg, Handler> };
+}
+
+// Payload-less frames (heartbeats) — no length requirement, no group
+template <void (*Handler)(VehicleState &)>
+void decodeEvent(VehicleState &state, const uint8_t *)
+{
+    Handler(state);
+}
+
+template <void (*Handler)(VehicleState &)>
+constexpr Entry event(uint32_t canId)
+{
+    return { canId, 0, 0, &decodeEvent<Handler> };
+}
+
+// ---- ECM Telemetry ----
+
+inline void rpmTpsMap(VehicleState &s, const VehMsgRpmTpsMap &m)
+{
+    s.rpm = m.rpm;
+    s.tps = m.tps / 10.0;
+    s.mapKpa = m.map_kpa;
+    s.timing = m.timing;
+}
+
+inline void tempsBatt(VehicleState &s, const VehMsgTempsBatt &m)
+{
+    s.coolantTemp = m.coolant / 10.0;
+    s.iatTemp = m.iat / 10.0;
+    s.batteryVoltage = m.battery_mv / 1000.0;
+}
+
+inline void o2FuelTrim(VehicleState &s, const VehMsgO2FuelTrim &m)
+{
+    s.lambdaB1 = m.lambda_b1 / 1000.0;
+    s.lambdaB2 = m.lambda_b2 / 1000.0;
+    s.lambdaTarget = m.lambda_target / 1000.0;
+    s.stft = m.stft;
+    s.ltft = m.ltft;
+}
+
+inline void ignKnock(VehicleState &s, const VehMsgIgnKnock &m)
+{
+    s.timing = m.timing;
+    s.knockRetard = m.knock_retard;
+    s.knockB1 = m.knock_b1;
+    s.knockB2 = m.knock_b2;
+}
+
+inline void pressures(VehicleState &s, const VehMsgPressures &m)
+{
+    s.oilPressureKpa = m.oil_kpa;
+    s.fuelPressureKpa = m.fuel_kpa;
+}
+
+inline void injVe(VehicleState &s, const VehMsgInjVe &m)
+{
+    s.injectorPwUs = m.injector_pw_us;
+    s.ve = m.ve_pct / 10.0;
+    s.engineState = m.engine_state;
+    s.injectorDuty = m.duty_cycle / 10.0;
+}
+
+inline void faults(VehicleState &s, const VehMsgFaults &m)
+{
+    s.sensorFaults = m.sensor_faults;
+    s.faultCount = m.fault_count;
+}
+
+inline void driveMode(VehicleState &s, const VehMsgDriveMode &m)
+{
+    s.driveMode = m.drive_mode;
+    s.launchState = m.launch_state;
+    s.tractionMode = m.traction_mode;
+}
+
+// ---- Tune ACK from ECM ----
+
+inline void tuneAck(VehicleState &s, const VehMsgTuneDelta &m)
+{
+    s.tuneAcks.append({m.table_id, m.rpm_idx, m.map_idx, m.delta != 0, m.session_seq});
+}
+
+// ---- Heartbeats ----
+// Online/offline transitions are decided on the GUI thread
+
+inline void ecmHeartbeat(VehicleState &s) { ++s.ecmHeartbeats; }
+inline void tcmHeartbeat(VehicleState &s) { ++s.tcmHeartbeats; }
+inline void pdcmHeartbeat(VehicleState &s) { ++s.pdcmHeartbeats; }
+inline void gcmHeartbeat(VehicleState &s) { ++s.gcmHeartbeats; }
+
+// ---- Registry ----
+
+constexpr std::array<Entry, 13> kEntries = {{
+    message<VehMsgRpmTpsMap, rpmTpsMap>(CAN_VEH_ECM_RPM_TPS_MAP, VehGroupTelemetry),
+    message<VehMsgTempsBatt, tempsBatt>(CAN_VEH_ECM_TEMPS_BATT, VehGroupTelemetry),
+    message<VehMsgO2FuelTrim, o2FuelTrim>(CAN_VEH_ECM_O2_FUELTRIM, VehGroupFuel),
+    message<VehMsgIgnKnock, ignKnock>(CAN_VEH_ECM_IGN_KNOCK, VehGroupIgnition),
+    message<VehMsgPressures, pressures>(CAN_VEH_ECM_PRESSURES, VehGroupPressures),
+    message<VehMsgInjVe, injVe>(CAN_VEH_ECM_INJ_VE, VehGroupFuel),
+    message<VehMsgFaults, faults>(CAN_VEH_ECM_FAULTS, VehGroupFaults),
+    message<VehMsgDriveMode, driveMode>(CAN_VEH_ECM_DRIVE_MODE, VehGroupDriveMode),
+    message<VehMsgTuneDelta, tuneAck>(CAN_VEH_HMI_TUNE_ACK, 0),
+    event<ecmHeartbeat>(CAN_VEH_ECM_HEARTBEAT),
+    event<tcmHeartbeat>(CAN_VEH_TCM_HEARTBEAT),
+    event<pdcmHeartbeat>(CAN_VEH_PDCM_HEARTBEAT),
+    event<gcmHeartbeat>(CAN_VEH_GCM_HEARTBEAT),
+}};
+
+template <std::size_t N>
+constexpr std::array<Entry, N> sortedById(std::array<Entry, N> entries)
+{
+    for (std::size_t i = 1; i < N; ++i) {
+        for (std::size_t j = i; j > 0 && entries[j].canId < entries[j - 1].canId; --j) {
+            Entry tmp = entries[j];
+            entries[j] = entries[j - 1];
+            entries[j - 1] = tmp;
+        }
+    }
+    return entries;
+}
+
+template <std::size_t N>
+constexpr bool uniqueIds(const std::array<Entry, N> &sorted)
+{
+    for (std::size_t i = 1; i < N; ++i) {
+        if (sorted[i].canId == sorted[i - 1].canId) return false;
+    }
+    return true;
+}
+
+constexpr auto kTable = sortedById(kEntries);
+static_assert(uniqueIds(kTable), "duplicate CAN ID in decoder registry");
+
+// Branchless lower-bound search. N is a compile-time constant, so the loop
+// has a fixed trip count and unrolls into conditional moves.
+inline const Entry *find(uint32_t canId)
+{
+    const Entry *base = kTable.data();
+    std::size_t n = kTable.size();
+    while (n > 1) {
+        std::size_t half = n / 2;
+        base = (base[half].canId <= canId) ? base + half : base;
+        n -= half;
+    }
+    return base->canId == canId ? base : nullptr;
+}
+
+// Decodes one frame into state. Returns the VehicleGroup bits it touched —
+// 0 for unknown IDs, short frames and event-only frames.
+inline uint32_t decode(VehicleState &state, uint32_t canId, const uint8_t *data, uint8_t len)
+{
+    const Entry *entry = find(canId);
+    if (!entry || len < entry->minLen) return 0;
+    entry->decode(state, data);
+    state.dirty |= entry->group;
+    return entry->group;
+}
+
+} // namespace VehicleDecoders
+
+#endif // VEHICLEDECODERS_H
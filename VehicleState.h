@@ -0,0 +1,82 @@
+#ifndef VEHICLESTATE_H
+#define VEHICLESTATE_H
+
+#include <QVector>
+#include <cstdint>
+
+// Signal groups — one bit per NOTIFY signal on VehicleBusManager.
+// Decoders set the bit for the group they touched; the QObject side
+// turns dirty bits into signal emissions.
+enum VehicleGroup : uint32_t {
+    VehGroupTelemetry    = 1u << 0,
+    VehGroupPressures    = 1u << 1,
+    VehGroupFuel         = 1u << 2,
+    VehGroupIgnition     = 1u << 3,
+    VehGroupDriveMode    = 1u << 4,
+    VehGroupFaults       = 1u << 5,
+    VehGroupModuleStatus = 1u << 6,
+    VehGroupDerived      = 1u << 7,  // Set on the GUI side by DerivedChannels
+};
+
+constexpr int VehGroupCount = 8;
+
+struct VehicleTuneAck {
+    int tableId = 0;
+    int rpmIdx = 0;
+    int mapIdx = 0;
+    bool accepted = false;
+    int seq = 0;         // Echoed session_seq
+};
+
+// Plain decoded bus state. Written by the CAN reader thread, handed to the
+// GUI thread as a snapshot — no QObject, no signals.
+struct VehicleState {
+    // ECM telemetry — primary gauges
+    int rpm = 0;
+    double tps = 0.0;
+    int mapKpa = 0;
+    int timing = 0;
+    double coolantTemp = 0.0;
+    double iatTemp = 0.0;
+    double batteryVoltage = 0.0;
+    int oilPressureKpa = 0;
+    int fuelPressureKpa = 0;
+
+    // O2 / fueling
+    double lambdaB1 = 0.0;
+    double lambdaB2 = 0.0;
+    double lambdaTarget = 0.0;
+    int stft = 0;
+    int ltft = 0;
+    int injectorPwUs = 0;
+    double ve = 0.0;
+    double injectorDuty = 0.0;
+
+    // Ignition / knock
+    int knockRetard = 0;
+    int knockB1 = 0;
+    int knockB2 = 0;
+
+    // Drive mode
+    int driveMode = 1;  // NORMAL
+    int launchState = 0;
+    int tractionMode = 1;
+
+    int engineState = 0;
+    int faultCount = 0;
+    int sensorFaults = 0;
+
+    // Heartbeat counters — the GUI side compares against the last value it
+    // saw to restart its per-module timeout clocks.
+    uint32_t ecmHeartbeats = 0;
+    uint32_t tcmHeartbeats = 0;
+    uint32_t pdcmHeartbeats = 0;
+    uint32_t gcmHeartbeats = 0;
+
+    // Event-style frames that must not be coalesced away
+    QVector<VehicleTuneAck> tuneAcks;
+
+    uint32_t dirty = 0;  // VehicleGroup bits touched since last snapshot
+};
+
+#endif // VEHICLESTATE_H
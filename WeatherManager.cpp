@@ -1,6 +1,7 @@
 #include "WeatherManager.h"
+#include "RefreshScheduler.h"
 #include <algorithm>
-#include <QNetworkReply>
+#include <QTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -11,24 +12,20 @@
 
 WeatherManager::WeatherManager(QObject *parent)
     : QObject(parent)
-    , m_locationNetwork(new QNetworkAccessManager(this))
-    , m_weatherNetwork(new QNetworkAccessManager(this))
-    , m_refreshTimer(new QTimer(this))
 {
-    connect(m_locationNetwork, &QNetworkAccessManager::finished,
-            this, &WeatherManager::onLocationReply);
-    connect(m_weatherNetwork, &QNetworkAccessManager::finished,
-            this, &WeatherManager::onWeatherReply);
-
-    // Auto-refresh every 15 minutes
-    m_refreshTimer->setInterval(15 * 60 * 1000);
-    connect(m_refreshTimer, &QTimer::timeout, this, &WeatherManager::refresh);
-    m_refreshTimer->start();
-
     // Initial fetch
     QTimer::singleShot(500, this, &WeatherManager::fetchLocation);
 }
 
+void WeatherManager::setFeedFetcher(FeedFetcher *fetcher) { m_fetcher = fetcher; }
+
+void WeatherManager::setRefreshScheduler(RefreshScheduler *scheduler)
+{
+    // Auto-refresh every 15 minutes
+    const int task = scheduler->add("weather", 15 * 60 * 1000, this, [this]() { refresh(); });
+    scheduler->start(task);
+}
+
 void WeatherManager::refresh()
 {
     if (m_hasLocation) {
@@ -52,6 +49,8 @@ void WeatherManager::setLocation(double lat, double lon)
 
 void WeatherManager::fetchLocation()
 {
+    if (!m_fetcher) return;
+
     m_loading = true;
     emit loadingChanged();
 
@@ -59,15 +58,14 @@ void WeatherManager::fetchLocation()
     QNetworkRequest request(QUrl("http://ip-api.com/json/?fields=lat,lon,city,regionName"));
     request.setHeader(QNetworkRequest::UserAgentHeader, "HeadUnit/1.0");
     request.setTransferTimeout(15000);
-    m_locationNetwork->get(request);
+    m_fetcher->get("weather/location", request, this,
+                   [this](const FeedFetcher::Result &result) { onLocationReply(result); });
 }
 
-void WeatherManager::onLocationReply(QNetworkReply *reply)
+void WeatherManager::onLocationReply(const FeedFetcher::Result &result)
 {
-    reply->deleteLater();
-
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "Location fetch failed:" << reply->errorString();
+    if (!result.ok()) {
+        qWarning() << "Location fetch failed:" << result.errorString;
         m_errorMessage = "Could not determine location";
         m_loading = false;
         emit loadingChanged();
@@ -75,7 +73,13 @@ void WeatherManager::onLocationReply(QNetworkReply *reply)
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    if (result.unchanged && m_hasLocation) {
+        // Same place as last time
+        fetchWeather();
+        return;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonObject obj = doc.object();
 
     m_latitude = obj["lat"].toDouble();
@@ -99,6 +103,7 @@ void WeatherManager::fetchWeather()
         fetchLocation();
         return;
     }
+    if (!m_fetcher) return;
 
     m_loading = true;
     emit loadingChanged();
@@ -120,24 +125,26 @@ void WeatherManager::fetchWeather()
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::UserAgentHeader, "HeadUnit/1.0");
     request.setTransferTimeout(15000);
-    m_weatherNetwork->get(request);
+    m_fetcher->get("weather/forecast", request, this,
+                   [this](const FeedFetcher::Result &result) { onWeatherReply(result); });
 }
 
-void WeatherManager::onWeatherReply(QNetworkReply *reply)
+void WeatherManager::onWeatherReply(const FeedFetcher::Result &result)
 {
-    reply->deleteLater();
-
     m_loading = false;
     emit loadingChanged();
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "Weather fetch failed:" << reply->errorString();
+    if (!result.ok()) {
+        qWarning() << "Weather fetch failed:" << result.errorString;
         m_errorMessage = "Weather update failed";
         emit errorOccurred(m_errorMessage);
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    // Nothing new from Open-Meteo; what's displayed is still current
+    if (result.unchanged) return;
+
+    QJsonDocument doc = QJsonDocument::fromJson(result.body);
     QJsonObject root = doc.object();
 
     // Parse current weather
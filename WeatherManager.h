@@ -1,11 +1,13 @@
 #pragma once
 
 #include <QObject>
-#include <QNetworkAccessManager>
-#include <QTimer>
 #include <QJsonObject>
 #include <QJsonArray>
 
+#include "FeedFetcher.h"
+
+class RefreshScheduler;
+
 class WeatherManager : public QObject
 {
     Q_OBJECT
@@ -30,6 +32,9 @@ class WeatherManager : public QObject
 public:
     explicit WeatherManager(QObject *parent = nullptr);
 
+    void setFeedFetcher(FeedFetcher *fetcher);
+    void setRefreshScheduler(RefreshScheduler *scheduler);
+
     double temperature() const { return m_temperature; }
     double feelsLike() const { return m_feelsLike; }
     int humidity() const { return m_humidity; }
@@ -57,19 +62,15 @@ signals:
     void loadingChanged();
     void errorOccurred(const QString &message);
 
-private slots:
-    void onLocationReply(QNetworkReply *reply);
-    void onWeatherReply(QNetworkReply *reply);
-
 private:
     void fetchLocation();
     void fetchWeather();
+    void onLocationReply(const FeedFetcher::Result &result);
+    void onWeatherReply(const FeedFetcher::Result &result);
     QString descriptionForCode(int code) const;
     QString iconForCode(int code, bool isDay) const;
 
-    QNetworkAccessManager *m_locationNetwork;
-    QNetworkAccessManager *m_weatherNetwork;
-    QTimer *m_refreshTimer;
+    FeedFetcher *m_fetcher = nullptr;
 
     double m_latitude = 0.0;
     double m_longitude = 0.0;
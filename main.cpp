@@ -5,6 +5,7 @@
 #include <QQuickWindow>
 #include <QDebug>
 #include <QDir>
+#include <QStandardPaths>
 #include <QUrl>
 #include "MediaController.h"
 #include "VoiceAssistant.h"
@@ -17,11 +18,17 @@
 #include "MessageManager.h"
 #include "VoiceCommandHandler.h"
 #include "WeatherManager.h"
+#include "FeedFetcher.h"
+#include "RefreshScheduler.h"
 #include "VehicleBusManager.h"
+#include "TuneSession.h"
 #include "TidalClient.h"
 #include "SpotifyClient.h"
 #include "UpdateManager.h"
 #include "ContextAggregator.h"
+#include "RouteLoader.h"
+#include "SpatialTileCache.h"
+#include "RouteProgressTracker.h"
 #include "PlacesSearchManager.h"
 #include "RouteWeatherManager.h"
 #include "CopilotMonitor.h"
@@ -81,8 +88,15 @@ int main(int argc, char *argv[])
     ContactManager contactManager;
     MessageManager messageManager;
     VoiceCommandHandler voiceCommandHandler;  // Kept for backward compat (unused by tool-use pipeline)
+    // Shared by every polling manager below, so declared first to outlive them
+    FeedFetcher feedFetcher;
+    RefreshScheduler refreshScheduler;
     WeatherManager weatherManager;
+    weatherManager.setFeedFetcher(&feedFetcher);
+    weatherManager.setRefreshScheduler(&refreshScheduler);
     VehicleBusManager vehicleBusManager;
+    TuneSession tuneSession;
+    tuneSession.setVehicleBusManager(&vehicleBusManager);
     TidalClient tidalClient;
     tidalClient.connectToService();
     SpotifyClient spotifyClient;
@@ -91,6 +105,9 @@ int main(int argc, char *argv[])
 
     // Wizard Copilot managers
     ContextAggregator contextAggregator;
+    RouteLoader routeLoader;
+    RouteProgressTracker routeProgressTracker;
+    SpatialTileCache spatialTileCache;
     PlacesSearchManager placesSearchManager;
     RouteWeatherManager routeWeatherManager;
     CopilotMonitor copilotMonitor;
@@ -125,6 +142,8 @@ int main(int argc, char *argv[])
     googleTTS.setApiKey(googleApiKey);
     picovoiceManager.setAccessKey(picovoiceAccessKey);
     picovoiceManager.setGoogleApiKey(googleApiKey);
+    // Optional streaming recognizer (tools/mock_stt_server.py for testing)
+    picovoiceManager.setStreamingSttUrl(qEnvironmentVariable("STREAMING_STT_URL"));
     if (googleApiKey.isEmpty()) {
         qWarning() << "GOOGLE_API_KEY not set - TTS and STT will not work. Set it with: export GOOGLE_API_KEY=your_key";
     }
@@ -137,6 +156,10 @@ int main(int argc, char *argv[])
     googleTTS.setSpeakingRate(1.0);
     googleTTS.setPitch(0.0);
 
+    // Ready prompts (VoicePipeline.qml) and fixed replies play from the
+    // on-disk TTS cache from the first wake word after boot
+    googleTTS.prewarm({ "Yes?", "What's up?", "I'm here", "Go ahead", "Listening", "Done." });
+
     // Wake word and voice pipeline wiring is handled by VoicePipeline.qml
 
     QQmlApplicationEngine engine;
@@ -159,15 +182,41 @@ int main(int argc, char *argv[])
     contextAggregator.setSpotifyClient(&spotifyClient);
     contextAggregator.setMediaController(&mediaController);
     contextAggregator.setBluetoothManager(&bluetoothManager);
+    contextAggregator.setRouteProgressTracker(&routeProgressTracker);
+    routeLoader.setContextAggregator(&contextAggregator);
+    routeLoader.setMapboxToken(qEnvironmentVariable("MAPBOX_TOKEN", ""));
+    routeProgressTracker.setContextAggregator(&contextAggregator);
+    refreshScheduler.setRouteProgressTracker(&routeProgressTracker);
     placesSearchManager.setContextAggregator(&contextAggregator);
     placesSearchManager.setMapboxToken(qEnvironmentVariable("MAPBOX_TOKEN", ""));
     placesSearchManager.setGoogleApiKey(qEnvironmentVariable("GOOGLE_API_KEY"));
     routeWeatherManager.setContextAggregator(&contextAggregator);
+    routeWeatherManager.setRouteProgressTracker(&routeProgressTracker);
+    routeWeatherManager.setRefreshScheduler(&refreshScheduler);
     roadConditionManager.setContextAggregator(&contextAggregator);
+    roadConditionManager.setRouteProgressTracker(&routeProgressTracker);
+    roadConditionManager.setSpatialTileCache(&spatialTileCache);
+    roadConditionManager.setFeedFetcher(&feedFetcher);
+    roadConditionManager.setRefreshScheduler(&refreshScheduler);
     speedLimitManager.setContextAggregator(&contextAggregator);
+    speedLimitManager.setRouteProgressTracker(&routeProgressTracker);
+    speedLimitManager.loadSpeedLimitIndex(qEnvironmentVariable("SPEEDLIMIT_DB",
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/speedlimits.bin"));
     roadSurfaceManager.setContextAggregator(&contextAggregator);
+    roadSurfaceManager.setSpatialTileCache(&spatialTileCache);
+    roadSurfaceManager.setFeedFetcher(&feedFetcher);
+    roadSurfaceManager.setRefreshScheduler(&refreshScheduler);
+    highwayCameraManager.setSpatialTileCache(&spatialTileCache);
+    highwayCameraManager.setFeedFetcher(&feedFetcher);
+    highwayCameraManager.setRefreshScheduler(&refreshScheduler);
+    highwayCameraManager.setRouteProgressTracker(&routeProgressTracker);
     avalancheManager.setContextAggregator(&contextAggregator);
+    avalancheManager.setFeedFetcher(&feedFetcher);
+    avalancheManager.setRefreshScheduler(&refreshScheduler);
     borderWaitManager.setContextAggregator(&contextAggregator);
+    borderWaitManager.setSpatialTileCache(&spatialTileCache);
+    borderWaitManager.setFeedFetcher(&feedFetcher);
+    borderWaitManager.setRefreshScheduler(&refreshScheduler);
     copilotMonitor.setContextAggregator(&contextAggregator);
     copilotMonitor.setVehicleBusManager(&vehicleBusManager);
     copilotMonitor.setRouteWeatherManager(&routeWeatherManager);
@@ -177,6 +226,15 @@ int main(int argc, char *argv[])
     copilotMonitor.setAvalancheManager(&avalancheManager);
     copilotMonitor.setBorderWaitManager(&borderWaitManager);
 
+    // Each parsed route goes to the route-aware managers as one shared object
+    QObject::connect(&routeLoader, &RouteLoader::routeChanged, &routeWeatherManager, &RouteWeatherManager::setRoute);
+    QObject::connect(&routeLoader, &RouteLoader::routeChanged, &roadConditionManager, &RoadConditionManager::setRoute);
+    QObject::connect(&routeLoader, &RouteLoader::routeChanged, &speedLimitManager, &SpeedLimitManager::setRoute);
+    QObject::connect(&routeLoader, &RouteLoader::routeChanged, &roadSurfaceManager, &RoadSurfaceManager::setRoute);
+    QObject::connect(&routeLoader, &RouteLoader::routeChanged, &highwayCameraManager, &HighwayCameraManager::setRoute);
+    QObject::connect(&routeLoader, &RouteLoader::routeChanged, &avalancheManager, &AvalancheManager::setRoute);
+    QObject::connect(&routeLoader, &RouteLoader::routeChanged, &borderWaitManager, &BorderWaitManager::setRoute);
+
     // Connect PicovoiceManager signals to handlers
     // Transcription ready -> send to Claude with live context from ContextAggregator
     QObject::connect(&picovoiceManager, &PicovoiceManager::transcriptionReady,
@@ -216,11 +274,16 @@ int main(int argc, char *argv[])
     engine.rootContext()->setContextProperty("messageManager", &messageManager);
     engine.rootContext()->setContextProperty("voiceCommandHandler", &voiceCommandHandler);
     engine.rootContext()->setContextProperty("weatherManager", &weatherManager);
+    engine.rootContext()->setContextProperty("feedFetcher", &feedFetcher);
+    engine.rootContext()->setContextProperty("refreshScheduler", &refreshScheduler);
     engine.rootContext()->setContextProperty("vehicleBusManager", &vehicleBusManager);
+    engine.rootContext()->setContextProperty("tuneSession", &tuneSession);
     engine.rootContext()->setContextProperty("tidalClient", &tidalClient);
     engine.rootContext()->setContextProperty("spotifyClient", &spotifyClient);
     engine.rootContext()->setContextProperty("updateManager", &updateManager);
     engine.rootContext()->setContextProperty("contextAggregator", &contextAggregator);
+    engine.rootContext()->setContextProperty("routeLoader", &routeLoader);
+    engine.rootContext()->setContextProperty("routeProgressTracker", &routeProgressTracker);
     engine.rootContext()->setContextProperty("placesSearchManager", &placesSearchManager);
     engine.rootContext()->setContextProperty("routeWeatherManager", &routeWeatherManager);
     engine.rootContext()->setContextProperty("copilotMonitor", &copilotMonitor);
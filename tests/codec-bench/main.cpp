@@ -0,0 +1,207 @@
+// Benchmark for AudioCodec: what Ogg Opus saves on the speech APIs.
+//
+// Uses the given WAV (16-bit mono at 8/12/16/24/48 kHz) as one utterance
+// or, without one, synthesizes speech-like utterances of several lengths
+// (voiced syllables with a moving pitch and two formants, gaps between
+// words, road noise underneath). For each utterance:
+//  - STT upload at 16 kHz: base64 LINEAR16 vs base64 Ogg Opus bytes in the
+//    JSON body, encode time, and the transfer time saved at the uplink rate
+//  - TTS download at 24 kHz: the same for the response, with decode time
+//    and the downlink rate
+//  - checks the decoded audio has the input's length
+//
+// "Net saved" is transfer time saved minus codec time, i.e. how much
+// sooner the request completes. Rates default to a weak rural LTE cell.
+//
+// Usage: codec-bench [speech.wav | -] [uplink-kbps] [downlink-kbps]
+
+#include "AudioCodec.h"
+#include <QByteArray>
+#include <QFile>
+#include <QtEndian>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Utterance {
+    QByteArray pcm;
+    int sampleRate = 16000;
+};
+
+double seconds(const Utterance &u)
+{
+    return u.pcm.size() / 2.0 / u.sampleRate;
+}
+
+QByteArray syntheticSpeech(int sampleRate, double secs, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    const int total = int(secs * sampleRate);
+    std::vector<qint16> samples(total, 0);
+    double phase = 0.0;
+    double road = 0.0;
+
+    int pos = int(0.15 * sampleRate);   // Leading quiet, as captured
+    while (pos < total) {
+        const int syllable = int((0.15 + 0.15 * uniform(rng)) * sampleRate);
+        const double f1 = 500.0 + 400.0 * uniform(rng);
+        const double f2 = 1000.0 + 1200.0 * uniform(rng);
+        for (int i = 0; i < syllable && pos + i < total; ++i) {
+            const double t = double(pos + i) / sampleRate;
+            const double f0 = 120.0 + 30.0 * std::sin(2.0 * M_PI * 1.3 * t);
+            phase += 2.0 * M_PI * f0 / sampleRate;
+            double v = 0.0;
+            for (int k = 1; k * f0 < sampleRate / 2.0 && k <= 30; ++k) {
+                const double f = k * f0;
+                const double a = std::exp(-std::pow((f - f1) / 250.0, 2))
+                               + 0.6 * std::exp(-std::pow((f - f2) / 350.0, 2)) + 0.02;
+                v += a * std::sin(k * phase);
+            }
+            const double envelope = std::sin(M_PI * i / syllable);
+            samples[pos + i] = qint16(qBound(-32767.0, 6000.0 * envelope * v, 32767.0));
+        }
+        pos += syllable;
+        // Most syllable boundaries run on; some are gaps between words
+        if (uniform(rng) < 0.35) pos += int((0.05 + 0.1 * uniform(rng)) * sampleRate);
+    }
+
+    for (int i = 0; i < total; ++i) {
+        road = 0.98 * road + 0.02 * noise(rng);
+        samples[i] = qint16(qBound(-32767.0, samples[i] + 1500.0 * road, 32767.0));
+    }
+    return QByteArray(reinterpret_cast<const char *>(samples.data()), total * int(sizeof(qint16)));
+}
+
+bool readWav(const QString &path, Utterance &out)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QByteArray wav = file.readAll();
+    if (wav.size() < 12 || !wav.startsWith("RIFF") || wav.mid(8, 4) != "WAVE") return false;
+
+    int channels = 0, bits = 0;
+    for (int pos = 12; pos + 8 <= wav.size();) {
+        const QByteArray id = wav.mid(pos, 4);
+        const int size = int(qFromLittleEndian<quint32>(wav.constData() + pos + 4));
+        const char *body = wav.constData() + pos + 8;
+        if (id == "fmt " && size >= 16) {
+            channels = qFromLittleEndian<quint16>(body + 2);
+            out.sampleRate = int(qFromLittleEndian<quint32>(body + 4));
+            bits = qFromLittleEndian<quint16>(body + 14);
+        } else if (id == "data") {
+            out.pcm = wav.mid(pos + 8, size);
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return channels == 1 && bits == 16 && !out.pcm.isEmpty() && 48000 % out.sampleRate == 0;
+}
+
+struct Row {
+    double secs = 0;
+    qint64 rawBytes = 0;       // base64 in the JSON body
+    qint64 opusBytes = 0;
+    double codecMs = 0;
+    double transferSavedMs = 0;
+    bool lengthOk = false;
+};
+
+double transferMs(qint64 bytes, double kbps)
+{
+    return bytes * 8.0 / kbps;   // bits / (kbit/s) = ms
+}
+
+Row measure(const Utterance &u, bool upload, double kbps)
+{
+    Row row;
+    row.secs = seconds(u);
+    row.rawBytes = u.pcm.toBase64().size();
+
+    auto start = Clock::now();
+    const QByteArray ogg = AudioCodec::encodeOggOpus(u.pcm, u.sampleRate);
+    const double encodeMs = msSince(start);
+
+    start = Clock::now();
+    const QByteArray decoded = AudioCodec::decodeOggOpus(ogg, u.sampleRate);
+    const double decodeMs = msSince(start);
+
+    row.opusBytes = ogg.toBase64().size();
+    row.codecMs = upload ? encodeMs : decodeMs;
+    row.transferSavedMs = transferMs(row.rawBytes, kbps) - transferMs(row.opusBytes, kbps);
+    row.lengthOk = decoded.size() == u.pcm.size();
+    return row;
+}
+
+void printTable(const char *title, const std::vector<Row> &rows, double kbps, const char *codecName)
+{
+    std::printf("%s at %.0f kbit/s\n", title, kbps);
+    std::printf("%7s %12s %11s %7s %10s %13s %11s %7s\n", "speech", "LINEAR16 B", "Opus B", "ratio",
+                codecName, "transfer -ms", "net -ms", "length");
+    for (const Row &r : rows) {
+        std::printf("%6.1fs %12lld %11lld %6.1fx %8.2fms %13.0f %11.0f %7s\n", r.secs,
+                    static_cast<long long>(r.rawBytes), static_cast<long long>(r.opusBytes),
+                    double(r.rawBytes) / qMax<qint64>(r.opusBytes, 1), r.codecMs, r.transferSavedMs,
+                    r.transferSavedMs - r.codecMs, r.lengthOk ? "ok" : "WRONG");
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const QString path = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString("-");
+    const double uplinkKbps = argc > 2 ? std::atof(argv[2]) : 500.0;
+    const double downlinkKbps = argc > 3 ? std::atof(argv[3]) : 2000.0;
+
+    if (!AudioCodec::isAvailable()) {
+        std::fprintf(stderr, "codec-bench: built without libopus\n");
+        return 1;
+    }
+
+    std::vector<Utterance> stt, tts;
+    if (path == "-") {
+        std::printf("codec-bench: synthetic speech\n\n");
+        unsigned seed = 1;
+        for (double secs : { 1.5, 3.0, 6.0, 12.0 }) {
+            stt.push_back(Utterance { syntheticSpeech(16000, secs, seed++), 16000 });
+            tts.push_back(Utterance { syntheticSpeech(24000, secs, seed++), 24000 });
+        }
+    } else {
+        Utterance u;
+        if (!readWav(path, u)) {
+            std::fprintf(stderr, "codec-bench: %s is not a 16-bit mono WAV at an Opus rate\n", qPrintable(path));
+            return 1;
+        }
+        std::printf("codec-bench: %s, %d Hz, %.1f s\n\n", qPrintable(path), u.sampleRate, seconds(u));
+        stt.push_back(u);
+        tts.push_back(u);
+    }
+
+    std::vector<Row> upload, download;
+    for (const Utterance &u : stt) upload.push_back(measure(u, true, uplinkKbps));
+    for (const Utterance &u : tts) download.push_back(measure(u, false, downlinkKbps));
+
+    printTable("STT upload", upload, uplinkKbps, "encode");
+    printTable("TTS download", download, downlinkKbps, "decode");
+
+    bool ok = true;
+    for (const Row &r : upload) ok = ok && r.lengthOk;
+    for (const Row &r : download) ok = ok && r.lengthOk;
+    return ok ? 0 : 1;
+}
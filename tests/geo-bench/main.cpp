@@ -0,0 +1,359 @@
+// Micro-benchmark for GeoUtils and PolylineSimplifier.
+//
+// Builds synthetic routes (roughly 1 km of drive per 10 points, heading
+// north-west out of Calgary) and times:
+//  - for a set of query points near a 10k-point route, the scalar haversine
+//    loops the managers used against the batch kernels at tolerance 0
+//    (haversine on every lane) and at the default tolerance
+//    (equirectangular fast path)
+//  - simplification of a 20k-point route to 100 points: the old recursive,
+//    epsilon-doubling QJsonArray implementation against PolylineSimplifier
+//  - getting a 20k-point route geometry into packed doubles: parsing the
+//    GeoJSON coordinates text against decoding a polyline6 string, plus
+//    CompactPolyline decode and random access, and the heap held by each
+//    representation (glibc only)
+//
+// Usage: geo-bench [points] [queries] [simplifyPoints] [simplifyTarget] [polylinePoints]
+
+#include "CompactPolyline.h"
+#include "GeoUtils.h"
+#include "PolylineSimplifier.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Route {
+    std::vector<double> lat;
+    std::vector<double> lon;
+};
+
+Route makeRoute(int points)
+{
+    Route r;
+    r.lat.reserve(points);
+    r.lon.reserve(points);
+    std::mt19937 rng(42);
+    std::normal_distribution<double> turn(0.0, 0.15);
+
+    double lat = 51.0447, lon = -114.0719, heading = 0.8;
+    for (int i = 0; i < points; ++i) {
+        r.lat.push_back(lat);
+        r.lon.push_back(lon);
+        heading += turn(rng);
+        lat += 0.0009 * std::cos(heading);
+        lon -= 0.0009 * std::sin(heading) / std::cos(lat * M_PI / 180.0);
+    }
+    return r;
+}
+
+template <class F>
+double timeNs(int repeats, F &&f)
+{
+    double best = 1e300;
+    for (int rep = 0; rep < repeats; ++rep) {
+        const auto start = Clock::now();
+        f();
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        best = std::min(best, ns);
+    }
+    return best;
+}
+
+volatile double g_sink;
+
+// The QJsonArray Douglas-Peucker from before PolylineSimplifier, for comparison
+QJsonArray legacySimplifyRoute(const QJsonArray &coords, int targetPoints)
+{
+    if (coords.size() <= targetPoints) return coords;
+
+    struct DP {
+        static void run(const QJsonArray &pts, int first, int last,
+                        double epsilon, QVector<bool> &keep)
+        {
+            if (last <= first + 1) return;
+
+            double aLat = pts[first].toArray()[1].toDouble();
+            double aLon = pts[first].toArray()[0].toDouble();
+            double bLat = pts[last].toArray()[1].toDouble();
+            double bLon = pts[last].toArray()[0].toDouble();
+
+            double maxDist = 0.0;
+            int maxIdx = first;
+
+            for (int i = first + 1; i < last; ++i) {
+                double pLat = pts[i].toArray()[1].toDouble();
+                double pLon = pts[i].toArray()[0].toDouble();
+                double d = GeoUtils::pointToSegmentDistanceKm(pLat, pLon, aLat, aLon, bLat, bLon);
+                if (d > maxDist) {
+                    maxDist = d;
+                    maxIdx = i;
+                }
+            }
+
+            if (maxDist > epsilon) {
+                keep[maxIdx] = true;
+                run(pts, first, maxIdx, epsilon, keep);
+                run(pts, maxIdx, last, epsilon, keep);
+            }
+        }
+    };
+
+    double epsilon = 0.05;
+    QJsonArray result;
+
+    for (int attempt = 0; attempt < 20; ++attempt) {
+        QVector<bool> keep(coords.size(), false);
+        keep[0] = true;
+        keep[coords.size() - 1] = true;
+
+        DP::run(coords, 0, coords.size() - 1, epsilon, keep);
+
+        int count = 0;
+        for (bool k : keep) { if (k) ++count; }
+
+        if (count <= targetPoints || attempt == 19) {
+            result = QJsonArray();
+            for (int i = 0; i < coords.size(); ++i) {
+                if (keep[i]) result.append(coords[i]);
+            }
+            break;
+        }
+
+        epsilon *= 2.0;
+    }
+
+    return result;
+}
+
+// Largest distance from any dropped point to the simplified line
+double maxDeviationKm(const Route &route, const int *kept, int count)
+{
+    double worst = 0.0;
+    for (int k = 0; k + 1 < count; ++k) {
+        const int a = kept[k], b = kept[k + 1];
+        for (int i = a + 1; i < b; ++i) {
+            worst = std::max(worst, GeoUtils::pointToSegmentDistanceKm(route.lat[i], route.lon[i],
+                                                                       route.lat[a], route.lon[a],
+                                                                       route.lat[b], route.lon[b]));
+        }
+    }
+    return worst;
+}
+
+void benchDistances(int points, int queries)
+{
+    const int repeats = 5;
+
+    const Route route = makeRoute(points);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(0, points - 1);
+    std::normal_distribution<double> offset(0.0, 0.02);
+    std::vector<std::pair<double, double>> q;
+    for (int i = 0; i < queries; ++i) {
+        const int k = pick(rng);
+        q.push_back({ route.lat[k] + offset(rng), route.lon[k] + offset(rng) });
+    }
+
+    std::vector<double> out(points), ref(points), ts(points);
+    const double *lats = route.lat.data(), *lons = route.lon.data();
+    const double work = double(points) * queries;
+
+    std::printf("geo-bench: %d points x %d queries, batch ISA: %s\n\n", points, queries, GeoUtils::batchIsa());
+
+    // Point distances
+    const double scalarPts = timeNs(repeats, [&] {
+        for (const auto &p : q) {
+            for (int i = 0; i < points; ++i)
+                out[i] = GeoUtils::haversineKm(p.first, p.second, lats[i], lons[i]);
+            g_sink = out[points / 2];
+        }
+    });
+    const double exactPts = timeNs(repeats, [&] {
+        for (const auto &p : q) {
+            GeoUtils::distancesKm(p.first, p.second, lats, lons, points, out.data(), 0.0);
+            g_sink = out[points / 2];
+        }
+    });
+    const double fastPts = timeNs(repeats, [&] {
+        for (const auto &p : q) {
+            GeoUtils::distancesKm(p.first, p.second, lats, lons, points, out.data());
+            g_sink = out[points / 2];
+        }
+    });
+
+    // Segment distances
+    const double scalarSegs = timeNs(repeats, [&] {
+        for (const auto &p : q) {
+            for (int i = 0; i + 1 < points; ++i)
+                out[i] = GeoUtils::pointToSegmentDistanceKm(p.first, p.second, lats[i], lons[i], lats[i + 1], lons[i + 1]);
+            g_sink = out[points / 2];
+        }
+    });
+    const double fastSegs = timeNs(repeats, [&] {
+        for (const auto &p : q) {
+            GeoUtils::segmentDistancesKm(p.first, p.second, lats, lons, points, out.data(), ts.data());
+            g_sink = out[points / 2];
+        }
+    });
+
+    // Worst deviation from haversine, with and without the fast path
+    double maxErr = 0.0, maxExactErr = 0.0;
+    for (const auto &p : q) {
+        for (int i = 0; i < points; ++i)
+            ref[i] = GeoUtils::haversineKm(p.first, p.second, lats[i], lons[i]);
+        GeoUtils::distancesKm(p.first, p.second, lats, lons, points, out.data());
+        for (int i = 0; i < points; ++i)
+            maxErr = std::max(maxErr, std::fabs(out[i] - ref[i]));
+        GeoUtils::distancesKm(p.first, p.second, lats, lons, points, out.data(), 0.0);
+        for (int i = 0; i < points; ++i)
+            maxExactErr = std::max(maxExactErr, std::fabs(out[i] - ref[i]));
+    }
+
+    std::printf("%-34s %8.2f ns/pt\n", "haversineKm loop", scalarPts / work);
+    std::printf("%-34s %8.2f ns/pt  %5.1fx\n", "distancesKm, tolerance 0", exactPts / work, scalarPts / exactPts);
+    std::printf("%-34s %8.2f ns/pt  %5.1fx\n", "distancesKm, 1 m tolerance", fastPts / work, scalarPts / fastPts);
+    std::printf("%-34s %8.2f ns/seg\n", "pointToSegmentDistanceKm loop", scalarSegs / work);
+    std::printf("%-34s %8.2f ns/seg %5.1fx\n", "segmentDistancesKm, 1 m tolerance", fastSegs / work, scalarSegs / fastSegs);
+    std::printf("\nmax |distancesKm - haversineKm| = %.3g m at tolerance %.3g m, %.3g m at tolerance 0\n",
+                maxErr * 1000.0, GeoUtils::kBatchToleranceKm * 1000.0, maxExactErr * 1000.0);
+}
+
+void benchSimplify(int points, int target)
+{
+    const int repeats = 3;
+    const Route route = makeRoute(points);
+
+    QJsonArray coords;
+    for (int i = 0; i < points; ++i)
+        coords.append(QJsonArray{ route.lon[i], route.lat[i] });
+
+    std::printf("\nsimplify: %d points -> %d\n\n", points, target);
+
+    int legacyCount = 0;
+    const double legacy = timeNs(repeats, [&] { legacyCount = legacySimplifyRoute(coords, target).size(); });
+
+    PolylineSimplifier simplifier;
+    std::vector<int> dp(target), vw(target);
+    int dpCount = 0, vwCount = 0;
+    const double packedDp = timeNs(repeats, [&] {
+        dpCount = simplifier.simplify(route.lat.data(), route.lon.data(), points, target, dp.data());
+    });
+    const double packedVw = timeNs(repeats, [&] {
+        vwCount = simplifier.simplify(route.lat.data(), route.lon.data(), points, target, vw.data(),
+                                      PolylineSimplifier::Visvalingam);
+    });
+
+    std::printf("%-34s %10.3f ms  %4d pts\n", "legacy QJsonArray simplify", legacy / 1e6, legacyCount);
+    std::printf("%-34s %10.3f ms  %4d pts  %6.1fx  max dev %.3f km\n", "Douglas-Peucker, packed", packedDp / 1e6,
+                dpCount, legacy / packedDp, maxDeviationKm(route, dp.data(), dpCount));
+    std::printf("%-34s %10.3f ms  %4d pts  %6.1fx  max dev %.3f km\n", "Visvalingam, packed", packedVw / 1e6,
+                vwCount, legacy / packedVw, maxDeviationKm(route, vw.data(), vwCount));
+}
+
+// Heap bytes in use, or -1 where mallinfo2 is not available
+long long heapInUse()
+{
+#ifdef __GLIBC__
+    return static_cast<long long>(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+void benchPolyline(int points)
+{
+    const int repeats = 5;
+    const Route route = makeRoute(points);
+
+    QJsonArray coords;
+    for (int i = 0; i < points; ++i)
+        coords.append(QJsonArray{ route.lon[i], route.lat[i] });
+    const QByteArray geoJson = QJsonDocument(QJsonObject{ { "type", "LineString" }, { "coordinates", coords } })
+                                   .toJson(QJsonDocument::Compact);
+    const QByteArray polyline6 = GeoUtils::encodePolyline(route.lat.data(), route.lon.data(), points, 6);
+
+    std::printf("\npolyline: %d points, GeoJSON %lld bytes, polyline6 %lld bytes\n\n", points,
+                static_cast<long long>(geoJson.size()), static_cast<long long>(polyline6.size()));
+
+    QVector<double> lats, lons;
+    const double json = timeNs(repeats, [&] {
+        const QJsonArray parsed = QJsonDocument::fromJson(geoJson).object().value("coordinates").toArray();
+        lats.clear();
+        lons.clear();
+        for (const QJsonValue &v : parsed) {
+            const QJsonArray pt = v.toArray();
+            lons.append(pt[0].toDouble());
+            lats.append(pt[1].toDouble());
+        }
+    });
+    const double decode = timeNs(repeats, [&] { GeoUtils::decodePolyline(polyline6, 6, lats, lons); });
+
+    double maxErr = 0.0;
+    for (int i = 0; i < points; ++i)
+        maxErr = std::max({ maxErr, std::abs(lats[i] - route.lat[i]), std::abs(lons[i] - route.lon[i]) });
+
+    const CompactPolyline compact = CompactPolyline::fromCoordinates(lats.constData(), lons.constData(), points);
+    const double compactDecode = timeNs(repeats, [&] { compact.decode(lats, lons); });
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(0, points - 1);
+    std::vector<int> probes(10000);
+    for (int &p : probes) p = pick(rng);
+    double sink = 0.0;
+    const double randomAt = timeNs(repeats, [&] {
+        for (const int p : probes) sink += compact.at(p).first;
+    });
+
+    std::printf("%-34s %8.2f ns/pt
+", "GeoJSON text -> doubles", json / points);
+    std::printf("%-34s %8.2f ns/pt %5.1fx  max err %.2g deg
+", "polyline6 -> doubles", decode / points,
+                json / decode, maxErr);
+    std::printf("%-34s %8.2f ns/pt %5.1fx
+", "CompactPolyline::decode", compactDecode / points, json / compactDecode);
+    std::printf("%-34s %8.2f ns/call (sink %.0f)
+", "CompactPolyline::at, random", randomAt / probes.size(), sink);
+
+    // Heap held per representation, measured by building a fresh copy
+    long long before = heapInUse();
+    QJsonArray *jsonCopy = new QJsonArray(QJsonDocument::fromJson(geoJson).object().value("coordinates").toArray());
+    const long long jsonBytes = heapInUse() - before;
+    before = heapInUse();
+    auto *packed = new std::pair<QVector<double>, QVector<double>>(
+        QVector<double>(lats.cbegin(), lats.cend()), QVector<double>(lons.cbegin(), lons.cend()));
+    const long long packedBytes = heapInUse() - before;
+    delete packed;
+    delete jsonCopy;
+
+    std::printf("\n%-34s %8s\n", "memory per point", "bytes");
+    if (before >= 0) {
+        std::printf("%-34s %8.1f\n", "QJsonArray of [lon, lat]", double(jsonBytes) / points);
+        std::printf("%-34s %8.1f\n", "packed doubles", double(packedBytes) / points);
+    }
+    std::printf("%-34s %8.1f\n", "polyline6 string", double(polyline6.size()) / points);
+    std::printf("%-34s %8.1f\n", "CompactPolyline", double(compact.byteSize()) / points);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    benchDistances(argc > 1 ? std::atoi(argv[1]) : 10000, argc > 2 ? std::atoi(argv[2]) : 200);
+    benchSimplify(argc > 3 ? std::atoi(argv[3]) : 20000, argc > 4 ? std::atoi(argv[4]) : 100);
+    benchPolyline(argc > 5 ? std::atoi(argv[5]) : 20000);
+    return 0;
+}
@@ -0,0 +1,227 @@
+// Benchmark for SpeedLimitIndex lookups.
+//
+// Uses the given index (tools/build_speed_limits.py) or, without one,
+// writes a synthetic grid of town streets around Calgary in the same format
+// — 20 km square, streets every ~220 m, one limit per street and every
+// fifth north-south street with different limits per direction. Then:
+//  - times opening (mapping) the file
+//  - times lookups at points a few metres off random segments, without and
+//    with a GPS heading, and a linear scan of every segment for scale
+//  - checks each lookup's distance against that linear scan
+//
+// Usage: speedlimit-bench [index.bin | -] [queries]
+
+#include "SpeedLimitIndex.h"
+#include <QByteArray>
+#include <QFile>
+#include <QTemporaryFile>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Segment = SpeedLimitIndex::Segment;
+
+constexpr int kTilesPerDeg = 100;
+constexpr double kMarginM = 40.0;
+constexpr double kMPerDegLat = 110574.0;
+
+double nsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+volatile int g_sink;
+
+// Files each segment the way build_speed_limits.py does
+void fileSegment(std::map<quint32, std::vector<Segment>> &tiles, const Segment &s, qint32 marginE6)
+{
+    const double cosLat = std::cos((s.lat0 + s.lat1) / 2e6 * M_PI / 180.0);
+    const double lonMargin = marginE6 / cosLat;
+    const int y0 = int(std::floor(((std::min(s.lat0, s.lat1) - marginE6) / 1e6 + 90.0) * kTilesPerDeg));
+    const int y1 = int(std::floor(((std::max(s.lat0, s.lat1) + marginE6) / 1e6 + 90.0) * kTilesPerDeg));
+    const int x0 = int(std::floor(((std::min(s.lon0, s.lon1) - lonMargin) / 1e6 + 180.0) * kTilesPerDeg));
+    const int x1 = int(std::floor(((std::max(s.lon0, s.lon1) + lonMargin) / 1e6 + 180.0) * kTilesPerDeg));
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+            tiles[quint32(y) * quint32(360 * kTilesPerDeg) + quint32(x)].push_back(s);
+}
+
+bool writeSyntheticIndex(const QString &path)
+{
+    const qint32 marginE6 = qint32(std::ceil(kMarginM / kMPerDegLat * 1e6));
+    std::map<quint32, std::vector<Segment>> tiles;
+    const qint32 lat0 = 50950000, lon0 = -114220000;
+    const qint32 spanLatE6 = 180000, spanLonE6 = 285000;   // ~20 km each way
+    const qint32 stepE6 = 1000;                             // Vertex spacing
+
+    int street = 0;
+    for (qint32 lat = lat0; lat <= lat0 + spanLatE6; lat += 2000, ++street) {
+        const quint16 kmh = quint16(30 + 10 * (street % 8));
+        for (qint32 lon = lon0; lon < lon0 + spanLonE6; lon += stepE6)
+            fileSegment(tiles, Segment { lat, lon, lat, lon + stepE6, kmh, 0 }, marginE6);
+    }
+    for (qint32 lon = lon0; lon <= lon0 + spanLonE6; lon += 3000, ++street) {
+        const quint16 kmh = quint16(30 + 10 * (street % 8));
+        const bool directional = street % 5 == 0;
+        for (qint32 lat = lat0; lat < lat0 + spanLatE6; lat += stepE6) {
+            const Segment s { lat, lon, lat + stepE6, lon, kmh, 0 };
+            if (!directional) {
+                fileSegment(tiles, s, marginE6);
+                continue;
+            }
+            Segment fwd = s, back = s;
+            fwd.flags = SpeedLimitIndex::Forward;
+            back.kmh = quint16(kmh - 10);
+            back.flags = SpeedLimitIndex::Backward;
+            fileSegment(tiles, fwd, marginE6);
+            fileSegment(tiles, back, marginE6);
+        }
+    }
+
+    SpeedLimitIndex::FileHeader header {};
+    std::memcpy(header.magic, SpeedLimitIndex::kMagic, sizeof(header.magic));
+    header.version = SpeedLimitIndex::kVersion;
+    header.tilesPerDeg = kTilesPerDeg;
+    header.marginE6 = marginE6;
+    header.tileCount = quint32(tiles.size());
+
+    QByteArray entries, segments;
+    for (const auto &[key, segs] : tiles) {
+        const SpeedLimitIndex::TileEntry e { key, header.segmentCount, quint32(segs.size()) };
+        entries.append(reinterpret_cast<const char *>(&e), sizeof(e));
+        segments.append(reinterpret_cast<const char *>(segs.data()), int(segs.size() * sizeof(Segment)));
+        header.segmentCount += quint32(segs.size());
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(entries);
+    file.write(segments);
+    return true;
+}
+
+// Every segment entry in the file (duplicated across tiles), for query
+// generation and the linear scan
+std::vector<Segment> readSegments(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return {};
+    const QByteArray data = file.readAll();
+    SpeedLimitIndex::FileHeader header;
+    std::memcpy(&header, data.constData(), sizeof(header));
+    std::vector<Segment> segs(header.segmentCount);
+    const qint64 offset = qint64(sizeof(header)) + qint64(header.tileCount) * qint64(sizeof(SpeedLimitIndex::TileEntry));
+    std::memcpy(segs.data(), data.constData() + offset, segs.size() * sizeof(Segment));
+    return segs;
+}
+
+double scanDistanceM(const std::vector<Segment> &segs, double lat, double lon, double radiusM)
+{
+    const double mLat = kMPerDegLat * 1e-6;
+    const double mLon = 111320.0 * std::cos(lat * M_PI / 180.0) * 1e-6;
+    double best = -1.0;
+    for (const Segment &s : segs) {
+        const double ax = (s.lon0 - lon * 1e6) * mLon, ay = (s.lat0 - lat * 1e6) * mLat;
+        const double dx = (s.lon1 - s.lon0) * mLon, dy = (s.lat1 - s.lat0) * mLat;
+        const double lenSq = dx * dx + dy * dy;
+        const double t = lenSq > 0.0 ? std::clamp(-(ax * dx + ay * dy) / lenSq, 0.0, 1.0) : 0.0;
+        const double d = std::hypot(ax + t * dx, ay + t * dy);
+        if (d <= radiusM && (best < 0.0 || d < best)) best = d;
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QString path = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString("-");
+    const int queries = argc > 2 ? std::atoi(argv[2]) : 200000;
+
+    QTemporaryFile synthetic;
+    if (path == "-") {
+        if (!synthetic.open()) return 1;
+        synthetic.close();
+        path = synthetic.fileName();
+        if (!writeSyntheticIndex(path)) return 1;
+        std::printf("speedlimit-bench: synthetic Calgary street grid\n");
+    }
+
+    const std::vector<Segment> segs = readSegments(path);
+    if (segs.empty()) {
+        std::fprintf(stderr, "speedlimit-bench: can't read %s\n", qPrintable(path));
+        return 1;
+    }
+
+    SpeedLimitIndex index;
+    auto start = Clock::now();
+    if (!index.open(path)) return 1;
+    const double openNs = nsSince(start);
+    std::printf("%d tiles, %d segment entries, %.1f MiB, %d queries\n\n", index.tileCount(),
+                index.segmentCount(), QFile(path).size() / 1048576.0, queries);
+
+    // Points up to 15 m off random segments, with the segment's heading
+    // give or take 20° either way along it
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, segs.size() - 1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> offsetM(0.0, 6.0), headingNoise(0.0, 10.0);
+    std::vector<double> lats(queries), lons(queries), headings(queries);
+    for (int i = 0; i < queries; ++i) {
+        const Segment &s = segs[pick(rng)];
+        const double t = unit(rng);
+        const double lat = (s.lat0 + t * (s.lat1 - s.lat0)) / 1e6;
+        const double lon = (s.lon0 + t * (s.lon1 - s.lon0)) / 1e6;
+        lats[i] = lat + std::clamp(offsetM(rng), -15.0, 15.0) / kMPerDegLat;
+        lons[i] = lon + std::clamp(offsetM(rng), -15.0, 15.0) / (111320.0 * std::cos(lat * M_PI / 180.0));
+        const double bearing = std::atan2((s.lon1 - s.lon0) * std::cos(lat * M_PI / 180.0),
+                                          double(s.lat1 - s.lat0)) * 180.0 / M_PI;
+        const double reverse = (s.flags & SpeedLimitIndex::Backward) || (!s.flags && unit(rng) < 0.5) ? 180.0 : 0.0;
+        headings[i] = std::fmod(bearing + reverse + headingNoise(rng) + 720.0, 360.0);
+    }
+
+    int hits = 0;
+    start = Clock::now();
+    for (int i = 0; i < queries; ++i)
+        hits += index.lookup(lats[i], lons[i]).kmh > 0;
+    const double plainNs = nsSince(start) / queries;
+
+    int headingHits = 0;
+    start = Clock::now();
+    for (int i = 0; i < queries; ++i)
+        headingHits += index.lookup(lats[i], lons[i], headings[i]).kmh > 0;
+    const double headingNs = nsSince(start) / queries;
+    g_sink = hits + headingHits;
+
+    // The scan is slow; a sample is enough for timing and agreement
+    const int scanned = std::min(queries, 500);
+    int mismatches = 0;
+    double scanNs = 0.0;
+    for (int i = 0; i < scanned; ++i) {
+        const SpeedLimitIndex::Match m = index.lookup(lats[i], lons[i]);
+        start = Clock::now();
+        const double d = scanDistanceM(segs, lats[i], lons[i], 25.0);
+        scanNs += nsSince(start);
+        if ((d < 0.0) != (m.kmh == 0) || (d >= 0.0 && std::abs(d - m.distanceM) > 0.01))
+            ++mismatches;
+    }
+    scanNs /= scanned;
+
+    std::printf("%-30s %10.1f us\n", "open (map)", openNs / 1e3);
+    std::printf("%-30s %10.1f ns/lookup  %5.1f%% matched\n", "lookup", plainNs, 100.0 * hits / queries);
+    std::printf("%-30s %10.1f ns/lookup  %5.1f%% matched\n", "lookup with heading", headingNs,
+                100.0 * headingHits / queries);
+    std::printf("%-30s %10.1f ns/lookup  %6.0fx\n", "linear scan", scanNs, scanNs / plainNs);
+    std::printf("\n%d of %d lookups disagree with the linear scan\n", mismatches, scanned);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Build the offline speed-limit index read by SpeedLimitIndex from an OSM
+PBF extract.
+
+Every way with a highway tag and a usable maxspeed (or a direction-specific
+maxspeed:forward / maxspeed:backward) is cut into straight segments of at
+most half a tile, and each segment is filed under every tile its bounding
+box touches once grown by the margin. The lookup then only ever reads the
+one tile under the car. See SpeedLimitIndex.h for the file layout.
+
+Numeric limits in km/h or mph are used as tagged. Implicit zone values
+("CA:urban", "CA:BC:rural", ...) use the defaults in IMPLICIT_KMH, which
+are Canada's; "none", "walk", "signals" and friends are skipped.
+
+Usage:
+  python3 build_speed_limits.py region.osm.pbf speedlimits.bin
+  python3 build_speed_limits.py region.osm.pbf speedlimits.bin --tiles-per-deg 100 --margin-m 40
+
+Requires pyosmium (pip install osmium). Copy the output to the head unit's
+app data directory, or point SPEEDLIMIT_DB at it.
+"""
+
+import argparse
+import math
+import re
+import struct
+import sys
+
+# ── File format (SpeedLimitIndex.h) ──────────────────────────────
+MAGIC = b'HUSL'
+VERSION = 1
+HEADER = struct.Struct('<4sIiiII8x')
+TILE = struct.Struct('<III')
+SEGMENT = struct.Struct('<iiiiHH')
+FORWARD = 1
+BACKWARD = 2
+
+M_PER_DEG_LAT = 110574.0
+
+# Implicit maxspeed by zone suffix
+IMPLICIT_KMH = {
+    'urban': 50,
+    'rural': 80,
+    'motorway': 100,
+    'trunk': 90,
+    'living_street': 20,
+    'school': 30,
+}
+
+_NUMBER_RE = re.compile(r'^\s*(\d+(?:\.\d+)?)\s*(km/h|kmh|kph|mph|knots)?\s*$')
+_ZONE_RE = re.compile(r'^[A-Z]{2}(?::[A-Z]{2})?:([a-z_]+)$')
+
+
+def parse_maxspeed(value):
+    """km/h for an OSM maxspeed value, or None if it isn't a fixed limit."""
+    if not value:
+        return None
+    # "50; 30" and friends: take the first
+    value = value.split(';')[0].strip()
+    m = _NUMBER_RE.match(value)
+    if m:
+        speed = float(m.group(1))
+        unit = m.group(2)
+        if unit == 'mph':
+            speed *= 1.609344
+        elif unit == 'knots':
+            speed *= 1.852
+        kmh = int(round(speed))
+        return kmh if 0 < kmh < 0xFFFF else None
+    m = _ZONE_RE.match(value)
+    if m:
+        return IMPLICIT_KMH.get(m.group(1))
+    return None
+
+
+def way_limits(tags):
+    """[(kmh, flags)] for a way's tags; empty if it has no usable limit."""
+    both = parse_maxspeed(tags.get('maxspeed'))
+    forward = parse_maxspeed(tags.get('maxspeed:forward'))
+    backward = parse_maxspeed(tags.get('maxspeed:backward'))
+
+    if forward is None and backward is None:
+        return [(both, 0)] if both is not None else []
+    forward = forward if forward is not None else both
+    backward = backward if backward is not None else both
+    if forward == backward:
+        return [(forward, 0)]
+    limits = []
+    if forward is not None:
+        limits.append((forward, FORWARD))
+    if backward is not None:
+        limits.append((backward, BACKWARD))
+    return limits
+
+
+class IndexBuilder:
+    def __init__(self, tiles_per_deg, margin_m):
+        self.tiles_per_deg = tiles_per_deg
+        self.margin_e6 = int(math.ceil(margin_m / M_PER_DEG_LAT * 1e6))
+        self.max_piece_e6 = int(1e6 / tiles_per_deg / 2)
+        self.tiles = {}
+        self.ways = 0
+        self.segments = 0
+
+    def tile_key(self, lat, lon):
+        tpd = self.tiles_per_deg
+        y = math.floor((lat + 90.0) * tpd)
+        x = math.floor((lon + 180.0) * tpd)
+        return y * 360 * tpd + x
+
+    def add_way(self, coords, limits):
+        """coords: [(lat_e6, lon_e6)] in way order."""
+        if len(coords) < 2 or not limits:
+            return
+        self.ways += 1
+        for (lat0, lon0), (lat1, lon1) in zip(coords, coords[1:]):
+            if lat0 == lat1 and lon0 == lon1:
+                continue
+            # Split long segments so their bounding boxes stay tight
+            pieces = max(1, math.ceil(max(abs(lat1 - lat0), abs(lon1 - lon0)) / self.max_piece_e6))
+            prev = (lat0, lon0)
+            for i in range(1, pieces + 1):
+                cur = (lat0 + round((lat1 - lat0) * i / pieces),
+                       lon0 + round((lon1 - lon0) * i / pieces))
+                for kmh, flags in limits:
+                    self._file(prev, cur, kmh, flags)
+                prev = cur
+
+    def _file(self, a, b, kmh, flags):
+        self.segments += 1
+        record = (a[0], a[1], b[0], b[1], kmh, flags)
+
+        # The lon margin covers the same distance on the ground as the lat one
+        cos_lat = max(0.01, math.cos(math.radians((a[0] + b[0]) / 2e6)))
+        lat_margin = self.margin_e6
+        lon_margin = self.margin_e6 / cos_lat
+        min_lat = (min(a[0], b[0]) - lat_margin) / 1e6
+        max_lat = (max(a[0], b[0]) + lat_margin) / 1e6
+        min_lon = (min(a[1], b[1]) - lon_margin) / 1e6
+        max_lon = (max(a[1], b[1]) + lon_margin) / 1e6
+
+        tpd = self.tiles_per_deg
+        y0 = math.floor((min_lat + 90.0) * tpd)
+        y1 = math.floor((max_lat + 90.0) * tpd)
+        x0 = math.floor((min_lon + 180.0) * tpd)
+        x1 = math.floor((max_lon + 180.0) * tpd)
+        for y in range(y0, y1 + 1):
+            for x in range(x0, x1 + 1):
+                self.tiles.setdefault(y * 360 * tpd + x, []).append(record)
+
+    def write(self, path):
+        keys = sorted(self.tiles)
+        segment_count = sum(len(self.tiles[k]) for k in keys)
+        with open(path, 'wb') as f:
+            f.write(HEADER.pack(MAGIC, VERSION, self.tiles_per_deg, self.margin_e6,
+                                len(keys), segment_count))
+            first = 0
+            for key in keys:
+                count = len(self.tiles[key])
+                f.write(TILE.pack(key, first, count))
+                first += count
+            for key in keys:
+                f.write(b''.join(SEGMENT.pack(*record) for record in self.tiles[key]))
+        return len(keys), segment_count
+
+
+def read_pbf(path, builder):
+    try:
+        import osmium
+    except ImportError:
+        sys.exit('pyosmium is required: pip install osmium')
+
+    class Handler(osmium.SimpleHandler):
+        def way(self, w):
+            if 'highway' not in w.tags:
+                return
+            limits = way_limits(w.tags)
+            if not limits:
+                return
+            coords = [(round(n.lat * 1e6), round(n.lon * 1e6))
+                      for n in w.nodes if n.location.valid()]
+            builder.add_way(coords, limits)
+
+    Handler().apply_file(path, locations=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build the HeadUnit speed-limit index from an OSM extract')
+    parser.add_argument('pbf', help='OSM PBF extract')
+    parser.add_argument('output', help='Index file to write')
+    parser.add_argument('--tiles-per-deg', type=int, default=100,
+                        help='Tile grid resolution (default 100, 0.01° tiles)')
+    parser.add_argument('--margin-m', type=float, default=40.0,
+                        help='Furthest a lookup can match a road, in metres (default 40)')
+    args = parser.parse_args()
+
+    builder = IndexBuilder(args.tiles_per_deg, args.margin_m)
+    read_pbf(args.pbf, builder)
+    tiles, entries = builder.write(args.output)
+
+    size = HEADER.size + tiles * TILE.size + entries * SEGMENT.size
+    print(f'{builder.ways} ways, {builder.segments} segments, {entries} tile entries '
+          f'in {tiles} tiles, {size / 1048576:.1f} MiB -> {args.output}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+"""
+Mock streaming speech recognizer for StreamingSTT.
+
+Speaks the WebSocket protocol described in StreamingSTT.h: a
+streamingConfig message, binary LINEAR16 audio, then {"audioEnd": true};
+answers with StreamingRecognizeResponse JSON. There is no recognition: a
+scripted transcript is revealed word by word while the audio is loud
+enough to be speech, and once speech has been followed by --endpoint-ms of
+quiet the server sends END_OF_SINGLE_UTTERANCE, the final result, and
+closes, the way a single-utterance Google stream does.
+
+Point the head unit at it with STREAMING_STT_URL=ws://127.0.0.1:8765/ and
+watch the PicovoiceManager / StreamingSTT log lines; the server logs when
+each event went out relative to the first audio.
+
+Usage:
+  python3 mock_stt_server.py
+  python3 mock_stt_server.py --transcript "call mom" --endpoint-ms 500
+  python3 mock_stt_server.py --final-delay-ms 800     # slow recognizer
+  python3 mock_stt_server.py --error-after-ms 1000    # exercise batch fallback
+  python3 mock_stt_server.py --drop-after-ms 1000     # connection lost mid-stream
+
+Standard library only.
+"""
+
+import argparse
+import array
+import asyncio
+import base64
+import hashlib
+import json
+import math
+import struct
+import sys
+import time
+
+WS_GUID = b'258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+
+OP_CONTINUATION = 0x0
+OP_TEXT = 0x1
+OP_BINARY = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+
+class Closed(Exception):
+    pass
+
+
+# ── WebSocket framing (RFC 6455, server side) ────────────────────
+
+async def handshake(reader, writer):
+    request = await reader.readuntil(b'\r\n\r\n')
+    headers = {}
+    for line in request.decode('latin-1').split('\r\n')[1:]:
+        if ':' in line:
+            name, value = line.split(':', 1)
+            headers[name.strip().lower()] = value.strip()
+
+    key = headers.get('sec-websocket-key')
+    if not key:
+        writer.write(b'HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n')
+        await writer.drain()
+        raise Closed('not a WebSocket request')
+
+    accept = base64.b64encode(hashlib.sha1(key.encode() + WS_GUID).digest())
+    writer.write(b'HTTP/1.1 101 Switching Protocols\r\n'
+                 b'Upgrade: websocket\r\n'
+                 b'Connection: Upgrade\r\n'
+                 b'Sec-WebSocket-Accept: ' + accept + b'\r\n\r\n')
+    await writer.drain()
+
+
+async def read_frame(reader):
+    b0, b1 = await reader.readexactly(2)
+    fin = bool(b0 & 0x80)
+    opcode = b0 & 0x0F
+    length = b1 & 0x7F
+    if length == 126:
+        length, = struct.unpack('>H', await reader.readexactly(2))
+    elif length == 127:
+        length, = struct.unpack('>Q', await reader.readexactly(8))
+    mask = await reader.readexactly(4) if b1 & 0x80 else None
+    payload = await reader.readexactly(length)
+    if mask:
+        payload = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    return fin, opcode, payload
+
+
+async def read_message(reader, writer):
+    """Next text (str) or binary (bytes) message; answers pings."""
+    message_opcode = None
+    parts = []
+    while True:
+        fin, opcode, payload = await read_frame(reader)
+        if opcode == OP_PING:
+            send_frame(writer, OP_PONG, payload)
+            continue
+        if opcode == OP_PONG:
+            continue
+        if opcode == OP_CLOSE:
+            send_frame(writer, OP_CLOSE, payload[:2])
+            raise Closed('client closed')
+        if opcode != OP_CONTINUATION:
+            message_opcode = opcode
+        parts.append(payload)
+        if fin:
+            data = b''.join(parts)
+            return data.decode('utf-8') if message_opcode == OP_TEXT else data
+
+
+def send_frame(writer, opcode, payload=b''):
+    header = bytes([0x80 | opcode])
+    length = len(payload)
+    if length < 126:
+        header += bytes([length])
+    elif length < 65536:
+        header += bytes([126]) + struct.pack('>H', length)
+    else:
+        header += bytes([127]) + struct.pack('>Q', length)
+    writer.write(header + payload)
+
+
+def send_json(writer, obj):
+    send_frame(writer, OP_TEXT, json.dumps(obj).encode('utf-8'))
+
+
+# ── Recognizer ───────────────────────────────────────────────────
+
+def rms(pcm):
+    samples = array.array('h')
+    samples.frombytes(pcm[:len(pcm) // 2 * 2])
+    if sys.byteorder == 'big':
+        samples.byteswap()
+    if not samples:
+        return 0.0
+    return math.sqrt(sum(s * s for s in samples) / len(samples))
+
+
+class Session:
+    def __init__(self, args, writer, peer):
+        self.args = args
+        self.writer = writer
+        self.peer = peer
+        self.words = args.transcript.split()
+        self.sample_rate = 16000
+        self.audio_ms = 0.0
+        self.speech_ms = 0.0
+        self.quiet_ms = 0.0
+        self.heard_speech = False
+        self.last_interim_ms = 0.0
+        self.revealed = 0
+        self.first_audio = None
+        self.done = False
+
+    def log(self, what):
+        at = '' if self.first_audio is None else ' @ %.0f ms' % ((time.monotonic() - self.first_audio) * 1000)
+        print('[%s] %s%s' % (self.peer, what, at), flush=True)
+
+    def configure(self, message):
+        config = message.get('streamingConfig', {}).get('config', {})
+        self.sample_rate = int(config.get('sampleRateHertz', 16000))
+        phrases = sum((c.get('phrases', []) for c in config.get('speechContexts', [])), [])
+        self.log('config: %d Hz, %s, %d hint phrases' % (
+            self.sample_rate, config.get('languageCode', '?'), len(phrases)))
+
+    async def audio(self, pcm):
+        if self.first_audio is None:
+            self.first_audio = time.monotonic()
+        chunk_ms = len(pcm) / 2 * 1000.0 / self.sample_rate
+        self.audio_ms += chunk_ms
+
+        if self.args.error_after_ms and self.audio_ms >= self.args.error_after_ms:
+            self.log('sending error')
+            send_json(self.writer, {'error': {'code': 13, 'message': 'Mock recognizer failure'}})
+            await self.writer.drain()
+            return await self.close()
+        if self.args.drop_after_ms and self.audio_ms >= self.args.drop_after_ms:
+            self.log('dropping connection')
+            self.writer.close()
+            self.done = True
+            return
+
+        if rms(pcm) >= self.args.speech_rms:
+            self.heard_speech = True
+            self.speech_ms += chunk_ms
+            self.quiet_ms = 0.0
+        elif self.heard_speech:
+            self.quiet_ms += chunk_ms
+
+        if self.heard_speech and self.audio_ms - self.last_interim_ms >= self.args.interim_ms:
+            self.last_interim_ms = self.audio_ms
+            await self.interim()
+
+        if self.heard_speech and self.quiet_ms >= self.args.endpoint_ms:
+            self.log('end of speech after %.0f ms of quiet' % self.quiet_ms)
+            send_json(self.writer, {'speechEventType': 'END_OF_SINGLE_UTTERANCE'})
+            await self.writer.drain()
+            await self.final()
+
+    async def interim(self):
+        count = min(len(self.words), 1 + int(self.speech_ms / 1000.0 * self.args.words_per_sec))
+        if count <= self.revealed and count < len(self.words):
+            return
+        self.revealed = count
+        # Stable head and unstable last word, as Google splits them
+        stable = ' '.join(self.words[:count - 1])
+        results = []
+        if stable:
+            results.append({'alternatives': [{'transcript': stable}], 'stability': 0.9})
+        results.append({'alternatives': [{'transcript': ' ' + self.words[count - 1] if stable
+                                          else self.words[count - 1]}], 'stability': 0.1})
+        send_json(self.writer, {'results': results})
+        await self.writer.drain()
+        self.log('interim: %s' % ' '.join(self.words[:count]))
+
+    async def final(self):
+        if self.done:
+            return
+        if self.args.final_delay_ms:
+            await asyncio.sleep(self.args.final_delay_ms / 1000.0)
+        transcript = ' '.join(self.words) if self.heard_speech or self.args.always_final else ''
+        send_json(self.writer, {'results': [{
+            'alternatives': [{'transcript': transcript, 'confidence': 0.93}],
+            'isFinal': True,
+            'stability': 1.0,
+        }]})
+        await self.writer.drain()
+        self.log('final: %r (%.0f ms of audio, %.0f ms speech)' % (transcript, self.audio_ms, self.speech_ms))
+        await self.close()
+
+    async def close(self):
+        if self.done:
+            return
+        self.done = True
+        send_frame(self.writer, OP_CLOSE, struct.pack('>H', 1000))
+        await self.writer.drain()
+
+
+async def serve_client(args, reader, writer):
+    peer = '%s:%d' % writer.get_extra_info('peername')[:2]
+    session = Session(args, writer, peer)
+    try:
+        await handshake(reader, writer)
+        session.log('connected')
+        while not session.done:
+            message = await read_message(reader, writer)
+            if isinstance(message, bytes):
+                await session.audio(message)
+                continue
+            request = json.loads(message)
+            if 'streamingConfig' in request:
+                session.configure(request)
+            elif request.get('audioEnd'):
+                session.log('audio end')
+                await session.final()
+    except (Closed, asyncio.IncompleteReadError, ConnectionError) as e:
+        if not session.done:
+            session.log('disconnected (%s)' % (e or 'eof'))
+    finally:
+        writer.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8765)
+    parser.add_argument('--transcript', default="what's the weather like at my destination",
+                        help='what every utterance is recognized as')
+    parser.add_argument('--speech-rms', type=float, default=600.0,
+                        help='chunk RMS at or above which audio counts as speech')
+    parser.add_argument('--endpoint-ms', type=int, default=600,
+                        help='quiet after speech before the utterance is endpointed')
+    parser.add_argument('--interim-ms', type=int, default=300,
+                        help='audio between interim results')
+    parser.add_argument('--words-per-sec', type=float, default=2.5,
+                        help='how fast interim results reveal the transcript')
+    parser.add_argument('--final-delay-ms', type=int, default=0,
+                        help='recognizer latency before the final result')
+    parser.add_argument('--always-final', action='store_true',
+                        help='return the transcript even if no speech was heard')
+    parser.add_argument('--error-after-ms', type=int, default=0,
+                        help='send an API error after this much audio')
+    parser.add_argument('--drop-after-ms', type=int, default=0,
+                        help='close the connection without a result after this much audio')
+    args = parser.parse_args()
+
+    async def run():
+        server = await asyncio.start_server(lambda r, w: serve_client(args, r, w), args.host, args.port)
+        print('Mock streaming STT on ws://%s:%d/' % (args.host, args.port), flush=True)
+        async with server:
+            await server.serve_forever()
+
+    try:
+        asyncio.run(run())
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()